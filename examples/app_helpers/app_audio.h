@@ -2,11 +2,13 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
 #include <memory>
 #include "basic_radio/basic_radio.h"
 #include "basic_radio/basic_audio_channel.h"
 #include "basic_radio/basic_audio_params.h"
 #include "dab/database/dab_database_types.h"
+#include "utility/latency_histogram.h"
 #include "utility/span.h"
 #include "../audio/audio_pipeline.h"
 #include "../audio/frame.h"
@@ -19,7 +21,7 @@ static void attach_audio_pipeline_to_radio(std::shared_ptr<AudioPipeline> audio_
             auto audio_source = std::make_shared<AudioPipelineSource>();
             audio_pipeline->add_source(audio_source);
             channel.OnAudioData().Attach(
-                [&controls, audio_source, audio_pipeline]
+                [&channel, &controls, audio_source, audio_pipeline]
                 (BasicAudioParams params, tcb::span<const uint8_t> buf) {
                     if (!controls.GetIsPlayAudio()) return;
                     auto frame_ptr = reinterpret_cast<const Frame<int16_t>*>(buf.data());
@@ -27,6 +29,13 @@ static void attach_audio_pipeline_to_radio(std::shared_ptr<AudioPipeline> audio_
                     auto frame_buf = tcb::span(frame_ptr, total_frames);
                     const bool is_blocking = audio_pipeline->get_sink() != nullptr;
                     audio_source->write(frame_buf, float(params.frequency), is_blocking);
+                    // Audio is heard once the samples buffered ahead of it have been played
+                    const auto& trace = channel.GetFrameTrace();
+                    if (!trace.IsValid()) return;
+                    const float written_duration = float(total_frames) / float(params.frequency);
+                    const float ahead_duration = std::max(audio_source->get_buffered_duration() - written_duration, 0.0f);
+                    const int64_t elapsed_ns = trace.GetElapsed(GetLatencyTimestamp());
+                    channel.GetLatency().audio_output.Record(elapsed_ns + int64_t(ahead_duration*1e9f));
                 }
             );
         }
@@ -0,0 +1,371 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <fmt/core.h>
+#include "utility/span.h"
+#include "viterbi_config.h"
+#include "./app_io_buffers.h"
+#include "./app_shared_memory_buffers.h"
+
+// Per frame measurements from the demodulator that travel alongside the soft bits
+struct FrameBusMetadata {
+    uint64_t frame_index;           // total frames read by the demodulator
+    int64_t timestamp_ns;           // steady clock when the frame was read which is shared between processes on the same host
+    float snr_db;                   // estimated from the spread of the DQPSK constellation
+    float signal_level;             // average L1 norm of the IQ signal
+    float frequency_offset;         // net fine and coarse frequency offset in Hz
+    uint32_t nb_bits;
+};
+
+// Fan out of demodulated frames in a named shared memory region so one demodulator feeds many processes
+// - The publisher writes each frame once into a ring of slots, subscribers read the slot in place
+// - A subscriber pins the slot it is reading with a reference count and the publisher skips pinned slots
+// - The publisher never blocks. A subscriber that falls behind skips to the oldest frame still in the ring
+//   and counts the frames it missed. If every slot is pinned the publisher drops the frame instead
+// - Subscribers can attach and detach at any time
+struct FrameBusHeader {
+    static constexpr uint32_t MAGIC = 0x42464144; // "DAFB"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t MAX_SUBSCRIBERS = 16;
+    struct Subscriber {
+        std::atomic<uint32_t> is_active;
+        alignas(64) std::atomic<uint64_t> nb_received;
+        std::atomic<uint64_t> nb_dropped;
+    };
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nb_slots;
+    uint32_t nb_frame_bits;
+    uint64_t slot_stride;
+    std::atomic<uint32_t> is_closed;
+    // Sequence number of the newest published frame starting from 1
+    alignas(64) std::atomic<uint64_t> publish_count;
+    std::atomic<uint64_t> nb_publisher_drops;
+    // futex word which is bumped whenever a frame is published or the bus is closed
+    alignas(64) std::atomic<uint32_t> write_sequence;
+    std::atomic<uint32_t> nb_waiting_subscribers;
+    alignas(64) Subscriber subscribers[MAX_SUBSCRIBERS];
+};
+
+struct FrameBusSlot {
+    // Sequence is zero while the publisher is overwriting the slot
+    std::atomic<uint32_t> refcount;
+    std::atomic<uint64_t> sequence;
+    FrameBusMetadata metadata;
+};
+
+static constexpr size_t get_frame_bus_slot_stride(const size_t nb_frame_bits) {
+    const size_t nb_bytes = sizeof(FrameBusSlot) + nb_frame_bits*sizeof(viterbi_bit_t);
+    return (nb_bytes + 63) & ~size_t(63);
+}
+
+class FrameBus
+{
+private:
+    SharedMemoryRegion m_region;
+    FrameBusHeader* m_header = nullptr;
+public:
+    // Publisher creates the region, subscribers open an existing region
+    FrameBus(const std::string& name, const size_t nb_frame_bits, const size_t nb_slots, const bool is_owner)
+    : m_region(name, sizeof(FrameBusHeader) + nb_slots*get_frame_bus_slot_stride(nb_frame_bits), is_owner)
+    {
+        if (m_region.get_size() < sizeof(FrameBusHeader)) {
+            throw std::runtime_error(fmt::format("Shared memory '{}' is not a frame bus", name));
+        }
+        m_header = reinterpret_cast<FrameBusHeader*>(m_region.get_data());
+        if (is_owner) {
+            // NOTE: ftruncate zero fills the region so the atomics start at zero
+            m_header->nb_slots = uint32_t(nb_slots);
+            m_header->nb_frame_bits = uint32_t(nb_frame_bits);
+            m_header->slot_stride = get_frame_bus_slot_stride(nb_frame_bits);
+            m_header->version = FrameBusHeader::VERSION;
+            std::atomic_thread_fence(std::memory_order_release);
+            m_header->magic = FrameBusHeader::MAGIC;
+        } else {
+            const bool is_valid =
+                (m_header->magic == FrameBusHeader::MAGIC) &&
+                (m_header->version == FrameBusHeader::VERSION) &&
+                (m_header->slot_stride == get_frame_bus_slot_stride(m_header->nb_frame_bits)) &&
+                ((sizeof(FrameBusHeader) + m_header->nb_slots*m_header->slot_stride) <= m_region.get_size());
+            if (!is_valid) {
+                throw std::runtime_error(fmt::format("Shared memory '{}' has an incompatible header", name));
+            }
+        }
+    }
+    ~FrameBus() {
+        if (m_region.get_is_owner()) close();
+    }
+    FrameBus(const FrameBus&) = delete;
+    FrameBus& operator=(const FrameBus&) = delete;
+
+    const std::string& get_name() const { return m_region.get_name(); }
+    size_t get_nb_slots() const { return size_t(m_header->nb_slots); }
+    size_t get_nb_frame_bits() const { return size_t(m_header->nb_frame_bits); }
+    bool get_is_closed() const { return m_header->is_closed.load(std::memory_order_acquire) != 0; }
+    uint64_t get_publish_count() const { return m_header->publish_count.load(std::memory_order_acquire); }
+    uint64_t get_publisher_drops() const { return m_header->nb_publisher_drops.load(std::memory_order_relaxed); }
+    FrameBusHeader::Subscriber& get_subscriber(const size_t index) { return m_header->subscribers[index]; }
+    FrameBusSlot& get_slot(const size_t index) {
+        auto* ptr = m_region.get_data() + sizeof(FrameBusHeader) + index*size_t(m_header->slot_stride);
+        return *reinterpret_cast<FrameBusSlot*>(ptr);
+    }
+    tcb::span<viterbi_bit_t> get_slot_bits(const size_t index) {
+        auto* ptr = reinterpret_cast<uint8_t*>(&get_slot(index)) + sizeof(FrameBusSlot);
+        return { reinterpret_cast<viterbi_bit_t*>(ptr), get_nb_frame_bits() };
+    }
+
+    void close() {
+        m_header->is_closed.store(1, std::memory_order_release);
+        notify();
+    }
+
+    // Publisher only
+    // Returns false if every slot was pinned and the frame was dropped
+    bool publish(tcb::span<const viterbi_bit_t> bits, const FrameBusMetadata& metadata) {
+        const size_t N = get_nb_slots();
+        const uint64_t sequence = get_publish_count() + 1;
+        for (size_t i = 0; i < N; i++) {
+            const size_t index = size_t((sequence + i) % N);
+            auto& slot = get_slot(index);
+            if (slot.refcount.load(std::memory_order_relaxed) != 0) continue;
+            // Claim the slot then check that no subscriber pinned it in the meantime
+            // NOTE: Pairs with the sequentially consistent pin in the subscriber (store then load on both sides)
+            const uint64_t old_sequence = slot.sequence.load(std::memory_order_relaxed);
+            slot.sequence.store(0, std::memory_order_seq_cst);
+            if (slot.refcount.load(std::memory_order_seq_cst) != 0) {
+                slot.sequence.store(old_sequence, std::memory_order_release);
+                continue;
+            }
+            auto dest = get_slot_bits(index);
+            const size_t nb_bits = (bits.size() > dest.size()) ? dest.size() : bits.size();
+            std::memcpy(dest.data(), bits.data(), nb_bits*sizeof(viterbi_bit_t));
+            slot.metadata = metadata;
+            slot.metadata.nb_bits = uint32_t(nb_bits);
+            slot.sequence.store(sequence, std::memory_order_release);
+            m_header->publish_count.store(sequence, std::memory_order_release);
+            notify();
+            return true;
+        }
+        m_header->nb_publisher_drops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Subscriber slots
+    int acquire_subscriber() {
+        for (size_t i = 0; i < FrameBusHeader::MAX_SUBSCRIBERS; i++) {
+            auto& subscriber = m_header->subscribers[i];
+            uint32_t expected = 0;
+            if (!subscriber.is_active.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) continue;
+            subscriber.nb_received.store(0, std::memory_order_relaxed);
+            subscriber.nb_dropped.store(0, std::memory_order_relaxed);
+            return int(i);
+        }
+        return -1;
+    }
+
+    void release_subscriber(const int index) {
+        if (index < 0) return;
+        m_header->subscribers[index].is_active.store(0, std::memory_order_release);
+    }
+
+    // Pins the oldest frame in the ring with a sequence of at least min_sequence
+    // Returns the slot index or -1 if there is no such frame yet
+    int try_pin(const uint64_t min_sequence) {
+        const size_t N = get_nb_slots();
+        while (true) {
+            int best_index = -1;
+            uint64_t best_sequence = 0;
+            for (size_t i = 0; i < N; i++) {
+                const uint64_t sequence = get_slot(i).sequence.load(std::memory_order_acquire);
+                if (sequence < min_sequence) continue;
+                if ((best_index < 0) || (sequence < best_sequence)) {
+                    best_index = int(i);
+                    best_sequence = sequence;
+                }
+            }
+            if (best_index < 0) return -1;
+
+            auto& slot = get_slot(size_t(best_index));
+            slot.refcount.fetch_add(1, std::memory_order_seq_cst);
+            if (slot.sequence.load(std::memory_order_seq_cst) == best_sequence) {
+                return best_index;
+            }
+            // The publisher overwrote the slot before we pinned it
+            slot.refcount.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void unpin(const int index) {
+        if (index < 0) return;
+        get_slot(size_t(index)).refcount.fetch_sub(1, std::memory_order_release);
+    }
+
+    uint32_t get_write_sequence() const {
+        return m_header->write_sequence.load(std::memory_order_acquire);
+    }
+
+    void wait(const uint32_t write_sequence) {
+        m_header->nb_waiting_subscribers.fetch_add(1, std::memory_order_acq_rel);
+        shared_memory_wait(m_header->write_sequence, write_sequence);
+        m_header->nb_waiting_subscribers.fetch_sub(1, std::memory_order_acq_rel);
+    }
+private:
+    void notify() {
+        m_header->write_sequence.fetch_add(1, std::memory_order_acq_rel);
+        // Avoid the syscall when nobody is waiting
+        if (m_header->nb_waiting_subscribers.load(std::memory_order_acquire) == 0) return;
+        shared_memory_wake_all(m_header->write_sequence);
+    }
+};
+
+// Estimates SNR from how far the DQPSK vectors of a frame spread around their ideal constellation points
+static inline float estimate_dqpsk_snr_db(tcb::span<const std::complex<float>> vecs) {
+    if (vecs.empty()) return 0.0f;
+    float average_amplitude = 0.0f;
+    for (const auto& vec: vecs) {
+        average_amplitude += fabsf(vec.real()) + fabsf(vec.imag());
+    }
+    average_amplitude /= float(2*vecs.size());
+    float noise_power = 0.0f;
+    for (const auto& vec: vecs) {
+        const float dI = fabsf(vec.real()) - average_amplitude;
+        const float dQ = fabsf(vec.imag()) - average_amplitude;
+        noise_power += dI*dI + dQ*dQ;
+    }
+    noise_power /= float(vecs.size());
+    const float signal_power = 2.0f*average_amplitude*average_amplitude;
+    if (noise_power <= 0.0f) return 100.0f;
+    return 10.0f*log10f(signal_power/noise_power);
+}
+
+class FrameBusPublisher
+{
+private:
+    FrameBus m_bus;
+public:
+    FrameBusPublisher(const std::string& name, const size_t nb_frame_bits, const size_t nb_slots)
+    : m_bus(name, nb_frame_bits, nb_slots, true) {}
+    auto& get_bus() { return m_bus; }
+    void close() { m_bus.close(); }
+    bool publish(tcb::span<const viterbi_bit_t> bits, const FrameBusMetadata& metadata) {
+        return m_bus.publish(bits, metadata);
+    }
+};
+
+// Frame that stays valid until the next read or until it is released
+struct FrameBusFrame {
+    tcb::span<const viterbi_bit_t> bits;
+    FrameBusMetadata metadata;
+    uint64_t sequence;
+};
+
+class FrameBusSubscriber
+{
+private:
+    FrameBus m_bus;
+    int m_subscriber_index = -1;
+    int m_pinned_slot = -1;
+    uint64_t m_next_sequence = 0;
+    std::atomic<bool> m_is_closed = false;
+public:
+    explicit FrameBusSubscriber(const std::string& name)
+    : m_bus(name, 0, 0, false)
+    {
+        m_subscriber_index = m_bus.acquire_subscriber();
+        if (m_subscriber_index < 0) {
+            throw std::runtime_error(fmt::format(
+                "Frame bus '{}' already has the maximum of {} subscribers",
+                name, FrameBusHeader::MAX_SUBSCRIBERS
+            ));
+        }
+        // Start from live frames instead of whatever is left in the ring
+        m_next_sequence = m_bus.get_publish_count() + 1;
+    }
+    ~FrameBusSubscriber() {
+        release();
+        m_bus.release_subscriber(m_subscriber_index);
+    }
+    FrameBusSubscriber(const FrameBusSubscriber&) = delete;
+    FrameBusSubscriber& operator=(const FrameBusSubscriber&) = delete;
+
+    size_t get_nb_frame_bits() const { return m_bus.get_nb_frame_bits(); }
+    uint64_t get_total_received() { return m_bus.get_subscriber(size_t(m_subscriber_index)).nb_received.load(std::memory_order_relaxed); }
+    uint64_t get_total_dropped() { return m_bus.get_subscriber(size_t(m_subscriber_index)).nb_dropped.load(std::memory_order_relaxed); }
+    // Stops this subscriber without closing the bus for other subscribers
+    void close() { m_is_closed = true; }
+
+    // Unpins the last frame so the publisher can reuse its slot
+    void release() {
+        m_bus.unpin(m_pinned_slot);
+        m_pinned_slot = -1;
+    }
+
+    // Blocks until the next frame is published and returns false once the bus is closed
+    bool read(FrameBusFrame& frame) {
+        release();
+        auto& subscriber = m_bus.get_subscriber(size_t(m_subscriber_index));
+        while (!m_is_closed) {
+            const uint32_t write_sequence = m_bus.get_write_sequence();
+            const int index = m_bus.try_pin(m_next_sequence);
+            if (index >= 0) {
+                auto& slot = m_bus.get_slot(size_t(index));
+                const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+                // Frames that were overwritten before we got to them
+                if (sequence > m_next_sequence) {
+                    subscriber.nb_dropped.fetch_add(sequence - m_next_sequence, std::memory_order_relaxed);
+                }
+                subscriber.nb_received.fetch_add(1, std::memory_order_relaxed);
+                m_next_sequence = sequence+1;
+                m_pinned_slot = index;
+                frame.metadata = slot.metadata;
+                frame.bits = m_bus.get_slot_bits(size_t(index)).first(slot.metadata.nb_bits);
+                frame.sequence = sequence;
+                return true;
+            }
+            if (m_bus.get_is_closed()) return false;
+            m_bus.wait(write_sequence);
+        }
+        return false;
+    }
+};
+
+// Adapts a subscriber to the stream interface used by the radio blocks
+class FrameBusInputBuffer: public InputBuffer<viterbi_bit_t>
+{
+private:
+    std::shared_ptr<FrameBusSubscriber> m_subscriber;
+    FrameBusFrame m_frame;
+    size_t m_frame_offset = 0;
+public:
+    explicit FrameBusInputBuffer(std::shared_ptr<FrameBusSubscriber> subscriber)
+    : m_subscriber(subscriber) {
+        m_frame.sequence = 0;
+    }
+    ~FrameBusInputBuffer() override = default;
+    size_t read(tcb::span<viterbi_bit_t> dest) override {
+        size_t total_read = 0;
+        while (total_read < dest.size()) {
+            if (m_frame_offset >= m_frame.bits.size()) {
+                m_frame_offset = 0;
+                m_frame.bits = {};
+                if (!m_subscriber->read(m_frame)) break;
+            }
+            const size_t nb_remain = m_frame.bits.size() - m_frame_offset;
+            const size_t nb_dest = dest.size() - total_read;
+            const size_t length = (nb_remain > nb_dest) ? nb_dest : nb_remain;
+            std::memcpy(&dest[total_read], &m_frame.bits[m_frame_offset], length*sizeof(viterbi_bit_t));
+            m_frame_offset += length;
+            total_read += length;
+        }
+        return total_read;
+    }
+};
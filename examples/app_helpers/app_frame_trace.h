@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <deque>
+#include <mutex>
+#include "utility/latency_histogram.h"
+
+// Carries the trace of each frame alongside a stream of soft bits from the demodulator to the radio
+// - Traces are pushed before the frame's bits are written so the reader always finds a matching trace
+// - The stream holds whole frames in order so the n-th frame read matches the n-th trace
+// - If the reader stalls then the oldest traces are dropped so the queue stays bounded
+class FrameTraceQueue
+{
+private:
+    const size_t m_max_length;
+    std::deque<Frame_Trace> m_traces;
+    std::mutex m_mutex;
+public:
+    explicit FrameTraceQueue(const size_t max_length=16): m_max_length(max_length) {}
+    void push(const Frame_Trace& trace) {
+        auto lock = std::scoped_lock(m_mutex);
+        if (m_traces.size() >= m_max_length) m_traces.pop_front();
+        m_traces.push_back(trace);
+    }
+    // Returns an invalid trace if none are queued
+    Frame_Trace pop() {
+        auto lock = std::scoped_lock(m_mutex);
+        if (m_traces.empty()) return Frame_Trace{};
+        const auto trace = m_traces.front();
+        m_traces.pop_front();
+        return trace;
+    }
+};
@@ -2,13 +2,16 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <atomic>
 #include <condition_variable>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <type_traits>
 #include <vector>
 #include "utility/span.h"
-#include "../audio/ring_buffer.h"
+#include "./app_mirrored_memory.h"
 
 template <typename T>
 struct InputBuffer {
@@ -184,63 +187,153 @@ public:
     }
 };
 
-// single producer single consumer ring buffer
+// Lock free single producer single consumer ring buffer
+// - Reserve/commit hands out contiguous spans inside the ring so data can be produced and consumed in place
+// - Spans that wrap around the end of the ring stay contiguous since the ring is mapped twice back to back
+// - Threads only take a lock to sleep when the ring is full or empty, and are only woken when they can make progress
+// - read/write copy through the ring for streams that don't need zero copy
 template <typename T>
 class ThreadedRingBuffer: public InputBuffer<T>, public OutputBuffer<T>
 {
 private:
-    RingBuffer<T> m_ring_buffer;
-    std::mutex m_mutex_ring_buffer;
+    static_assert(std::is_trivially_copyable_v<T>, "Ring buffer elements are moved with memcpy");
+    static_assert((sizeof(T) & (sizeof(T)-1)) == 0, "Element size must divide the page size so wrapped spans line up");
+    MirroredMemory m_memory;
+    T* m_data;
+    const size_t m_capacity;
+    // Monotonically increasing counters, the ring index is the counter modulo the capacity
+    // Kept on separate cache lines so the producer and consumer don't contend
+    alignas(64) std::atomic<size_t> m_write_count {0};
+    alignas(64) std::atomic<size_t> m_read_count {0};
+    // Sleeping threads publish how much they are waiting for so the other thread only wakes them when it's available
+    alignas(64) std::atomic<size_t> m_reader_wait_length {0};
+    std::atomic<size_t> m_writer_wait_length {0};
+    std::atomic<bool> m_is_closed {false};
+    std::mutex m_mutex_wait;
     std::condition_variable m_cv_reader;
     std::condition_variable m_cv_writer;
-    bool m_is_closed = false;
 public:
-    explicit ThreadedRingBuffer(size_t length): m_ring_buffer(length) {}
+    // Length is rounded up to a whole number of pages
+    explicit ThreadedRingBuffer(size_t length)
+    : m_memory(length*sizeof(T), alignof(T)),
+      m_data(reinterpret_cast<T*>(m_memory.get_data())),
+      m_capacity(m_memory.get_size()/sizeof(T))
+    {}
     ~ThreadedRingBuffer() override {
         close();
     }
 
+    size_t get_capacity() const { return m_capacity; }
+    size_t get_total_used() const {
+        return m_write_count.load(std::memory_order_acquire) - m_read_count.load(std::memory_order_acquire);
+    }
+    bool get_is_closed() const { return m_is_closed.load(std::memory_order_acquire); }
+
     void close() {
-        {
-            auto lock = std::unique_lock(m_mutex_ring_buffer);
-            m_is_closed = true;
-        }
+        m_is_closed.store(true, std::memory_order_seq_cst);
+        auto lock = std::unique_lock(m_mutex_wait);
         m_cv_reader.notify_all();
         m_cv_writer.notify_all();
     }
 
+    // Producer only
+    // Blocks until at least min_length elements are free and returns all contiguous free space
+    // Returns an empty span if the ring was closed
+    tcb::span<T> reserve_write(const size_t min_length) {
+        const size_t write_count = m_write_count.load(std::memory_order_relaxed);
+        const size_t total_free = wait_for_length(m_writer_wait_length, m_cv_writer, min_length, [this, write_count]() {
+            return m_capacity - (write_count - m_read_count.load(std::memory_order_acquire));
+        });
+        if (get_is_closed()) return {};
+        return tcb::span<T>(m_data + (write_count % m_capacity), total_free);
+    }
+    void commit_write(const size_t length) {
+        const size_t write_count = m_write_count.load(std::memory_order_relaxed);
+        m_memory.sync((write_count % m_capacity)*sizeof(T), length*sizeof(T));
+        m_write_count.store(write_count + length, std::memory_order_release);
+        wake_if_ready(m_reader_wait_length, m_cv_reader, [this, write_count, length]() {
+            return write_count + length - m_read_count.load(std::memory_order_acquire);
+        });
+    }
+
+    // Consumer only
+    // Blocks until at least min_length elements can be read and returns all contiguous readable data
+    // If the ring was closed then whatever is left is returned which can be less than min_length
+    tcb::span<const T> reserve_read(const size_t min_length) {
+        const size_t read_count = m_read_count.load(std::memory_order_relaxed);
+        const size_t total_used = wait_for_length(m_reader_wait_length, m_cv_reader, min_length, [this, read_count]() {
+            return m_write_count.load(std::memory_order_acquire) - read_count;
+        });
+        return tcb::span<const T>(m_data + (read_count % m_capacity), total_used);
+    }
+    void commit_read(const size_t length) {
+        const size_t read_count = m_read_count.load(std::memory_order_relaxed);
+        m_read_count.store(read_count + length, std::memory_order_release);
+        wake_if_ready(m_writer_wait_length, m_cv_writer, [this, read_count, length]() {
+            return m_capacity - (m_write_count.load(std::memory_order_acquire) - (read_count + length));
+        });
+    }
+
+    // Blocks until dest is filled or the ring is closed like a file
     size_t read(tcb::span<T> dest) override {
-        auto lock = std::unique_lock(m_mutex_ring_buffer);
-        size_t total_written = 0;
-        while (true) {
-            const size_t length = m_ring_buffer.read(dest);
-            total_written += length;
+        size_t total_read = 0;
+        while (!dest.empty()) {
+            const auto src = reserve_read(1);
+            if (src.empty()) break;
+            const size_t length = (src.size() > dest.size()) ? dest.size() : src.size();
+            std::memcpy(dest.data(), src.data(), length*sizeof(T));
+            commit_read(length);
+            total_read += length;
             dest = dest.subspan(length);
-            if (length > 0) m_cv_reader.notify_one();
-            if (dest.empty()) break;
-            m_cv_writer.wait(lock, [this](){
-                return m_is_closed || !m_ring_buffer.is_empty();
-            });
-            if (m_is_closed) break;
         }
-        return total_written;
+        return total_read;
     }
 
+    // Blocks until src is written or the ring is closed
     size_t write(tcb::span<const T> src) override {
-        auto lock = std::unique_lock(m_mutex_ring_buffer);
-        size_t total_read = 0;
-        while (true) {
-            const size_t length = m_ring_buffer.write(src);
-            total_read += length;
+        size_t total_written = 0;
+        while (!src.empty()) {
+            auto dest = reserve_write(1);
+            if (dest.empty()) break;
+            const size_t length = (src.size() > dest.size()) ? dest.size() : src.size();
+            std::memcpy(dest.data(), src.data(), length*sizeof(T));
+            commit_write(length);
+            total_written += length;
             src = src.subspan(length);
-            if (length > 0) m_cv_writer.notify_one();
-            if (src.empty()) break;
-            m_cv_reader.wait(lock, [this](){
-                return m_is_closed || !m_ring_buffer.is_full();
+        }
+        return total_written;
+    }
+private:
+    // NOTE: The waiting length is published before checking the counter again, and the other thread updates
+    //       the counter before checking the waiting length. The fences between them mean at least one of us
+    //       sees the other so the wake up can't be lost
+    template <typename F>
+    size_t wait_for_length(std::atomic<size_t>& wait_length, std::condition_variable& cv, size_t min_length, F&& get_length) {
+        min_length = (min_length > m_capacity) ? m_capacity : min_length;
+        min_length = (min_length == 0) ? 1 : min_length;
+        size_t length = get_length();
+        if (length >= min_length) return length;
+        wait_length.store(min_length, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        length = get_length();
+        if (length < min_length && !get_is_closed()) {
+            auto lock = std::unique_lock(m_mutex_wait);
+            cv.wait(lock, [&]() {
+                length = get_length();
+                return (length >= min_length) || get_is_closed();
             });
-            if (m_is_closed) break;
         }
-        return total_read;
+        wait_length.store(0, std::memory_order_relaxed);
+        return get_length();
+    }
+    template <typename F>
+    void wake_if_ready(std::atomic<size_t>& wait_length, std::condition_variable& cv, F&& get_length) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const size_t min_length = wait_length.load(std::memory_order_relaxed);
+        if ((min_length == 0) || (get_length() < min_length)) return;
+        // Taking the lock means the other thread is either asleep or hasn't checked its condition yet
+        auto lock = std::unique_lock(m_mutex_wait);
+        cv.notify_one();
     }
 };
 
@@ -104,6 +104,32 @@ static std::shared_ptr<InputBuffer<std::complex<float>>> get_quantised_iq_file_r
     return output_raw_iq;
 }
 
+// Converts raw IQ straight into the free space of the ring so it is only copied once
+// Returns the number of bytes consumed which is short if the ring was closed
+template <typename T>
+static size_t write_quantised_iq_to_ring(ThreadedRingBuffer<std::complex<float>>& ring, tcb::span<const uint8_t> bytes) {
+    constexpr size_t stride = sizeof(QuantisedIQ<T>);
+    const auto src = tcb::span<const QuantisedIQ<T>>(
+        reinterpret_cast<const QuantisedIQ<T>*>(bytes.data()),
+        bytes.size()/stride
+    );
+    constexpr float scale = 1.0f/QuantisedIQ<T>::MAX_AMPLITUDE;
+    size_t total_written = 0;
+    while (total_written < src.size()) {
+        auto dest = ring.reserve_write(1);
+        if (dest.empty()) break;
+        const size_t N_remain = src.size() - total_written;
+        const size_t length = (dest.size() > N_remain) ? N_remain : dest.size();
+        for (size_t i = 0; i < length; i++) {
+            const std::complex<float> v = src[total_written+i].to_c32();
+            dest[i] = std::complex<float>(v.real()*scale, v.imag()*scale);
+        }
+        ring.commit_write(length);
+        total_written += length;
+    }
+    return total_written*stride;
+}
+
 static const std::vector<std::string> iq_read_modes = {
     "wav",
     "raw_u8", "raw_s8",
@@ -112,11 +138,26 @@ static const std::vector<std::string> iq_read_modes = {
     "raw_f32l", "raw_f32b", "raw_f64l", "raw_f64b",
 };
 
+// Number of bytes in each IQ sample for raw formats, or 0 if the format has a header
+static size_t get_iq_sample_size_from_mode_string(const std::string& mode) {
+    if (mode == "raw_u8" || mode == "raw_s8") return 2;
+    if (mode == "raw_s16l" || mode == "raw_s16b" || mode == "raw_u16l" || mode == "raw_u16b") return 4;
+    if (mode == "raw_s32l" || mode == "raw_s32b" || mode == "raw_u32l" || mode == "raw_u32b") return 8;
+    if (mode == "raw_f32l" || mode == "raw_f32b") return 8;
+    if (mode == "raw_f64l" || mode == "raw_f64b") return 16;
+    return 0;
+}
+
 static std::shared_ptr<InputBuffer<std::complex<float>>> get_iq_file_reader_from_mode_string(
-    std::shared_ptr<InputFile<uint8_t>> file, const std::string& mode
+    std::shared_ptr<InputBuffer<uint8_t>> file, const std::string& mode
 ) {
     if (mode == "wav") {
-        auto wav_reader = std::make_shared<WavFileReader>(file);
+        // NOTE: The wav header can only be parsed from a seekable file
+        auto wav_file = std::dynamic_pointer_cast<InputFile<uint8_t>>(file);
+        if (wav_file == nullptr) {
+            throw std::runtime_error("WAV format can only be read from a file");
+        }
+        auto wav_reader = std::make_shared<WavFileReader>(wav_file);
         const auto& header = wav_reader->get_header();
         header.debug_print(stdout);
         if (header.total_channels != 2) {
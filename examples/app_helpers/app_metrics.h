@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "ofdm/ofdm_demodulator.h"
+#include "utility/metrics.h"
+
+static void collect_ofdm_metrics(Metrics_Writer& writer, const OFDM_Demod& demod, const Metric_Labels& labels) {
+    constexpr double Fs = 2.048e6; // OFDM sampling frequency
+    writer.AddCounter("dab_ofdm_frames_total", "Frames read by the OFDM demodulator", labels, uint64_t(demod.GetTotalFramesRead()));
+    writer.AddCounter("dab_ofdm_frames_desync_total", "Times the OFDM demodulator lost synchronisation", labels, uint64_t(demod.GetTotalFramesDesync()));
+    writer.AddGauge("dab_ofdm_is_tracking", "OFDM demodulator is synchronised to the signal", labels, demod.GetIsTracking() ? 1.0 : 0.0);
+    writer.AddGauge("dab_ofdm_signal_level", "Average L1 norm of the IQ signal", labels, double(demod.GetSignalAverage()));
+    writer.AddGauge("dab_ofdm_frequency_offset_hz", "Net coarse and fine frequency correction", labels, double(demod.GetNetFrequencyOffset())*Fs);
+    writer.AddHistogram("dab_ofdm_frame_latency_seconds", "Time from the frame being read to its soft bits being ready", labels, demod.GetFrameLatency());
+}
+
+// Periodically writes all metrics in the Prometheus text format
+// - Intended for the textfile collector of the node exporter which scrapes every file in a directory
+// - The file is written to a temporary path and renamed so a scrape never reads a partially written file
+// - A final snapshot is written when stopped so offline runs leave their totals behind
+class MetricsFileExporter
+{
+private:
+    std::shared_ptr<Metrics_Registry> m_registry;
+    const std::string m_filepath;
+    const std::chrono::milliseconds m_interval;
+    std::mutex m_mutex_stop;
+    std::condition_variable m_cv_stop;
+    bool m_is_stopped = false;
+    std::unique_ptr<std::thread> m_thread = nullptr;
+public:
+    MetricsFileExporter(std::shared_ptr<Metrics_Registry> registry, const std::string& filepath, const std::chrono::milliseconds interval)
+    : m_registry(registry), m_filepath(filepath), m_interval(interval)
+    {
+        m_thread = std::make_unique<std::thread>([this]() { run(); });
+    }
+    ~MetricsFileExporter() { stop(); }
+    MetricsFileExporter(const MetricsFileExporter&) = delete;
+    MetricsFileExporter& operator=(const MetricsFileExporter&) = delete;
+    void stop() {
+        {
+            auto lock = std::scoped_lock(m_mutex_stop);
+            if (m_is_stopped) return;
+            m_is_stopped = true;
+        }
+        m_cv_stop.notify_all();
+        if (m_thread != nullptr) m_thread->join();
+        m_thread = nullptr;
+        write_once();
+    }
+    bool write_once() {
+        const auto text = FormatPrometheusText(m_registry->GetSnapshot());
+        const auto temp_filepath = m_filepath + ".tmp";
+        FILE* fp = fopen(temp_filepath.c_str(), "wb");
+        if (fp == nullptr) {
+            fprintf(stderr, "Failed to open metrics file: '%s'\n", temp_filepath.c_str());
+            return false;
+        }
+        const size_t nb_written = fwrite(text.data(), sizeof(char), text.size(), fp);
+        fclose(fp);
+        if (nb_written != text.size()) return false;
+        #if _WIN32
+        // rename doesn't replace an existing file on windows
+        remove(m_filepath.c_str());
+        #endif
+        return rename(temp_filepath.c_str(), m_filepath.c_str()) == 0;
+    }
+private:
+    void run() {
+        auto lock = std::unique_lock(m_mutex_stop);
+        while (!m_is_stopped) {
+            m_cv_stop.wait_for(lock, m_interval, [this]() { return m_is_stopped; });
+            if (m_is_stopped) break;
+            lock.unlock();
+            write_once();
+            lock.lock();
+        }
+    }
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cstring>
+#include <new>
+
+#if !_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+// Block of memory whose second half maps onto the same pages as its first half
+// - A region starting anywhere in the first half can extend past its end and stay contiguous
+// - This lets a ring buffer hand out contiguous spans that wrap around without copying
+// - Where the pages can't be mapped twice the second half is a plain copy which the owner keeps in sync
+class MirroredMemory
+{
+private:
+    size_t m_size = 0;
+    uint8_t* m_data = nullptr;
+    bool m_is_mirrored = false;
+public:
+    // Size is rounded up to a multiple of the page size and alignment, which must be a power of 2
+    MirroredMemory(const size_t min_size, const size_t alignment) {
+        const size_t page_size = get_page_size();
+        const size_t unit = (alignment > page_size) ? alignment : page_size;
+        m_size = ((min_size + unit-1) / unit) * unit;
+        if (m_size == 0) m_size = unit;
+        m_is_mirrored = map_mirrored();
+        if (!m_is_mirrored) {
+            m_data = reinterpret_cast<uint8_t*>(operator new(2*m_size, std::align_val_t(page_size)));
+        }
+    }
+    ~MirroredMemory() {
+        if (m_data == nullptr) return;
+        #if !_WIN32
+        if (m_is_mirrored) {
+            munmap(m_data, 2*m_size);
+            return;
+        }
+        #endif
+        operator delete(m_data, std::align_val_t(get_page_size()));
+    }
+    MirroredMemory(const MirroredMemory&) = delete;
+    MirroredMemory(MirroredMemory&&) = delete;
+    MirroredMemory& operator=(const MirroredMemory&) = delete;
+    MirroredMemory& operator=(MirroredMemory&&) = delete;
+    // Size of one half
+    size_t get_size() const { return m_size; }
+    uint8_t* get_data() const { return m_data; }
+    bool get_is_mirrored() const { return m_is_mirrored; }
+    // Copies bytes written at [offset, offset+length) into the other half when the pages aren't shared
+    void sync(const size_t offset, const size_t length) {
+        if (m_is_mirrored || (length == 0)) return;
+        // Wrap into the first half and copy in at most two pieces since length can be up to the full size
+        const size_t start = offset % m_size;
+        const size_t length_0 = ((start + length) > m_size) ? (m_size - start) : length;
+        std::memcpy(m_data + start + m_size, m_data + start, length_0);
+        std::memcpy(m_data, m_data + m_size, length - length_0);
+    }
+private:
+    static size_t get_page_size() {
+        #if !_WIN32
+        const long page_size = sysconf(_SC_PAGESIZE);
+        return (page_size > 0) ? size_t(page_size) : size_t(4096);
+        #else
+        return size_t(4096);
+        #endif
+    }
+
+    bool map_mirrored() {
+        #if _WIN32
+        // NOTE: Windows requires placeholder mappings (VirtualAlloc2) which older versions don't have
+        return false;
+        #else
+        int fd = -1;
+        #if defined(__linux__) && defined(SYS_memfd_create)
+        fd = int(syscall(SYS_memfd_create, "mirrored_memory", 0));
+        #else
+        // Anonymous posix shared memory is unlinked straight away so only our mapping keeps it alive
+        char name[64];
+        snprintf(name, sizeof(name), "/mirrored_memory_%ld_%p", long(getpid()), reinterpret_cast<void*>(this));
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd >= 0) shm_unlink(name);
+        #endif
+        if (fd < 0) return false;
+        if (ftruncate(fd, off_t(m_size)) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        // Reserve address space for both halves then map the same pages into each half
+        void* base = mmap(nullptr, 2*m_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        auto* data = reinterpret_cast<uint8_t*>(base);
+        void* first = mmap(data, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        void* second = mmap(data + m_size, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        ::close(fd);
+        if ((first != data) || (second != (data + m_size))) {
+            munmap(base, 2*m_size);
+            return false;
+        }
+        m_data = data;
+        return true;
+        #endif
+    }
+};
@@ -3,15 +3,19 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <complex>
 #include <memory>
 #include <vector>
 #include "utility/span.h"
+#include "utility/thread_placement.h"
 #include "ofdm/dab_mapper_ref.h"
 #include "ofdm/dab_ofdm_params_ref.h"
 #include "ofdm/dab_prs_ref.h"
 #include "ofdm/ofdm_demodulator.h"
 #include "viterbi_config.h"
+#include "./app_frame_bus.h"
+#include "./app_frame_trace.h"
 #include "./app_io_buffers.h"
 
 class OFDM_Block 
@@ -19,32 +23,52 @@ class OFDM_Block
 private:
     std::shared_ptr<InputBuffer<std::complex<float>>> m_input_stream = nullptr;
     std::shared_ptr<OutputBuffer<viterbi_bit_t>> m_output_stream = nullptr;
+    std::shared_ptr<FrameBusPublisher> m_frame_bus = nullptr;
+    std::shared_ptr<FrameTraceQueue> m_frame_traces = nullptr;
     std::unique_ptr<OFDM_Demod> m_ofdm_demod = nullptr;
     std::vector<std::complex<float>> m_buffer;
+    tcb::span<const std::complex<float>> m_source_block;
 public:
-    OFDM_Block(const int transmission_mode, const size_t total_threads) {
+    OFDM_Block(const int transmission_mode, const size_t total_threads, const Thread_Placement& placement=Thread_Placement()) {
         const auto ofdm_params = get_DAB_OFDM_params(transmission_mode);
         auto ofdm_prs_ref = std::vector<std::complex<float>>(ofdm_params.nb_fft);
         get_DAB_PRS_reference(transmission_mode, ofdm_prs_ref);
         auto ofdm_mapper_ref = std::vector<int>(ofdm_params.nb_data_carriers);
         get_DAB_mapper_ref(ofdm_mapper_ref, ofdm_params.nb_fft);
-        m_ofdm_demod = std::make_unique<OFDM_Demod>(ofdm_params, ofdm_prs_ref, ofdm_mapper_ref, int(total_threads));
+        m_ofdm_demod = std::make_unique<OFDM_Demod>(ofdm_params, ofdm_prs_ref, ofdm_mapper_ref, int(total_threads), placement);
         m_ofdm_demod->On_OFDM_Frame().Attach([this](tcb::span<const viterbi_bit_t> buf){
+            if (m_frame_bus != nullptr) publish_frame(buf);
             if (m_output_stream == nullptr) return; 
+            if (m_frame_traces != nullptr) m_frame_traces->push(m_ofdm_demod->GetFrameTrace());
             m_output_stream->write(buf);
         });
     }
     auto& get_ofdm_demod() { return *(m_ofdm_demod.get()); }
-    tcb::span<const std::complex<float>> get_buffer() const { return m_buffer; }
+    // NOTE: When reading in place from a ring this can be overwritten by the producer while it is being used
+    tcb::span<const std::complex<float>> get_buffer() const { return m_source_block; }
     void set_input_stream(std::shared_ptr<InputBuffer<std::complex<float>>> stream) { 
         m_input_stream = stream; 
     }
     void set_output_stream(std::shared_ptr<OutputBuffer<viterbi_bit_t>> stream) { 
         m_output_stream = stream; 
     }
+    void set_frame_bus(std::shared_ptr<FrameBusPublisher> frame_bus) {
+        m_frame_bus = frame_bus;
+    }
+    // Traces of frames written to the output stream
+    void set_frame_traces(std::shared_ptr<FrameTraceQueue> frame_traces) {
+        m_frame_traces = frame_traces;
+    }
     void run(size_t block_size) {
         if (m_input_stream == nullptr) return;
+        // Demodulate in place from the ring instead of copying each block out of it
+        auto ring = std::dynamic_pointer_cast<ThreadedRingBuffer<std::complex<float>>>(m_input_stream);
+        if (ring != nullptr) {
+            run_ring(*(ring.get()), block_size);
+            return;
+        }
         m_buffer.resize(block_size);
+        m_source_block = m_buffer;
         bool is_finished = false;
         while (!is_finished) {
             const size_t length = m_input_stream->read(m_buffer);
@@ -56,4 +80,30 @@ public:
             m_ofdm_demod->Process(buf);
         }
     }
+private:
+    void run_ring(ThreadedRingBuffer<std::complex<float>>& ring, const size_t block_size) {
+        while (true) {
+            auto buf = ring.reserve_read(block_size);
+            if (buf.empty()) break;
+            buf = buf.first(std::min(buf.size(), block_size));
+            m_source_block = buf;
+            m_ofdm_demod->Process(buf);
+            ring.commit_read(buf.size());
+        }
+    }
+    void publish_frame(tcb::span<const viterbi_bit_t> buf) {
+        const auto& demod = *(m_ofdm_demod.get());
+        const auto& trace = demod.GetFrameTrace();
+        FrameBusMetadata metadata;
+        metadata.frame_index = trace.frame_index;
+        metadata.timestamp_ns = trace.timestamp_ns;
+        // NOTE: Only the data carriers at the start of each symbol are used by the DQPSK buffer
+        const auto params = demod.GetOFDMParams();
+        const auto vecs = demod.GetFrameDataVec().first((params.nb_frame_symbols-1)*params.nb_data_carriers);
+        metadata.snr_db = estimate_dqpsk_snr_db(vecs);
+        metadata.signal_level = demod.GetSignalAverage();
+        metadata.frequency_offset = demod.GetNetFrequencyOffset();
+        metadata.nb_bits = uint32_t(buf.size());
+        m_frame_bus->publish(buf, metadata);
+    }
 };
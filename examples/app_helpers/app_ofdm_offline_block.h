@@ -0,0 +1,254 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <atomic>
+#include <complex>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fmt/core.h>
+#include "utility/span.h"
+#include "ofdm/dab_mapper_ref.h"
+#include "ofdm/dab_ofdm_params_ref.h"
+#include "ofdm/dab_prs_ref.h"
+#include "ofdm/ofdm_demodulator.h"
+#include "viterbi_config.h"
+#include "./app_io_buffers.h"
+#include "./app_iq_readers.h"
+
+struct OFDM_Offline_Config {
+    size_t nb_frames_per_chunk = 64;
+    // Frames before each chunk that are demodulated to acquire sync but not output
+    size_t nb_lead_in_frames = 8;
+    size_t nb_workers = 0;      // 0 = number of cores
+    size_t block_size = 8192;
+};
+
+// Demodulates a recording by splitting it into frame aligned chunks which are processed concurrently
+// - Each chunk has its own demodulator that acquires sync during a lead in from the previous chunk
+// - Frames are identified by the input sample they end on which lets overlapping chunks be merged
+// - Chunks are written in order so the output is identical in layout to the realtime demodulator
+class OFDM_Offline_Block
+{
+private:
+    struct Frame {
+        uint64_t end_sample;
+        std::vector<viterbi_bit_t> bits;
+    };
+    struct Chunk {
+        bool is_done = false;
+        std::vector<Frame> frames;
+    };
+    const OFDM_Params m_params;
+    std::vector<std::complex<float>> m_prs_ref;
+    std::vector<int> m_mapper_ref;
+    const std::string m_filepath;
+    const std::string m_iq_mode;
+    const size_t m_sample_size;
+    OFDM_Offline_Config m_cfg;
+    OFDM_Demod_Config m_demod_cfg;
+    std::shared_ptr<OutputBuffer<viterbi_bit_t>> m_output_stream = nullptr;
+    // chunks
+    uint64_t m_total_samples = 0;
+    uint64_t m_chunk_samples = 0;
+    size_t m_max_pending_chunks = 0;
+    std::vector<Chunk> m_chunks;
+    size_t m_next_chunk = 0;
+    size_t m_next_output_chunk = 0;
+    std::mutex m_mutex_chunks;
+    std::condition_variable m_cv_chunks;
+    std::atomic<bool> m_is_stopped = false;
+    // statistics
+    size_t m_nb_frames_written = 0;
+    size_t m_nb_frames_missing = 0;
+public:
+    OFDM_Offline_Block(const int transmission_mode, const std::string& filepath, const std::string& iq_mode)
+    : m_params(get_DAB_OFDM_params(transmission_mode)),
+      m_filepath(filepath), m_iq_mode(iq_mode),
+      m_sample_size(get_iq_sample_size_from_mode_string(iq_mode))
+    {
+        if (m_sample_size == 0) {
+            throw std::runtime_error(fmt::format("Offline demodulation requires a raw IQ format but got '{}'", iq_mode));
+        }
+        m_prs_ref.resize(m_params.nb_fft);
+        get_DAB_PRS_reference(transmission_mode, m_prs_ref);
+        m_mapper_ref.resize(m_params.nb_data_carriers);
+        get_DAB_mapper_ref(m_mapper_ref, m_params.nb_fft);
+    }
+    auto& get_config() { return m_cfg; }
+    // Copied into the demodulator of each chunk
+    auto& get_demod_config() { return m_demod_cfg; }
+    size_t get_total_frames_written() const { return m_nb_frames_written; }
+    size_t get_total_frames_missing() const { return m_nb_frames_missing; }
+    size_t get_frame_samples() const { return m_params.nb_null_period + m_params.nb_frame_symbols*m_params.nb_symbol_period; }
+    void set_output_stream(std::shared_ptr<OutputBuffer<viterbi_bit_t>> stream) {
+        m_output_stream = stream;
+    }
+    void stop() {
+        m_is_stopped = true;
+        m_cv_chunks.notify_all();
+    }
+    // Returns once the whole file has been demodulated or the block was stopped
+    void run() {
+        FILE* fp = fopen(m_filepath.c_str(), "rb");
+        if (fp == nullptr) {
+            throw std::runtime_error(fmt::format("Failed to open input file: '{}'", m_filepath));
+        }
+        const uint64_t total_bytes = get_file_size(fp);
+        fclose(fp);
+
+        m_total_samples = total_bytes / uint64_t(m_sample_size);
+        m_chunk_samples = uint64_t(m_cfg.nb_frames_per_chunk) * uint64_t(get_frame_samples());
+        if (m_chunk_samples == 0 || m_total_samples == 0) return;
+        const size_t nb_chunks = size_t((m_total_samples + m_chunk_samples - 1) / m_chunk_samples);
+        m_chunks.clear();
+        m_chunks.resize(nb_chunks);
+        m_next_chunk = 0;
+        m_next_output_chunk = 0;
+
+        size_t nb_workers = m_cfg.nb_workers;
+        if (nb_workers == 0) nb_workers = size_t(std::thread::hardware_concurrency());
+        if (nb_workers == 0) nb_workers = 1;
+        if (nb_workers > nb_chunks) nb_workers = nb_chunks;
+        // Bound memory used by chunks that finished ahead of a slow chunk
+        m_max_pending_chunks = nb_workers*2;
+
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < nb_workers; i++) {
+            workers.emplace_back([this]() { run_worker(); });
+        }
+
+        uint64_t last_end_sample = 0;
+        bool is_first_frame = true;
+        for (size_t i = 0; i < nb_chunks; i++) {
+            std::vector<Frame> frames;
+            {
+                auto lock = std::unique_lock(m_mutex_chunks);
+                m_cv_chunks.wait(lock, [this, i]() { return m_chunks[i].is_done || m_is_stopped; });
+                if (!m_chunks[i].is_done) break;
+                frames = std::move(m_chunks[i].frames);
+                m_next_output_chunk = i+1;
+            }
+            m_cv_chunks.notify_all();
+            write_frames(frames, last_end_sample, is_first_frame);
+        }
+
+        stop();
+        for (auto& worker: workers) {
+            worker.join();
+        }
+    }
+private:
+    static uint64_t get_file_size(FILE* fp) {
+        #if _WIN32
+        _fseeki64(fp, 0, SEEK_END);
+        return uint64_t(_ftelli64(fp));
+        #else
+        fseeko(fp, 0, SEEK_END);
+        return uint64_t(ftello(fp));
+        #endif
+    }
+
+    static bool seek_file(FILE* fp, const uint64_t offset) {
+        #if _WIN32
+        return _fseeki64(fp, int64_t(offset), SEEK_SET) == 0;
+        #else
+        return fseeko(fp, off_t(offset), SEEK_SET) == 0;
+        #endif
+    }
+
+    // NOTE: FFTW plan creation and destruction isn't thread safe
+    static std::mutex& get_fftw_mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    void run_worker() {
+        while (true) {
+            size_t index = 0;
+            {
+                auto lock = std::unique_lock(m_mutex_chunks);
+                m_cv_chunks.wait(lock, [this]() {
+                    if (m_is_stopped || (m_next_chunk >= m_chunks.size())) return true;
+                    return m_next_chunk < (m_next_output_chunk + m_max_pending_chunks);
+                });
+                if (m_is_stopped || (m_next_chunk >= m_chunks.size())) return;
+                index = m_next_chunk++;
+            }
+            auto frames = demodulate_chunk(index);
+            {
+                auto lock = std::unique_lock(m_mutex_chunks);
+                m_chunks[index].frames = std::move(frames);
+                m_chunks[index].is_done = true;
+            }
+            m_cv_chunks.notify_all();
+        }
+    }
+
+    std::vector<Frame> demodulate_chunk(const size_t index) {
+        std::vector<Frame> frames;
+        const uint64_t lead_in_samples = uint64_t(m_cfg.nb_lead_in_frames) * uint64_t(get_frame_samples());
+        const uint64_t chunk_start = uint64_t(index) * m_chunk_samples;
+        const uint64_t chunk_end = std::min(chunk_start + m_chunk_samples, m_total_samples);
+        const uint64_t read_start = (chunk_start > lead_in_samples) ? (chunk_start - lead_in_samples) : 0;
+
+        FILE* fp = fopen(m_filepath.c_str(), "rb");
+        if (fp == nullptr) return frames;
+        auto file = std::make_shared<InputFile<uint8_t>>(fp);
+        if (!seek_file(fp, read_start*uint64_t(m_sample_size))) return frames;
+        auto iq_stream = get_iq_file_reader_from_mode_string(file, m_iq_mode);
+
+        std::unique_ptr<OFDM_Demod> demod = nullptr;
+        {
+            auto lock = std::scoped_lock(get_fftw_mutex());
+            demod = std::make_unique<OFDM_Demod>(m_params, m_prs_ref, m_mapper_ref, 1);
+        }
+        demod->GetConfig() = m_demod_cfg;
+        const auto* demod_ptr = demod.get();
+        demod->On_OFDM_Frame().Attach([&frames, demod_ptr, read_start](tcb::span<const viterbi_bit_t> buf) {
+            auto& frame = frames.emplace_back();
+            frame.end_sample = read_start + demod_ptr->GetFrameEndSample();
+            frame.bits.assign(buf.begin(), buf.end());
+        });
+
+        std::vector<std::complex<float>> buf(m_cfg.block_size);
+        uint64_t nb_remain = chunk_end - read_start;
+        while ((nb_remain > 0) && !m_is_stopped) {
+            const size_t N = size_t(std::min(nb_remain, uint64_t(buf.size())));
+            const size_t length = iq_stream->read(tcb::span(buf).first(N));
+            if (length == 0) break;
+            demod->Process(tcb::span(buf).first(length));
+            nb_remain -= uint64_t(length);
+        }
+        demod->Flush();
+        {
+            auto lock = std::scoped_lock(get_fftw_mutex());
+            demod = nullptr;
+        }
+        return frames;
+    }
+
+    void write_frames(tcb::span<const Frame> frames, uint64_t& last_end_sample, bool& is_first_frame) {
+        const uint64_t frame_samples = uint64_t(get_frame_samples());
+        for (const auto& frame: frames) {
+            if (!is_first_frame) {
+                // Frames from the lead in were already written by the previous chunk
+                if (frame.end_sample < (last_end_sample + frame_samples/2)) continue;
+                const uint64_t delta = frame.end_sample - last_end_sample;
+                const uint64_t nb_frames = (delta + frame_samples/2) / frame_samples;
+                if (nb_frames > 1) m_nb_frames_missing += size_t(nb_frames-1);
+            }
+            is_first_frame = false;
+            last_end_sample = frame.end_sample;
+            m_nb_frames_written++;
+            if (m_output_stream != nullptr) m_output_stream->write(frame.bits);
+        }
+    }
+};
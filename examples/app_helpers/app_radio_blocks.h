@@ -5,33 +5,90 @@
 #include <vector>
 #include "basic_radio/basic_radio.h"
 #include "dab/constants/dab_parameters.h"
+#include "utility/latency_histogram.h"
+#include "utility/thread_placement.h"
 #include "viterbi_config.h"
+#include "./app_frame_bus.h"
+#include "./app_frame_trace.h"
 #include "./app_io_buffers.h"
 
 class Basic_Radio_Block
 {
 private:
     std::shared_ptr<InputBuffer<viterbi_bit_t>> m_input_stream = nullptr;
+    std::shared_ptr<FrameBusSubscriber> m_frame_bus = nullptr;
+    std::shared_ptr<FrameTraceQueue> m_frame_traces = nullptr;
     std::unique_ptr<BasicRadio> m_basic_radio = nullptr;
     std::vector<viterbi_bit_t> m_bits_buffer;
     DAB_Parameters m_dab_params;
 public:
-    Basic_Radio_Block(const int transmission_mode, const size_t total_threads)
-    {
+    Basic_Radio_Block(
+        const int transmission_mode, const size_t total_threads, const Thread_Placement& placement=Thread_Placement(),
+        const BasicRadio_Viterbi_Config& viterbi_config=BasicRadio_Viterbi_Config()
+    ) {
         m_dab_params = get_dab_parameters(transmission_mode);
-        m_basic_radio = std::make_unique<BasicRadio>(m_dab_params, total_threads);
+        m_basic_radio = std::make_unique<BasicRadio>(m_dab_params, total_threads, placement, viterbi_config);
         m_bits_buffer.resize(m_dab_params.nb_frame_bits);
     }
     BasicRadio& get_basic_radio() { return *(m_basic_radio.get()); }
     void set_input_stream(std::shared_ptr<InputBuffer<viterbi_bit_t>> stream) { 
         m_input_stream = stream; 
     }
+    // Frames are decoded in place from the bus without copying them into a stream
+    void set_frame_bus(std::shared_ptr<FrameBusSubscriber> frame_bus) {
+        m_frame_bus = frame_bus;
+    }
+    // Traces of frames read from the input stream
+    void set_frame_traces(std::shared_ptr<FrameTraceQueue> frame_traces) {
+        m_frame_traces = frame_traces;
+    }
     void run() {
+        if (m_frame_bus != nullptr) {
+            run_frame_bus();
+            return;
+        }
         if (m_input_stream == nullptr) return;  
+        // Decode frames in place from the ring instead of copying each frame out of it
+        auto ring = std::dynamic_pointer_cast<ThreadedRingBuffer<viterbi_bit_t>>(m_input_stream);
+        if (ring != nullptr) {
+            run_ring(*(ring.get()));
+            return;
+        }
         while (true) {
             const size_t length = m_input_stream->read(m_bits_buffer);
             if (length != m_bits_buffer.size()) return;
-            m_basic_radio->Process(m_bits_buffer);
+            process_frame(m_bits_buffer);
+        }
+    }
+private:
+    // NOTE: The ring must hold at least one frame
+    void run_ring(ThreadedRingBuffer<viterbi_bit_t>& ring) {
+        const size_t nb_frame_bits = m_bits_buffer.size();
+        while (true) {
+            const auto buf = ring.reserve_read(nb_frame_bits);
+            if (buf.size() < nb_frame_bits) return;
+            process_frame(buf.first(nb_frame_bits));
+            ring.commit_read(nb_frame_bits);
+        }
+    }
+    void process_frame(tcb::span<const viterbi_bit_t> buf) {
+        const auto trace = (m_frame_traces != nullptr) ? m_frame_traces->pop() : Frame_Trace{};
+        if (trace.IsValid()) {
+            m_basic_radio->Process(buf, trace);
+        } else {
+            m_basic_radio->Process(buf);
+        }
+    }
+    void run_frame_bus() {
+        FrameBusFrame frame;
+        while (m_frame_bus->read(frame)) {
+            if (frame.bits.size() != m_bits_buffer.size()) continue;
+            // NOTE: The sample index isn't published on the bus
+            Frame_Trace trace;
+            trace.frame_index = frame.metadata.frame_index;
+            trace.timestamp_ns = frame.metadata.timestamp_ns;
+            m_basic_radio->Process(frame.bits, trace);
         }
+        m_frame_bus->release();
     }
 };
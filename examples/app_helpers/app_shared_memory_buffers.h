@@ -0,0 +1,378 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <fmt/core.h>
+#include "utility/span.h"
+#include "./app_io_buffers.h"
+
+#if !_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+#endif
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory atomics must be lock free to be address free");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory atomics must be lock free to be address free");
+
+#if !_WIN32
+
+// Named posix shared memory region which is unlinked when the owner is destroyed
+class SharedMemoryRegion
+{
+private:
+    const std::string m_name;
+    const bool m_is_owner;
+    int m_fd = -1;
+    size_t m_size = 0;
+    uint8_t* m_data = nullptr;
+public:
+    // Owner creates a zero filled region, otherwise an existing region is opened with whatever size it has
+    SharedMemoryRegion(const std::string& name, const size_t size, const bool is_owner)
+    : m_name(name), m_is_owner(is_owner)
+    {
+        if (m_is_owner) {
+            shm_unlink(m_name.c_str());
+            m_fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        } else {
+            m_fd = shm_open(m_name.c_str(), O_RDWR, 0600);
+        }
+        if (m_fd < 0) {
+            throw std::runtime_error(fmt::format("Failed to open shared memory '{}' ({})", m_name, strerror(errno)));
+        }
+
+        if (m_is_owner) {
+            m_size = size;
+            if (ftruncate(m_fd, off_t(m_size)) != 0) {
+                close_handles();
+                throw std::runtime_error(fmt::format("Failed to resize shared memory '{}' ({})", m_name, strerror(errno)));
+            }
+        } else {
+            struct stat info;
+            if ((fstat(m_fd, &info) != 0) || (info.st_size <= 0)) {
+                close_handles();
+                throw std::runtime_error(fmt::format("Shared memory '{}' is empty", m_name));
+            }
+            m_size = size_t(info.st_size);
+        }
+
+        void* ptr = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (ptr == MAP_FAILED) {
+            close_handles();
+            throw std::runtime_error(fmt::format("Failed to map shared memory '{}' ({})", m_name, strerror(errno)));
+        }
+        m_data = reinterpret_cast<uint8_t*>(ptr);
+    }
+    ~SharedMemoryRegion() {
+        close_handles();
+        if (m_is_owner) shm_unlink(m_name.c_str());
+    }
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+    const std::string& get_name() const { return m_name; }
+    bool get_is_owner() const { return m_is_owner; }
+    size_t get_size() const { return m_size; }
+    uint8_t* get_data() const { return m_data; }
+private:
+    void close_handles() {
+        if (m_data != nullptr) {
+            munmap(m_data, m_size);
+            m_data = nullptr;
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+};
+
+#else
+
+// Windows has no posix shared memory so opening a region always fails
+class SharedMemoryRegion
+{
+public:
+    SharedMemoryRegion(const std::string& name, const size_t size, const bool is_owner) {
+        throw std::runtime_error(fmt::format("Shared memory '{}' is not supported on windows", name));
+    }
+    const std::string& get_name() const { static const std::string name; return name; }
+    bool get_is_owner() const { return false; }
+    size_t get_size() const { return 0; }
+    uint8_t* get_data() const { return nullptr; }
+};
+
+#endif
+
+// Wakes every process sleeping on a futex word in shared memory
+static inline void shared_memory_wake_all(std::atomic<uint32_t>& word) {
+    #if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+    #else
+    (void)word;
+    #endif
+}
+
+// Sleeps while the futex word still holds the expected value
+// NOTE: Timeout guards against a writer that exited without closing the stream
+static inline void shared_memory_wait(std::atomic<uint32_t>& word, const uint32_t expected) {
+    #if defined(__linux__)
+    struct timespec timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_nsec = 100'000'000;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+    #else
+    if (word.load(std::memory_order_acquire) == expected) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    #endif
+}
+
+// Ring buffer in a named shared memory region so processes can exchange a stream without pipes
+// - There is a single writer and up to MAX_READERS readers which each keep their own read position
+// - The writer never blocks since a tuner can't be paused. A reader that falls too far behind
+//   skips ahead to recent data and counts the bytes it dropped
+// - Data is written once into shared memory so adding another reader doesn't add another copy
+// - Readers sleep on a futex (linux) or poll (other posix) until the writer publishes more data
+struct SharedMemoryRingHeader {
+    static constexpr uint32_t MAGIC = 0x51524D53; // "SMRQ"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t MAX_READERS = 8;
+    struct Reader {
+        std::atomic<uint32_t> is_active;
+        alignas(64) std::atomic<uint64_t> read_count;
+    };
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    std::atomic<uint32_t> is_closed;
+    // Bytes up to write_reserve may be in the middle of being written, bytes up to write_count are published
+    alignas(64) std::atomic<uint64_t> write_reserve;
+    std::atomic<uint64_t> write_count;
+    // futex word which is bumped whenever data is published or the stream is closed
+    alignas(64) std::atomic<uint32_t> write_sequence;
+    std::atomic<uint32_t> nb_waiting_readers;
+    alignas(64) Reader readers[MAX_READERS];
+};
+
+class SharedMemoryRing
+{
+private:
+    SharedMemoryRegion m_region;
+    SharedMemoryRingHeader* m_header = nullptr;
+    uint8_t* m_data = nullptr;
+public:
+    // Writer creates the region, readers open an existing region
+    SharedMemoryRing(const std::string& name, const size_t capacity, const bool is_owner)
+    : m_region(name, sizeof(SharedMemoryRingHeader) + capacity, is_owner)
+    {
+        if (m_region.get_size() < sizeof(SharedMemoryRingHeader)) {
+            throw std::runtime_error(fmt::format("Shared memory '{}' is not a ring buffer", name));
+        }
+        m_header = reinterpret_cast<SharedMemoryRingHeader*>(m_region.get_data());
+        m_data = m_region.get_data() + sizeof(SharedMemoryRingHeader);
+
+        if (is_owner) {
+            // NOTE: ftruncate zero fills the region so the atomics start at zero
+            m_header->capacity = capacity;
+            m_header->version = SharedMemoryRingHeader::VERSION;
+            std::atomic_thread_fence(std::memory_order_release);
+            m_header->magic = SharedMemoryRingHeader::MAGIC;
+        } else {
+            const bool is_valid =
+                (m_header->magic == SharedMemoryRingHeader::MAGIC) &&
+                (m_header->version == SharedMemoryRingHeader::VERSION) &&
+                ((sizeof(SharedMemoryRingHeader) + m_header->capacity) <= m_region.get_size());
+            if (!is_valid) {
+                throw std::runtime_error(fmt::format("Shared memory '{}' has an incompatible header", name));
+            }
+        }
+    }
+    ~SharedMemoryRing() {
+        if (m_region.get_is_owner()) close();
+    }
+    SharedMemoryRing(const SharedMemoryRing&) = delete;
+    SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+    size_t get_capacity() const { return size_t(m_header->capacity); }
+    bool get_is_closed() const { return m_header->is_closed.load(std::memory_order_acquire) != 0; }
+
+    void close() {
+        m_header->is_closed.store(1, std::memory_order_release);
+        publish();
+    }
+
+    // Writer only
+    size_t write(tcb::span<const uint8_t> src) {
+        const size_t N = get_capacity();
+        // Only the newest data is kept if the source is larger than the ring
+        if (src.size() > N) src = src.last(N);
+        const uint64_t write_count = m_header->write_count.load(std::memory_order_relaxed);
+        // Readers check the reservation after copying to detect if we overwrote their data
+        m_header->write_reserve.store(write_count + src.size(), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        copy_circular(size_t(write_count % N), src);
+        m_header->write_count.store(write_count + src.size(), std::memory_order_release);
+        publish();
+        return src.size();
+    }
+
+    // Reader slots
+    int acquire_reader() {
+        for (size_t i = 0; i < SharedMemoryRingHeader::MAX_READERS; i++) {
+            auto& reader = m_header->readers[i];
+            uint32_t expected = 0;
+            if (!reader.is_active.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) continue;
+            // Start from live data instead of whatever is left in the ring
+            reader.read_count.store(m_header->write_count.load(std::memory_order_acquire), std::memory_order_release);
+            return int(i);
+        }
+        return -1;
+    }
+
+    void release_reader(const int index) {
+        if (index < 0) return;
+        m_header->readers[index].is_active.store(0, std::memory_order_release);
+    }
+
+    // Returns the number of bytes read into dest which is a multiple of alignment
+    // Blocks until some data is available or the writer has closed the stream
+    size_t read(
+        const int index, tcb::span<uint8_t> dest, const size_t alignment,
+        uint64_t& nb_dropped, const std::atomic<bool>& is_cancelled
+    ) {
+        auto& reader = m_header->readers[index];
+        const size_t N = get_capacity();
+        dest = dest.first(dest.size() - (dest.size() % alignment));
+        while (true) {
+            const uint32_t sequence = m_header->write_sequence.load(std::memory_order_acquire);
+            const uint64_t write_count = m_header->write_count.load(std::memory_order_acquire);
+            uint64_t read_count = reader.read_count.load(std::memory_order_relaxed);
+
+            // Skip ahead to the middle of the ring so we have some headroom before being lapped again
+            if ((write_count - read_count) > N) {
+                uint64_t new_read_count = write_count - N/2;
+                new_read_count += (alignment - (new_read_count - read_count) % alignment) % alignment;
+                nb_dropped += new_read_count - read_count;
+                read_count = new_read_count;
+                reader.read_count.store(read_count, std::memory_order_release);
+            }
+
+            size_t length = size_t(write_count - read_count);
+            length = (length > dest.size()) ? dest.size() : length;
+            length -= length % alignment;
+            if (length > 0) {
+                copy_from_circular(size_t(read_count % N), dest.first(length));
+                // The writer may have overwritten what we were copying
+                std::atomic_thread_fence(std::memory_order_acquire);
+                const uint64_t write_reserve = m_header->write_reserve.load(std::memory_order_relaxed);
+                if ((write_reserve - read_count) > N) continue;
+                reader.read_count.store(read_count + length, std::memory_order_release);
+                return length;
+            }
+
+            if (get_is_closed() || is_cancelled) return 0;
+            wait(sequence);
+        }
+    }
+private:
+    void copy_circular(const size_t offset, tcb::span<const uint8_t> src) {
+        const size_t N = get_capacity();
+        const size_t length_0 = (src.size() > (N-offset)) ? (N-offset) : src.size();
+        std::memcpy(m_data + offset, src.data(), length_0);
+        std::memcpy(m_data, src.data() + length_0, src.size() - length_0);
+    }
+
+    void copy_from_circular(const size_t offset, tcb::span<uint8_t> dest) const {
+        const size_t N = get_capacity();
+        const size_t length_0 = (dest.size() > (N-offset)) ? (N-offset) : dest.size();
+        std::memcpy(dest.data(), m_data + offset, length_0);
+        std::memcpy(dest.data() + length_0, m_data, dest.size() - length_0);
+    }
+
+    void publish() {
+        m_header->write_sequence.fetch_add(1, std::memory_order_acq_rel);
+        // Avoid the syscall when nobody is waiting
+        if (m_header->nb_waiting_readers.load(std::memory_order_acquire) == 0) return;
+        shared_memory_wake_all(m_header->write_sequence);
+    }
+
+    void wait(const uint32_t sequence) {
+        m_header->nb_waiting_readers.fetch_add(1, std::memory_order_acq_rel);
+        shared_memory_wait(m_header->write_sequence, sequence);
+        m_header->nb_waiting_readers.fetch_sub(1, std::memory_order_acq_rel);
+    }
+};
+
+template <typename T>
+class SharedMemoryOutputBuffer: public OutputBuffer<T>
+{
+private:
+    SharedMemoryRing m_ring;
+public:
+    SharedMemoryOutputBuffer(const std::string& name, const size_t capacity_bytes)
+    : m_ring(name, capacity_bytes - (capacity_bytes % sizeof(T)), true) {}
+    ~SharedMemoryOutputBuffer() override = default;
+    void close() { m_ring.close(); }
+    size_t write(tcb::span<const T> src) override {
+        const auto src_bytes = tcb::span<const uint8_t>(
+            reinterpret_cast<const uint8_t*>(src.data()),
+            src.size()*sizeof(T)
+        );
+        return m_ring.write(src_bytes) / sizeof(T);
+    }
+};
+
+template <typename T>
+class SharedMemoryInputBuffer: public InputBuffer<T>
+{
+private:
+    SharedMemoryRing m_ring;
+    int m_reader_index = -1;
+    uint64_t m_nb_dropped_bytes = 0;
+    std::atomic<bool> m_is_closed = false;
+public:
+    explicit SharedMemoryInputBuffer(const std::string& name)
+    : m_ring(name, 0, false)
+    {
+        m_reader_index = m_ring.acquire_reader();
+        if (m_reader_index < 0) {
+            throw std::runtime_error(fmt::format(
+                "Shared memory '{}' already has the maximum of {} readers",
+                name, SharedMemoryRingHeader::MAX_READERS
+            ));
+        }
+    }
+    ~SharedMemoryInputBuffer() override {
+        m_ring.release_reader(m_reader_index);
+    }
+    // Stops this reader without closing the stream for other readers
+    void close() { m_is_closed = true; }
+    uint64_t get_total_dropped_bytes() const { return m_nb_dropped_bytes; }
+    // Blocks until dest is filled or the stream is closed like a file
+    size_t read(tcb::span<T> dest) override {
+        auto dest_bytes = tcb::span<uint8_t>(
+            reinterpret_cast<uint8_t*>(dest.data()),
+            dest.size()*sizeof(T)
+        );
+        size_t total_read = 0;
+        while (!dest_bytes.empty() && !m_is_closed) {
+            const size_t length = m_ring.read(m_reader_index, dest_bytes, sizeof(T), m_nb_dropped_bytes, m_is_closed);
+            if (length == 0) break;
+            total_read += length;
+            dest_bytes = dest_bytes.subspan(length);
+        }
+        return total_read / sizeof(T);
+    }
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <optional>
+#include <string>
+#include <vector>
+#include "utility/thread_placement.h"
+
+// Parses a cpu list in the same format as taskset and /sys/devices/system/node/node*/cpulist, e.g. "0-3,8,10-11"
+static std::optional<std::vector<int>> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        const auto range = list.substr(start, end-start);
+        start = end+1;
+        if (range.empty()) return std::nullopt;
+
+        const size_t dash = range.find('-');
+        const auto first_str = range.substr(0, dash);
+        const auto last_str = (dash == std::string::npos) ? first_str : range.substr(dash+1);
+        if (first_str.empty() || last_str.empty()) return std::nullopt;
+        char* first_end = nullptr;
+        char* last_end = nullptr;
+        const long first = strtol(first_str.c_str(), &first_end, 10);
+        const long last = strtol(last_str.c_str(), &last_end, 10);
+        if ((*first_end != '\0') || (*last_end != '\0')) return std::nullopt;
+        if ((first < 0) || (last < first) || (last > 65535)) return std::nullopt;
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(int(cpu));
+        }
+    }
+    return cpus;
+}
+
+static void print_placement_report(FILE* fp, const char* owner, const Thread_Placement_Report& report) {
+    fprintf(fp, "placement of %s\n", owner);
+    for (const auto& thread: report.GetThreads()) {
+        fprintf(fp, "  thread %-32s cpu=%-3d node=%-2d %s\n",
+            thread.name.c_str(), thread.cpu, thread.numa_node, thread.is_pinned ? "pinned" : "floating");
+    }
+    for (const auto& memory: report.GetMemory()) {
+        fprintf(fp, "  memory %-32s size=%.2fMB node=%-2d huge_pages=%s locked=%s\n",
+            memory.name.c_str(), double(memory.nb_bytes)/double(1u << 20), memory.numa_node,
+            memory.is_huge_pages ? "yes" : "no", memory.is_locked ? "yes" : "no");
+    }
+}
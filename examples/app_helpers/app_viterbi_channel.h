@@ -0,0 +1,157 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "dab/algorithms/dab_viterbi_decoder.h"
+#include "dab/constants/puncture_codes.h"
+#include "utility/span.h"
+#include "viterbi_config.h"
+
+// Block of bytes that is convolutionally encoded and punctured like a DAB subchannel
+// DOC: ETSI EN 300 401
+// Clause 11.1.1 - Mother code with the same polynomials as DAB_Viterbi_Decoder
+// Clause 11.1.2 - Every byte is 32 symbols of the mother code which are punctured by one PI vector
+//                 The 6 tail bits are 24 symbols which are punctured by PI_X
+struct ViterbiBlockLayout {
+    static constexpr size_t TOTAL_TAIL_BITS = 6;
+    size_t nb_bytes = 96;
+    int puncture_code = 16;
+    size_t get_total_encoded_bits() const {
+        size_t total_pi = 0;
+        for (const auto count: GetPunctureCode(puncture_code)) total_pi += size_t(count);
+        size_t total_pi_x = 0;
+        for (const auto count: PI_X) total_pi_x += size_t(count);
+        return nb_bytes*total_pi + total_pi_x;
+    }
+    float get_code_rate() const {
+        return float(nb_bytes*8) / float(get_total_encoded_bits());
+    }
+};
+
+// Returns the punctured code bits as 0 or 1
+static std::vector<uint8_t> encode_viterbi_block(const ViterbiBlockLayout& layout, tcb::span<const uint8_t> bytes) {
+    assert(bytes.size() == layout.nb_bytes);
+    constexpr size_t K = DAB_Viterbi_Decoder::m_constraint_length;
+    constexpr size_t R = DAB_Viterbi_Decoder::m_code_rate;
+    // Reversed form of the polynomials so the newest bit is the least significant bit of the register
+    constexpr uint8_t G[R] = { 109, 79, 83, 109 };
+    constexpr uint32_t REGISTER_MASK = (1u << K) - 1u;
+
+    std::vector<uint8_t> encoded;
+    encoded.reserve(layout.get_total_encoded_bits());
+    uint32_t reg = 0;
+    auto encode_bit = [&reg, &encoded, &G](const uint8_t bit, const size_t total_kept) {
+        reg = ((reg << 1) | bit) & REGISTER_MASK;
+        for (size_t r = 0; r < total_kept; r++) {
+            const uint32_t taps = reg & uint32_t(G[r]);
+            uint32_t parity = 0;
+            for (size_t k = 0; k < K; k++) parity ^= (taps >> k) & 0b1;
+            encoded.push_back(uint8_t(parity));
+        }
+    };
+
+    // NOTE: Puncture vectors only ever remove the last symbols in each group of 4
+    const auto puncture_code = GetPunctureCode(layout.puncture_code);
+    size_t index_code = 0;
+    for (const uint8_t byte: bytes) {
+        for (size_t i = 0; i < 8; i++) {
+            const uint8_t bit = (byte >> (7-i)) & 0b1;
+            encode_bit(bit, size_t(puncture_code[index_code]));
+            index_code = (index_code+1) % puncture_code.size();
+        }
+    }
+    for (size_t i = 0; i < ViterbiBlockLayout::TOTAL_TAIL_BITS; i++) {
+        encode_bit(0, size_t(PI_X[i]));
+    }
+    assert(encoded.size() == layout.get_total_encoded_bits());
+    return encoded;
+}
+
+// Returns the error metric of the decoder
+static uint64_t decode_viterbi_block(
+    const ViterbiBlockLayout& layout, DAB_Viterbi_Decoder& decoder,
+    tcb::span<const viterbi_bit_t> soft_bits, tcb::span<uint8_t> bytes_out
+) {
+    assert(soft_bits.size() == layout.get_total_encoded_bits());
+    assert(bytes_out.size() == layout.nb_bytes);
+    constexpr size_t R = DAB_Viterbi_Decoder::m_code_rate;
+    decoder.reset();
+    const size_t N = decoder.update(soft_bits, GetPunctureCode(layout.puncture_code), layout.nb_bytes*8*R);
+    decoder.update(soft_bits.subspan(N), PI_X, ViterbiBlockLayout::TOTAL_TAIL_BITS*R);
+    return decoder.chainback(bytes_out);
+}
+
+// Frame filled with encoded blocks back to back
+// Information bytes come from a seeded generator so the receiver can recreate the payload
+struct ViterbiFramePayload {
+    size_t nb_blocks = 0;
+    std::vector<uint8_t> tx_bytes;          // nb_blocks*nb_bytes
+    std::vector<uint8_t> encoded_bits;      // nb_frame_bits with unused bits at the end set to 0
+};
+
+static ViterbiFramePayload create_viterbi_frame_payload(
+    const ViterbiBlockLayout& layout, const size_t nb_frame_bits, const uint32_t seed
+) {
+    ViterbiFramePayload payload;
+    const size_t nb_block_bits = layout.get_total_encoded_bits();
+    payload.nb_blocks = nb_frame_bits / nb_block_bits;
+    payload.tx_bytes.resize(payload.nb_blocks*layout.nb_bytes);
+    payload.encoded_bits.resize(nb_frame_bits, 0);
+    auto rng = std::mt19937(seed);
+    for (auto& byte: payload.tx_bytes) byte = uint8_t(rng());
+    for (size_t i = 0; i < payload.nb_blocks; i++) {
+        const auto tx_bytes = tcb::span<const uint8_t>(payload.tx_bytes).subspan(i*layout.nb_bytes, layout.nb_bytes);
+        const auto encoded_bits = encode_viterbi_block(layout, tx_bytes);
+        std::copy(encoded_bits.begin(), encoded_bits.end(), payload.encoded_bits.begin() + i*nb_block_bits);
+    }
+    return payload;
+}
+
+static size_t count_bit_errors(tcb::span<const uint8_t> x0, tcb::span<const uint8_t> x1) {
+    assert(x0.size() == x1.size());
+    size_t total_errors = 0;
+    for (size_t i = 0; i < x0.size(); i++) {
+        uint8_t diff = x0[i] ^ x1[i];
+        for (; diff != 0; diff &= uint8_t(diff-1)) total_errors++;
+    }
+    return total_errors;
+}
+
+// QPSK channel with additive white gaussian noise
+// Soft decisions are normalised by the L1 norm of each carrier the same way as the OFDM demodulator
+// DOC: docs/DAB_implementation_in_SDR_detailed.pdf
+// Clause 3.16.2 - QPSK symbol demapper: bit=1 is sent as a negative real or imaginary component
+class QPSK_AWGN_Channel
+{
+private:
+    std::mt19937 m_rng;
+    std::normal_distribution<float> m_noise {0.0f, 1.0f};
+public:
+    explicit QPSK_AWGN_Channel(const uint32_t seed): m_rng(seed) {}
+    // Eb/N0 is measured for information bits so the code rate is needed to scale the noise
+    void transmit(
+        tcb::span<const uint8_t> bits, tcb::span<viterbi_bit_t> soft_bits,
+        const float EbN0_dB, const float code_rate
+    ) {
+        assert(bits.size() == soft_bits.size());
+        const float A = 1.0f/std::sqrt(2.0f);
+        const float EsN0 = std::pow(10.0f, EbN0_dB/10.0f) * 2.0f * code_rate;
+        const float sigma = std::sqrt(1.0f/(2.0f*EsN0));
+        const size_t N = bits.size();
+        for (size_t i = 0; i < N; i+=2) {
+            const uint8_t b0 = bits[i];
+            const uint8_t b1 = ((i+1) < N) ? bits[i+1] : 0;
+            const float re = (b0 ? -A : A) + m_noise(m_rng)*sigma;
+            const float im = (b1 ? -A : A) + m_noise(m_rng)*sigma;
+            const float norm = std::max(std::abs(re), std::abs(im));
+            constexpr float scale = float(SOFT_DECISION_VITERBI_HIGH);
+            soft_bits[i] = viterbi_bit_t(-re/norm*scale);
+            if ((i+1) < N) soft_bits[i+1] = viterbi_bit_t(-im/norm*scale);
+        }
+    }
+};
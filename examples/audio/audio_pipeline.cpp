@@ -2,15 +2,19 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 #include <limits>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <utility>
 #include <vector>
 #include "utility/span.h"
 #include "./frame.h"
+#include "./polyphase_resampler.h"
 
 template <typename T, typename U, typename F>
 static void audio_map_with_callback(tcb::span<const Frame<T>> src, tcb::span<Frame<U>> dest, F&& func) {
@@ -69,10 +73,12 @@ AudioPipelineSource::AudioPipelineSource(float sampling_rate, size_t buffer_leng
 
 void AudioPipelineSource::write(tcb::span<const Frame<int16_t>> src, float src_sampling_rate, bool is_blocking) {
     const float gain = m_gain / float(std::numeric_limits<int16_t>::max());
-    const size_t resample_length = size_t(float(src.size()) * m_sampling_rate / src_sampling_rate);
-    m_resampling_buffer.resize(resample_length);
+    const auto input_rate = uint32_t(src_sampling_rate);
+    const auto output_rate = uint32_t(m_sampling_rate);
 
-    if (resample_length == src.size()) {
+    if (input_rate == output_rate) {
+        m_resampler = nullptr;
+        m_resampling_buffer.resize(src.size());
         audio_map_with_callback<int16_t,float>(
             src, m_resampling_buffer, 
             [gain](Frame<float>& v_dest, const Frame<int16_t>& v_src) {
@@ -80,39 +86,31 @@ void AudioPipelineSource::write(tcb::span<const Frame<int16_t>> src, float src_s
             }
         );
     } else {
-        audio_resample_with_callback<int16_t,float>(
-            src, m_resampling_buffer, 
-            [gain](Frame<float>& v_dest, const Frame<float>& v_src) {
-                v_dest = v_src * gain;
-            }
-        );
-    }
-
-    auto lock = std::unique_lock(m_mutex_ring_buffer);
-    if (!is_blocking) {
-        m_ring_buffer.write_forcefully(m_resampling_buffer);
-        return;
+        if ((m_resampler == nullptr) || (m_resampler->get_input_rate() != input_rate)) {
+            m_resampler = std::make_unique<PolyphaseResampler>(input_rate, output_rate);
+        }
+        m_resampler->process(src, m_resampling_buffer, gain);
     }
 
-    auto read_buffer = tcb::span<const Frame<float>>(m_resampling_buffer);
+    // NOTE: The consumer owns the read position so we drop the newest samples if there is no room
+    auto write_buffer = tcb::span<const Frame<float>>(m_resampling_buffer);
     while (true) {
-        const size_t total_read = m_ring_buffer.write(read_buffer);
-        read_buffer = read_buffer.subspan(total_read);
-        if (read_buffer.empty()) break;
-        m_cv_ring_buffer.wait(lock, [this]{ 
-            return !m_ring_buffer.is_full();
-        });
+        const size_t total_written = m_ring_buffer.write(write_buffer);
+        write_buffer = write_buffer.subspan(total_written);
+        if (write_buffer.empty()) break;
+        if (!is_blocking) break;
+        // Wait for the audio callback to consume roughly what we still have to write
+        const auto nb_remain = std::min(write_buffer.size(), m_ring_buffer.get_size());
+        const auto wait_time = std::chrono::duration<float>(float(nb_remain) / m_sampling_rate);
+        std::this_thread::sleep_for(wait_time);
     }
 }
 
 bool AudioPipelineSource::read(tcb::span<Frame<float>> dest) {
-    auto lock = std::unique_lock(m_mutex_ring_buffer);
     if (m_ring_buffer.get_total_used() < dest.size()) {
         return false;
     }
     m_ring_buffer.read(dest);
-    lock.unlock();
-    m_cv_ring_buffer.notify_one();
     return true;
 }
 
@@ -135,7 +133,17 @@ size_t AudioPipeline::mix_sources_to_sink(tcb::span<Frame<float>> dest, float de
     std::vector<std::shared_ptr<AudioPipelineSource>> sources;
     {
         auto lock = std::scoped_lock(m_mutex_sources);
-        sources = m_sources;
+        sources.reserve(m_sources.size());
+        auto it = m_sources.begin();
+        while (it != m_sources.end()) {
+            auto source = it->lock();
+            if (source == nullptr) {
+                it = m_sources.erase(it);
+                continue;
+            }
+            sources.push_back(std::move(source));
+            ++it;
+        }
     }
     size_t total_sources_mixed = 0;
     for (auto& source: sources) {
@@ -2,7 +2,6 @@
 
 #include <stddef.h>
 #include <stdint.h>
-#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -10,7 +9,8 @@
 #include <vector>
 #include "utility/span.h"
 #include "./frame.h"
-#include "./ring_buffer.h"
+#include "./polyphase_resampler.h"
+#include "./spsc_ring_buffer.h"
 
 constexpr float DEFAULT_AUDIO_SAMPLE_RATE = 48000.0f;
 constexpr float DEFAULT_AUDIO_SINK_DURATION = 0.1f;
@@ -27,30 +27,31 @@ public:
     virtual std::string_view get_name() const = 0;
 };
 
+// Decoder thread writes and the audio callback reads without either of them taking a lock
 class AudioPipelineSource 
 {
 private:
     const float m_sampling_rate;
     float m_gain = 1.0f;
 
+    std::unique_ptr<PolyphaseResampler> m_resampler;
     std::vector<Frame<float>> m_resampling_buffer;
-    RingBuffer<Frame<float>> m_ring_buffer;
-    std::vector<Frame<float>> m_read_buffer;
-
-    std::mutex m_mutex_ring_buffer;
-    std::condition_variable m_cv_ring_buffer;
+    SPSCRingBuffer<Frame<float>> m_ring_buffer;
 public:
     explicit AudioPipelineSource(float sampling_rate=DEFAULT_AUDIO_SAMPLE_RATE, size_t buffer_length=DEFAULT_AUDIO_SOURCE_SAMPLES);
     void write(tcb::span<const Frame<int16_t>> src, float src_sampling_rate, bool is_blocking); 
     bool read(tcb::span<Frame<float>> dest);
     float get_sampling_rate() const { return m_sampling_rate; }
+    // Seconds of audio waiting to be read by the sink
+    float get_buffered_duration() const { return float(m_ring_buffer.get_total_used()) / m_sampling_rate; }
 };
 
 class AudioPipeline
 {
 private:
     float m_global_gain = 1.0f;
-    std::vector<std::shared_ptr<AudioPipelineSource>> m_sources;
+    // Sources are owned by whoever writes to them so their buffers are freed once that writer is gone
+    std::vector<std::weak_ptr<AudioPipelineSource>> m_sources;
     std::unique_ptr<AudioPipelineSink> m_sink = nullptr;
     std::vector<Frame<float>> m_read_buffer;
     std::mutex m_mutex_sources;
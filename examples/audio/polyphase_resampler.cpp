@@ -0,0 +1,255 @@
+#define _USE_MATH_DEFINES
+#include "./polyphase_resampler.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+#include "detect_architecture.h"
+#include "simd_flags.h" // NOLINT
+#include "utility/span.h"
+#include "./frame.h"
+
+// Kaiser window with beta=8 gives roughly 80dB of stopband attenuation
+constexpr double KAISER_BETA = 8.0;
+// Fraction of the lower nyquist frequency that is kept
+constexpr double PASSBAND_RATIO = 0.90;
+
+// Zeroth order modified bessel function of the first kind
+static double bessel_i0(const double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    const double y = x*x/4.0;
+    for (int k = 1; k < 32; k++) {
+        term *= y / double(k*k);
+        sum += term;
+        if (term < sum*1e-12) break;
+    }
+    return sum;
+}
+
+// y = [Σ h(k)*x_left(k), Σ h(k)*x_right(k)]
+// Filter taps are duplicated so they line up with interleaved stereo frames
+static Frame<float> stereo_dot_product_scalar(tcb::span<const float> h, tcb::span<const float> x) {
+    assert(h.size() == x.size());
+    const size_t N = x.size();
+    Frame<float> y;
+    y.channels[0] = 0.0f;
+    y.channels[1] = 0.0f;
+    for (size_t i = 0; i < N; i+=2) {
+        y.channels[0] += h[i+0]*x[i+0];
+        y.channels[1] += h[i+1]*x[i+1];
+    }
+    return y;
+}
+
+#if defined(__ARCH_X86__)
+
+#if defined(__SSE3__)
+#include <xmmintrin.h>
+static Frame<float> stereo_dot_product_sse3(tcb::span<const float> h, tcb::span<const float> x) {
+    assert(h.size() == x.size());
+    const size_t N = x.size();
+
+    // 128bits = 16bytes = 4*4bytes
+    const size_t K = 4u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    __m128 Y_vec = _mm_set1_ps(0.0f);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        __m128 H = _mm_loadu_ps(&h[i]);
+        __m128 X = _mm_loadu_ps(&x[i]);
+        Y_vec = _mm_add_ps(Y_vec, _mm_mul_ps(H, X));
+    }
+
+    // [l1 r1 l2 r2]
+    // [l1+l2 r1+r2]
+    Y_vec = _mm_add_ps(Y_vec, _mm_shuffle_ps(Y_vec, Y_vec, 0b0000'1110));
+    Frame<float> y;
+    y.channels[0] = _mm_cvtss_f32(Y_vec);
+    y.channels[1] = _mm_cvtss_f32(_mm_shuffle_ps(Y_vec, Y_vec, 0b000000'01));
+
+    y += stereo_dot_product_scalar(h.subspan(N_vector), x.subspan(N_vector));
+    return y;
+}
+#endif
+
+#if defined(__AVX__)
+#include <immintrin.h>
+static Frame<float> stereo_dot_product_avx(tcb::span<const float> h, tcb::span<const float> x) {
+    assert(h.size() == x.size());
+    const size_t N = x.size();
+
+    // 256bits = 32bytes = 8*4bytes
+    const size_t K = 8u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    __m256 Y_vec = _mm256_set1_ps(0.0f);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        __m256 H = _mm256_loadu_ps(&h[i]);
+        __m256 X = _mm256_loadu_ps(&x[i]);
+        #if defined(__FMA__)
+        Y_vec = _mm256_fmadd_ps(H, X, Y_vec);
+        #else
+        Y_vec = _mm256_add_ps(Y_vec, _mm256_mul_ps(H, X));
+        #endif
+    }
+
+    // [l1 r1 l2 r2 l3 r3 l4 r4]
+    // [l1+l3 r1+r3 l2+l4 r2+r4]
+    __m128 v0 = _mm_add_ps(_mm256_extractf128_ps(Y_vec, 0), _mm256_extractf128_ps(Y_vec, 1));
+    // [l1+l2+l3+l4 r1+r2+r3+r4]
+    v0 = _mm_add_ps(v0, _mm_permute_ps(v0, 0b0000'1110));
+    Frame<float> y;
+    y.channels[0] = _mm_cvtss_f32(v0);
+    y.channels[1] = _mm_cvtss_f32(_mm_permute_ps(v0, 0b000000'01));
+
+    y += stereo_dot_product_scalar(h.subspan(N_vector), x.subspan(N_vector));
+    return y;
+}
+#endif
+
+#endif
+
+#if defined(__ARCH_AARCH64__)
+#include <arm_neon.h>
+static Frame<float> stereo_dot_product_neon(tcb::span<const float> h, tcb::span<const float> x) {
+    assert(h.size() == x.size());
+    const size_t N = x.size();
+
+    // 128bits = 16bytes = 4*4bytes
+    const size_t K = 4u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    float32x4_t Y_vec = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        float32x4_t H = vld1q_f32(&h[i]);
+        float32x4_t X = vld1q_f32(&x[i]);
+        Y_vec = vfmaq_f32(Y_vec, H, X);
+    }
+
+    // [l1 r1 l2 r2]
+    // [l1+l2 r1+r2]
+    const float32x2_t v0 = vadd_f32(vget_low_f32(Y_vec), vget_high_f32(Y_vec));
+    Frame<float> y;
+    y.channels[0] = vget_lane_f32(v0, 0);
+    y.channels[1] = vget_lane_f32(v0, 1);
+
+    y += stereo_dot_product_scalar(h.subspan(N_vector), x.subspan(N_vector));
+    return y;
+}
+#endif
+
+static Frame<float> stereo_dot_product_auto(tcb::span<const float> h, tcb::span<const float> x) {
+    #if defined(__ARCH_X86__)
+        #if defined(__AVX__)
+        return stereo_dot_product_avx(h, x);
+        #elif defined(__SSE3__)
+        return stereo_dot_product_sse3(h, x);
+        #else
+        return stereo_dot_product_scalar(h, x);
+        #endif
+    #elif defined(__ARCH_AARCH64__)
+        return stereo_dot_product_neon(h, x);
+    #else
+        return stereo_dot_product_scalar(h, x);
+    #endif
+}
+
+PolyphaseResampler::PolyphaseResampler(uint32_t input_rate, uint32_t output_rate, size_t taps_per_phase)
+: m_input_rate(input_rate), m_output_rate(output_rate), m_taps_per_phase(taps_per_phase)
+{
+    assert(m_input_rate > 0);
+    assert(m_output_rate > 0);
+    assert(m_taps_per_phase > 0);
+    const uint32_t gcd = std::gcd(m_input_rate, m_output_rate);
+    m_L = size_t(m_output_rate / gcd);
+    m_M = size_t(m_input_rate / gcd);
+    create_filter_bank();
+    reset();
+}
+
+void PolyphaseResampler::reset() {
+    m_history.resize(m_taps_per_phase-1);
+    for (auto& v: m_history) {
+        v.channels[0] = 0.0f;
+        v.channels[1] = 0.0f;
+    }
+    m_phase = 0;
+}
+
+void PolyphaseResampler::create_filter_bank() {
+    // Prototype lowpass filter runs at the upsampled rate of input_rate*L
+    // Its cutoff is the lower of the input and output nyquist frequencies
+    const size_t L = m_L;
+    const size_t T = m_taps_per_phase;
+    const size_t N = L*T;
+    const double cutoff = PASSBAND_RATIO * 0.5 / double(std::max(m_L, m_M));
+    const double centre = double(N-1) / 2.0;
+    const double window_norm = 1.0 / bessel_i0(KAISER_BETA);
+
+    std::vector<double> h(N);
+    for (size_t i = 0; i < N; i++) {
+        const double t = double(i) - centre;
+        const double x = 2.0*cutoff*t;
+        const double sinc = (std::abs(x) < 1e-12) ? 1.0 : std::sin(M_PI*x)/(M_PI*x); // NOLINT
+        const double r = (centre > 0.0) ? (t / centre) : 0.0;
+        const double window = bessel_i0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r*r))) * window_norm;
+        h[i] = 2.0*cutoff*sinc*window;
+    }
+
+    // Branch p contains taps h[p + k*L]
+    // We normalise each branch for unity gain so there is no ripple at DC between phases
+    m_filter_bank.resize(L*T*2);
+    for (size_t p = 0; p < L; p++) {
+        double sum = 0.0;
+        for (size_t k = 0; k < T; k++) {
+            sum += h[p + k*L];
+        }
+        const double norm = (std::abs(sum) > 1e-12) ? (1.0/sum) : 0.0;
+        // Reverse taps so the dot product runs forward over the history
+        auto branch = tcb::span(m_filter_bank).subspan(p*T*2, T*2);
+        for (size_t k = 0; k < T; k++) {
+            const float v = float(h[p + (T-1-k)*L] * norm);
+            branch[2*k+0] = v;
+            branch[2*k+1] = v;
+        }
+    }
+}
+
+size_t PolyphaseResampler::process(tcb::span<const Frame<int16_t>> src, std::vector<Frame<float>>& dest, const float gain) {
+    const size_t T = m_taps_per_phase;
+    const size_t N_src = src.size();
+    const size_t N_history = T-1;
+
+    m_history.resize(N_history + N_src);
+    for (size_t i = 0; i < N_src; i++) {
+        m_history[N_history+i] = static_cast<Frame<float>>(src[i]) * gain;
+    }
+
+    const size_t N_upsampled = N_src*m_L;
+    const size_t N_dest = (m_phase < N_upsampled) ? ((N_upsampled - m_phase + m_M - 1) / m_M) : 0;
+    dest.resize(N_dest);
+
+    const auto history = tcb::span(reinterpret_cast<const float*>(m_history.data()), m_history.size()*2);
+    for (size_t i = 0; i < N_dest; i++) {
+        // output sample lies between input samples j and j+1 at fractional phase p/L
+        const size_t j = m_phase / m_L;
+        const size_t p = m_phase % m_L;
+        const auto h = tcb::span<const float>(m_filter_bank).subspan(p*T*2, T*2);
+        const auto x = history.subspan(j*2, T*2);
+        dest[i] = stereo_dot_product_auto(h, x);
+        m_phase += m_M;
+    }
+    m_phase -= N_upsampled;
+
+    // keep the tail of this block for the next call
+    std::copy(m_history.end()-ptrdiff_t(N_history), m_history.end(), m_history.begin());
+    m_history.resize(N_history);
+    return N_dest;
+}
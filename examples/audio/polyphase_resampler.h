@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+#include "./frame.h"
+
+constexpr size_t DEFAULT_RESAMPLER_TAPS_PER_PHASE = 32;
+
+// Rational resampler using a windowed sinc filter split into L polyphase branches
+// Output rate = input rate * L/M where L and M are reduced by their greatest common divisor
+// DAB uses a small set of sampling rates so L and M are small, e.g. 32kHz to 48kHz is L=3, M=2
+// Filter state is kept between calls so consecutive blocks are resampled seamlessly
+class PolyphaseResampler
+{
+private:
+    const uint32_t m_input_rate;
+    const uint32_t m_output_rate;
+    const size_t m_taps_per_phase;
+    size_t m_L;
+    size_t m_M;
+    // [L][2*taps_per_phase] with taps reversed and duplicated for interleaved stereo frames
+    std::vector<float> m_filter_bank;
+    // [taps_per_phase-1 previous frames, current block]
+    std::vector<Frame<float>> m_history;
+    // position of the next output sample in the upsampled domain relative to the current block
+    size_t m_phase = 0;
+public:
+    PolyphaseResampler(uint32_t input_rate, uint32_t output_rate, size_t taps_per_phase=DEFAULT_RESAMPLER_TAPS_PER_PHASE);
+    uint32_t get_input_rate() const { return m_input_rate; }
+    uint32_t get_output_rate() const { return m_output_rate; }
+    // Converts to float, applies gain and resamples. Returns the number of frames written into dest
+    size_t process(tcb::span<const Frame<int16_t>> src, std::vector<Frame<float>>& dest, const float gain);
+    void reset();
+private:
+    void create_filter_bank();
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <stddef.h>
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include "./utility/span.h"
+
+// Wait free ring buffer for exactly one producer thread and one consumer thread
+// The real time audio callback is the consumer so it must never block on a lock held by the producer
+template <typename T>
+class SPSCRingBuffer
+{
+private:
+    std::vector<T> m_data;
+    // Monotonically increasing counters, the buffer index is the counter modulo the size
+    // Kept on separate cache lines so the producer and consumer don't contend
+    alignas(64) std::atomic<size_t> m_write_count = 0;
+    alignas(64) std::atomic<size_t> m_read_count = 0;
+public:
+    explicit SPSCRingBuffer(size_t length): m_data(length) {}
+
+    size_t get_size() const { return m_data.size(); }
+    size_t get_total_used() const {
+        return m_write_count.load(std::memory_order_acquire) - m_read_count.load(std::memory_order_acquire);
+    }
+    size_t get_total_free() const { return get_size()-get_total_used(); }
+    bool is_full() const { return get_total_used() == get_size(); }
+    bool is_empty() const { return get_total_used() == 0; }
+
+    // Producer only
+    size_t write(tcb::span<const T> src) {
+        const size_t write_count = m_write_count.load(std::memory_order_relaxed);
+        const size_t read_count = m_read_count.load(std::memory_order_acquire);
+        const size_t total_free = get_size() - (write_count - read_count);
+        const size_t full_write_length = (src.size() > total_free) ? total_free : src.size();
+
+        const size_t write_index = write_count % get_size();
+        size_t write_length = full_write_length;
+        size_t overflow_length = 0;
+        const size_t end_index = write_index + write_length;
+        if (end_index > get_size()) {
+            overflow_length = end_index - get_size();
+            write_length -= overflow_length;
+        }
+
+        std::memcpy(m_data.data() + write_index, src.data(), write_length * sizeof(T));
+        std::memcpy(m_data.data(), src.data() + write_length, overflow_length * sizeof(T));
+        m_write_count.store(write_count + full_write_length, std::memory_order_release);
+        return full_write_length;
+    }
+
+    // Consumer only
+    size_t read(tcb::span<T> dest) {
+        const size_t read_count = m_read_count.load(std::memory_order_relaxed);
+        const size_t write_count = m_write_count.load(std::memory_order_acquire);
+        const size_t total_used = write_count - read_count;
+        const size_t full_read_length = (dest.size() > total_used) ? total_used : dest.size();
+
+        const size_t read_index = read_count % get_size();
+        size_t read_length = full_read_length;
+        size_t overflow_length = 0;
+        const size_t end_index = read_index + read_length;
+        if (end_index > get_size()) {
+            overflow_length = end_index - get_size();
+            read_length -= overflow_length;
+        }
+
+        std::memcpy(dest.data(), m_data.data() + read_index, read_length * sizeof(T));
+        std::memcpy(dest.data() + read_length, m_data.data(), overflow_length * sizeof(T));
+        m_read_count.store(read_count + full_read_length, std::memory_order_release);
+        return full_read_length;
+    }
+};
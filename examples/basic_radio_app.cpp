@@ -1,9 +1,11 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <chrono>
 #include <exception>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 
@@ -18,16 +20,23 @@
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 #include "basic_radio/basic_audio_channel.h"
+#include "basic_radio/basic_database_cache.h"
+#include "basic_radio/basic_fic_runner.h"
 #include "basic_radio/basic_radio.h"
 #include "basic_scraper/basic_scraper.h"
 #include "dab/constants/dab_parameters.h"
 #include "dab/database/dab_database_types.h"
 #include "viterbi_config.h"
+#include "./app_helpers/app_frame_bus.h"
+#include "./app_helpers/app_frame_trace.h"
 #include "./app_helpers/app_io_buffers.h"
 #include "./app_helpers/app_iq_readers.h"
 #include "./app_helpers/app_logging.h"
+#include "./app_helpers/app_metrics.h"
 #include "./app_helpers/app_ofdm_blocks.h"
+#include "./app_helpers/app_shared_memory_buffers.h"
 #include "./app_helpers/app_radio_blocks.h"
+#include "./app_helpers/app_thread_placement.h"
 #include "./app_helpers/app_viterbi_convert_block.h"
 
 #if !BUILD_COMMAND_LINE
@@ -51,6 +60,16 @@ void init_parser(argparse::ArgumentParser& parser) {
         .metavar("INPUT_FILENAME")
         .nargs(1).required()
         .help("Filename of input to radio (defaults to stdin)");
+    parser.add_argument("--input-shm")
+        .default_value(std::string(""))
+        .metavar("SHM_NAME")
+        .nargs(1).required()
+        .help("Read from a shared memory ring buffer created by rtl_sdr --shm instead of a file (posix only)");
+    parser.add_argument("--input-frame-bus")
+        .default_value(std::string(""))
+        .metavar("SHM_NAME")
+        .nargs(1).required()
+        .help("Radio decodes frames published by another process with --ofdm-frame-bus (posix only)");
     parser.add_argument("--transmission-mode")
         .default_value(int(1)).scan<'i', int>()
         .choices(1,2,3,4)
@@ -98,18 +117,70 @@ void init_parser(argparse::ArgumentParser& parser) {
     parser.add_argument("--ofdm-output-hard-bytes")
         .default_value(false).implicit_value(true)
         .help("Output of OFDM demodulator is converted from soft bits to hard bytes (8x compression)");
+    parser.add_argument("--ofdm-skip-unused-symbols")
+        .default_value(false).implicit_value(true)
+        .help("Only demodulate the symbols holding the FIC and subchannels the radio is decoding");
+    parser.add_argument("--ofdm-frame-bus")
+        .default_value(std::string(""))
+        .metavar("SHM_NAME")
+        .nargs(1).required()
+        .help("Publish OFDM frames to shared memory so other processes can decode them (posix only)");
+    parser.add_argument("--ofdm-frame-bus-slots")
+        .default_value(size_t(16)).scan<'u', size_t>()
+        .metavar("SLOTS")
+        .nargs(1).required()
+        .help("Number of frames kept in the frame bus for slow subscribers");
+    parser.add_argument("--ofdm-cpus")
+        .default_value(std::string(""))
+        .metavar("CPU_LIST")
+        .nargs(1).required()
+        .help("Restrict OFDM demodulator threads to these cpus, e.g. 0-3,8 (defaults to any cpu)");
+    parser.add_argument("--ofdm-huge-pages")
+        .default_value(false).implicit_value(true)
+        .help("Back OFDM demodulator buffers with transparent huge pages (linux only)");
+    parser.add_argument("--ofdm-lock-memory")
+        .default_value(false).implicit_value(true)
+        .help("Lock OFDM demodulator buffers into memory so they are never paged out");
     // radio settings
     parser.add_argument("--radio-total-threads")
         .default_value(size_t(1)).scan<'u', size_t>()
         .metavar("TOTAL_THREADS")
         .nargs(1).required()
         .help("Number of basic radio threads (0 = max number of threads)");
+    parser.add_argument("--radio-disable-adaptive-fic")
+        .default_value(false).implicit_value(true)
+        .help("Decode every FIB group each frame even when the ensemble database is stable");
+    parser.add_argument("--radio-viterbi-u8-fic")
+        .default_value(false).implicit_value(true)
+        .help("Decode the FIC with 8bit instead of 16bit Viterbi path metrics which use coarser soft decisions");
+    parser.add_argument("--radio-viterbi-u8-msc-level")
+        .default_value(int(0)).scan<'i', int>()
+        .metavar("PROTECTION_LEVEL")
+        .nargs(1).required()
+        .help("Decode subchannels with this protection level or stronger (1 is the strongest) with 8bit instead of 16bit Viterbi path metrics. "
+              "0 decodes every subchannel with 16bit path metrics");
+    parser.add_argument("--radio-cpus")
+        .default_value(std::string(""))
+        .metavar("CPU_LIST")
+        .nargs(1).required()
+        .help("Restrict basic radio threads to these cpus, e.g. 4-7 (defaults to any cpu)");
+    parser.add_argument("--pin-each-thread")
+        .default_value(false).implicit_value(true)
+        .help("Pin each thread to a single cpu in its list instead of letting it move within the list");
+    parser.add_argument("--placement-report")
+        .default_value(false).implicit_value(true)
+        .help("Print the cpu and NUMA node of each thread and buffer when finished");
     parser.add_argument("--radio-enable-logging")
         .default_value(false).implicit_value(true)
         .help("Enable verbose logging for radio");
     parser.add_argument("--radio-input-hard-bytes")
         .default_value(false).implicit_value(true)
         .help("Input of radio is converted from hard bytes to soft bits (unpack compression)");
+    parser.add_argument("--radio-database-cache")
+        .default_value(std::string(""))
+        .metavar("CACHE_FILEPATH")
+        .nargs(1).required()
+        .help("Ensemble database is loaded from and saved to this file for faster startup (disabled if empty)");
     // scraper settings
     parser.add_argument("--scraper-enable")
         .default_value(false).implicit_value(true)
@@ -125,6 +196,30 @@ void init_parser(argparse::ArgumentParser& parser) {
     parser.add_argument("--scraper-disable-auto")
         .default_value(false).implicit_value(true)
         .help("Disable automatic scraping of new channels");
+    parser.add_argument("--scraper-segment-seconds")
+        .default_value(int(3600)).scan<'i', int>()
+        .metavar("SECONDS")
+        .nargs(1).required()
+        .help("Duration of each archived audio segment (0 = never rotate)");
+    parser.add_argument("--scraper-record-pcm")
+        .default_value(false).implicit_value(true)
+        .help("Also record decoded PCM audio as WAV alongside the AAC/MP2 archive");
+    // metrics settings
+    parser.add_argument("--metrics-file")
+        .default_value(std::string(""))
+        .metavar("OUTPUT_FILEPATH")
+        .nargs(1).required()
+        .help("Periodically write metrics in the Prometheus text format to this file (disabled if empty)");
+    parser.add_argument("--metrics-interval")
+        .default_value(int(10)).scan<'i', int>()
+        .metavar("SECONDS")
+        .nargs(1).required()
+        .help("Seconds between each write of the metrics file");
+    parser.add_argument("--metrics-ensemble")
+        .default_value(std::string(""))
+        .metavar("NAME")
+        .nargs(1).required()
+        .help("Value of the ensemble label added to all metrics (omitted if empty)");
     // other
 #if !BUILD_COMMAND_LINE
     parser.add_argument("--audio-no-auto-select")
@@ -139,6 +234,8 @@ void init_parser(argparse::ArgumentParser& parser) {
 
 struct Args {
     std::string input_file; 
+    std::string input_shm;
+    std::string input_frame_bus;
     int transmission_mode;
     bool is_ofdm_used;
     bool is_dab_used;
@@ -150,15 +247,35 @@ struct Args {
     bool ofdm_enable_output;
     std::string ofdm_output;
     bool ofdm_output_hard_bytes;
+    bool ofdm_skip_unused_symbols;
+    std::string ofdm_frame_bus;
+    size_t ofdm_frame_bus_slots;
+    std::string ofdm_cpus;
+    bool ofdm_huge_pages;
+    bool ofdm_lock_memory;
     // radio settings
     size_t radio_total_threads;
+    bool radio_disable_adaptive_fic;
+    bool radio_viterbi_u8_fic;
+    int radio_viterbi_u8_msc_level;
     bool radio_enable_logging;
     bool radio_input_hard_bytes;
+    std::string radio_database_cache;
+    std::string radio_cpus;
+    // placement settings
+    bool pin_each_thread;
+    bool placement_report;
     // scraper settings
     bool scraper_enable;
     std::string scraper_output;
     bool scraper_disable_logging;
     bool scraper_disable_auto;
+    int scraper_segment_seconds;
+    bool scraper_record_pcm;
+    // metrics settings
+    std::string metrics_file;
+    int metrics_interval;
+    std::string metrics_ensemble;
     // other
 #if !BUILD_COMMAND_LINE
     bool audio_no_auto_select;
@@ -170,6 +287,8 @@ struct Args {
 Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     Args args;
     args.input_file = parser.get<std::string>("--input");
+    args.input_shm = parser.get<std::string>("--input-shm");
+    args.input_frame_bus = parser.get<std::string>("--input-frame-bus");
     args.transmission_mode = parser.get<int>("--transmission-mode");
     auto configuration = parser.get<std::string>("--configuration");
     args.is_ofdm_used = true;
@@ -187,15 +306,35 @@ Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     args.ofdm_enable_output = parser.get<bool>("--ofdm-enable-output");
     args.ofdm_output = parser.get<std::string>("--ofdm-output");
     args.ofdm_output_hard_bytes = parser.get<bool>("--ofdm-output-hard-bytes");
+    args.ofdm_skip_unused_symbols = parser.get<bool>("--ofdm-skip-unused-symbols");
+    args.ofdm_frame_bus = parser.get<std::string>("--ofdm-frame-bus");
+    args.ofdm_frame_bus_slots = parser.get<size_t>("--ofdm-frame-bus-slots");
+    args.ofdm_cpus = parser.get<std::string>("--ofdm-cpus");
+    args.ofdm_huge_pages = parser.get<bool>("--ofdm-huge-pages");
+    args.ofdm_lock_memory = parser.get<bool>("--ofdm-lock-memory");
     // radio settings
     args.radio_total_threads = parser.get<size_t>("--radio-total-threads");
+    args.radio_disable_adaptive_fic = parser.get<bool>("--radio-disable-adaptive-fic");
+    args.radio_viterbi_u8_fic = parser.get<bool>("--radio-viterbi-u8-fic");
+    args.radio_viterbi_u8_msc_level = parser.get<int>("--radio-viterbi-u8-msc-level");
     args.radio_enable_logging = parser.get<bool>("--radio-enable-logging");
     args.radio_input_hard_bytes = parser.get<bool>("--radio-input-hard-bytes");
+    args.radio_database_cache = parser.get<std::string>("--radio-database-cache");
+    args.radio_cpus = parser.get<std::string>("--radio-cpus");
+    // placement settings
+    args.pin_each_thread = parser.get<bool>("--pin-each-thread");
+    args.placement_report = parser.get<bool>("--placement-report");
     // scraper settings
     args.scraper_enable = parser.get<bool>("--scraper-enable");
     args.scraper_output = parser.get<std::string>("--scraper-output");
     args.scraper_disable_logging = parser.get<bool>("--scraper-disable-logging");
     args.scraper_disable_auto = parser.get<bool>("--scraper-disable-auto");
+    args.scraper_segment_seconds = parser.get<int>("--scraper-segment-seconds");
+    args.scraper_record_pcm = parser.get<bool>("--scraper-record-pcm");
+    // metrics settings
+    args.metrics_file = parser.get<std::string>("--metrics-file");
+    args.metrics_interval = parser.get<int>("--metrics-interval");
+    args.metrics_ensemble = parser.get<std::string>("--metrics-ensemble");
     // other
 #if !BUILD_COMMAND_LINE
     args.audio_no_auto_select = parser.get<bool>("--audio-no-auto-select");
@@ -232,6 +371,40 @@ int main(int argc, char** argv) {
         fprintf(stderr, "OFDM block size cannot be zero\n");
         return 1;
     }
+    if (args.ofdm_frame_bus_slots == 0) {
+        fprintf(stderr, "OFDM frame bus slots cannot be zero\n");
+        return 1;
+    }
+    if (args.ofdm_skip_unused_symbols && (!args.is_dab_used || args.ofdm_enable_output || !args.ofdm_frame_bus.empty())) {
+        fprintf(stderr, "Skipping unused OFDM symbols requires the radio to be the only consumer of the demodulator\n");
+        return 1;
+    }
+    if (!args.input_frame_bus.empty() && args.is_ofdm_used) {
+        fprintf(stderr, "Reading from a frame bus requires --configuration dab\n");
+        return 1;
+    }
+    if (args.metrics_interval <= 0) {
+        fprintf(stderr, "Metrics interval must be positive\n");
+        return 1;
+    }
+    const auto ofdm_cpus = parse_cpu_list(args.ofdm_cpus);
+    if (!ofdm_cpus.has_value()) {
+        fprintf(stderr, "Invalid OFDM cpu list: '%s'\n", args.ofdm_cpus.c_str());
+        return 1;
+    }
+    const auto radio_cpus = parse_cpu_list(args.radio_cpus);
+    if (!radio_cpus.has_value()) {
+        fprintf(stderr, "Invalid radio cpu list: '%s'\n", args.radio_cpus.c_str());
+        return 1;
+    }
+    Thread_Placement ofdm_placement;
+    ofdm_placement.cpus = ofdm_cpus.value();
+    ofdm_placement.is_pin_each_thread = args.pin_each_thread;
+    ofdm_placement.is_huge_pages = args.ofdm_huge_pages;
+    ofdm_placement.is_lock_memory = args.ofdm_lock_memory;
+    Thread_Placement radio_placement;
+    radio_placement.cpus = radio_cpus.value();
+    radio_placement.is_pin_each_thread = args.pin_each_thread;
 
     FILE* fp_in = stdin;
     if (!args.input_file.empty()) { 
@@ -262,7 +435,7 @@ int main(int argc, char** argv) {
     std::shared_ptr<OFDM_Block> ofdm_block = nullptr;
     auto ofdm_output_splitter = std::shared_ptr<OutputSplitter<viterbi_bit_t>>();
     if (args.is_ofdm_used) {
-        ofdm_block = std::make_shared<OFDM_Block>(args.transmission_mode, args.ofdm_total_threads);
+        ofdm_block = std::make_shared<OFDM_Block>(args.transmission_mode, args.ofdm_total_threads, ofdm_placement);
         ofdm_output_splitter = std::make_shared<OutputSplitter<viterbi_bit_t>>();
         ofdm_block->set_output_stream(ofdm_output_splitter);
         auto& config = ofdm_block->get_ofdm_demod().GetConfig();
@@ -271,28 +444,79 @@ int main(int argc, char** argv) {
     // setup radio
     std::shared_ptr<Basic_Radio_Block> radio_block = nullptr;
     if (args.is_dab_used) {
-        radio_block = std::make_shared<Basic_Radio_Block>(args.transmission_mode, args.radio_total_threads);
+        BasicRadio_Viterbi_Config viterbi_config;
+        if (args.radio_viterbi_u8_fic) viterbi_config.fic = DAB_Viterbi_Decoder::Metric::U8;
+        viterbi_config.msc_u8_protection_level = args.radio_viterbi_u8_msc_level;
+        radio_block = std::make_shared<Basic_Radio_Block>(args.transmission_mode, args.radio_total_threads, radio_placement, viterbi_config);
+        auto& fic_config = radio_block->get_basic_radio().GetFICRunnerConfig();
+        fic_config.is_adaptive = !args.radio_disable_adaptive_fic;
+    }
+    // setup frame bus
+    std::shared_ptr<FrameBusPublisher> frame_bus_out = nullptr;
+    std::shared_ptr<FrameBusSubscriber> frame_bus_in = nullptr;
+    try {
+        if (args.is_ofdm_used && !args.ofdm_frame_bus.empty()) {
+            frame_bus_out = std::make_shared<FrameBusPublisher>(
+                args.ofdm_frame_bus, dab_params.nb_frame_bits, args.ofdm_frame_bus_slots
+            );
+            ofdm_block->set_frame_bus(frame_bus_out);
+        }
+        if (args.is_dab_used && !args.input_frame_bus.empty()) {
+            frame_bus_in = std::make_shared<FrameBusSubscriber>(args.input_frame_bus);
+            if (frame_bus_in->get_nb_frame_bits() != dab_params.nb_frame_bits) {
+                fprintf(stderr, "Frame bus '%s' has frames of %zu bits but transmission mode %d expects %zu bits\n",
+                    args.input_frame_bus.c_str(), frame_bus_in->get_nb_frame_bits(),
+                    args.transmission_mode, size_t(dab_params.nb_frame_bits));
+                return 1;
+            }
+            radio_block->set_frame_bus(frame_bus_in);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
     }
     // setup input
     std::shared_ptr<FileWrapper> file_in = nullptr;
+    std::shared_ptr<SharedMemoryInputBuffer<uint8_t>> shm_in = nullptr;
+    std::shared_ptr<InputBuffer<uint8_t>> bytes_in = nullptr;
+    if (!args.input_shm.empty()) {
+        try {
+            shm_in = std::make_shared<SharedMemoryInputBuffer<uint8_t>>(args.input_shm);
+            bytes_in = shm_in;
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << std::endl;
+            return 1;
+        }
+    }
     if (args.is_ofdm_used) {
         try {
-            auto raw_iq_in = std::make_shared<InputFile<uint8_t>>(fp_in);
+            std::shared_ptr<InputBuffer<uint8_t>> raw_iq_in = bytes_in;
+            if (raw_iq_in == nullptr) {
+                auto raw_iq_file = std::make_shared<InputFile<uint8_t>>(fp_in);
+                raw_iq_in = raw_iq_file;
+                file_in = raw_iq_file;
+            }
             auto iq_stream = get_iq_file_reader_from_mode_string(raw_iq_in, args.ofdm_input_mode);
             ofdm_block->set_input_stream(iq_stream);
-            file_in = raw_iq_in;
         } catch (const std::exception& ex) {
             std::cerr << "Failed to parse OFDM IQ file with format: " << args.ofdm_input_mode << std::endl;
             std::cerr << ex.what() << std::endl;
             return 1;
         }
-    } else {
+    } else if (frame_bus_in == nullptr) {
         if (args.radio_input_hard_bytes) {
-            auto hard_bytes_in = std::make_shared<InputFile<uint8_t>>(fp_in);
+            std::shared_ptr<InputBuffer<uint8_t>> hard_bytes_in = bytes_in;
+            if (hard_bytes_in == nullptr) {
+                auto hard_bytes_file = std::make_shared<InputFile<uint8_t>>(fp_in);
+                hard_bytes_in = hard_bytes_file;
+                file_in = hard_bytes_file;
+            }
             auto convert_viterbi_hard_to_soft = std::make_shared<Convert_Viterbi_Bytes_to_Bits>();
             convert_viterbi_hard_to_soft->set_input_stream(hard_bytes_in);
             radio_block->set_input_stream(convert_viterbi_hard_to_soft);
-            file_in = hard_bytes_in;
+        } else if (bytes_in != nullptr) {
+            auto soft_bits_in = std::make_shared<ReinterpretCastInputBuffer<viterbi_bit_t, uint8_t>>(bytes_in);
+            radio_block->set_input_stream(soft_bits_in);
         } else {
             auto soft_bits_in = std::make_shared<InputFile<viterbi_bit_t>>(fp_in);
             radio_block->set_input_stream(soft_bits_in);
@@ -320,10 +544,21 @@ int main(int argc, char** argv) {
         ofdm_to_radio_buffer = std::make_shared<ThreadedRingBuffer<viterbi_bit_t>>(dab_params.nb_frame_bits*2);
         ofdm_output_splitter->add_output_stream(ofdm_to_radio_buffer);
         radio_block->set_input_stream(ofdm_to_radio_buffer);
+        auto frame_traces = std::make_shared<FrameTraceQueue>();
+        ofdm_block->set_frame_traces(frame_traces);
+        radio_block->set_frame_traces(frame_traces);
+        if (args.ofdm_skip_unused_symbols) {
+            radio_block->get_basic_radio().On_Wanted_Symbols().Attach([ofdm_block](tcb::span<const int> symbols) {
+                ofdm_block->get_ofdm_demod().SetWantedSymbols(symbols);
+            });
+        }
     }
     // scraper
     if (args.is_dab_used && args.scraper_enable) {
-        auto basic_scraper = std::make_shared<BasicScraper>(args.scraper_output);
+        BasicScraper_Config scraper_cfg;
+        scraper_cfg.archive.segment_duration = std::chrono::seconds(args.scraper_segment_seconds);
+        scraper_cfg.is_record_pcm = args.scraper_record_pcm;
+        auto basic_scraper = std::make_shared<BasicScraper>(args.scraper_output, scraper_cfg);
         fprintf(stderr, "basic scraper is writing to folder '%s'\n", args.scraper_output.c_str()); 
         BasicScraper::attach_to_radio(basic_scraper, radio_block->get_basic_radio());
         radio_block->get_basic_radio().On_Audio_Channel().Attach(
@@ -400,19 +635,55 @@ int main(int argc, char** argv) {
         }
     };
 #endif
+    // metrics
+    std::shared_ptr<Metrics_Registry> metrics_registry = nullptr;
+    std::unique_ptr<MetricsFileExporter> metrics_exporter = nullptr;
+    if (!args.metrics_file.empty()) {
+        metrics_registry = std::make_shared<Metrics_Registry>();
+        Metric_Labels labels;
+        if (!args.metrics_ensemble.empty()) labels.push_back({ "ensemble", args.metrics_ensemble });
+        if (args.is_ofdm_used) {
+            metrics_registry->Attach([ofdm_block, labels](Metrics_Writer& writer) {
+                collect_ofdm_metrics(writer, ofdm_block->get_ofdm_demod(), labels);
+            });
+        }
+        if (args.is_dab_used) {
+            metrics_registry->Attach([radio_block, labels](Metrics_Writer& writer) {
+                radio_block->get_basic_radio().CollectMetrics(writer, labels);
+            });
+        }
+        metrics_exporter = std::make_unique<MetricsFileExporter>(
+            metrics_registry, args.metrics_file, std::chrono::seconds(args.metrics_interval)
+        );
+    }
+    // database cache is loaded after all observers are attached so they see the speculatively created channels
+    if (args.is_dab_used && !args.radio_database_cache.empty()) {
+        auto db = ReadDatabaseCache(args.radio_database_cache);
+        if (db.has_value()) {
+            radio_block->get_basic_radio().LoadDatabaseCache(db.value());
+        }
+    }
     // threads
     std::unique_ptr<std::thread> thread_ofdm = nullptr;
     if (args.is_ofdm_used) {
         const size_t block_size = args.ofdm_block_size;
-        thread_ofdm = std::make_unique<std::thread>([ofdm_block, block_size, ofdm_to_radio_buffer]() {
+        thread_ofdm = std::make_unique<std::thread>([ofdm_block, block_size, ofdm_to_radio_buffer, frame_bus_out, ofdm_placement]() {
+            // reader thread shares the cpus of the demodulator since it writes into the same buffers
+            Thread_Placement reader_placement = ofdm_placement;
+            reader_placement.is_pin_each_thread = false;
+            ApplyThreadPlacement(reader_placement, 0);
             ofdm_block->run(block_size);
             fprintf(stderr, "ofdm thread finished\n");
             if (ofdm_to_radio_buffer != nullptr) ofdm_to_radio_buffer->close();
+            if (frame_bus_out != nullptr) frame_bus_out->close();
         });
     }
     std::unique_ptr<std::thread> thread_radio = nullptr;
     if (args.is_dab_used) {
-        thread_radio = std::make_unique<std::thread>([radio_block]() {
+        thread_radio = std::make_unique<std::thread>([radio_block, radio_placement]() {
+            Thread_Placement reader_placement = radio_placement;
+            reader_placement.is_pin_each_thread = false;
+            ApplyThreadPlacement(reader_placement, 0);
             radio_block->run();
             fprintf(stderr, "radio thread finished\n");
         });
@@ -431,10 +702,24 @@ int main(int argc, char** argv) {
     const int gui_retval = render_common_gui_blocking(gui);
     if (thread_select_default_audio != nullptr) thread_select_default_audio->join();
     if (file_in != nullptr) file_in->close();
+    if (shm_in != nullptr) shm_in->close();
+    if (frame_bus_in != nullptr) frame_bus_in->close();
     if (file_out != nullptr) file_out->close();
     if (thread_ofdm != nullptr) thread_ofdm->join();
     if (ofdm_to_radio_buffer != nullptr) ofdm_to_radio_buffer->close();
     if (thread_radio != nullptr) thread_radio->join();
+    // collectors keep the blocks alive so the exporter is stopped before they are released
+    metrics_exporter = nullptr;
+    metrics_registry = nullptr;
+    if (args.placement_report) {
+        if (ofdm_block != nullptr) print_placement_report(stderr, "ofdm demodulator", ofdm_block->get_ofdm_demod().GetPlacementReport());
+        if (radio_block != nullptr) print_placement_report(stderr, "basic radio", radio_block->get_basic_radio().GetPlacementReport());
+    }
+    if (args.is_dab_used && !args.radio_database_cache.empty()) {
+        auto& radio = radio_block->get_basic_radio();
+        auto lock = std::unique_lock(radio.GetMutex());
+        WriteDatabaseCache(args.radio_database_cache, radio.GetDatabase());
+    }
     ofdm_block = nullptr;
     radio_block = nullptr;
     portaudio_threaded_actions = nullptr;
@@ -446,7 +731,21 @@ int main(int argc, char** argv) {
     if (thread_ofdm != nullptr) thread_ofdm->join();
     if (ofdm_to_radio_buffer != nullptr) ofdm_to_radio_buffer->close();
     if (thread_radio != nullptr) thread_radio->join();
+    // collectors keep the blocks alive so the exporter is stopped before they are released
+    metrics_exporter = nullptr;
+    metrics_registry = nullptr;
+    if (args.placement_report) {
+        if (ofdm_block != nullptr) print_placement_report(stderr, "ofdm demodulator", ofdm_block->get_ofdm_demod().GetPlacementReport());
+        if (radio_block != nullptr) print_placement_report(stderr, "basic radio", radio_block->get_basic_radio().GetPlacementReport());
+    }
+    if (args.is_dab_used && !args.radio_database_cache.empty()) {
+        auto& radio = radio_block->get_basic_radio();
+        auto lock = std::unique_lock(radio.GetMutex());
+        WriteDatabaseCache(args.radio_database_cache, radio.GetDatabase());
+    }
     if (file_in != nullptr) file_in->close();
+    if (shm_in != nullptr) shm_in->close();
+    if (frame_bus_in != nullptr) frame_bus_in->close();
     if (file_out != nullptr) file_out->close();
     ofdm_block = nullptr;
     radio_block = nullptr;
@@ -0,0 +1,159 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+#include "dab/mot/MOT_entities.h"
+#include "utility/observable.h"
+#include "utility/span.h"
+
+void init_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("-n", "--total-events")
+        .default_value(size_t(1000000)).scan<'u', size_t>()
+        .metavar("TOTAL_EVENTS")
+        .nargs(1).required()
+        .help("Number of notifications sent for each scenario");
+    parser.add_argument("-m", "--total-observers")
+        .default_value(size_t(2)).scan<'u', size_t>()
+        .metavar("TOTAL_OBSERVERS")
+        .nargs(1).required()
+        .help("Number of observers attached to each observable");
+    parser.add_argument("--total-header-params")
+        .default_value(size_t(4)).scan<'u', size_t>()
+        .metavar("TOTAL_PARAMS")
+        .nargs(1).required()
+        .help("Number of user application parameters in the MOT header used for the heavy event");
+}
+
+struct Args {
+    size_t total_events;
+    size_t total_observers;
+    size_t total_header_params;
+};
+
+Args get_args_from_parser(const argparse::ArgumentParser& parser) {
+    Args args;
+    args.total_events = parser.get<size_t>("--total-events");
+    args.total_observers = parser.get<size_t>("--total-observers");
+    args.total_header_params = parser.get<size_t>("--total-header-params");
+    return args;
+}
+
+// Written to by every observer so the compiler can't remove the calls
+static volatile uint64_t observer_sink = 0;
+
+template <typename F>
+static void run_scenario(const char* name, const Args& args, F&& notify) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < args.total_events; i++) {
+        notify(i);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(end-start).count();
+    const double events_per_second = (seconds > 0.0) ? double(args.total_events)/seconds : 0.0;
+    const double ns_per_call = (args.total_events*args.total_observers > 0) ?
+        seconds*1e9/double(args.total_events*args.total_observers) : 0.0;
+    fprintf(stdout, "%-32s %12.0f events/s %8.2f ns/observer\n", name, events_per_second, ns_per_call);
+}
+
+static MOT_Entity create_mot_entity(const size_t total_header_params) {
+    auto body = std::make_shared<std::vector<uint8_t>>(16384, uint8_t(0xAA));
+    MOT_Entity entity;
+    entity.transport_id = 1234;
+    entity.header.body_size = uint32_t(body->size());
+    entity.header.content_type = 2;
+    entity.header.content_sub_type = 1;
+    entity.header.content_name = std::string("slideshow/station_logo_320x240.jpg");
+    for (size_t i = 0; i < total_header_params; i++) {
+        MOT_Header_Extension_Parameter param;
+        param.type = uint8_t(i);
+        param.data.resize(32, uint8_t(i));
+        entity.header.user_app_params.push_back(std::move(param));
+    }
+    entity.body_buf = *body;
+    entity.body_data = body;
+    return entity;
+}
+
+int main(int argc, char** argv) {
+    auto parser = argparse::ArgumentParser("benchmark_observable", "0.1.0");
+    parser.add_description("Measures how many events per second an Observable can deliver to its observers");
+    parser.add_epilog(
+        "Observers taking a MOT entity by value show the cost of copying it once per observer.\n"
+        "Increase the number of observers past 4 to include those stored outside the inline capacity."
+    );
+    init_parser(parser);
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    const auto args = get_args_from_parser(parser);
+
+    fprintf(stdout, "events=%zu observers=%zu\n", args.total_events, args.total_observers);
+
+    {
+        Observable<size_t> observable;
+        for (size_t i = 0; i < args.total_observers; i++) {
+            observable.Attach([](const size_t& value) { observer_sink = observer_sink + value; });
+        }
+        run_scenario("integer", args, [&observable](size_t i) { observable.Notify(i); });
+    }
+
+    {
+        std::vector<uint8_t> buf(512, 0);
+        Observable<tcb::span<const uint8_t>> observable;
+        for (size_t i = 0; i < args.total_observers; i++) {
+            observable.Attach([](const tcb::span<const uint8_t>& data) { observer_sink = observer_sink + data[0]; });
+        }
+        run_scenario("span", args, [&observable, &buf](size_t i) {
+            buf[0] = uint8_t(i);
+            observable.Notify(buf);
+        });
+    }
+
+    const auto entity = create_mot_entity(args.total_header_params);
+    {
+        Observable<MOT_Entity> observable;
+        for (size_t i = 0; i < args.total_observers; i++) {
+            observable.Attach([](const MOT_Entity& mot) { observer_sink = observer_sink + mot.header.body_size; });
+        }
+        run_scenario("mot_entity (const reference)", args, [&observable, &entity](size_t) { observable.Notify(entity); });
+    }
+
+    {
+        Observable<MOT_Entity> observable;
+        for (size_t i = 0; i < args.total_observers; i++) {
+            observable.Attach([](MOT_Entity mot) { observer_sink = observer_sink + mot.header.body_size; });
+        }
+        run_scenario("mot_entity (copy per observer)", args, [&observable, &entity](size_t) { observable.Notify(entity); });
+    }
+
+    {
+        // Each notification attaches and detaches an extra observer from inside an observer
+        Observable<size_t> observable;
+        for (size_t i = 0; i < args.total_observers; i++) {
+            observable.Attach([](const size_t& value) { observer_sink = observer_sink + value; });
+        }
+        ObserverToken token = INVALID_OBSERVER_TOKEN;
+        observable.Attach([&observable, &token](const size_t&) {
+            if (token != INVALID_OBSERVER_TOKEN) {
+                observable.Detach(token);
+                token = INVALID_OBSERVER_TOKEN;
+            } else {
+                token = observable.Attach([](const size_t& value) { observer_sink = observer_sink + value; });
+            }
+        });
+        run_scenario("integer (attach/detach churn)", args, [&observable](size_t i) { observable.Notify(i); });
+    }
+
+    return 0;
+}
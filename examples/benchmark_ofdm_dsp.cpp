@@ -0,0 +1,256 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+#include "detect_architecture.h"
+#include "simd_flags.h" // NOLINT
+#include "ofdm/dab_ofdm_params_ref.h"
+#include "ofdm/dsp/apply_pll.h"
+#include "ofdm/dsp/complex_conj_mul_sum.h"
+#include "ofdm/ofdm_params.h"
+#include "utility/span.h"
+
+void init_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("-M", "--transmission-mode")
+        .default_value(int(1)).scan<'i', int>()
+        .metavar("MODE")
+        .nargs(1).required()
+        .help("Transmission mode which determines the number and size of symbols in each frame");
+    parser.add_argument("--total-frames")
+        .default_value(size_t(200)).scan<'u', size_t>()
+        .metavar("TOTAL_FRAMES")
+        .nargs(1).required()
+        .help("Number of OFDM frames used for the timing measurements");
+    parser.add_argument("--max-frequency-offset")
+        .default_value(float(20e3f)).scan<'g', float>()
+        .metavar("HZ")
+        .nargs(1).required()
+        .help("Each frame is corrected by a random frequency offset within +-HZ");
+    parser.add_argument("--tolerance")
+        .default_value(float(5e-3f)).scan<'g', float>()
+        .metavar("TOLERANCE")
+        .nargs(1).required()
+        .help("Largest error relative to the signal magnitude allowed between the vectorised and scalar kernels. "
+              "The PLL phase is a single precision float so the error grows with the frequency offset and frame length");
+    parser.add_argument("--seed")
+        .default_value(uint32_t(0)).scan<'u', uint32_t>()
+        .metavar("SEED")
+        .nargs(1).required()
+        .help("Seed for the samples and frequency offsets so runs are repeatable");
+}
+
+struct Args {
+    int transmission_mode;
+    size_t total_frames;
+    float max_frequency_offset;
+    float tolerance;
+    uint32_t seed;
+};
+
+Args get_args_from_parser(const argparse::ArgumentParser& parser) {
+    Args args;
+    args.transmission_mode = parser.get<int>("--transmission-mode");
+    args.total_frames = parser.get<size_t>("--total-frames");
+    args.max_frequency_offset = parser.get<float>("--max-frequency-offset");
+    args.tolerance = parser.get<float>("--tolerance");
+    args.seed = parser.get<uint32_t>("--seed");
+    return args;
+}
+
+// Vectorised variant that the *_auto kernels dispatch to for this build
+static const char* get_simd_name() {
+    #if defined(__ARCH_X86__)
+        #if defined(__AVX__)
+        return "avx";
+        #elif defined(__SSE3__)
+        return "sse3";
+        #else
+        return "scalar";
+        #endif
+    #elif defined(__ARCH_AARCH64__)
+        return "neon";
+    #else
+        return "scalar";
+    #endif
+}
+
+constexpr float SAMPLING_RATE = 2.048e6f;
+
+// Samples of the data symbols in a frame which is the block the demodulator corrects every frame
+// DOC: docs/DAB_implementation_in_SDR_detailed.pdf
+// Clause 3.13 - Frequency offset estimation and correction
+struct Frame_Data {
+    OFDM_Params params;
+    std::vector<std::complex<float>> samples;
+    std::vector<float> freq_norms;
+    tcb::span<const std::complex<float>> get_symbol(const size_t i) const {
+        return tcb::span(samples).subspan(i*params.nb_symbol_period, params.nb_symbol_period);
+    }
+};
+
+static Frame_Data create_frame_data(const Args& args) {
+    Frame_Data data;
+    data.params = get_DAB_OFDM_params(args.transmission_mode);
+    data.samples.resize(data.params.nb_frame_symbols*data.params.nb_symbol_period);
+    data.freq_norms.resize(args.total_frames);
+    auto rng = std::mt19937(args.seed);
+    auto sample_dist = std::normal_distribution<float>(0.0f, 1.0f);
+    for (auto& x: data.samples) x = { sample_dist(rng), sample_dist(rng) };
+    auto freq_dist = std::uniform_real_distribution<float>(-args.max_frequency_offset, args.max_frequency_offset);
+    for (auto& freq_norm: data.freq_norms) freq_norm = freq_dist(rng)/SAMPLING_RATE;
+    return data;
+}
+
+// Same calls as the demodulator which advances the PLL phase by the symbol period for each symbol
+template <typename F>
+static void apply_pll_frame(const Frame_Data& data, const float freq_norm, tcb::span<std::complex<float>> y, F&& apply_pll) {
+    const size_t N = data.params.nb_symbol_period;
+    for (size_t i = 0; i < data.params.nb_frame_symbols; i++) {
+        const float dt_start = float(i*N)*freq_norm;
+        apply_pll(data.get_symbol(i), y.subspan(i*N, N), freq_norm, dt_start);
+    }
+}
+
+// Same calls as the demodulator which correlates the cyclic prefix against the end of each symbol
+template <typename F>
+static void conj_mul_sum_frame(const Frame_Data& data, tcb::span<std::complex<float>> y, F&& conj_mul_sum) {
+    const size_t N = data.params.nb_cyclic_prefix;
+    const size_t M = data.params.nb_fft;
+    for (size_t i = 0; i < data.params.nb_frame_symbols; i++) {
+        const auto sym = data.get_symbol(i);
+        y[i] = conj_mul_sum(sym.subspan(M, N), sym.subspan(0, N));
+    }
+}
+
+// Returns the largest error relative to the magnitude of the input sample
+static float check_apply_pll(const Frame_Data& data) {
+    std::vector<std::complex<float>> y_vector(data.samples.size());
+    std::vector<std::complex<float>> y_scalar(data.samples.size());
+    float max_error = 0.0f;
+    for (const float freq_norm: data.freq_norms) {
+        apply_pll_frame(data, freq_norm, y_vector, apply_pll_auto);
+        apply_pll_frame(data, freq_norm, y_scalar, apply_pll_scalar);
+        for (size_t i = 0; i < data.samples.size(); i++) {
+            const float magnitude = std::max(std::abs(data.samples[i]), 1e-6f);
+            max_error = std::max(max_error, std::abs(y_vector[i]-y_scalar[i])/magnitude);
+        }
+    }
+    return max_error;
+}
+
+// Returns the largest error relative to the sum of magnitudes since the summation order differs
+static float check_conj_mul_sum(const Frame_Data& data) {
+    const size_t N = data.params.nb_frame_symbols;
+    std::vector<std::complex<float>> y_vector(N);
+    std::vector<std::complex<float>> y_scalar(N);
+    conj_mul_sum_frame(data, y_vector, complex_conj_mul_sum_auto);
+    conj_mul_sum_frame(data, y_scalar, complex_conj_mul_sum_scalar);
+    float max_error = 0.0f;
+    for (size_t i = 0; i < N; i++) {
+        const auto sym = data.get_symbol(i);
+        float magnitude = 0.0f;
+        for (size_t j = 0; j < data.params.nb_cyclic_prefix; j++) {
+            magnitude += std::abs(sym[data.params.nb_fft+j])*std::abs(sym[j]);
+        }
+        max_error = std::max(max_error, std::abs(y_vector[i]-y_scalar[i])/std::max(magnitude, 1e-6f));
+    }
+    return max_error;
+}
+
+// Written to by every scenario so the compiler can't remove the work
+static volatile float benchmark_sink = 0.0f;
+
+// Returns microseconds per frame
+template <typename F>
+static double run_timing(const size_t total_frames, F&& process) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < total_frames; i++) {
+        process(i);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(end-start).count();
+    return (total_frames > 0) ? seconds*1e6/double(total_frames) : 0.0;
+}
+
+static void print_timing(const char* name, const double scalar_us, const double vector_us) {
+    const double speedup = (vector_us > 0.0) ? scalar_us/vector_us : 0.0;
+    fprintf(stdout, "%-24s %12.1f %12.1f %8.2fx\n", name, scalar_us, vector_us, speedup);
+}
+
+static void run_timings(const Args& args, const Frame_Data& data) {
+    std::vector<std::complex<float>> y(data.samples.size());
+    std::vector<std::complex<float>> y_sums(data.params.nb_frame_symbols);
+
+    fprintf(stdout, "%-24s %12s %12s %9s\n", "us/frame", "scalar", get_simd_name(), "speedup");
+    const double pll_scalar_us = run_timing(args.total_frames, [&](size_t i) {
+        apply_pll_frame(data, data.freq_norms[i], y, apply_pll_scalar);
+        benchmark_sink = benchmark_sink + y.back().real();
+    });
+    const double pll_vector_us = run_timing(args.total_frames, [&](size_t i) {
+        apply_pll_frame(data, data.freq_norms[i], y, apply_pll_auto);
+        benchmark_sink = benchmark_sink + y.back().real();
+    });
+    print_timing("apply_pll", pll_scalar_us, pll_vector_us);
+
+    const double sum_scalar_us = run_timing(args.total_frames, [&](size_t) {
+        conj_mul_sum_frame(data, y_sums, complex_conj_mul_sum_scalar);
+        benchmark_sink = benchmark_sink + y_sums.back().real();
+    });
+    const double sum_vector_us = run_timing(args.total_frames, [&](size_t) {
+        conj_mul_sum_frame(data, y_sums, complex_conj_mul_sum_auto);
+        benchmark_sink = benchmark_sink + y_sums.back().real();
+    });
+    print_timing("complex_conj_mul_sum", sum_scalar_us, sum_vector_us);
+}
+
+int main(int argc, char** argv) {
+    auto parser = argparse::ArgumentParser("benchmark_ofdm_dsp", "0.1.0");
+    parser.add_description("Compares the vectorised OFDM DSP kernels against their scalar implementations");
+    parser.add_epilog(
+        "The kernels are called on every symbol of a frame the same way as the demodulator.\n"
+        "Fails if the vectorised output differs from the scalar output by more than the tolerance."
+    );
+    init_parser(parser);
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    const auto args = get_args_from_parser(parser);
+    if ((args.transmission_mode < 1) || (args.transmission_mode > 4)) {
+        fprintf(stderr, "Transmission mode must be between 1 and 4 but got %d\n", args.transmission_mode);
+        return 1;
+    }
+    if (args.total_frames == 0) {
+        fprintf(stderr, "Number of frames must be greater than 0\n");
+        return 1;
+    }
+
+    const auto data = create_frame_data(args);
+    fprintf(stdout, "Transmission mode %d with %zu symbols of %zu samples in each frame\n",
+        args.transmission_mode, data.params.nb_frame_symbols, data.params.nb_symbol_period);
+
+    const float pll_error = check_apply_pll(data);
+    const float sum_error = check_conj_mul_sum(data);
+    fprintf(stdout, "%-24s %12s %12.3e\n", "apply_pll", "max error", pll_error);
+    fprintf(stdout, "%-24s %12s %12.3e\n", "complex_conj_mul_sum", "max error", sum_error);
+    if ((pll_error > args.tolerance) || (sum_error > args.tolerance)) {
+        fprintf(stderr, "Vectorised kernels exceeded the tolerance of %.3e\n", args.tolerance);
+        return 1;
+    }
+    fprintf(stdout, "\n");
+
+    run_timings(args, data);
+    return 0;
+}
@@ -0,0 +1,337 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+#include "dab/algorithms/reed_solomon_decoder.h"
+#include "dab/algorithms/reed_solomon_syndromes.h"
+#include "utility/span.h"
+
+void init_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("--aac-columns")
+        .default_value(size_t(24)).scan<'u', size_t>()
+        .metavar("TOTAL_COLUMNS")
+        .nargs(1).required()
+        .help("Number of RS(120,110) codewords in each DAB+ superframe. Default is a 192kbps subchannel");
+    parser.add_argument("--total-iterations")
+        .default_value(size_t(5000)).scan<'u', size_t>()
+        .metavar("TOTAL_ITERATIONS")
+        .nargs(1).required()
+        .help("Number of codeword tables decoded for each scenario");
+    parser.add_argument("--total-patterns")
+        .default_value(size_t(64)).scan<'u', size_t>()
+        .metavar("TOTAL_PATTERNS")
+        .nargs(1).required()
+        .help("Number of different error patterns that the iterations cycle through");
+    parser.add_argument("--error-probability")
+        .default_value(float(0.25f)).scan<'g', float>()
+        .metavar("PROBABILITY")
+        .nargs(1).required()
+        .help("Probability that a codeword is corrupted when errors are injected");
+    parser.add_argument("--seed")
+        .default_value(uint32_t(0)).scan<'u', uint32_t>()
+        .metavar("SEED")
+        .nargs(1).required()
+        .help("Seed for the messages and error patterns so runs are repeatable");
+}
+
+struct Args {
+    size_t aac_columns;
+    size_t total_iterations;
+    size_t total_patterns;
+    float error_probability;
+    uint32_t seed;
+};
+
+Args get_args_from_parser(const argparse::ArgumentParser& parser) {
+    Args args;
+    args.aac_columns = parser.get<size_t>("--aac-columns");
+    args.total_iterations = parser.get<size_t>("--total-iterations");
+    args.total_patterns = parser.get<size_t>("--total-patterns");
+    args.error_probability = parser.get<float>("--error-probability");
+    args.seed = parser.get<uint32_t>("--seed");
+    return args;
+}
+
+// Shortened RS code over GF(2^8) that is padded out to RS(255,255-nb_parity) for the decoder
+// DOC: ETSI TS 102 563 - Clause 6.1 uses RS(120,110) for DAB+ superframes
+// DOC: ETSI EN 300 401 - Clause 5.3.5.1 uses RS(204,188) for packet mode FEC frames
+struct Code_Params {
+    const char* name;
+    size_t nb_message;
+    size_t nb_parity;
+    size_t nb_columns;
+};
+
+// P(x) = x^8 + x^4 + x^3 + x^2 + 1 with fcr=0 and prim=1 for both codes
+constexpr int GALOIS_FIELD_POLY = 0b100011101;
+
+// Systematic encoder so the benchmark can create valid codewords
+// The first message symbol is the highest power of x which is the same order as the decoder
+class Reed_Solomon_Encoder
+{
+private:
+    uint8_t m_alpha_to[256] = {0};
+    uint8_t m_index_of[256] = {0};
+    std::vector<uint8_t> m_generator;
+    std::vector<uint8_t> m_remainder;
+public:
+    explicit Reed_Solomon_Encoder(const size_t nb_parity) {
+        int sr = 1;
+        for (int i = 0; i < 255; i++) {
+            m_index_of[sr] = uint8_t(i);
+            m_alpha_to[i] = uint8_t(sr);
+            sr <<= 1;
+            if (sr & (1 << 8)) sr ^= GALOIS_FIELD_POLY;
+            sr &= 255;
+        }
+        // G(x) = (x+λ^0)*(x+λ^1)*...*(x+λ^(nb_parity-1)) with the highest power first
+        m_generator = { 1 };
+        for (size_t i = 0; i < nb_parity; i++) {
+            const uint8_t root = m_alpha_to[i % 255];
+            std::vector<uint8_t> product(m_generator.size()+1, 0);
+            for (size_t j = 0; j < m_generator.size(); j++) {
+                product[j] ^= m_generator[j];
+                product[j+1] ^= mul(root, m_generator[j]);
+            }
+            m_generator = std::move(product);
+        }
+    }
+    uint8_t mul(const uint8_t x, const uint8_t y) const {
+        if (x == 0 || y == 0) return 0;
+        return m_alpha_to[(int(m_index_of[x]) + int(m_index_of[y])) % 255];
+    }
+    // Codeword is the message followed by the parity symbols
+    void Encode(tcb::span<uint8_t> codeword) {
+        const size_t nb_parity = m_generator.size()-1;
+        const size_t nb_data = codeword.size()-nb_parity;
+        m_remainder.assign(codeword.begin(), codeword.end());
+        std::fill_n(m_remainder.begin()+nb_data, nb_parity, uint8_t(0));
+        for (size_t i = 0; i < nb_data; i++) {
+            const uint8_t coeff = m_remainder[i];
+            if (coeff == 0) continue;
+            for (size_t j = 1; j <= nb_parity; j++) {
+                m_remainder[i+j] ^= mul(coeff, m_generator[j]);
+            }
+        }
+        std::copy_n(m_remainder.begin()+nb_data, nb_parity, codeword.begin()+nb_data);
+    }
+};
+
+// Codewords are interleaved column-wise the same way as the DAB+ superframe and packet mode FEC frame
+// Symbol j of codeword i is located at buf[i + j*nb_columns]
+class Codeword_Table_Decoder
+{
+private:
+    const Code_Params m_params;
+    Reed_Solomon_Decoder m_decoder;
+    Reed_Solomon_Syndromes m_syndromes;
+    std::vector<uint8_t> m_codeword;
+    std::vector<int> m_error_positions;
+public:
+    std::vector<uint8_t> is_error;
+public:
+    explicit Codeword_Table_Decoder(const Code_Params& params)
+    : m_params(params),
+      m_decoder(8, GALOIS_FIELD_POLY, 0, 1, int(params.nb_parity), int(255-params.nb_message)),
+      m_syndromes(GALOIS_FIELD_POLY, 0, 1, int(params.nb_parity))
+    {
+        m_codeword.resize(params.nb_message);
+        m_error_positions.resize(params.nb_parity);
+        is_error.resize(params.nb_columns);
+    }
+    // Only the codewords with a non-zero syndrome go through error location
+    void DecodeWithSyndromes(tcb::span<uint8_t> table) {
+        const size_t nb_errors = m_syndromes.Calculate(table, m_params.nb_columns, m_params.nb_message, is_error);
+        if (nb_errors == 0) return;
+        for (size_t i = 0; i < m_params.nb_columns; i++) {
+            if (is_error[i]) DecodeColumn(table, i);
+        }
+    }
+    // Every codeword goes through the decoder which is what happened before the syndrome check
+    void DecodeAll(tcb::span<uint8_t> table) {
+        for (size_t i = 0; i < m_params.nb_columns; i++) {
+            const int error_count = DecodeColumn(table, i);
+            is_error[i] = (error_count != 0) ? 1 : 0;
+        }
+    }
+private:
+    int DecodeColumn(tcb::span<uint8_t> table, const size_t column) {
+        const size_t N = m_params.nb_columns;
+        for (size_t j = 0; j < m_params.nb_message; j++) {
+            m_codeword[j] = table[column + j*N];
+        }
+        const int error_count = m_decoder.Decode(m_codeword.data(), m_error_positions.data(), 0);
+        const int nb_padding = int(255-m_params.nb_message);
+        for (int j = 0; j < error_count; j++) {
+            const int k = m_error_positions[j] - nb_padding;
+            if (k < 0) continue;
+            table[column + size_t(k)*N] = m_codeword[size_t(k)];
+        }
+        return error_count;
+    }
+};
+
+static std::vector<uint8_t> create_clean_table(const Code_Params& params, std::mt19937& rng) {
+    const size_t N = params.nb_columns;
+    auto encoder = Reed_Solomon_Encoder(params.nb_parity);
+    std::vector<uint8_t> codeword(params.nb_message);
+    std::vector<uint8_t> table(params.nb_message*N);
+    for (size_t i = 0; i < N; i++) {
+        for (auto& symbol: codeword) symbol = uint8_t(rng());
+        encoder.Encode(codeword);
+        for (size_t j = 0; j < params.nb_message; j++) {
+            table[i + j*N] = codeword[j];
+        }
+    }
+    return table;
+}
+
+// Corrupted codewords get between 1 and floor(nb_parity/2) symbol errors so they are always correctable
+static std::vector<uint8_t> create_error_pattern(
+    const Code_Params& params, tcb::span<const uint8_t> clean_table,
+    const float error_probability, std::mt19937& rng
+) {
+    const size_t N = params.nb_columns;
+    const size_t max_errors = params.nb_parity/2;
+    auto table = std::vector<uint8_t>(clean_table.begin(), clean_table.end());
+    auto is_corrupted = std::bernoulli_distribution(double(error_probability));
+    auto nb_errors_dist = std::uniform_int_distribution<size_t>(1, max_errors);
+    auto position_dist = std::uniform_int_distribution<size_t>(0, params.nb_message-1);
+    auto error_dist = std::uniform_int_distribution<int>(1, 255);
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < N; i++) {
+        if (!is_corrupted(rng)) continue;
+        const size_t nb_errors = nb_errors_dist(rng);
+        positions.clear();
+        while (positions.size() < nb_errors) {
+            const size_t j = position_dist(rng);
+            if (std::find(positions.begin(), positions.end(), j) != positions.end()) continue;
+            positions.push_back(j);
+            table[i + j*N] ^= uint8_t(error_dist(rng));
+        }
+    }
+    return table;
+}
+
+template <typename F>
+static double run_throughput(const char* name, const Code_Params& params, const size_t total_iterations, F&& process) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < total_iterations; i++) {
+        process(i);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(end-start).count();
+    const double codewords_per_second = (seconds > 0.0) ? double(total_iterations*params.nb_columns)/seconds : 0.0;
+    fprintf(stdout, "%-24s %-12s %12.0f codewords/s\n", params.name, name, codewords_per_second);
+    return codewords_per_second;
+}
+
+// Returns false if the syndrome check and the full decoder disagree
+static bool run_scenario(const Args& args, const Code_Params& params, const bool is_inject_errors) {
+    auto rng = std::mt19937(args.seed);
+    const auto clean_table = create_clean_table(params, rng);
+    std::vector<std::vector<uint8_t>> patterns;
+    const size_t total_patterns = is_inject_errors ? std::max(args.total_patterns, size_t(1)) : size_t(1);
+    for (size_t i = 0; i < total_patterns; i++) {
+        const float error_probability = is_inject_errors ? args.error_probability : 0.0f;
+        patterns.push_back(create_error_pattern(params, clean_table, error_probability, rng));
+    }
+
+    auto syndrome_decoder = Codeword_Table_Decoder(params);
+    auto full_decoder = Codeword_Table_Decoder(params);
+    std::vector<uint8_t> syndrome_table(clean_table.size());
+    std::vector<uint8_t> full_table(clean_table.size());
+
+    // Both paths must flag the same codewords and produce identical corrected tables
+    size_t total_flagged = 0;
+    for (size_t i = 0; i < total_patterns; i++) {
+        const auto& pattern = patterns[i];
+        syndrome_table = pattern;
+        full_table = pattern;
+        syndrome_decoder.DecodeWithSyndromes(syndrome_table);
+        full_decoder.DecodeAll(full_table);
+        for (size_t j = 0; j < params.nb_columns; j++) {
+            bool is_expected_error = false;
+            for (size_t k = 0; k < params.nb_message; k++) {
+                const size_t index = j + k*params.nb_columns;
+                is_expected_error |= (clean_table[index] != pattern[index]);
+            }
+            if ((syndrome_decoder.is_error[j] != full_decoder.is_error[j]) ||
+                (bool(full_decoder.is_error[j]) != is_expected_error))
+            {
+                fprintf(stderr, "[%s] Pattern %zu column %zu flagged differently syndrome=%u decoder=%u expected=%u\n",
+                    params.name, i, j,
+                    unsigned(syndrome_decoder.is_error[j]), unsigned(full_decoder.is_error[j]),
+                    unsigned(is_expected_error));
+                return false;
+            }
+            total_flagged += size_t(full_decoder.is_error[j]);
+        }
+        if (syndrome_table != full_table) {
+            fprintf(stderr, "[%s] Pattern %zu corrected tables differ between syndrome check and decoder\n",
+                params.name, i);
+            return false;
+        }
+        if (full_table != clean_table) {
+            fprintf(stderr, "[%s] Pattern %zu wasn't corrected back to the original codewords\n",
+                params.name, i);
+            return false;
+        }
+    }
+
+    fprintf(stdout, "%s with %zu codewords %s, %.1f%% of codewords flagged\n",
+        params.name, params.nb_columns, is_inject_errors ? "with injected errors" : "clean",
+        100.0*double(total_flagged)/double(total_patterns*params.nb_columns));
+    const double syndrome_rate = run_throughput("syndromes", params, args.total_iterations, [&](size_t i) {
+        syndrome_table = patterns[i % total_patterns];
+        syndrome_decoder.DecodeWithSyndromes(syndrome_table);
+    });
+    const double full_rate = run_throughput("decoder", params, args.total_iterations, [&](size_t i) {
+        full_table = patterns[i % total_patterns];
+        full_decoder.DecodeAll(full_table);
+    });
+    fprintf(stdout, "%-24s %-12s %12.2fx\n\n", params.name, "speedup", (full_rate > 0.0) ? syndrome_rate/full_rate : 0.0);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    auto parser = argparse::ArgumentParser("benchmark_reed_solomon", "0.1.0");
+    parser.add_description("Compares the vectorised Reed Solomon syndrome check against running the decoder on every codeword");
+    parser.add_epilog(
+        "Both paths are checked to flag the same codewords and to produce identical corrected output before they are timed.\n"
+        "Throughput includes copying each error pattern into the table that gets corrected."
+    );
+    init_parser(parser);
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    const auto args = get_args_from_parser(parser);
+    if (args.aac_columns == 0) {
+        fprintf(stderr, "Number of RS(120,110) codewords must be greater than 0\n");
+        return 1;
+    }
+
+    const Code_Params codes[] = {
+        { "RS(120,110) DAB+ audio", 120, 10, args.aac_columns },
+        { "RS(204,188) packet FEC", 204, 16, 12 },
+    };
+    for (const auto& params: codes) {
+        for (const bool is_inject_errors: { false, true }) {
+            if (!run_scenario(args, params, is_inject_errors)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
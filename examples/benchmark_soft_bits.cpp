@@ -0,0 +1,222 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+#include "dab/algorithms/dab_viterbi_decoder.h"
+#include "dab/algorithms/packed_soft_bits.h"
+#include "dab/msc/cif_deinterleaver.h"
+#include "utility/span.h"
+#include "viterbi_config.h"
+#include "./app_helpers/app_viterbi_channel.h"
+
+void init_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("--total-bytes")
+        .default_value(size_t(864*8)).scan<'u', size_t>()
+        .metavar("TOTAL_BYTES")
+        .nargs(1).required()
+        .help("Number of bytes in each logical frame given to the deinterleaver. Default is a full CIF of 864 CUs");
+    parser.add_argument("--total-frames")
+        .default_value(size_t(1000)).scan<'u', size_t>()
+        .metavar("TOTAL_FRAMES")
+        .nargs(1).required()
+        .help("Number of logical frames used for the throughput measurements");
+    parser.add_argument("--total-blocks")
+        .default_value(size_t(2000)).scan<'u', size_t>()
+        .metavar("TOTAL_BLOCKS")
+        .nargs(1).required()
+        .help("Number of viterbi blocks decoded for each Eb/N0 point");
+    parser.add_argument("--block-bytes")
+        .default_value(size_t(96)).scan<'u', size_t>()
+        .metavar("BLOCK_BYTES")
+        .nargs(1).required()
+        .help("Number of information bytes in each viterbi block");
+    parser.add_argument("--puncture-code")
+        .default_value(int(8)).scan<'i', int>()
+        .metavar("PI")
+        .nargs(1).required()
+        .help("Puncture code used for each viterbi block from 1 to 24. Default is close to code rate 1/2");
+    parser.add_argument("--ebno-start")
+        .default_value(float(0.0f)).scan<'g', float>()
+        .metavar("DB")
+        .nargs(1).required()
+        .help("First Eb/N0 point in dB");
+    parser.add_argument("--ebno-end")
+        .default_value(float(5.0f)).scan<'g', float>()
+        .metavar("DB")
+        .nargs(1).required()
+        .help("Last Eb/N0 point in dB");
+    parser.add_argument("--ebno-step")
+        .default_value(float(0.5f)).scan<'g', float>()
+        .metavar("DB")
+        .nargs(1).required()
+        .help("Step between Eb/N0 points in dB");
+    parser.add_argument("--seed")
+        .default_value(uint32_t(0)).scan<'u', uint32_t>()
+        .metavar("SEED")
+        .nargs(1).required()
+        .help("Seed for the payload and channel noise so runs are repeatable");
+}
+
+struct Args {
+    size_t total_bytes;
+    size_t total_frames;
+    size_t total_blocks;
+    size_t block_bytes;
+    int puncture_code;
+    float ebno_start;
+    float ebno_end;
+    float ebno_step;
+    uint32_t seed;
+};
+
+Args get_args_from_parser(const argparse::ArgumentParser& parser) {
+    Args args;
+    args.total_bytes = parser.get<size_t>("--total-bytes");
+    args.total_frames = parser.get<size_t>("--total-frames");
+    args.total_blocks = parser.get<size_t>("--total-blocks");
+    args.block_bytes = parser.get<size_t>("--block-bytes");
+    args.puncture_code = parser.get<int>("--puncture-code");
+    args.ebno_start = parser.get<float>("--ebno-start");
+    args.ebno_end = parser.get<float>("--ebno-end");
+    args.ebno_step = parser.get<float>("--ebno-step");
+    args.seed = parser.get<uint32_t>("--seed");
+    return args;
+}
+
+// Written to by every scenario so the compiler can't remove the work
+static volatile uint64_t benchmark_sink = 0;
+
+template <typename F>
+static void run_throughput(const char* name, const size_t total_frames, const size_t nb_bits, F&& process) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < total_frames; i++) {
+        process(i);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(end-start).count();
+    const double frames_per_second = (seconds > 0.0) ? double(total_frames)/seconds : 0.0;
+    const double mbits_per_second = frames_per_second*double(nb_bits)*1e-6;
+    fprintf(stdout, "%-32s %10.0f frames/s %10.1f Mbit/s\n", name, frames_per_second, mbits_per_second);
+}
+
+static void run_throughputs(const Args& args) {
+    const size_t nb_bits = args.total_bytes*8;
+    std::vector<viterbi_bit_t> bits_in(nb_bits);
+    std::vector<viterbi_bit_t> bits_out(nb_bits);
+    std::vector<uint8_t> packed(GetPackedSoftBitsSize(nb_bits));
+    auto rng = std::mt19937(args.seed);
+    auto dist = std::uniform_int_distribution<int>(SOFT_DECISION_VITERBI_LOW, SOFT_DECISION_VITERBI_HIGH);
+    for (auto& bit: bits_in) bit = viterbi_bit_t(dist(rng));
+
+    fprintf(stdout, "Throughput for logical frames of %zu bytes\n", args.total_bytes);
+    run_throughput("copy", args.total_frames, nb_bits, [&](size_t i) {
+        bits_in[0] = viterbi_bit_t(i);
+        std::copy(bits_in.begin(), bits_in.end(), bits_out.begin());
+        benchmark_sink = benchmark_sink + uint64_t(bits_out[nb_bits-1]);
+    });
+    run_throughput("pack", args.total_frames, nb_bits, [&](size_t i) {
+        bits_in[0] = viterbi_bit_t(i);
+        PackSoftBits(bits_in, packed);
+        benchmark_sink = benchmark_sink + uint64_t(packed.back());
+    });
+    run_throughput("unpack", args.total_frames, nb_bits, [&](size_t i) {
+        packed[0] = uint8_t(i);
+        UnpackSoftBits(packed, bits_out);
+        benchmark_sink = benchmark_sink + uint64_t(bits_out[nb_bits-1]);
+    });
+
+    auto deinterleaver = CIF_Deinterleaver(int(args.total_bytes));
+#if DAB_CORE_USE_PACKED_SOFT_BITS
+    const char* deinterleaver_name = "deinterleave (packed)";
+#else
+    const char* deinterleaver_name = "deinterleave (int8)";
+#endif
+    run_throughput(deinterleaver_name, args.total_frames, nb_bits, [&](size_t i) {
+        bits_in[0] = viterbi_bit_t(i);
+        deinterleaver.Consume(bits_in);
+        const bool is_ready = deinterleaver.Deinterleave(bits_out);
+        benchmark_sink = benchmark_sink + uint64_t(is_ready) + uint64_t(bits_out[nb_bits-1]);
+    });
+}
+
+static void run_bit_error_rates(const Args& args) {
+    ViterbiBlockLayout layout;
+    layout.nb_bytes = args.block_bytes;
+    layout.puncture_code = args.puncture_code;
+    const float code_rate = layout.get_code_rate();
+    const size_t nb_encoded_bits = layout.get_total_encoded_bits();
+
+    auto rng = std::mt19937(args.seed);
+    auto channel = QPSK_AWGN_Channel(args.seed+1u);
+    std::vector<uint8_t> tx_bytes(layout.nb_bytes);
+    std::vector<uint8_t> rx_bytes(layout.nb_bytes);
+    std::vector<viterbi_bit_t> soft_bits(nb_encoded_bits);
+    std::vector<viterbi_bit_t> packed_soft_bits(nb_encoded_bits);
+    std::vector<uint8_t> packed(GetPackedSoftBitsSize(nb_encoded_bits));
+    auto decoder = DAB_Viterbi_Decoder();
+    decoder.set_traceback_length(layout.nb_bytes*8);
+
+    fprintf(stdout, "Bit error rate for PI=%d with code rate %.3f over %zu blocks of %zu bytes\n",
+        layout.puncture_code, code_rate, args.total_blocks, layout.nb_bytes);
+    fprintf(stdout, "%8s %12s %12s\n", "Eb/N0", "int8", "packed");
+    const size_t total_steps = (args.ebno_step > 0.0f && args.ebno_end >= args.ebno_start) ?
+        size_t((args.ebno_end-args.ebno_start)/args.ebno_step + 0.5f) + 1 : 1;
+    for (size_t step = 0; step < total_steps; step++) {
+        const float EbN0_dB = args.ebno_start + float(step)*args.ebno_step;
+        size_t total_errors = 0;
+        size_t total_packed_errors = 0;
+        for (size_t i = 0; i < args.total_blocks; i++) {
+            for (auto& byte: tx_bytes) byte = uint8_t(rng());
+            const auto encoded_bits = encode_viterbi_block(layout, tx_bytes);
+            channel.transmit(encoded_bits, soft_bits, EbN0_dB, code_rate);
+
+            decode_viterbi_block(layout, decoder, soft_bits, rx_bytes);
+            total_errors += count_bit_errors(tx_bytes, rx_bytes);
+
+            PackSoftBits(soft_bits, packed);
+            UnpackSoftBits(packed, packed_soft_bits);
+            decode_viterbi_block(layout, decoder, packed_soft_bits, rx_bytes);
+            total_packed_errors += count_bit_errors(tx_bytes, rx_bytes);
+        }
+        const double total_bits = double(args.total_blocks*layout.nb_bytes*8);
+        fprintf(stdout, "%8.2f %12.3e %12.3e\n",
+            EbN0_dB, double(total_errors)/total_bits, double(total_packed_errors)/total_bits);
+    }
+}
+
+int main(int argc, char** argv) {
+    auto parser = argparse::ArgumentParser("benchmark_soft_bits", "0.1.0");
+    parser.add_description("Compares 8bit soft bits against packed 4bit soft bits for throughput and bit error rate");
+    parser.add_epilog(
+        "The deinterleaver is timed with whichever storage DAB_CORE_USE_PACKED_SOFT_BITS selected at compile time.\n"
+        "Bit error rates are measured over a QPSK channel with additive white gaussian noise."
+    );
+    init_parser(parser);
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    const auto args = get_args_from_parser(parser);
+    if ((args.puncture_code < 1) || (args.puncture_code > 24)) {
+        fprintf(stderr, "Puncture code must be between 1 and 24 but got %d\n", args.puncture_code);
+        return 1;
+    }
+    if (args.total_bytes == 0 || args.block_bytes == 0) {
+        fprintf(stderr, "Number of bytes must be greater than 0\n");
+        return 1;
+    }
+
+    run_throughputs(args);
+    fprintf(stdout, "\n");
+    run_bit_error_rates(args);
+    return 0;
+}
@@ -0,0 +1,281 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include <argparse/argparse.hpp>
+#include "dab/algorithms/dab_viterbi_decoder.h"
+#include "dab/constants/dab_parameters.h"
+#include "utility/span.h"
+#include "viterbi_config.h"
+#include "./app_helpers/app_viterbi_channel.h"
+
+void init_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("-i", "--input")
+        .default_value(std::string(""))
+        .metavar("INPUT_FILENAME")
+        .nargs(1).required()
+        .help("Soft bits from ofdm_offline_demod of a simulate_transmitter viterbi payload. Use '-' for stdin. Uses a simulated channel if empty");
+    parser.add_argument("-m", "--transmission-mode")
+        .default_value(int(1)).scan<'i', int>()
+        .choices(1,2,3,4)
+        .metavar("MODE")
+        .nargs(1).required()
+        .help("Dab transmission mode of the input");
+    parser.add_argument("--block-bytes")
+        .default_value(size_t(96)).scan<'u', size_t>()
+        .metavar("BLOCK_BYTES")
+        .nargs(1).required()
+        .help("Number of information bytes in each viterbi block");
+    parser.add_argument("--puncture-code")
+        .default_value(int(8)).scan<'i', int>()
+        .metavar("PI")
+        .nargs(1).required()
+        .help("Puncture code used for each viterbi block from 1 to 24");
+    parser.add_argument("--seed")
+        .default_value(uint32_t(0)).scan<'u', uint32_t>()
+        .metavar("SEED")
+        .nargs(1).required()
+        .help("Seed for the payload and channel noise. Must match the transmitter when reading an input");
+    parser.add_argument("--total-frames")
+        .default_value(size_t(0)).scan<'u', size_t>()
+        .metavar("TOTAL_FRAMES")
+        .nargs(1).required()
+        .help("Maximum number of frames read from the input. Reads until the end if this is 0");
+    parser.add_argument("--total-blocks")
+        .default_value(size_t(2000)).scan<'u', size_t>()
+        .metavar("TOTAL_BLOCKS")
+        .nargs(1).required()
+        .help("Number of viterbi blocks decoded for each Eb/N0 point of the simulated channel");
+    parser.add_argument("--ebno-start")
+        .default_value(float(0.0f)).scan<'g', float>()
+        .metavar("DB")
+        .nargs(1).required()
+        .help("First Eb/N0 point in dB of the simulated channel");
+    parser.add_argument("--ebno-end")
+        .default_value(float(5.0f)).scan<'g', float>()
+        .metavar("DB")
+        .nargs(1).required()
+        .help("Last Eb/N0 point in dB of the simulated channel");
+    parser.add_argument("--ebno-step")
+        .default_value(float(0.5f)).scan<'g', float>()
+        .metavar("DB")
+        .nargs(1).required()
+        .help("Step between Eb/N0 points in dB of the simulated channel");
+}
+
+struct Args {
+    std::string input_filename;
+    int transmission_mode;
+    size_t block_bytes;
+    int puncture_code;
+    uint32_t seed;
+    size_t total_frames;
+    size_t total_blocks;
+    float ebno_start;
+    float ebno_end;
+    float ebno_step;
+};
+
+Args get_args_from_parser(const argparse::ArgumentParser& parser) {
+    Args args;
+    args.input_filename = parser.get<std::string>("--input");
+    args.transmission_mode = parser.get<int>("--transmission-mode");
+    args.block_bytes = parser.get<size_t>("--block-bytes");
+    args.puncture_code = parser.get<int>("--puncture-code");
+    args.seed = parser.get<uint32_t>("--seed");
+    args.total_frames = parser.get<size_t>("--total-frames");
+    args.total_blocks = parser.get<size_t>("--total-blocks");
+    args.ebno_start = parser.get<float>("--ebno-start");
+    args.ebno_end = parser.get<float>("--ebno-end");
+    args.ebno_step = parser.get<float>("--ebno-step");
+    return args;
+}
+
+// Decoder for each metric with its own error count and timing
+class Metric_Result
+{
+private:
+    const char* m_name;
+    DAB_Viterbi_Decoder m_decoder;
+    std::vector<uint8_t> m_rx_bytes;
+    size_t m_total_bits = 0;
+    size_t m_total_bit_errors = 0;
+    size_t m_total_blocks = 0;
+    size_t m_total_block_errors = 0;
+    double m_total_seconds = 0.0;
+public:
+    Metric_Result(const char* name, const DAB_Viterbi_Decoder::Metric metric, const ViterbiBlockLayout& layout)
+    : m_name(name), m_decoder(metric)
+    {
+        m_decoder.set_traceback_length(layout.nb_bytes*8);
+        m_rx_bytes.resize(layout.nb_bytes);
+    }
+    void decode(const ViterbiBlockLayout& layout, tcb::span<const viterbi_bit_t> soft_bits, tcb::span<const uint8_t> tx_bytes) {
+        const auto start = std::chrono::steady_clock::now();
+        decode_viterbi_block(layout, m_decoder, soft_bits, m_rx_bytes);
+        const auto end = std::chrono::steady_clock::now();
+        m_total_seconds += std::chrono::duration<double>(end-start).count();
+        const size_t nb_errors = count_bit_errors(tx_bytes, m_rx_bytes);
+        m_total_bits += tx_bytes.size()*8;
+        m_total_bit_errors += nb_errors;
+        m_total_blocks++;
+        if (nb_errors > 0) m_total_block_errors++;
+    }
+    void reset() {
+        m_total_bits = 0;
+        m_total_bit_errors = 0;
+        m_total_blocks = 0;
+        m_total_block_errors = 0;
+        m_total_seconds = 0.0;
+    }
+    double get_bit_error_rate() const {
+        return (m_total_bits > 0) ? double(m_total_bit_errors)/double(m_total_bits) : 0.0;
+    }
+    double get_block_error_rate() const {
+        return (m_total_blocks > 0) ? double(m_total_block_errors)/double(m_total_blocks) : 0.0;
+    }
+    double get_mbits_per_second() const {
+        return (m_total_seconds > 0.0) ? double(m_total_bits)/m_total_seconds*1e-6 : 0.0;
+    }
+    const char* get_name() const { return m_name; }
+};
+
+static void print_header(const char* label_name) {
+    fprintf(stdout, "%8s %6s %12s %12s %12s\n", label_name, "metric", "BER", "BLER", "Mbit/s");
+}
+
+static void print_result(const char* label, const Metric_Result& result) {
+    fprintf(stdout, "%8s %6s %12.3e %12.3e %12.2f\n",
+        label, result.get_name(),
+        result.get_bit_error_rate(), result.get_block_error_rate(), result.get_mbits_per_second());
+}
+
+static int run_simulated_channel(const Args& args, const ViterbiBlockLayout& layout) {
+    const float code_rate = layout.get_code_rate();
+    Metric_Result results[] = {
+        { "u16", DAB_Viterbi_Decoder::Metric::U16, layout },
+        { "u8", DAB_Viterbi_Decoder::Metric::U8, layout },
+    };
+
+    auto rng = std::mt19937(args.seed);
+    auto channel = QPSK_AWGN_Channel(args.seed+1u);
+    std::vector<uint8_t> tx_bytes(layout.nb_bytes);
+    std::vector<viterbi_bit_t> soft_bits(layout.get_total_encoded_bits());
+
+    fprintf(stdout, "Simulated QPSK channel with PI=%d and code rate %.3f over %zu blocks of %zu bytes\n",
+        layout.puncture_code, code_rate, args.total_blocks, layout.nb_bytes);
+    print_header("Eb/N0");
+    const size_t total_steps = (args.ebno_step > 0.0f && args.ebno_end >= args.ebno_start) ?
+        size_t((args.ebno_end-args.ebno_start)/args.ebno_step + 0.5f) + 1 : 1;
+    for (size_t step = 0; step < total_steps; step++) {
+        const float EbN0_dB = args.ebno_start + float(step)*args.ebno_step;
+        for (auto& result: results) result.reset();
+        for (size_t i = 0; i < args.total_blocks; i++) {
+            for (auto& byte: tx_bytes) byte = uint8_t(rng());
+            const auto encoded_bits = encode_viterbi_block(layout, tx_bytes);
+            channel.transmit(encoded_bits, soft_bits, EbN0_dB, code_rate);
+            for (auto& result: results) result.decode(layout, soft_bits, tx_bytes);
+        }
+        char label[16];
+        snprintf(label, sizeof(label), "%.2f", EbN0_dB);
+        for (const auto& result: results) print_result(label, result);
+    }
+    return 0;
+}
+
+static int run_input_file(const Args& args, const ViterbiBlockLayout& layout) {
+    FILE* fp_in = stdin;
+    if (args.input_filename != "-") {
+        fp_in = fopen(args.input_filename.c_str(), "rb");
+        if (fp_in == nullptr) {
+            fprintf(stderr, "Failed to open input file: '%s'\n", args.input_filename.c_str());
+            return 1;
+        }
+    }
+#if _WIN32
+    _setmode(_fileno(fp_in), _O_BINARY);
+#endif
+
+    const auto params = get_dab_parameters(args.transmission_mode);
+    const size_t nb_frame_bits = size_t(params.nb_frame_bits);
+    const auto payload = create_viterbi_frame_payload(layout, nb_frame_bits, args.seed);
+    if (payload.nb_blocks == 0) {
+        fprintf(stderr, "Viterbi block with %zu encoded bits doesn't fit in a frame with %zu bits\n",
+            layout.get_total_encoded_bits(), nb_frame_bits);
+        return 1;
+    }
+
+    Metric_Result results[] = {
+        { "u16", DAB_Viterbi_Decoder::Metric::U16, layout },
+        { "u8", DAB_Viterbi_Decoder::Metric::U8, layout },
+    };
+
+    const size_t nb_block_bits = layout.get_total_encoded_bits();
+    std::vector<viterbi_bit_t> frame_bits(nb_frame_bits);
+    size_t total_frames = 0;
+    while ((args.total_frames == 0) || (total_frames < args.total_frames)) {
+        const size_t nb_read = fread(frame_bits.data(), sizeof(viterbi_bit_t), nb_frame_bits, fp_in);
+        if (nb_read != nb_frame_bits) break;
+        total_frames++;
+        for (size_t i = 0; i < payload.nb_blocks; i++) {
+            const auto soft_bits = tcb::span<const viterbi_bit_t>(frame_bits).subspan(i*nb_block_bits, nb_block_bits);
+            const auto tx_bytes = tcb::span<const uint8_t>(payload.tx_bytes).subspan(i*layout.nb_bytes, layout.nb_bytes);
+            for (auto& result: results) result.decode(layout, soft_bits, tx_bytes);
+        }
+    }
+    if (fp_in != stdin) fclose(fp_in);
+
+    fprintf(stdout, "Input with PI=%d and code rate %.3f over %zu frames of %zu blocks with %zu bytes\n",
+        layout.puncture_code, layout.get_code_rate(), total_frames, payload.nb_blocks, layout.nb_bytes);
+    print_header("source");
+    for (const auto& result: results) print_result("input", result);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    auto parser = argparse::ArgumentParser("benchmark_viterbi", "0.1.0");
+    parser.add_description("Compares the 16bit and 8bit path metrics of the DAB viterbi decoder for bit error rate and throughput");
+    parser.add_epilog(
+        "Without an input the blocks are sent over a simulated QPSK channel with additive white gaussian noise.\n"
+        "With an input the blocks are read from the soft bits of a simulated transmission, e.g.\n"
+        "  simulate_transmitter --payload viterbi --snr 10 --total-frames 100 -o tx.raw\n"
+        "  ofdm_offline_demod -i tx.raw -o rx.bits\n"
+        "  benchmark_viterbi -i rx.bits"
+    );
+    init_parser(parser);
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    const auto args = get_args_from_parser(parser);
+    if ((args.puncture_code < 1) || (args.puncture_code > 24)) {
+        fprintf(stderr, "Puncture code must be between 1 and 24 but got %d\n", args.puncture_code);
+        return 1;
+    }
+    if (args.block_bytes == 0) {
+        fprintf(stderr, "Number of bytes must be greater than 0\n");
+        return 1;
+    }
+
+    ViterbiBlockLayout layout;
+    layout.nb_bytes = args.block_bytes;
+    layout.puncture_code = args.puncture_code;
+    if (args.input_filename.empty()) {
+        return run_simulated_channel(args, layout);
+    }
+    return run_input_file(args, layout);
+}
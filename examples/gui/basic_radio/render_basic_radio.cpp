@@ -14,11 +14,13 @@
 #include "basic_radio/basic_dab_channel.h"
 #include "basic_radio/basic_dab_plus_channel.h"
 #include "basic_radio/basic_data_packet_channel.h"
+#include "basic_radio/basic_msc_runner.h"
 #include "basic_radio/basic_radio.h"
 #include "basic_radio/basic_slideshow.h"
 #include "dab/database/dab_database.h"
 #include "dab/database/dab_database_entities.h"
 #include "dab/database/dab_database_types.h"
+#include "utility/latency_histogram.h"
 #include "../font_awesome_definitions.h"
 #include "./basic_radio_view_controller.h"
 #include "./formatters.h"
@@ -44,6 +46,7 @@ static void RenderSimple_LinkService(BasicRadio& radio, BasicRadioViewController
 static void RenderSimple_GlobalBasicAudioChannelControls(BasicRadio& radio);
 static void RenderSimple_Basic_DAB_Plus_Channel_Status(Basic_DAB_Plus_Channel& channel);
 static void RenderSimple_Basic_DAB_Channel_Status(Basic_DAB_Channel& channel);
+static void RenderSimple_Latency(BasicRadio& radio, Basic_MSC_Runner& runner);
 
 void RenderBasicRadio(BasicRadio& radio, BasicRadioViewController& controller) {
     auto lock = std::scoped_lock(radio.GetMutex());
@@ -405,6 +408,11 @@ void RenderSimple_Basic_Audio_Channel(BasicRadio& radio, BasicRadioViewControlle
     if (ImGui::Checkbox("Play audio", &v)) {
         controls.SetIsPlayAudio(v);
     }
+    v = controls.GetIsDecodePCM();
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Decode PCM", &v)) {
+        controls.SetIsDecodePCM(v);
+    }
 
     const auto ascty = channel.GetType();
     switch (ascty) {
@@ -418,6 +426,7 @@ void RenderSimple_Basic_Audio_Channel(BasicRadio& radio, BasicRadioViewControlle
     default:
         break;
     }
+    RenderSimple_Latency(radio, channel);
 
     // Programme associated data
     // 1. Dynamic label
@@ -430,6 +439,7 @@ void RenderSimple_Basic_Audio_Channel(BasicRadio& radio, BasicRadioViewControlle
 }
 
 void RenderSimple_Basic_Data_Channel(BasicRadio& radio, BasicRadioViewController& controller, Basic_Data_Packet_Channel& channel, const subchannel_id_t subchannel_id) {
+    RenderSimple_Latency(radio, channel);
     auto& slideshow_manager = channel.GetSlideshowManager();
     RenderSimple_Slideshow_Manager(controller, slideshow_manager, subchannel_id);
 }
@@ -511,6 +521,42 @@ void RenderSimple_Basic_DAB_Channel_Status(Basic_DAB_Channel& channel) {
     }
 }
 
+void RenderSimple_Latency(BasicRadio& radio, Basic_MSC_Runner& runner) {
+    if (!ImGui::TreeNode("Latency")) return;
+    const auto& trace = runner.GetFrameTrace();
+    ImGui::Text("Frame: %" PRIu64 " Sample: %" PRIu64, trace.frame_index, trace.sample_index);
+    const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+    if (ImGui::BeginTable("Latency", 6, flags)) {
+        ImGui::TableSetupColumn("Stage", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Count", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Last", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("P50", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("P99", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("Max", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+        auto render_row = [](const char* label, const Latency_Histogram& histogram) {
+            const auto snapshot = histogram.GetSnapshot();
+            if (snapshot.count == 0) return;
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0); ImGui::TextWrapped("%s", label);
+            ImGui::TableSetColumnIndex(1); ImGui::Text("%" PRIu64, snapshot.count);
+            ImGui::TableSetColumnIndex(2); ImGui::Text("%.1fms", float(snapshot.last_us)*1e-3f);
+            ImGui::TableSetColumnIndex(3); ImGui::Text("%.1fms", snapshot.GetPercentile(0.5f)*1e-3f);
+            ImGui::TableSetColumnIndex(4); ImGui::Text("%.1fms", snapshot.GetPercentile(0.99f)*1e-3f);
+            ImGui::TableSetColumnIndex(5); ImGui::Text("%.1fms", float(snapshot.max_us)*1e-3f);
+        };
+        auto& radio_latency = radio.GetLatency();
+        auto& runner_latency = runner.GetLatency();
+        render_row("Radio input", radio_latency.input);
+        render_row("MSC decode", runner_latency.msc_decode);
+        render_row("Audio decode", runner_latency.audio_decode);
+        render_row("Audio output", runner_latency.audio_output);
+        render_row("Radio frame", radio_latency.process);
+        ImGui::EndTable();
+    }
+    ImGui::TreePop();
+}
+
 void RenderSimple_BasicSlideshowSelected(BasicRadio& radio, BasicRadioViewController& controller) {
     if (!controller.selected_slideshow.has_value()) {
         return;
@@ -68,6 +68,10 @@ void RenderControls(OFDM_Demod& demod) {
         ImGui::SliderFloat("Coarse freq slow beta", &cfg.sync.coarse_freq_slow_beta, 0.0f, 1.0f);
         ImGui::SliderFloat("Impulse peak threshold (dB)", &cfg.sync.impulse_peak_threshold_db, 0, 100.0f, "%.f");
         ImGui::SliderFloat("Impulse peak distance weight", &cfg.sync.impulse_peak_distance_probability, 0.0f, 1.0f, "%.3f");
+        ImGui::Checkbox("Tracking mode", &cfg.sync.is_tracking_mode);
+        ImGui::SliderInt("Tracking coarse freq period", &cfg.sync.tracking_coarse_freq_period, 1, 100);
+        ImGui::SliderFloat("Tracking fine freq drift", &cfg.sync.tracking_fine_freq_drift_threshold, 0.0f, 0.5f, "%.2f");
+        ImGui::SliderFloat("Tracking impulse window", &cfg.sync.tracking_impulse_window_norm, 0.0f, 1.0f, "%.2f");
         static float null_threshold[2] = {0,0};
         null_threshold[0] = cfg.null_l1_search.thresh_null_start;
         null_threshold[1] = cfg.null_l1_search.thresh_null_end;
@@ -97,12 +101,15 @@ void RenderState(const OFDM_Demod& demod) {
         ImGui::Text("State: Unknown"); 
             break;
         }
+        ImGui::Text("Tracking: %s", demod.GetIsTracking() ? "true" : "false");
         ImGui::Text("Fine freq: %.2f Hz", demod.GetFineFrequencyOffset() * Fs);
         ImGui::Text("Coarse freq: %.2f Hz", demod.GetCoarseFrequencyOffset() * Fs);
         ImGui::Text("Net freq: %.2f Hz", demod.GetNetFrequencyOffset() * Fs);
         ImGui::Text("Signal level: %.2f", demod.GetSignalAverage());
         ImGui::Text("Frames read: %d", demod.GetTotalFramesRead());
         ImGui::Text("Frames desynced: %d", demod.GetTotalFramesDesync());
+        const auto latency = demod.GetFrameLatency().GetSnapshot();
+        ImGui::Text("Frame latency: %.2fms (p99 %.2fms)", latency.GetMean()*1e-3f, latency.GetPercentile(0.99f)*1e-3f);
     }
     ImGui::End();
 
@@ -232,6 +239,15 @@ void RenderSynchronisation(const OFDM_Demod& demod) {
     if (ImGui::Begin("Fine time synchronisation")) {
         if (ImPlot::BeginPlot("Fine time response")) {
             auto buf = demod.GetImpulseResponse();
+            // Impulse response is kept as linear power while tracking
+            static std::vector<float> impulse_response_dB;
+            if (demod.GetIsTracking()) {
+                impulse_response_dB.resize(buf.size());
+                for (size_t i = 0; i < buf.size(); i++) {
+                    impulse_response_dB[i] = 10.0f*std::log10(buf[i]);
+                }
+                buf = impulse_response_dB;
+            }
             ImPlot::SetupAxisLimits(ImAxis_Y1, -10, 90, ImPlotCond_Once);
             ImPlot::PlotLine("Impulse response", buf.data(), (int)buf.size());
             // Plot useful markers for fine time sync using time correlation
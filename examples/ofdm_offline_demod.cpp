@@ -0,0 +1,158 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include <argparse/argparse.hpp>
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include "viterbi_config.h"
+#include "./app_helpers/app_io_buffers.h"
+#include "./app_helpers/app_iq_readers.h"
+#include "./app_helpers/app_ofdm_offline_block.h"
+
+void init_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("-i", "--input")
+        .metavar("INPUT_FILENAME")
+        .nargs(1).required()
+        .help("Filename of IQ recording (must be a seekable file)");
+    parser.add_argument("-o", "--output")
+        .default_value(std::string(""))
+        .metavar("OUTPUT_FILENAME")
+        .nargs(1).required()
+        .help("Filename of OFDM soft bits (defaults to stdout)");
+    parser.add_argument("--transmission-mode")
+        .default_value(int(1)).scan<'i', int>()
+        .choices(1,2,3,4)
+        .metavar("MODE")
+        .nargs(1).required()
+        .help("Dab transmission mode");
+    {
+        auto arg = parser.add_argument("--input-mode")
+            .default_value(std::string("raw_u8"))
+            .metavar("MODE")
+            .nargs(1).required()
+            .help(fmt::format("Format of IQ recording ({})", fmt::join(tcb::span(iq_read_modes).subspan(1), ", ")));
+        // wav files have a header which prevents seeking to an arbitrary sample
+        for (size_t i = 1; i < iq_read_modes.size(); i++) {
+            arg.add_choice(iq_read_modes[i]);
+        }
+    }
+    parser.add_argument("--threads")
+        .default_value(size_t(0)).scan<'u', size_t>()
+        .metavar("TOTAL_THREADS")
+        .nargs(1).required()
+        .help("Number of chunks demodulated concurrently (0 = max number of threads)");
+    parser.add_argument("--chunk-frames")
+        .default_value(size_t(64)).scan<'u', size_t>()
+        .metavar("TOTAL_FRAMES")
+        .nargs(1).required()
+        .help("Number of frames in each chunk");
+    parser.add_argument("--lead-in-frames")
+        .default_value(size_t(8)).scan<'u', size_t>()
+        .metavar("TOTAL_FRAMES")
+        .nargs(1).required()
+        .help("Number of frames before each chunk used to acquire sync");
+    parser.add_argument("--block-size")
+        .default_value(size_t(8192)).scan<'u', size_t>()
+        .metavar("BLOCK_SIZE")
+        .nargs(1).required()
+        .help("Number of IQ samples read at once by each thread");
+    parser.add_argument("--disable-coarse-freq")
+        .default_value(false).implicit_value(true)
+        .help("Disable OFDM coarse frequency correction");
+}
+
+struct Args {
+    std::string input_filename;
+    std::string output_filename;
+    int transmission_mode;
+    std::string input_mode;
+    size_t total_threads;
+    size_t chunk_frames;
+    size_t lead_in_frames;
+    size_t block_size;
+    bool disable_coarse_freq;
+};
+
+Args get_args_from_parser(const argparse::ArgumentParser& parser) {
+    Args args;
+    args.input_filename = parser.get<std::string>("--input");
+    args.output_filename = parser.get<std::string>("--output");
+    args.transmission_mode = parser.get<int>("--transmission-mode");
+    args.input_mode = parser.get<std::string>("--input-mode");
+    args.total_threads = parser.get<size_t>("--threads");
+    args.chunk_frames = parser.get<size_t>("--chunk-frames");
+    args.lead_in_frames = parser.get<size_t>("--lead-in-frames");
+    args.block_size = parser.get<size_t>("--block-size");
+    args.disable_coarse_freq = parser.get<bool>("--disable-coarse-freq");
+    return args;
+}
+
+int main(int argc, char** argv) {
+    auto parser = argparse::ArgumentParser("ofdm_offline_demod", "0.1.0");
+    parser.add_description("Demodulates an IQ recording into OFDM soft bits using many threads");
+    parser.add_epilog(
+        "The recording is split into chunks of frames which are demodulated concurrently.\n"
+        "Each chunk acquires sync over the lead in frames from the end of the previous chunk.\n"
+        "The output can be piped into basic_radio_app with --configuration dab."
+    );
+    init_parser(parser);
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    const auto args = get_args_from_parser(parser);
+
+    if (args.block_size == 0) {
+        fprintf(stderr, "Block size cannot be zero\n");
+        return 1;
+    }
+    if (args.chunk_frames == 0) {
+        fprintf(stderr, "Chunk frames cannot be zero\n");
+        return 1;
+    }
+
+    FILE* fp_out = stdout;
+    if (!args.output_filename.empty()) {
+        fp_out = fopen(args.output_filename.c_str(), "wb+");
+        if (fp_out == nullptr) {
+            fprintf(stderr, "Failed to open output file: '%s'\n", args.output_filename.c_str());
+            return 1;
+        }
+    }
+
+#if _WIN32
+    _setmode(_fileno(fp_out), _O_BINARY);
+#endif
+
+    try {
+        auto offline_block = std::make_unique<OFDM_Offline_Block>(args.transmission_mode, args.input_filename, args.input_mode);
+        auto& cfg = offline_block->get_config();
+        cfg.nb_frames_per_chunk = args.chunk_frames;
+        cfg.nb_lead_in_frames = args.lead_in_frames;
+        cfg.nb_workers = args.total_threads;
+        cfg.block_size = args.block_size;
+        auto& demod_cfg = offline_block->get_demod_config();
+        demod_cfg.sync.is_coarse_freq_correction = !args.disable_coarse_freq;
+        offline_block->set_output_stream(std::make_shared<OutputFile<viterbi_bit_t>>(fp_out));
+        offline_block->run();
+        fprintf(stderr, "Wrote %zu frames (%zu missing)\n",
+            offline_block->get_total_frames_written(), offline_block->get_total_frames_missing());
+    } catch (const std::exception& ex) {
+        fprintf(stderr, "%s\n", ex.what());
+        return 1;
+    }
+    return 0;
+}
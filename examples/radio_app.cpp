@@ -5,6 +5,7 @@
 #include <exception>
 #include <functional>
 #include <iostream>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -21,14 +22,20 @@
 #include <fmt/format.h>
 #include <portaudio.h>
 #include "basic_radio/basic_audio_channel.h"
+#include "basic_radio/basic_database_cache.h"
+#include "basic_radio/basic_fic_runner.h"
 #include "basic_radio/basic_radio.h"
+#include "basic_radio/basic_thread_pool.h"
 #include "basic_scraper/basic_scraper.h"
 #include "dab/constants/dab_parameters.h"
+#include "dab/database/dab_database.h"
+#include "dab/database/dab_database_serialiser.h"
 #include "dab/database/dab_database_types.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
 #include "./app_helpers/app_audio.h"
 #include "./app_helpers/app_common_gui.h"
+#include "./app_helpers/app_frame_trace.h"
 #include "./app_helpers/app_io_buffers.h"
 #include "./app_helpers/app_iq_readers.h"
 #include "./app_helpers/app_logging.h"
@@ -96,9 +103,31 @@ void init_parser(argparse::ArgumentParser& parser) {
         .metavar("TOTAL_THREADS")
         .nargs(1).required()
         .help("Number of basic radio threads (0 = max number of threads)");
+    parser.add_argument("--radio-disable-adaptive-fic")
+        .default_value(false).implicit_value(true)
+        .help("Decode every FIB group each frame even when the ensemble database is stable");
+    parser.add_argument("--radio-viterbi-u8-fic")
+        .default_value(false).implicit_value(true)
+        .help("Decode the FIC with 8bit instead of 16bit Viterbi path metrics which use coarser soft decisions");
+    parser.add_argument("--radio-viterbi-u8-msc-level")
+        .default_value(int(0)).scan<'i', int>()
+        .metavar("PROTECTION_LEVEL")
+        .nargs(1).required()
+        .help("Decode subchannels with this protection level or stronger (1 is the strongest) with 8bit instead of 16bit Viterbi path metrics. "
+              "0 decodes every subchannel with 16bit path metrics");
+    parser.add_argument("--radio-awake-instances")
+        .default_value(size_t(2)).scan<'u', size_t>()
+        .metavar("TOTAL_INSTANCES")
+        .nargs(1).required()
+        .help("Number of recently tuned channels that keep their decoders, the rest only keep their database");
     parser.add_argument("--radio-enable-logging")
         .default_value(false).implicit_value(true)
         .help("Enable verbose logging for radio");
+    parser.add_argument("--radio-database-cache")
+        .default_value(std::string(""))
+        .metavar("CACHE_FOLDER")
+        .nargs(1).required()
+        .help("Folder where the database of each channel is cached for faster startup (disabled if empty)");
     parser.add_argument("--scraper-enable")
         .default_value(false).implicit_value(true)
         .help("Radio scraper will be used to save radio data to a directory");
@@ -133,7 +162,12 @@ struct Args {
     size_t ofdm_total_threads;
     bool ofdm_disable_coarse_freq;
     size_t radio_total_threads;
+    bool radio_disable_adaptive_fic;
+    bool radio_viterbi_u8_fic;
+    int radio_viterbi_u8_msc_level;
+    size_t radio_awake_instances;
     bool radio_enable_logging;
+    std::string radio_database_cache;
     bool scraper_enable;
     std::string scraper_output;
     bool scraper_disable_logging;
@@ -155,7 +189,12 @@ Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     args.ofdm_total_threads = parser.get<size_t>("--ofdm-total-threads");
     args.ofdm_disable_coarse_freq = parser.get<bool>("--ofdm-disable-coarse-freq");
     args.radio_total_threads = parser.get<size_t>("--radio-total-threads");
+    args.radio_disable_adaptive_fic = parser.get<bool>("--radio-disable-adaptive-fic");
+    args.radio_viterbi_u8_fic = parser.get<bool>("--radio-viterbi-u8-fic");
+    args.radio_viterbi_u8_msc_level = parser.get<int>("--radio-viterbi-u8-msc-level");
+    args.radio_awake_instances = parser.get<size_t>("--radio-awake-instances");
     args.radio_enable_logging = parser.get<bool>("--radio-enable-logging");
+    args.radio_database_cache = parser.get<std::string>("--radio-database-cache");
     args.scraper_enable = parser.get<bool>("--scraper-enable");
     args.scraper_output = parser.get<std::string>("--scraper-output");
     args.scraper_disable_logging = parser.get<bool>("--scraper-disable-logging");
@@ -170,29 +209,59 @@ private:
     const std::string m_name;
     BasicRadio m_radio;
     BasicRadioViewController m_view_controller;
+    std::string m_database_cache_path;
 public:
     template <typename... T>
     Radio_Instance(std::string_view name, T... args): m_name(name), m_radio(std::forward<T>(args)...) {}
+    ~Radio_Instance() { save_database_cache(); }
     auto& get_radio() { return m_radio; }
     auto& get_view_controller() { return m_view_controller; }
     std::string_view get_name() const { return m_name; }
+    void set_database_cache_path(std::string_view path) { m_database_cache_path = std::string(path); }
+    // NOTE: Load after attaching observers so they see the speculatively created channels
+    void load_database(const DAB_Database& db) {
+        m_radio.LoadDatabaseCache(db);
+    }
+    void load_database_cache() {
+        if (m_database_cache_path.empty()) return;
+        auto db = ReadDatabaseCache(m_database_cache_path);
+        if (!db.has_value()) return;
+        m_radio.LoadDatabaseCache(db.value());
+    }
+    void save_database_cache() {
+        if (m_database_cache_path.empty()) return;
+        auto lock = std::unique_lock(m_radio.GetMutex());
+        WriteDatabaseCache(m_database_cache_path, m_radio.GetDatabase());
+    }
+    std::vector<uint8_t> serialise_database() {
+        auto lock = std::unique_lock(m_radio.GetMutex());
+        return SerialiseDatabase(m_radio.GetDatabase());
+    }
 };
 
+// Keeps a radio for each channel that has been tuned to
+// - Only the most recently used instances are kept awake with their decoders and audio buffers
+// - The rest hibernate as a serialised database which warm starts a new radio when they are selected again
 class Basic_Radio_Switcher 
 {
 private:
     DAB_Parameters m_dab_params;
     std::shared_ptr<InputBuffer<viterbi_bit_t>> m_input_stream = nullptr;
+    std::shared_ptr<FrameTraceQueue> m_frame_traces = nullptr;
     std::vector<viterbi_bit_t> m_bits_buffer;
-    std::map<std::string, std::shared_ptr<Radio_Instance>> m_instances;
+    // awake instances ordered from most to least recently selected
+    std::list<std::pair<std::string, std::shared_ptr<Radio_Instance>>> m_instances;
+    std::map<std::string, std::vector<uint8_t>> m_hibernated_databases;
+    const size_t m_max_awake_instances;
     std::shared_ptr<Radio_Instance> m_selected_instance = nullptr;
     std::mutex m_mutex_selected_instance;
     size_t m_flush_reads = 0;
     std::function<std::shared_ptr<Radio_Instance>(const DAB_Parameters&,std::string_view)> m_create_instance;
 public:
     template <typename F>
-    Basic_Radio_Switcher(int transmission_mode, F&& create_instance)
+    Basic_Radio_Switcher(int transmission_mode, const size_t max_awake_instances, F&& create_instance)
     : m_dab_params(get_dab_parameters(transmission_mode)),
+      m_max_awake_instances(std::max(max_awake_instances, size_t(1))),
       m_create_instance(create_instance)
     {
         m_bits_buffer.resize(m_dab_params.nb_frame_bits);
@@ -200,23 +269,21 @@ public:
     void set_input_stream(std::shared_ptr<InputBuffer<viterbi_bit_t>> stream) { 
         m_input_stream = stream; 
     }
+    void set_frame_traces(std::shared_ptr<FrameTraceQueue> frame_traces) {
+        m_frame_traces = frame_traces;
+    }
     void flush_input_stream() {
         m_flush_reads = 5;
     }
     void switch_instance(std::string_view key) {
         auto lock = std::unique_lock(m_mutex_selected_instance);
-        auto res = m_instances.find(std::string(key));
-        std::shared_ptr<Radio_Instance> new_instance = nullptr;
-        if (res != m_instances.end()) {
-            new_instance = res->second;
-        } else {
-            new_instance = m_create_instance(m_dab_params, key);
-            m_instances.insert({ std::string(key), new_instance });
-        }
+        auto new_instance = wake_instance(key);
         if (m_selected_instance != new_instance) {
             flush_input_stream();
+            if (m_selected_instance != nullptr) m_selected_instance->save_database_cache();
         }
         m_selected_instance = new_instance;
+        hibernate_instances();
     }
     std::shared_ptr<Radio_Instance> get_instance() {
         auto lock = std::unique_lock(m_mutex_selected_instance);
@@ -224,17 +291,67 @@ public:
     }
     void run() {
         if (m_input_stream == nullptr) return;
+        // Decode frames in place from the ring instead of copying each frame out of it
+        auto ring = std::dynamic_pointer_cast<ThreadedRingBuffer<viterbi_bit_t>>(m_input_stream);
+        if (ring != nullptr) {
+            const size_t nb_frame_bits = m_bits_buffer.size();
+            while (true) {
+                const auto buf = ring->reserve_read(nb_frame_bits);
+                if (buf.size() < nb_frame_bits) return;
+                process_frame(buf.first(nb_frame_bits));
+                ring->commit_read(nb_frame_bits);
+            }
+        }
         while (true) {
             const size_t length = m_input_stream->read(m_bits_buffer);
             if (length != m_bits_buffer.size()) return;
+            process_frame(m_bits_buffer);
+        }
+    }
+private:
+    std::shared_ptr<Radio_Instance> wake_instance(std::string_view key) {
+        for (auto it = m_instances.begin(); it != m_instances.end(); ++it) {
+            if (it->first != key) continue;
+            m_instances.splice(m_instances.begin(), m_instances, it);
+            return it->second;
+        }
+        auto instance = m_create_instance(m_dab_params, key);
+        // A hibernated database is more recent than the cache on disk
+        DAB_Database db;
+        auto res = m_hibernated_databases.find(std::string(key));
+        if ((res != m_hibernated_databases.end()) && DeserialiseDatabase(res->second, db)) {
+            instance->load_database(db);
+        } else {
+            instance->load_database_cache();
+        }
+        if (res != m_hibernated_databases.end()) m_hibernated_databases.erase(res);
+        m_instances.push_front({ std::string(key), instance });
+        return instance;
+    }
+    void hibernate_instances() {
+        // NOTE: The selected instance was moved to the front so it is never hibernated
+        while (m_instances.size() > m_max_awake_instances) {
+            auto& [key, instance] = m_instances.back();
+            m_hibernated_databases[key] = instance->serialise_database();
+            fprintf(stderr, "radio instance '%s' is hibernating (%zu bytes)\n", key.c_str(), m_hibernated_databases[key].size());
+            // Decoders are freed once the gui releases its reference to the instance
+            m_instances.pop_back();
+        }
+    }
+    void process_frame(tcb::span<const viterbi_bit_t> buf) {
+        // Traces are popped for flushed frames so they stay matched with the stream
+        const auto trace = (m_frame_traces != nullptr) ? m_frame_traces->pop() : Frame_Trace{};
 
-            auto lock = std::unique_lock(m_mutex_selected_instance);
-            if (m_flush_reads > 0) {
-                m_flush_reads -= 1;
-                continue;
-            }
-            if (m_selected_instance == nullptr) continue;
-            m_selected_instance->get_radio().Process(m_bits_buffer);
+        auto lock = std::unique_lock(m_mutex_selected_instance);
+        if (m_flush_reads > 0) {
+            m_flush_reads -= 1;
+            return;
+        }
+        if (m_selected_instance == nullptr) return;
+        if (trace.IsValid()) {
+            m_selected_instance->get_radio().Process(buf, trace);
+        } else {
+            m_selected_instance->get_radio().Process(buf);
         }
     }
 };
@@ -307,6 +424,10 @@ int main(int argc, char** argv) {
         fprintf(stderr, "OFDM block size cannot be zero\n");
         return 1;
     }
+    if (args.radio_awake_instances == 0) {
+        fprintf(stderr, "At least one radio instance must be awake\n");
+        return 1;
+    }
 
     const auto tuner_default_channel = args.tuner_default_channel;
     if (block_frequencies.find(tuner_default_channel) == block_frequencies.end()) {
@@ -324,10 +445,17 @@ int main(int argc, char** argv) {
     ofdm_config.sync.is_coarse_freq_correction = !args.ofdm_disable_coarse_freq;
     // radio switcher
     auto audio_pipeline = std::make_shared<AudioPipeline>();
+    // NOTE: Only the selected instance decodes frames so every instance can share the same workers
+    auto radio_thread_pool = std::make_shared<BasicThreadPool>(args.radio_total_threads);
+    BasicRadio_Viterbi_Config viterbi_config;
+    if (args.radio_viterbi_u8_fic) viterbi_config.fic = DAB_Viterbi_Decoder::Metric::U8;
+    viterbi_config.msc_u8_protection_level = args.radio_viterbi_u8_msc_level;
     auto radio_switcher = std::make_shared<Basic_Radio_Switcher>(
-        args.transmission_mode,
-        [args, audio_pipeline](const DAB_Parameters& params, std::string_view channel_name) -> auto {
-            auto instance = std::make_shared<Radio_Instance>(channel_name, params, args.radio_total_threads);
+        args.transmission_mode, args.radio_awake_instances,
+        [args, audio_pipeline, radio_thread_pool, viterbi_config](const DAB_Parameters& params, std::string_view channel_name) -> auto {
+            auto instance = std::make_shared<Radio_Instance>(channel_name, params, radio_thread_pool, viterbi_config);
+            auto& fic_config = instance->get_radio().GetFICRunnerConfig();
+            fic_config.is_adaptive = !args.radio_disable_adaptive_fic;
             auto& radio = instance->get_radio(); 
             attach_audio_pipeline_to_radio(audio_pipeline, radio);
             if (args.scraper_enable) {
@@ -346,17 +474,23 @@ int main(int argc, char** argv) {
                     );
                 }
             }
+            if (!args.radio_database_cache.empty()) {
+                instance->set_database_cache_path(fmt::format("{}/{}.dabdb", args.radio_database_cache, channel_name));
+            }
             return instance;
         }
     );
     // ofdm input
-    auto iq_ring_buffer = std::make_shared<ThreadedRingBuffer<uint8_t>>(args.ofdm_block_size*sizeof(QuantisedIQ<uint8_t>)*2);
-    auto raw_iq_to_float = get_quantised_iq_file_reader<uint8_t>(iq_ring_buffer, true);
-    ofdm_block->set_input_stream(raw_iq_to_float);
+    // NOTE: Samples are converted to floats as they arrive so the demodulator can read them in place
+    auto iq_ring_buffer = std::make_shared<ThreadedRingBuffer<std::complex<float>>>(args.ofdm_block_size*2);
+    ofdm_block->set_input_stream(iq_ring_buffer);
     // connect ofdm to radio_switcher
     auto ofdm_to_radio_buffer = std::make_shared<ThreadedRingBuffer<viterbi_bit_t>>(dab_params.nb_frame_bits*2);
     ofdm_block->set_output_stream(ofdm_to_radio_buffer);
     radio_switcher->set_input_stream(ofdm_to_radio_buffer);
+    auto frame_traces = std::make_shared<FrameTraceQueue>();
+    ofdm_block->set_frame_traces(frame_traces);
+    radio_switcher->set_frame_traces(frame_traces);
     // device to ofdm
     auto device_list = std::make_shared<DeviceList>();
     auto device_source = std::make_shared<DeviceSource>(
@@ -370,7 +504,7 @@ int main(int argc, char** argv) {
                 device->SetNearestGain(args.tuner_manual_gain);
             }
             device->SetDataCallback([iq_ring_buffer](tcb::span<const uint8_t> bytes) {
-                return iq_ring_buffer->write(bytes);
+                return write_quantised_iq_to_ring<uint8_t>(*(iq_ring_buffer.get()), bytes);
             });
             device->SetFrequencyChangeCallback([radio_switcher](const std::string& label, const uint32_t freq) {
                 radio_switcher->switch_instance(label);
@@ -24,6 +24,7 @@
 #include <exception>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -39,6 +40,9 @@
 #endif
 
 #include <argparse/argparse.hpp>
+#include "utility/span.h"
+#include "./app_helpers/app_io_buffers.h"
+#include "./app_helpers/app_shared_memory_buffers.h"
 #include "./block_frequencies.h"
 
 extern "C" {
@@ -51,8 +55,8 @@ struct GlobalContext {
 };
 
 static GlobalContext global_context {};
-static int read_sync(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read);
-static int read_async(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read);
+static int read_sync(OutputBuffer<uint8_t>* output, const uint32_t out_block_size, uint32_t bytes_to_read);
+static int read_async(OutputBuffer<uint8_t>* output, const uint32_t out_block_size, uint32_t bytes_to_read);
 static int find_nearest_gain(rtlsdr_dev_t *dev, int target_gain);
 static int verbose_set_frequency(rtlsdr_dev_t *dev, uint32_t frequency);
 static int verbose_set_sample_rate(rtlsdr_dev_t *dev, uint32_t samp_rate);
@@ -106,6 +110,16 @@ void init_parser(argparse::ArgumentParser& parser) {
         .metavar("OUTPUT_FILENAME")
         .nargs(1).required()
         .help("Filename of output (defaults to stdout)");
+    parser.add_argument("--shm")
+        .default_value(std::string(""))
+        .metavar("SHM_NAME")
+        .nargs(1).required()
+        .help("Write to a shared memory ring buffer instead of a file so multiple apps can read without pipes (posix only)");
+    parser.add_argument("--shm-size")
+        .default_value(size_t(64*1024*1024)).scan<'u', size_t>()
+        .metavar("TOTAL_BYTES")
+        .nargs(1).required()
+        .help("Size of the shared memory ring buffer in bytes");
     parser.add_argument("-d", "--device")
         .default_value(int(0)).scan<'i', int>()
         .metavar("INDEX")
@@ -163,6 +177,8 @@ struct Args {
     std::optional<float> frequency_Hz;
     float sampling_rate;
     std::string output_filename;
+    std::string shm_name;
+    size_t shm_size;
     std::optional<int> device_index;
     float manual_gain;
     bool is_automatic_gain;
@@ -190,6 +206,8 @@ Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     }
     args.sampling_rate = parser.get<float>("--sampling-rate");
     args.output_filename = parser.get<std::string>("--output"); 
+    args.shm_name = parser.get<std::string>("--shm");
+    args.shm_size = parser.get<size_t>("--shm-size");
     const int device_index = parser.get<int>("--device");
     args.device_index = std::nullopt;
     if (parser.is_used("--device")) {
@@ -283,18 +301,29 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    FILE* fp_out = stdout;
-    if (!args.output_filename.empty()) {
-        fp_out = fopen(args.output_filename.c_str(), "wb+");
-        if (fp_out == nullptr) {
-            fprintf(stderr, "Failed to open output file: '%s'\n", args.output_filename.c_str());
+    std::shared_ptr<OutputBuffer<uint8_t>> output = nullptr;
+    if (!args.shm_name.empty()) {
+        try {
+            output = std::make_shared<SharedMemoryOutputBuffer<uint8_t>>(args.shm_name, args.shm_size);
+            fprintf(stderr, "Writing to shared memory '%s' with %zu bytes.\n", args.shm_name.c_str(), args.shm_size);
+        } catch (const std::exception& ex) {
+            fprintf(stderr, "%s\n", ex.what());
             return 1;
         }
-    }
-
+    } else {
+        FILE* fp_out = stdout;
+        if (!args.output_filename.empty()) {
+            fp_out = fopen(args.output_filename.c_str(), "wb+");
+            if (fp_out == nullptr) {
+                fprintf(stderr, "Failed to open output file: '%s'\n", args.output_filename.c_str());
+                return 1;
+            }
+        }
 #if _WIN32
-    _setmode(_fileno(fp_out), _O_BINARY);
+        _setmode(_fileno(fp_out), _O_BINARY);
 #endif
+        output = std::make_shared<OutputFile<uint8_t>>(fp_out);
+    }
 
     int device_index = 0;
     if (args.device_index.has_value()) {
@@ -360,10 +389,10 @@ int main(int argc, char **argv) {
     int read_result = 0;
     if (args.is_sync) {
         fprintf(stderr, "Reading samples in sync mode...\n");
-        read_result = read_sync(fp_out, uint32_t(args.block_size), uint32_t(args.bytes_to_read));
+        read_result = read_sync(output.get(), uint32_t(args.block_size), uint32_t(args.bytes_to_read));
     } else {
         fprintf(stderr, "Reading samples in async mode...\n");
-        read_result = read_async(fp_out, uint32_t(args.block_size), uint32_t(args.bytes_to_read));
+        read_result = read_async(output.get(), uint32_t(args.block_size), uint32_t(args.bytes_to_read));
     }
 
     if (global_context.is_user_exit) {
@@ -372,12 +401,13 @@ int main(int argc, char **argv) {
         fprintf(stderr, "\nLibrary error %d, exiting...\n", read_result);
     }
 
-    fclose(fp_out);
+    // NOTE: closes the file or signals shared memory readers that the stream has ended
+    output = nullptr;
     rtlsdr_close(global_context.device);
     return (read_result >= 0) ? read_result : -read_result;
 }
 
-int read_sync(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read) {
+int read_sync(OutputBuffer<uint8_t>* output, const uint32_t out_block_size, uint32_t bytes_to_read) {
     std::vector<uint8_t> buffer(out_block_size);
 
     while (!global_context.is_user_exit) {
@@ -393,7 +423,7 @@ int read_sync(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read)
             global_context.is_user_exit = true;
         }
 
-        if (fwrite(buffer.data(), 1, n_read, file) != size_t(n_read)) {
+        if (output->write(tcb::span(buffer).first(size_t(n_read))) != size_t(n_read)) {
             fprintf(stderr, "Short write, samples lost, exiting!\n");
             break;
         }
@@ -411,14 +441,14 @@ int read_sync(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read)
     return 0;
 }
 
-int read_async(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read) {
+int read_async(OutputBuffer<uint8_t>* output, const uint32_t out_block_size, uint32_t bytes_to_read) {
     struct context_t {
         uint32_t bytes_to_read;
-        FILE *file_out;
+        OutputBuffer<uint8_t>* output;
     } context;
 
     context.bytes_to_read = bytes_to_read;
-    context.file_out = file;
+    context.output = output;
 
     auto rtlsdr_callback = [](unsigned char *buf, uint32_t len, void *user_data) {
         if (user_data == nullptr) {
@@ -426,7 +456,7 @@ int read_async(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read
         }
 
         auto &local_context = *reinterpret_cast<context_t*>(user_data);
-        if (local_context.file_out == nullptr) {
+        if (local_context.output == nullptr) {
             return;
         }
 
@@ -440,7 +470,7 @@ int read_async(FILE *file, const uint32_t out_block_size, uint32_t bytes_to_read
             rtlsdr_cancel_async(global_context.device);
         }
 
-        if (fwrite(buf, 1, len, local_context.file_out) != len) {
+        if (local_context.output->write(tcb::span<const uint8_t>(buf, len)) != len) {
             fprintf(stderr, "Short write, samples lost, exiting!\n");
             global_context.is_user_exit = true;
             rtlsdr_cancel_async(global_context.device);
@@ -1,8 +1,11 @@
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <cmath>
 #include <complex>
 #include <exception>
 #include <iostream>
+#include <random>
 #include <string>
 #include <vector>
 #include "utility/span.h"
@@ -15,6 +18,7 @@
 #include <argparse/argparse.hpp>
 #include "app_helpers/app_iq_readers.h"
 #include "app_helpers/app_io_buffers.h"
+#include "app_helpers/app_viterbi_channel.h"
 #include "ofdm/dab_mapper_ref.h"
 #include "ofdm/dab_ofdm_params_ref.h"
 #include "ofdm/dab_prs_ref.h"
@@ -57,12 +61,50 @@ void init_parser(argparse::ArgumentParser& parser) {
         .metavar("OUTPUT_FILENAME")
         .nargs(1).required()
         .help("Filename of output from converter (defaults to stdout)");
+    parser.add_argument("--payload")
+        .default_value(std::string("scrambler"))
+        .choices("scrambler", "viterbi")
+        .metavar("PAYLOAD")
+        .nargs(1).required()
+        .help("Data sent in each frame (scrambler, viterbi). Viterbi sends encoded blocks that benchmark_viterbi can check");
+    parser.add_argument("--viterbi-block-bytes")
+        .default_value(size_t(96)).scan<'u', size_t>()
+        .metavar("BLOCK_BYTES")
+        .nargs(1).required()
+        .help("Number of information bytes in each viterbi block");
+    parser.add_argument("--viterbi-puncture-code")
+        .default_value(int(8)).scan<'i', int>()
+        .metavar("PI")
+        .nargs(1).required()
+        .help("Puncture code used for each viterbi block from 1 to 24");
+    parser.add_argument("--seed")
+        .default_value(uint32_t(0)).scan<'u', uint32_t>()
+        .metavar("SEED")
+        .nargs(1).required()
+        .help("Seed for the viterbi payload and channel noise");
+    parser.add_argument("--snr")
+        .scan<'g', float>()
+        .metavar("SNR")
+        .nargs(1)
+        .help("Add white gaussian noise to each frame with this signal to noise ratio in dB");
+    parser.add_argument("--total-frames")
+        .default_value(size_t(0)).scan<'u', size_t>()
+        .metavar("TOTAL_FRAMES")
+        .nargs(1).required()
+        .help("Number of frames to write. Writes forever if this is 0");
 }
 
 struct Args {
     int transmission_mode;
     float frequency;
     std::string output_filename;
+    std::string payload;
+    size_t viterbi_block_bytes;
+    int viterbi_puncture_code;
+    uint32_t seed;
+    bool is_noise;
+    float snr;
+    size_t total_frames;
 };
 
 Args get_args_from_parser(const argparse::ArgumentParser& parser) {
@@ -70,11 +112,53 @@ Args get_args_from_parser(const argparse::ArgumentParser& parser) {
     args.transmission_mode = parser.get<int>("--transmission-mode");
     args.frequency = parser.get<float>("--frequency");
     args.output_filename = parser.get<std::string>("--output");
+    args.payload = parser.get<std::string>("--payload");
+    args.viterbi_block_bytes = parser.get<size_t>("--viterbi-block-bytes");
+    args.viterbi_puncture_code = parser.get<int>("--viterbi-puncture-code");
+    args.seed = parser.get<uint32_t>("--seed");
+    args.is_noise = parser.is_used("--snr");
+    args.snr = args.is_noise ? parser.get<float>("--snr") : 0.0f;
+    args.total_frames = parser.get<size_t>("--total-frames");
     return args;
 }
 
+// Pack soft bits so the OFDM demodulator outputs them in the same order
+// DOC: ETSI EN 300 401
+// Clause 14.6 - Frequency interleaving: bit i and i+nb_carriers of a symbol are sent on carrier_mapper[i]
+// Clause 14.5 - QPSK symbol mapper: b0=1 has a negative real component and b1=1 has a negative imaginary component
+//               The modulator's phase index for each (b0,b1) is the inverse of its phase map
+static void map_bits_to_frame_bytes(
+    tcb::span<const uint8_t> bits, tcb::span<const int> carrier_mapper, tcb::span<uint8_t> frame_bytes
+) {
+    constexpr uint8_t PHASE_INDEX[2][2] = { {2,1}, {3,0} };
+    const size_t nb_carriers = carrier_mapper.size();
+    const size_t nb_symbol_bits = nb_carriers*2;
+    const size_t nb_symbol_bytes = nb_symbol_bits/8;
+    const size_t nb_symbols = bits.size()/nb_symbol_bits;
+    std::fill(frame_bytes.begin(), frame_bytes.end(), uint8_t(0));
+    for (size_t s = 0; s < nb_symbols; s++) {
+        const auto symbol_bits = bits.subspan(s*nb_symbol_bits, nb_symbol_bits);
+        auto symbol_bytes = frame_bytes.subspan(s*nb_symbol_bytes, nb_symbol_bytes);
+        for (size_t i = 0; i < nb_carriers; i++) {
+            const size_t j = size_t(carrier_mapper[i]);
+            const uint8_t phase = PHASE_INDEX[symbol_bits[i] & 0b1][symbol_bits[i+nb_carriers] & 0b1];
+            symbol_bytes[j/4] |= uint8_t(phase << (2*(j%4)));
+        }
+    }
+}
+
+static void add_noise(
+    tcb::span<const std::complex<float>> data, tcb::span<std::complex<float>> noisy_data,
+    const float sigma, std::mt19937& rng
+) {
+    auto noise = std::normal_distribution<float>(0.0f, sigma);
+    for (size_t i = 0; i < data.size(); i++) {
+        noisy_data[i] = data[i] + std::complex<float>(noise(rng), noise(rng));
+    }
+}
+
 template <typename T>
-void write_frame_to_file(
+bool write_frame_to_file(
     FILE* fp_out,
     tcb::span<const std::complex<float>> data, float scale,
     const bool is_little_endian
@@ -99,14 +183,13 @@ void write_frame_to_file(
         reverse_endian_inplace(components);
     }
 
-    while (true) {
-        const size_t N = quantised.size();
-        const size_t nb_write = fwrite(quantised.data(), sizeof(QuantisedIQ<T>), N, fp_out);
-        if (nb_write != N) {
-            fprintf(stderr, "Failed to write out frame %zu/%zu\n", nb_write, N);
-            break;
-        }
+    const size_t N = quantised.size();
+    const size_t nb_write = fwrite(quantised.data(), sizeof(QuantisedIQ<T>), N, fp_out);
+    if (nb_write != N) {
+        fprintf(stderr, "Failed to write out frame %zu/%zu\n", nb_write, N);
+        return false;
     }
+    return true;
 }
 
 int main(int argc, char** argv) {
@@ -121,6 +204,10 @@ int main(int argc, char** argv) {
         return 1;
     }
     const auto args = get_args_from_parser(parser);
+    if ((args.viterbi_puncture_code < 1) || (args.viterbi_puncture_code > 24)) {
+        fprintf(stderr, "Puncture code must be between 1 and 24 but got %d\n", args.viterbi_puncture_code);
+        return 1;
+    }
 
     FILE* fp_out = stdout;
     if (!args.output_filename.empty()) {
@@ -152,10 +239,23 @@ int main(int argc, char** argv) {
 
     // generate random digital data
     auto frame_bytes_buf = std::vector<uint8_t>(nb_frame_bytes);
-    auto scrambler = Scrambler();
-    scrambler.Reset();
-    for (size_t i = 0; i < nb_frame_bytes; i++) {
-        frame_bytes_buf[i] = scrambler.Process();
+    if (args.payload == "viterbi") {
+        ViterbiBlockLayout layout;
+        layout.nb_bytes = args.viterbi_block_bytes;
+        layout.puncture_code = args.viterbi_puncture_code;
+        const auto payload = create_viterbi_frame_payload(layout, nb_frame_bits, args.seed);
+        if (payload.nb_blocks == 0) {
+            fprintf(stderr, "Viterbi block with %zu encoded bits doesn't fit in a frame with %zu bits\n",
+                layout.get_total_encoded_bits(), nb_frame_bits);
+            return 1;
+        }
+        map_bits_to_frame_bytes(payload.encoded_bits, carrier_mapper, frame_bytes_buf);
+    } else {
+        auto scrambler = Scrambler();
+        scrambler.Reset();
+        for (size_t i = 0; i < nb_frame_bytes; i++) {
+            frame_bytes_buf[i] = scrambler.Process();
+        }
     }
 
     // perform OFDM modulation 
@@ -173,9 +273,31 @@ int main(int argc, char** argv) {
         apply_pll_auto(frame_out_buf, frame_out_buf, frequency_norm);
     }
 
+    // noise power is relative to the average power of the symbols excluding the null period
+    float noise_sigma = 0.0f;
+    if (args.is_noise) {
+        float signal_power = 0.0f;
+        for (size_t i = params.nb_null_period; i < frame_size; i++) {
+            signal_power += std::norm(frame_out_buf[i]);
+        }
+        signal_power /= float(frame_size - params.nb_null_period);
+        const float noise_power = signal_power / std::pow(10.0f, args.snr/10.0f);
+        noise_sigma = std::sqrt(noise_power/2.0f);
+    }
+
     const float scale = 1.0f/(float)params.nb_data_carriers * 4.0f;
     const bool is_little_endian = true;
-    write_frame_to_file<uint8_t>(fp_out, frame_out_buf, scale, is_little_endian);
+    auto rng = std::mt19937(args.seed);
+    auto noisy_frame_buf = std::vector<std::complex<float>>(args.is_noise ? frame_size : 0);
+    for (size_t i = 0; (args.total_frames == 0) || (i < args.total_frames); i++) {
+        // each frame gets a new noise realisation
+        tcb::span<const std::complex<float>> frame = frame_out_buf;
+        if (args.is_noise) {
+            add_noise(frame_out_buf, noisy_frame_buf, noise_sigma, rng);
+            frame = noisy_frame_buf;
+        }
+        if (!write_frame_to_file<uint8_t>(fp_out, frame, scale, is_little_endian)) break;
+    }
     fclose(fp_out);
     return 0;
 }
@@ -7,8 +7,10 @@
 #include "./basic_audio_controls.h"
 #include "./basic_audio_params.h"
 #include "./basic_msc_runner.h"
+#include "dab/algorithms/dab_viterbi_decoder.h"
 #include "dab/constants/dab_parameters.h"
 #include "dab/database/dab_database_entities.h"
+#include "utility/metrics.h"
 #include "utility/observable.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
@@ -36,10 +38,13 @@ protected:
     Observable<std::string_view> m_obs_dynamic_label;
     Observable<MOT_Entity> m_obs_MOT_entity;
 public:
-    explicit Basic_Audio_Channel(const DAB_Parameters& params, const Subchannel subchannel, const AudioServiceType audio_service_type);
+    explicit Basic_Audio_Channel(const DAB_Parameters& params, const Subchannel subchannel, const AudioServiceType audio_service_type, const DAB_Viterbi_Decoder::Metric viterbi_metric=DAB_Viterbi_Decoder::Metric::U16);
     virtual ~Basic_Audio_Channel() override;
     virtual void Process(tcb::span<const viterbi_bit_t> msc_bits_buf) override = 0;
+    bool GetIsDecoding() const override { return m_controls.GetAnyEnabled(); }
+    const Subchannel& GetSubchannel() const override { return m_subchannel; }
     AudioServiceType GetType(void) const { return m_audio_service_type; }
+    void CollectMetrics(Metrics_Writer& writer, const Metric_Labels& labels) const override;
     auto& GetControls(void) { return m_controls; }
     std::string_view GetDynamicLabel(void) const { return m_dynamic_label; }
     auto& GetSlideshowManager(void) { return *m_slideshow_manager; }
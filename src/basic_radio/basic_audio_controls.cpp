@@ -5,6 +5,7 @@
 constexpr uint8_t CONTROL_FLAG_DECODE_AUDIO = 0b10000000;
 constexpr uint8_t CONTROL_FLAG_DECODE_DATA  = 0b01000000;
 constexpr uint8_t CONTROL_FLAG_PLAY_AUDIO   = 0b00100000;
+constexpr uint8_t CONTROL_FLAG_DECODE_PCM   = 0b00010000;
 constexpr uint8_t CONTROL_FLAG_ALL_SELECTED = 0b11100000;
 
 bool Basic_Audio_Controls::GetAnyEnabled(void) const {
@@ -12,18 +13,18 @@ bool Basic_Audio_Controls::GetAnyEnabled(void) const {
 }
 
 bool Basic_Audio_Controls::GetAllEnabled(void) const {
-    return (flags == CONTROL_FLAG_ALL_SELECTED);
+    return (flags & CONTROL_FLAG_ALL_SELECTED) == CONTROL_FLAG_ALL_SELECTED;
 }
 
 void Basic_Audio_Controls::RunAll(void) {
-    flags = CONTROL_FLAG_ALL_SELECTED;
+    flags |= CONTROL_FLAG_ALL_SELECTED;
 }
 
 void Basic_Audio_Controls::StopAll(void) {
     flags = 0;
 }
 
-// Decode AAC audio elements
+// Extract audio elements and PAD without decoding them to PCM (pass-through)
 bool Basic_Audio_Controls::GetIsDecodeAudio(void) const {
     return (flags & CONTROL_FLAG_DECODE_AUDIO) != 0;
 }
@@ -32,6 +33,7 @@ void Basic_Audio_Controls::SetIsDecodeAudio(bool v) {
     SetFlag(CONTROL_FLAG_DECODE_AUDIO, v);
     if (!v) {
         SetFlag(CONTROL_FLAG_PLAY_AUDIO, false);
+        SetFlag(CONTROL_FLAG_DECODE_PCM, false);
     }
 }
 
@@ -56,6 +58,18 @@ void Basic_Audio_Controls::SetIsPlayAudio(bool v) {
     }
 }
 
+// Decode audio elements to PCM for consumers other than the sound device
+bool Basic_Audio_Controls::GetIsDecodePCM(void) const {
+    return (flags & (CONTROL_FLAG_DECODE_PCM | CONTROL_FLAG_PLAY_AUDIO)) != 0;
+}
+
+void Basic_Audio_Controls::SetIsDecodePCM(bool v) {
+    SetFlag(CONTROL_FLAG_DECODE_PCM, v);
+    if (v) {
+        SetFlag(CONTROL_FLAG_DECODE_AUDIO, true);
+    }
+}
+
 void Basic_Audio_Controls::SetFlag(const uint8_t flag, const bool state) {
     if (state) {
         flags |= flag;
@@ -11,7 +11,7 @@ public:
     bool GetAllEnabled(void) const;
     void RunAll(void);
     void StopAll(void);
-    // Decode AAC audio elements
+    // Extract audio elements and PAD without decoding them to PCM (pass-through)
     bool GetIsDecodeAudio(void) const;
     void SetIsDecodeAudio(bool);
     // Decode AAC data_stream_element
@@ -20,6 +20,10 @@ public:
     // Play audio data through sound device
     bool GetIsPlayAudio(void) const;
     void SetIsPlayAudio(bool);
+    // Decode audio elements to PCM for consumers other than the sound device
+    // This is implied by playing audio
+    bool GetIsDecodePCM(void) const;
+    void SetIsDecodePCM(bool);
 private:
     void SetFlag(const uint8_t flag, const bool state);
 };
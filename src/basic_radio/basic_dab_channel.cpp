@@ -12,6 +12,7 @@
 #include "dab/database/dab_database_entities.h"
 #include "dab/msc/msc_decoder.h"
 #include "dab/pad/pad_processor.h"
+#include "utility/metrics.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
 #include "./basic_audio_channel.h"
@@ -23,8 +24,8 @@
 #undef min // NOLINT
 #undef max // NOLINT
 
-Basic_DAB_Channel::Basic_DAB_Channel(const DAB_Parameters& params, const Subchannel subchannel, const AudioServiceType audio_service_type)
-: Basic_Audio_Channel(params, subchannel, audio_service_type) 
+Basic_DAB_Channel::Basic_DAB_Channel(const DAB_Parameters& params, const Subchannel subchannel, const AudioServiceType audio_service_type, const DAB_Viterbi_Decoder::Metric viterbi_metric)
+: Basic_Audio_Channel(params, subchannel, audio_service_type, viterbi_metric) 
 {
     m_pad_processor = std::make_unique<PAD_Processor>();
     m_mp2_decoder = std::make_unique<MP2_Audio_Decoder>();
@@ -55,16 +56,20 @@ void Basic_DAB_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_buf) {
         if (decoded_bytes.empty()) {
             continue;
         }
+        m_latency.msc_decode.RecordSince(m_frame_trace);
 
         m_obs_mp2_data.Notify(decoded_bytes);
 
-        if (!m_controls.GetAnyEnabled()) { 
+        // Pass-through mode only needs the raw frames
+        if (!m_controls.GetIsDecodeData() && !m_controls.GetIsDecodePCM()) { 
             continue;
         }
 
         const auto res = m_mp2_decoder->decode_frame(decoded_bytes);
+        m_statistics.nb_frames.Increment();
         if (!res.has_value()) {
             m_is_error = true;
+            m_statistics.nb_errors.Increment();
             continue;
         }
 
@@ -77,7 +82,7 @@ void Basic_DAB_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_buf) {
             m_pad_processor->Process(frame.fpad_data, frame.xpad_data);
         }
 
-        if (m_controls.GetIsPlayAudio()) {
+        if (m_controls.GetIsDecodePCM()) {
             const auto audio_data = frame.audio_data;
             if (frame.frame_header.is_stereo) {
                 const size_t N = audio_data.size();
@@ -103,11 +108,18 @@ void Basic_DAB_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_buf) {
             params.frequency = uint32_t(frame.frame_header.sample_rate);
             params.bytes_per_sample = 2;
             params.is_stereo = true;
+            m_latency.audio_decode.RecordSince(m_frame_trace);
             m_obs_audio_data.Notify(params, data);
         }
     }
 }
 
+void Basic_DAB_Channel::CollectMetrics(Metrics_Writer& writer, const Metric_Labels& labels) const {
+    Basic_Audio_Channel::CollectMetrics(writer, labels);
+    writer.AddCounter("dab_mp2_frames_total", "MPEG-1 audio frames passed to the decoder", labels, m_statistics.nb_frames.Get());
+    writer.AddCounter("dab_mp2_errors_total", "MPEG-1 audio frames the decoder failed to decode", labels, m_statistics.nb_errors.Get());
+}
+
 void Basic_DAB_Channel::SetupCallbacks(void) {
     m_pad_processor->OnLabelUpdate().Attach([this](const std::string& label) {
         m_dynamic_label = label;
@@ -115,7 +127,7 @@ void Basic_DAB_Channel::SetupCallbacks(void) {
         LOG_MESSAGE("dynamic_label={}", label);
     });
 
-    m_pad_processor->OnMOTUpdate().Attach([this](MOT_Entity entity) {
+    m_pad_processor->OnMOTUpdate().Attach([this](const MOT_Entity& entity) {
         auto slideshow = m_slideshow_manager->Process_MOT_Entity(entity);
         if (slideshow == nullptr) {
             m_obs_MOT_entity.Notify(entity);
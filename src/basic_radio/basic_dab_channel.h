@@ -6,6 +6,7 @@
 #include <vector>
 #include "dab/constants/dab_parameters.h"
 #include "dab/database/dab_database_entities.h"
+#include "utility/metrics.h"
 #include "utility/observable.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
@@ -15,6 +16,11 @@
 class PAD_Processor;
 class MP2_Audio_Decoder;
 
+struct Basic_DAB_Statistics {
+    Metric_Counter nb_frames;
+    Metric_Counter nb_errors;
+};
+
 // Audio channel player for DAB+
 class Basic_DAB_Channel: public Basic_Audio_Channel
 {
@@ -25,13 +31,16 @@ private:
     bool m_is_error = true;
     std::optional<MP2_Audio_Decoder::FrameHeader> m_audio_params = std::nullopt;
     Observable<tcb::span<const uint8_t>> m_obs_mp2_data;
+    Basic_DAB_Statistics m_statistics;
 public:
-    explicit Basic_DAB_Channel(const DAB_Parameters& params, const Subchannel subchannel, const AudioServiceType audio_service_type);
+    explicit Basic_DAB_Channel(const DAB_Parameters& params, const Subchannel subchannel, const AudioServiceType audio_service_type, const DAB_Viterbi_Decoder::Metric viterbi_metric=DAB_Viterbi_Decoder::Metric::U16);
     ~Basic_DAB_Channel() override;
     void Process(tcb::span<const viterbi_bit_t> msc_bits_buf) override;
     auto& OnMP2Data() { return m_obs_mp2_data; }
     bool GetIsError() const { return m_is_error; }
     const auto& GetAudioParams() const { return m_audio_params; }
+    const auto& GetStatistics() const { return m_statistics; }
+    void CollectMetrics(Metrics_Writer& writer, const Metric_Labels& labels) const override;
 private:
     void SetupCallbacks(void);
 };
@@ -11,6 +11,7 @@
 #include "dab/database/dab_database_entities.h"
 #include "dab/mot/MOT_entities.h"
 #include "dab/msc/msc_decoder.h"
+#include "utility/metrics.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
 #include "./basic_audio_channel.h"
@@ -20,8 +21,8 @@
 #define LOG_MESSAGE(...) BASIC_RADIO_LOG_MESSAGE(fmt::format(__VA_ARGS__))
 #define LOG_ERROR(...) BASIC_RADIO_LOG_ERROR(fmt::format(__VA_ARGS__))
 
-Basic_DAB_Plus_Channel::Basic_DAB_Plus_Channel(const DAB_Parameters& params, const Subchannel subchannel, const AudioServiceType audio_service_type)
-: Basic_Audio_Channel(params, subchannel, audio_service_type)
+Basic_DAB_Plus_Channel::Basic_DAB_Plus_Channel(const DAB_Parameters& params, const Subchannel subchannel, const AudioServiceType audio_service_type, const DAB_Viterbi_Decoder::Metric viterbi_metric)
+: Basic_Audio_Channel(params, subchannel, audio_service_type, viterbi_metric)
 {
     m_aac_frame_processor = std::make_unique<AAC_Frame_Processor>();
     m_aac_audio_decoder = nullptr;
@@ -48,11 +49,16 @@ void Basic_DAB_Plus_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_buf
         const auto cif_buf = msc_bits_buf.subspan(
             i*m_params.nb_cif_bits, 
               m_params.nb_cif_bits);
-        const auto decoded_bytes = m_msc_decoder->DecodeCIF(cif_buf);
+        // Decode straight into the superframe buffer to avoid copying each logical frame
+        const auto frame_buf = m_aac_frame_processor->GetNextFrameBuffer(size_t(m_msc_decoder->GetNbDecodedBytes()));
+        const auto decoded_bytes = frame_buf.empty() ? 
+            m_msc_decoder->DecodeCIF(cif_buf) : 
+            m_msc_decoder->DecodeCIF(cif_buf, frame_buf);
         // The MSC decoder can have 0 bytes if the deinterleaver is still collecting frames
         if (decoded_bytes.empty()) {
             continue;
         }
+        m_latency.msc_decode.RecordSince(m_frame_trace);
         m_aac_frame_processor->Process(decoded_bytes);
     }
 }
@@ -92,6 +98,14 @@ void Basic_DAB_Plus_Channel::SetupCallbacks(void) {
             m_obs_aac_data.Notify(m_super_frame_header, header, buf);
         }
 
+        // Pass-through mode skips the AAC decoder which is the most expensive part of the channel
+        if (!m_controls.GetIsDecodePCM()) {
+            if (au_index == 0) {
+                m_is_codec_error = false;
+            }
+            return;
+        }
+
         const auto res = m_aac_audio_decoder->DecodeFrame(buf);
         // reset error flag on new superframe
         if (au_index == 0) {
@@ -101,6 +115,7 @@ void Basic_DAB_Plus_Channel::SetupCallbacks(void) {
             LOG_ERROR("[aac-audio-decoder] error={} au_index={}/{}", 
                 res.error_code, au_index, nb_aus);
             m_is_codec_error = true;
+            m_statistics.nb_codec_errors.Increment();
             return;
         }
 
@@ -109,6 +124,7 @@ void Basic_DAB_Plus_Channel::SetupCallbacks(void) {
         params.frequency = audio_params.sampling_frequency;
         params.is_stereo = true;
         params.bytes_per_sample = 2;
+        m_latency.audio_decode.RecordSince(m_frame_trace);
         m_obs_audio_data.Notify(params, res.audio_buf);
     });
 
@@ -127,7 +143,7 @@ void Basic_DAB_Plus_Channel::SetupCallbacks(void) {
         LOG_MESSAGE("dynamic_label={}", label);
     });
 
-    pad_processor.OnMOTUpdate().Attach([this](MOT_Entity entity) {
+    pad_processor.OnMOTUpdate().Attach([this](const MOT_Entity& entity) {
         auto slideshow = m_slideshow_manager->Process_MOT_Entity(entity);
         if (slideshow == nullptr) {
             m_obs_MOT_entity.Notify(entity);
@@ -137,24 +153,39 @@ void Basic_DAB_Plus_Channel::SetupCallbacks(void) {
     // Listen for errors
     m_aac_frame_processor->OnFirecodeError().Attach([this](int frame_index, uint16_t crc_got, uint16_t crc_calc) {
         m_is_firecode_error = true;
+        m_statistics.nb_firecode_errors.Increment();
     });
 
     m_aac_frame_processor->OnRSError().Attach([this](int au_index, int total_aus) {
         m_is_rs_error = true;
+        m_statistics.nb_rs_errors.Increment();
     });
 
     m_aac_frame_processor->OnSuperFrameHeader().Attach([this](SuperFrameHeader header) {
         m_is_firecode_error = false;
         m_is_rs_error = false;
+        m_statistics.nb_superframes.Increment();
     });
 
     m_aac_frame_processor->OnAccessUnitCRCError().Attach([this](int au_index, int nb_aus, uint16_t crc_got, uint16_t crc_calc) {
         m_is_au_error = true;
+        m_statistics.nb_au_crc_errors.Increment();
     });
 
     m_aac_frame_processor->OnAccessUnit().Attach([this](int au_index, int nb_aus, tcb::span<uint8_t> data) {
         if (au_index == 0) {
             m_is_au_error = false;
         }
+        m_statistics.nb_access_units.Increment();
     });
 }
+
+void Basic_DAB_Plus_Channel::CollectMetrics(Metrics_Writer& writer, const Metric_Labels& labels) const {
+    Basic_Audio_Channel::CollectMetrics(writer, labels);
+    writer.AddCounter("dab_aac_superframes_total", "DAB+ superframes with a valid header", labels, m_statistics.nb_superframes.Get());
+    writer.AddCounter("dab_aac_firecode_errors_total", "DAB+ superframes which failed the firecode check", labels, m_statistics.nb_firecode_errors.Get());
+    writer.AddCounter("dab_aac_rs_errors_total", "DAB+ superframes with uncorrectable Reed Solomon errors", labels, m_statistics.nb_rs_errors.Get());
+    writer.AddCounter("dab_aac_access_units_total", "DAB+ access units passed to the decoders", labels, m_statistics.nb_access_units.Get());
+    writer.AddCounter("dab_aac_au_crc_errors_total", "DAB+ access units which failed the CRC check", labels, m_statistics.nb_au_crc_errors.Get());
+    writer.AddCounter("dab_aac_codec_errors_total", "DAB+ access units the AAC decoder failed to decode", labels, m_statistics.nb_codec_errors.Get());
+}
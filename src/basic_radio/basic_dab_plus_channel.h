@@ -5,6 +5,7 @@
 #include "dab/audio/aac_frame_processor.h"
 #include "dab/constants/dab_parameters.h"
 #include "dab/database/dab_database_entities.h"
+#include "utility/metrics.h"
 #include "utility/observable.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
@@ -13,6 +14,15 @@
 class AAC_Audio_Decoder;
 class AAC_Data_Decoder;
 
+struct Basic_DAB_Plus_Statistics {
+    Metric_Counter nb_superframes;
+    Metric_Counter nb_firecode_errors;
+    Metric_Counter nb_rs_errors;
+    Metric_Counter nb_access_units;
+    Metric_Counter nb_au_crc_errors;
+    Metric_Counter nb_codec_errors;
+};
+
 // Audio channel player for DAB+
 class Basic_DAB_Plus_Channel: public Basic_Audio_Channel
 {
@@ -25,10 +35,11 @@ private:
     bool m_is_rs_error = false;
     bool m_is_au_error = false;
     bool m_is_codec_error = false;
+    Basic_DAB_Plus_Statistics m_statistics;
     // superframe, header, audio_frame_data
     Observable<SuperFrameHeader, tcb::span<const uint8_t>, tcb::span<const uint8_t>> m_obs_aac_data;
 public:
-    explicit Basic_DAB_Plus_Channel(const DAB_Parameters& params, const Subchannel subchannel, const AudioServiceType audio_service_type);
+    explicit Basic_DAB_Plus_Channel(const DAB_Parameters& params, const Subchannel subchannel, const AudioServiceType audio_service_type, const DAB_Viterbi_Decoder::Metric viterbi_metric=DAB_Viterbi_Decoder::Metric::U16);
     ~Basic_DAB_Plus_Channel() override;
     void Process(tcb::span<const viterbi_bit_t> msc_bits_buf) override;
     const auto& GetSuperFrameHeader() const { return m_super_frame_header; }
@@ -36,6 +47,8 @@ public:
     bool IsRSError() const { return m_is_rs_error; }
     bool IsAUError() const { return m_is_au_error; }
     bool IsCodecError() const { return m_is_codec_error; }
+    const auto& GetStatistics() const { return m_statistics; }
+    void CollectMetrics(Metrics_Writer& writer, const Metric_Labels& labels) const override;
     auto& OnAACData() { return m_obs_aac_data; }
 private:
     void SetupCallbacks(void);
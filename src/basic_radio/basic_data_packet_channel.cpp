@@ -10,6 +10,7 @@
 #include "dab/msc/msc_data_packet_processor.h"
 #include "dab/msc/msc_decoder.h"
 #include "dab/msc/msc_reed_solomon_data_packet_processor.h"
+#include "utility/metrics.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
 #include "./basic_radio_logging.h"
@@ -17,13 +18,13 @@
 #define LOG_MESSAGE(...) BASIC_RADIO_LOG_MESSAGE(fmt::format(__VA_ARGS__))
 #define LOG_ERROR(...) BASIC_RADIO_LOG_ERROR(fmt::format(__VA_ARGS__))
 
-Basic_Data_Packet_Channel::Basic_Data_Packet_Channel(const DAB_Parameters& params, Subchannel subchannel, packet_addr_t packet_addr, DataServiceType type)
+Basic_Data_Packet_Channel::Basic_Data_Packet_Channel(const DAB_Parameters& params, Subchannel subchannel, packet_addr_t packet_addr, DataServiceType type, const DAB_Viterbi_Decoder::Metric viterbi_metric)
 : m_params(params), m_subchannel(subchannel), m_packet_addr(packet_addr), m_type(type)
 {
     assert(subchannel.is_complete);
     assert(subchannel.fec_scheme != FEC_Scheme::UNDEFINED);
     m_msc_rs_data_packet_processor = nullptr;
-    m_msc_decoder = std::make_unique<MSC_Decoder>(m_subchannel);
+    m_msc_decoder = std::make_unique<MSC_Decoder>(m_subchannel, viterbi_metric);
     m_msc_data_packet_processor = std::make_unique<MSC_Data_Packet_Processor>();
     m_slideshow_manager = std::make_unique<Basic_Slideshow_Manager>();
     if (m_subchannel.fec_scheme == FEC_Scheme::REED_SOLOMON) {
@@ -32,7 +33,7 @@ Basic_Data_Packet_Channel::Basic_Data_Packet_Channel(const DAB_Parameters& param
             ProcessNonFECPackets(buf);
         });
     }
-    m_msc_data_packet_processor->Get_MOT_Processor().OnEntityComplete().Attach([this](MOT_Entity entity) {
+    m_msc_data_packet_processor->Get_MOT_Processor().OnEntityComplete().Attach([this](const MOT_Entity& entity) {
         auto slideshow = m_slideshow_manager->Process_MOT_Entity(entity);
         if (slideshow == nullptr) {
             m_obs_MOT_entity.Notify(entity);
@@ -62,6 +63,7 @@ void Basic_Data_Packet_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_
         if (buf.empty()) {
             continue;
         }
+        m_latency.msc_decode.RecordSince(m_frame_trace);
 
         if (m_msc_rs_data_packet_processor) {
             ProcessFECPackets(buf);
@@ -71,6 +73,10 @@ void Basic_Data_Packet_Channel::Process(tcb::span<const viterbi_bit_t> msc_bits_
     }
 }
 
+void Basic_Data_Packet_Channel::CollectMetrics(Metrics_Writer& writer, const Metric_Labels& labels) const {
+    CollectMSCMetrics(writer, labels, m_msc_decoder->GetStatistics());
+}
+
 void Basic_Data_Packet_Channel::ProcessFECPackets(tcb::span<const uint8_t> buf) {
     while (!buf.empty()) {
         const size_t total_read = m_msc_rs_data_packet_processor->ReadPacket(buf);
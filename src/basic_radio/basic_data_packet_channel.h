@@ -2,8 +2,10 @@
 
 #include <stdint.h>
 #include <memory>
+#include "dab/algorithms/dab_viterbi_decoder.h"
 #include "dab/constants/dab_parameters.h"
 #include "dab/database/dab_database_entities.h"
+#include "utility/metrics.h"
 #include "utility/observable.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
@@ -28,9 +30,12 @@ private:
     std::unique_ptr<Basic_Slideshow_Manager> m_slideshow_manager;
     Observable<MOT_Entity> m_obs_MOT_entity;
 public:
-    explicit Basic_Data_Packet_Channel(const DAB_Parameters& params, Subchannel subchannel, packet_addr_t packet_addr, DataServiceType type);
+    explicit Basic_Data_Packet_Channel(const DAB_Parameters& params, Subchannel subchannel, packet_addr_t packet_addr, DataServiceType type, const DAB_Viterbi_Decoder::Metric viterbi_metric=DAB_Viterbi_Decoder::Metric::U16);
     ~Basic_Data_Packet_Channel() override;
     void Process(tcb::span<const viterbi_bit_t> msc_bits_buf) override;
+    bool GetIsDecoding() const override { return true; }
+    const Subchannel& GetSubchannel() const override { return m_subchannel; }
+    void CollectMetrics(Metrics_Writer& writer, const Metric_Labels& labels) const override;
     auto& GetSlideshowManager() { return *m_slideshow_manager; }
     auto& OnMOTEntity() { return m_obs_MOT_entity; }
 private:
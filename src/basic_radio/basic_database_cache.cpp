@@ -0,0 +1,75 @@
+#include "./basic_database_cache.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <fmt/format.h>
+#include "dab/database/dab_database.h"
+#include "dab/database/dab_database_serialiser.h"
+#include "./basic_radio_logging.h"
+#define LOG_MESSAGE(...) BASIC_RADIO_LOG_MESSAGE(fmt::format(__VA_ARGS__))
+#define LOG_ERROR(...) BASIC_RADIO_LOG_ERROR(fmt::format(__VA_ARGS__))
+
+namespace fs = std::filesystem;
+
+std::optional<DAB_Database> ReadDatabaseCache(std::string_view filepath) {
+    const auto path = std::string(filepath);
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) return std::nullopt;
+
+    std::vector<uint8_t> buf;
+    uint8_t block[4096];
+    while (true) {
+        const size_t length = fread(block, sizeof(uint8_t), sizeof(block), fp);
+        buf.insert(buf.end(), block, block+length);
+        if (length != sizeof(block)) break;
+    }
+    fclose(fp);
+
+    DAB_Database db;
+    if (!DeserialiseDatabase(buf, db)) {
+        LOG_ERROR("Ignoring invalid database cache '{}'", path);
+        return std::nullopt;
+    }
+    LOG_MESSAGE("Loaded database cache '{}' with {} subchannels", path, db.subchannels.size());
+    return db;
+}
+
+bool WriteDatabaseCache(std::string_view filepath, const DAB_Database& db) {
+    if (!db.ensemble.is_complete) return false;
+
+    const auto path = fs::path(filepath);
+    std::error_code ec;
+    if (path.has_parent_path()) {
+        fs::create_directories(path.parent_path(), ec);
+    }
+
+    // Write to a temporary file first so a crash midway doesn't corrupt the existing cache
+    const auto buf = SerialiseDatabase(db);
+    const auto tmp_path = fs::path(path.string() + ".tmp");
+    FILE* fp = fopen(tmp_path.string().c_str(), "wb+");
+    if (fp == nullptr) {
+        LOG_ERROR("Failed to open database cache '{}'", tmp_path.string());
+        return false;
+    }
+    const size_t length = fwrite(buf.data(), sizeof(uint8_t), buf.size(), fp);
+    fclose(fp);
+    if (length != buf.size()) {
+        LOG_ERROR("Failed to write database cache '{}' ({}/{})", tmp_path.string(), length, buf.size());
+        fs::remove(tmp_path, ec);
+        return false;
+    }
+
+    fs::rename(tmp_path, path, ec);
+    if (ec) {
+        LOG_ERROR("Failed to replace database cache '{}': {}", path.string(), ec.message());
+        return false;
+    }
+    LOG_MESSAGE("Saved database cache '{}' with {} subchannels", path.string(), db.subchannels.size());
+    return true;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include "dab/database/dab_database.h"
+
+// Persists the last known database of an ensemble so the radio can warm start after a retune or restart
+std::optional<DAB_Database> ReadDatabaseCache(std::string_view filepath);
+// Only complete ensembles are written so we never warm start from a partially decoded FIC
+bool WriteDatabaseCache(std::string_view filepath, const DAB_Database& db);
@@ -1,4 +1,5 @@
 #include "./basic_fic_runner.h"
+#include <stddef.h>
 #include <stdint.h>
 #include <memory>
 #include <fmt/format.h>
@@ -13,24 +14,39 @@
 #define LOG_MESSAGE(...) BASIC_RADIO_LOG_MESSAGE(fmt::format(__VA_ARGS__))
 #define LOG_ERROR(...) BASIC_RADIO_LOG_ERROR(fmt::format(__VA_ARGS__))
 
-BasicFICRunner::BasicFICRunner(const DAB_Parameters& _params) 
+// FNV-1a 64bit hash
+static uint64_t calculate_fib_hash(tcb::span<const uint8_t> buf) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const uint8_t v: buf) {
+        hash ^= uint64_t(v);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+BasicFICRunner::BasicFICRunner(const DAB_Parameters& _params, const DAB_Viterbi_Decoder::Metric viterbi_metric) 
 : m_params(_params)
 {
     m_dab_db_updater = std::make_unique<DAB_Database_Updater>();
-    m_fic_decoder = std::make_unique<FIC_Decoder>(m_params.nb_fib_cif_bits, m_params.nb_fibs_per_cif);
+    m_fic_decoder = std::make_unique<FIC_Decoder>(m_params.nb_fib_cif_bits, m_params.nb_fibs_per_cif, viterbi_metric);
     m_fig_processor = std::make_unique<FIG_Processor>();
     m_fig_handler = std::make_unique<Radio_FIG_Handler>();
+    m_last_stats = std::make_unique<DatabaseUpdaterGlobalStatistics>();
 
     m_fig_handler->SetUpdater(m_dab_db_updater.get());
     m_fig_handler->SetMiscInfo(&m_misc_info);
     m_fig_processor->SetHandler(m_fig_handler.get());
     m_fic_decoder->OnFIB().Attach([this](tcb::span<const uint8_t> buf) {
-        m_fig_processor->ProcessFIB(buf);
+        OnFIB(buf);
     });
 }
 
 BasicFICRunner::~BasicFICRunner() = default;
 
+const FIC_Decoder_Statistics& BasicFICRunner::GetFICStatistics(void) const {
+    return m_fic_decoder->GetStatistics();
+}
+
 void BasicFICRunner::Process(tcb::span<const viterbi_bit_t> fic_bits_buf) {
     BASIC_RADIO_SET_THREAD_NAME("FIC");
 
@@ -41,9 +57,80 @@ void BasicFICRunner::Process(tcb::span<const viterbi_bit_t> fic_bits_buf) {
     }
 
 
+    m_frame_index++;
     for (int i = 0; i < m_params.nb_cifs; i++) {
+        // NOTE: m_is_throttled can be cleared by a FIB decoded earlier in this frame
+        const bool is_decode = !m_is_throttled || ((m_group_index % m_cfg.throttled_group_stride) == 0);
+        m_group_index++;
+        if (!is_decode) continue;
         const int N = m_params.nb_fib_cif_bits;
         const auto fib_cif_buf = fic_bits_buf.subspan(i*N, N);
         m_fic_decoder->DecodeFIBGroup(fib_cif_buf, i);
     }
-}
\ No newline at end of file
+
+    if (!m_cfg.is_adaptive) {
+        SetIsThrottled(false);
+        return;
+    }
+
+    const bool is_updated = CheckIsUpdated();
+    m_nb_stable_frames = is_updated ? 0 : (m_nb_stable_frames+1);
+    SetIsThrottled(m_nb_stable_frames >= m_cfg.nb_stable_frames);
+
+    // Forget FIBs that haven't been seen for a while
+    if ((m_frame_index % m_cfg.nb_fib_history_frames) == 0) {
+        for (auto it = m_fib_last_seen.begin(); it != m_fib_last_seen.end();) {
+            if ((m_frame_index - it->second) > m_cfg.nb_fib_history_frames) {
+                it = m_fib_last_seen.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void BasicFICRunner::OnFIB(tcb::span<const uint8_t> buf) {
+    if (!m_cfg.is_adaptive) {
+        m_fig_processor->ProcessFIB(buf);
+        return;
+    }
+
+    // FIBs are CRC checked so identical bytes carry identical FIGs
+    const uint64_t hash = calculate_fib_hash(buf);
+    auto res = m_fib_last_seen.find(hash);
+    const bool is_seen = 
+        (res != m_fib_last_seen.end()) && 
+        ((m_frame_index - res->second) <= m_cfg.nb_fib_history_frames);
+    m_fib_last_seen[hash] = m_frame_index;
+    if (is_seen) return;
+
+    // NOTE: The FIB carrying fig 0/0 is always unseen since it contains the CIF counter
+    //       So we only restore full rate if the new FIB actually changed something
+    m_fig_processor->ProcessFIB(buf);
+    if (CheckIsUpdated()) {
+        m_nb_stable_frames = 0;
+        SetIsThrottled(false);
+    }
+}
+
+bool BasicFICRunner::CheckIsUpdated(void) {
+    const auto& stats = m_dab_db_updater->GetStatistics();
+    bool is_updated = false;
+    if (stats != *m_last_stats) {
+        *m_last_stats = stats;
+        is_updated = true;
+    }
+    // DOC: ETSI EN 300 401
+    // Clause 6.4.1: Ensemble information
+    // Change flags are set ahead of a multiplex reconfiguration
+    if (m_misc_info.change_flags != 0) {
+        is_updated = true;
+    }
+    return is_updated;
+}
+
+void BasicFICRunner::SetIsThrottled(const bool is_throttled) {
+    if (m_is_throttled == is_throttled) return;
+    m_is_throttled = is_throttled;
+    LOG_MESSAGE("FIC decoding is {}", is_throttled ? "throttled" : "at full rate");
+}
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
 #include <memory>
+#include <unordered_map>
 
+#include "dab/algorithms/dab_viterbi_decoder.h"
 #include "dab/constants/dab_parameters.h"
 #include "dab/dab_misc_info.h"
 #include "utility/span.h"
@@ -9,22 +13,53 @@
 
 class DAB_Database_Updater;
 class FIC_Decoder;
+struct FIC_Decoder_Statistics;
 class FIG_Processor;
 class Radio_FIG_Handler;
+struct DatabaseUpdaterGlobalStatistics;
+
+// Most of the FIC repeats the same FIGs once the ensemble is fully described
+// In adaptive mode we skip FIG processing for FIBs that were seen recently and decode fewer FIB groups
+// Full rate is restored when a reconfiguration is signalled or a new FIB changes the database
+struct BasicFICRunner_Config {
+    bool is_adaptive = true;
+    // frames without any database updates before we start skipping FIB groups (~10s in mode I)
+    size_t nb_stable_frames = 100;
+    // while throttled we decode one in every N FIB groups
+    // this is coprime to the number of CIFs per frame (1,2,4) so every CIF position is eventually decoded
+    size_t throttled_group_stride = 5;
+    // a FIB is considered to be seen recently if it was received within this many frames
+    size_t nb_fib_history_frames = 250;
+};
 
 class BasicFICRunner
 {
 private:
     const DAB_Parameters m_params;
+    BasicFICRunner_Config m_cfg;
     DAB_Misc_Info m_misc_info;
     std::unique_ptr<DAB_Database_Updater> m_dab_db_updater;
     std::unique_ptr<FIC_Decoder> m_fic_decoder;
     std::unique_ptr<FIG_Processor> m_fig_processor;
     std::unique_ptr<Radio_FIG_Handler> m_fig_handler;
+    // adaptive decoding
+    std::unordered_map<uint64_t, size_t> m_fib_last_seen;
+    std::unique_ptr<DatabaseUpdaterGlobalStatistics> m_last_stats;
+    size_t m_frame_index = 0;
+    size_t m_group_index = 0;
+    size_t m_nb_stable_frames = 0;
+    bool m_is_throttled = false;
 public:
-    explicit BasicFICRunner(const DAB_Parameters& _params);
+    explicit BasicFICRunner(const DAB_Parameters& _params, const DAB_Viterbi_Decoder::Metric viterbi_metric=DAB_Viterbi_Decoder::Metric::U16);
     ~BasicFICRunner();
     void Process(tcb::span<const viterbi_bit_t> fic_bits_buf);
     auto& GetDatabaseUpdater(void) { return *(m_dab_db_updater.get()); }
     const auto& GetMiscInfo(void) { return m_misc_info; }
-};
\ No newline at end of file
+    auto& GetConfig(void) { return m_cfg; }
+    bool GetIsThrottled(void) const { return m_is_throttled; }
+    const FIC_Decoder_Statistics& GetFICStatistics(void) const;
+private:
+    void OnFIB(tcb::span<const uint8_t> buf);
+    bool CheckIsUpdated(void);
+    void SetIsThrottled(const bool is_throttled);
+};
@@ -1,10 +1,49 @@
 #pragma once
 
+#include "dab/database/dab_database_entities.h"
+#include "dab/msc/msc_decoder.h"
+#include "utility/latency_histogram.h"
+#include "utility/metrics.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
 
+// Latency of each stage of a subchannel measured from when its frame was read by the demodulator
+// NOTE: This excludes the fixed delay of the time deinterleaver since data is traced to the frame that completes it
+struct Basic_Channel_Latency {
+    Latency_Histogram msc_decode;       // logical frame decoded from a CIF
+    Latency_Histogram audio_decode;     // PCM decoded from an access unit or MPEG-1 frame
+    Latency_Histogram audio_output;     // PCM written to an audio sink which is recorded by the application
+};
+
 class Basic_MSC_Runner {
+protected:
+    Frame_Trace m_frame_trace;
+    Basic_Channel_Latency m_latency;
 public:
     virtual ~Basic_MSC_Runner() {};
     virtual void Process(tcb::span<const viterbi_bit_t> msc_bits_buf) = 0;
+    // Lets the demodulator skip the symbols of subchannels that nobody is decoding
+    virtual bool GetIsDecoding() const = 0;
+    virtual const Subchannel& GetSubchannel() const = 0;
+    // Frame that the bits passed to the next call of Process() came from
+    void SetFrameTrace(const Frame_Trace& trace) { m_frame_trace = trace; }
+    // Valid inside callbacks that are notified during Process()
+    const auto& GetFrameTrace() const { return m_frame_trace; }
+    auto& GetLatency() { return m_latency; }
+    // Labels identify the radio and service this runner belongs to
+    virtual void CollectMetrics(Metrics_Writer& writer, const Metric_Labels& labels) const = 0;
+protected:
+    void CollectMSCMetrics(Metrics_Writer& writer, const Metric_Labels& labels, const MSC_Decoder_Statistics& stats) const {
+        writer.AddGauge("dab_msc_is_decoding", "Subchannel is being decoded", labels, GetIsDecoding() ? 1.0 : 0.0);
+        writer.AddCounter("dab_msc_frames_total", "Logical frames decoded from the subchannel", labels, stats.nb_decoded_frames.Get());
+        writer.AddCounter("dab_msc_viterbi_error_total", "Sum of the Viterbi decoder error of each logical frame", labels, stats.total_viterbi_error.Get());
+        const auto add_latency = [&writer, &labels](const char* stage, const Latency_Histogram& histogram) {
+            auto stage_labels = labels;
+            stage_labels.push_back({ "stage", stage });
+            writer.AddHistogram("dab_channel_latency_seconds", "Time from the frame being read by the demodulator to each decoding stage", stage_labels, histogram);
+        };
+        add_latency("msc_decode", m_latency.msc_decode);
+        add_latency("audio_decode", m_latency.audio_decode);
+        add_latency("audio_output", m_latency.audio_output);
+    }
 };
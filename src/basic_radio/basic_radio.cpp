@@ -1,14 +1,22 @@
 #include "./basic_radio.h"
 #include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
 #include <memory>
 #include <mutex>
+#include <utility>
+#include <vector>
 #include <fmt/format.h>
 #include "dab/constants/dab_parameters.h"
+#include "dab/constants/subchannel_protection_tables.h"
 #include "dab/dab_misc_info.h"
 #include "dab/database/dab_database.h"
 #include "dab/database/dab_database_entities.h"
 #include "dab/database/dab_database_types.h"
 #include "dab/database/dab_database_updater.h"
+#include "dab/fic/fic_decoder.h"
+#include "utility/latency_histogram.h"
+#include "utility/metrics.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
 #include "./basic_audio_channel.h"
@@ -22,11 +30,68 @@
 #define LOG_MESSAGE(...) BASIC_RADIO_LOG_MESSAGE(fmt::format(__VA_ARGS__))
 #define LOG_ERROR(...) BASIC_RADIO_LOG_ERROR(fmt::format(__VA_ARGS__))
 
-BasicRadio::BasicRadio(const DAB_Parameters& params, const size_t nb_threads)
-: m_params(params)
+// Speculative channels that the live FIC hasn't confirmed after this many frames are removed
+// This is roughly 10 seconds for transmission mode I with 96ms frames
+constexpr size_t SPECULATIVE_CHANNEL_TIMEOUT_FRAMES = 100;
+// DOC: ETSI EN 300 401
+// Clause 6.2.1: Basic sub-channel organisation - A capacity unit is 64 bits of a CIF
+constexpr int TOTAL_CAPACITY_UNIT_BITS = 64;
+
+static const Subchannel* find_subchannel(const DAB_Database& db, const subchannel_id_t id) {
+    for (const auto& e: db.subchannels) {
+        if (e.id == id) return &e;
+    }
+    return nullptr;
+}
+
+static const ServiceComponent* find_service_component(const DAB_Database& db, const subchannel_id_t id) {
+    for (const auto& e: db.service_components) {
+        if (e.subchannel_id == id) return &e;
+    }
+    return nullptr;
+}
+
+static DAB_Viterbi_Decoder::Metric get_msc_viterbi_metric(const BasicRadio_Viterbi_Config& config, const Subchannel& subchannel) {
+    const int level = GetSubchannelProtectionLevel(subchannel);
+    if (level <= config.msc_u8_protection_level) {
+        return DAB_Viterbi_Decoder::Metric::U8;
+    }
+    return DAB_Viterbi_Decoder::Metric::U16;
+}
+
+// Only compare the fields that determine how the subchannel is decoded
+static bool is_same_channel(
+    const Subchannel& a_subchannel, const ServiceComponent& a_component,
+    const Subchannel& b_subchannel, const ServiceComponent& b_component
+) {
+    return
+        (a_subchannel.start_address == b_subchannel.start_address) &&
+        (a_subchannel.length == b_subchannel.length) &&
+        (a_subchannel.is_uep == b_subchannel.is_uep) &&
+        (a_subchannel.uep_prot_index == b_subchannel.uep_prot_index) &&
+        (a_subchannel.eep_prot_level == b_subchannel.eep_prot_level) &&
+        (a_subchannel.eep_type == b_subchannel.eep_type) &&
+        (a_subchannel.fec_scheme == b_subchannel.fec_scheme) &&
+        (a_component.transport_mode == b_component.transport_mode) &&
+        (a_component.audio_service_type == b_component.audio_service_type) &&
+        (a_component.data_service_type == b_component.data_service_type) &&
+        (a_component.packet_address == b_component.packet_address);
+}
+
+BasicRadio::BasicRadio(
+    const DAB_Parameters& params, const size_t nb_threads, const Thread_Placement& placement,
+    const BasicRadio_Viterbi_Config& viterbi_config
+)
+: BasicRadio(params, std::make_shared<BasicThreadPool>(nb_threads, placement), viterbi_config)
+{}
+
+BasicRadio::BasicRadio(
+    const DAB_Parameters& params, std::shared_ptr<BasicThreadPool> thread_pool,
+    const BasicRadio_Viterbi_Config& viterbi_config
+)
+: m_params(params), m_viterbi_config(viterbi_config), m_thread_pool(thread_pool)
 {
-    m_thread_pool = std::make_unique<BasicThreadPool>(nb_threads);
-    m_fic_runner = std::make_unique<BasicFICRunner>(m_params);
+    m_fic_runner = std::make_unique<BasicFICRunner>(m_params, m_viterbi_config.fic);
     m_dab_misc_info = std::make_unique<DAB_Misc_Info>();
     m_dab_database = std::make_unique<DAB_Database>();
     m_dab_database_stats = std::make_unique<DatabaseUpdaterGlobalStatistics>();
@@ -38,7 +103,24 @@ size_t BasicRadio::GetTotalThreads() const {
     return m_thread_pool->GetTotalThreads();
 }
 
+BasicFICRunner_Config& BasicRadio::GetFICRunnerConfig() {
+    return m_fic_runner->GetConfig();
+}
+
+const Thread_Placement_Report& BasicRadio::GetPlacementReport() const {
+    return m_thread_pool->GetPlacementReport();
+}
+
 void BasicRadio::Process(tcb::span<const viterbi_bit_t> buf) {
+    Frame_Trace trace;
+    trace.frame_index = m_nb_frames_processed.Get();
+    trace.timestamp_ns = GetLatencyTimestamp();
+    Process(buf, trace);
+}
+
+void BasicRadio::Process(tcb::span<const viterbi_bit_t> buf, const Frame_Trace& trace) {
+    m_nb_frames_processed.Increment();
+    m_latency.input.RecordSince(trace);
     const int N = (int)buf.size();
     if (N != m_params.nb_frame_bits) {
         LOG_ERROR("Got incorrect number of frame bits {}/{}", N, m_params.nb_frame_bits);
@@ -54,14 +136,17 @@ void BasicRadio::Process(tcb::span<const viterbi_bit_t> buf) {
 
     for (const auto& [_, msc_runner]: m_msc_runners) {
         const auto runner = msc_runner;
+        runner->SetFrameTrace(trace);
         m_thread_pool->PushTask([runner, msc_buf]() {
             runner->Process(msc_buf);
         });
     }
 
     m_thread_pool->WaitAll();
+    m_latency.process.RecordSince(trace);
 
     UpdateAfterProcessing();
+    UpdateWantedSymbols();
 }
 
 Basic_Audio_Channel* BasicRadio::Get_Audio_Channel(const subchannel_id_t id) {
@@ -80,6 +165,79 @@ Basic_Data_Packet_Channel* BasicRadio::Get_Data_Packet_Channel(const subchannel_
     return res->second.get();
 }
 
+void BasicRadio::CollectMetrics(Metrics_Writer& writer, const Metric_Labels& labels) {
+    auto lock = std::scoped_lock(m_mutex_data);
+    writer.AddCounter("dab_radio_frames_total", "Frames passed to the radio", labels, m_nb_frames_processed.Get());
+    writer.AddGauge("dab_radio_subchannels", "Subchannels which have a decoder", labels, double(m_msc_runners.size()));
+    const auto add_latency = [&writer, &labels](const char* stage, const Latency_Histogram& histogram) {
+        auto stage_labels = labels;
+        stage_labels.push_back({ "stage", stage });
+        writer.AddHistogram("dab_radio_latency_seconds", "Time from the frame being read by the demodulator to each radio stage", stage_labels, histogram);
+    };
+    add_latency("input", m_latency.input);
+    add_latency("process", m_latency.process);
+
+    const auto& fic_stats = m_fic_runner->GetFICStatistics();
+    writer.AddCounter("dab_fic_groups_total", "FIB groups decoded from the FIC", labels, fic_stats.nb_fib_groups.Get());
+    writer.AddCounter("dab_fic_fibs_total", "FIBs decoded from the FIC", labels, fic_stats.nb_fibs.Get());
+    writer.AddCounter("dab_fic_fib_crc_errors_total", "FIBs which failed the CRC check", labels, fic_stats.nb_fib_crc_errors.Get());
+    writer.AddCounter("dab_fic_viterbi_error_total", "Sum of the Viterbi decoder error of each FIB group", labels, fic_stats.total_viterbi_error.Get());
+
+    const auto& db_stats = *m_dab_database_stats;
+    const auto add_entities = [&writer, &labels](const char* state, const size_t value) {
+        auto state_labels = labels;
+        state_labels.push_back({ "state", state });
+        writer.AddGauge("dab_database_entities", "Entities in the ensemble database", state_labels, double(value));
+    };
+    add_entities("total", db_stats.nb_total);
+    add_entities("pending", db_stats.nb_pending);
+    add_entities("completed", db_stats.nb_completed);
+    writer.AddGauge("dab_database_conflicts", "Entities with conflicting updates from the FIC", labels, double(db_stats.nb_conflicts));
+    writer.AddCounter("dab_database_updates_total", "Updates applied to the ensemble database", labels, db_stats.nb_updates);
+
+    const auto& ensemble = m_dab_database->ensemble;
+    if (ensemble.id.value != 0) {
+        auto ensemble_labels = labels;
+        ensemble_labels.push_back({ "ensemble_id", fmt::format("0x{:04X}", ensemble.id.get_unique_identifier()) });
+        ensemble_labels.push_back({ "ensemble_label", ensemble.label });
+        writer.AddGauge("dab_ensemble_info", "Identity of the decoded ensemble", ensemble_labels, 1.0);
+    }
+
+    for (const auto& [id, msc_runner]: m_msc_runners) {
+        auto runner_labels = labels;
+        runner_labels.push_back({ "subchannel", fmt::format("{}", id) });
+        const auto* service_component = find_service_component(*m_dab_database, id);
+        if (service_component != nullptr) {
+            runner_labels.push_back({ "service_id", fmt::format("0x{:04X}", service_component->service_id.get_unique_identifier()) });
+        }
+        msc_runner->CollectMetrics(writer, runner_labels);
+    }
+}
+
+void BasicRadio::LoadDatabaseCache(const DAB_Database& db) {
+    auto lock = std::scoped_lock(m_mutex_data);
+    if (!m_msc_runners.empty()) {
+        LOG_ERROR("Database cache can only be loaded before any channels are created");
+        return;
+    }
+
+    *m_dab_database = db;
+    m_cached_database = std::make_unique<DAB_Database>(db);
+    m_speculative_subchannels.clear();
+    m_nb_speculative_frames = 0;
+
+    for (const auto& subchannel: m_cached_database->subchannels) {
+        if (!subchannel.is_complete) continue;
+        const auto* service_component = find_service_component(*m_cached_database, subchannel.id);
+        if (!service_component) continue;
+        if (!service_component->is_complete) continue;
+        if (CreateChannel(subchannel, *service_component)) {
+            m_speculative_subchannels.push_back(subchannel.id);
+        }
+    }
+    LOG_MESSAGE("Speculatively created {} subchannels from database cache", m_speculative_subchannels.size());
+}
+
 void BasicRadio::UpdateAfterProcessing() {
     auto lock = std::scoped_lock(m_mutex_data);
     const auto& new_misc_info = m_fic_runner->GetMiscInfo();
@@ -90,8 +248,10 @@ void BasicRadio::UpdateAfterProcessing() {
 
     *m_dab_misc_info = new_misc_info;
 
+    // Removed speculative channels may need to be recreated with the live parameters
+    const bool is_removed = ValidateSpeculativeChannels(new_dab_database);
     const bool is_updated = new_dab_database_stats != *m_dab_database_stats;
-    if (!is_updated) return;
+    if (!is_updated && !is_removed) return;
     *m_dab_database = new_dab_database;
     *m_dab_database_stats = new_dab_database_stats;
 
@@ -102,53 +262,144 @@ void BasicRadio::UpdateAfterProcessing() {
             continue;
         }
  
-        const ServiceComponent* service_component = nullptr;
-        for (auto& e: m_dab_database->service_components) {
-            if (e.subchannel_id == subchannel.id) {
-                service_component = &e;
-                break;
-            }
-        }
+        const auto* service_component = find_service_component(*m_dab_database, subchannel.id);
         if (!service_component) {
             continue;
         }
         if (!service_component->is_complete) {
             continue;
         }
+        CreateChannel(subchannel, *service_component);
+    }
+}
 
-        const auto mode = service_component->transport_mode;
-        const auto audio_type = service_component->audio_service_type;
-        const auto data_type = service_component->data_service_type;
-        const auto packet_addr = service_component->packet_address;
-
-        if (audio_type == AudioServiceType::DAB_PLUS && mode == TransportMode::STREAM_MODE_AUDIO) {
-            LOG_MESSAGE("Added DAB+ subchannel {}", subchannel.id);
-            auto channel = std::make_shared<Basic_DAB_Plus_Channel>(m_params, subchannel, audio_type);
-            m_msc_runners.insert({ subchannel.id, channel });
-            m_audio_channels.insert({ subchannel.id, channel });
-            m_obs_audio_channel.Notify(subchannel.id, *channel);
-            continue;
+void BasicRadio::UpdateWantedSymbols() {
+    // The FIC is always decoded
+    std::vector<uint8_t> is_wanted(size_t(m_params.nb_symbols), 0);
+    for (int i = 0; i < m_params.nb_fic_symbols; i++) {
+        is_wanted[i] = 1;
+    }
+    // Frequency interleaving is per symbol so each subchannel occupies a fixed set of symbols in each CIF
+    for (const auto& [_, msc_runner]: m_msc_runners) {
+        if (!msc_runner->GetIsDecoding()) continue;
+        const auto& subchannel = msc_runner->GetSubchannel();
+        if (subchannel.length == 0) continue;
+        const int start_bit = subchannel.start_address*TOTAL_CAPACITY_UNIT_BITS;
+        const int end_bit = start_bit + subchannel.length*TOTAL_CAPACITY_UNIT_BITS;
+        for (int cif = 0; cif < m_params.nb_cifs; cif++) {
+            const int cif_bit = m_params.nb_fic_bits + cif*m_params.nb_cif_bits;
+            const int symbol_start = (cif_bit + start_bit) / m_params.nb_sym_bits;
+            const int symbol_end = std::min((cif_bit + end_bit - 1) / m_params.nb_sym_bits, m_params.nb_symbols-1);
+            for (int i = symbol_start; i <= symbol_end; i++) {
+                is_wanted[i] = 1;
+            }
         }
+    }
 
-        if (audio_type == AudioServiceType::DAB && mode == TransportMode::STREAM_MODE_AUDIO) {
-            LOG_MESSAGE("Added DAB subchannel {}", subchannel.id);
-            auto channel = std::make_shared<Basic_DAB_Channel>(m_params, subchannel, audio_type);
-            m_msc_runners.insert({ subchannel.id, channel });
-            m_audio_channels.insert({ subchannel.id, channel });
-            m_obs_audio_channel.Notify(subchannel.id, *channel);
-            continue;
-        } 
+    std::vector<int> wanted_symbols;
+    for (int i = 0; i < m_params.nb_symbols; i++) {
+        if (is_wanted[i]) wanted_symbols.push_back(i);
+    }
+    if (wanted_symbols == m_wanted_symbols) return;
+    m_wanted_symbols = std::move(wanted_symbols);
+    LOG_MESSAGE("Wanted symbols changed to {}/{}", m_wanted_symbols.size(), m_params.nb_symbols);
+    m_obs_wanted_symbols.Notify(m_wanted_symbols);
+}
+
+bool BasicRadio::CreateChannel(const Subchannel& subchannel, const ServiceComponent& service_component) {
+    const auto mode = service_component.transport_mode;
+    const auto audio_type = service_component.audio_service_type;
+    const auto data_type = service_component.data_service_type;
+    const auto packet_addr = service_component.packet_address;
+    const auto viterbi_metric = get_msc_viterbi_metric(m_viterbi_config, subchannel);
+
+    if (audio_type == AudioServiceType::DAB_PLUS && mode == TransportMode::STREAM_MODE_AUDIO) {
+        LOG_MESSAGE("Added DAB+ subchannel {}", subchannel.id);
+        auto channel = std::make_shared<Basic_DAB_Plus_Channel>(m_params, subchannel, audio_type, viterbi_metric);
+        m_msc_runners.insert({ subchannel.id, channel });
+        m_audio_channels.insert({ subchannel.id, channel });
+        m_obs_audio_channel.Notify(subchannel.id, *channel);
+        return true;
+    }
+
+    if (audio_type == AudioServiceType::DAB && mode == TransportMode::STREAM_MODE_AUDIO) {
+        LOG_MESSAGE("Added DAB subchannel {}", subchannel.id);
+        auto channel = std::make_shared<Basic_DAB_Channel>(m_params, subchannel, audio_type, viterbi_metric);
+        m_msc_runners.insert({ subchannel.id, channel });
+        m_audio_channels.insert({ subchannel.id, channel });
+        m_obs_audio_channel.Notify(subchannel.id, *channel);
+        return true;
+    } 
  
-        // DOC: EN 300 401
-        // Clause: 5.3.5 FEC for MSC packet mode
-        // Data packet channels require the FEC scheme to be defined for outer encoding
-        if (mode == TransportMode::PACKET_MODE_DATA && (subchannel.fec_scheme != FEC_Scheme::UNDEFINED)) {
-            LOG_MESSAGE("Added data packet subchannel {}", subchannel.id);
-            auto channel = std::make_shared<Basic_Data_Packet_Channel>(m_params, subchannel, packet_addr, data_type);
-            m_msc_runners.insert({ subchannel.id, channel });
-            m_data_packet_channels.insert({ subchannel.id, channel });
-            m_obs_data_packet_channel.Notify(subchannel.id, *channel);
+    // DOC: EN 300 401
+    // Clause: 5.3.5 FEC for MSC packet mode
+    // Data packet channels require the FEC scheme to be defined for outer encoding
+    if (mode == TransportMode::PACKET_MODE_DATA && (subchannel.fec_scheme != FEC_Scheme::UNDEFINED)) {
+        LOG_MESSAGE("Added data packet subchannel {}", subchannel.id);
+        auto channel = std::make_shared<Basic_Data_Packet_Channel>(m_params, subchannel, packet_addr, data_type, viterbi_metric);
+        m_msc_runners.insert({ subchannel.id, channel });
+        m_data_packet_channels.insert({ subchannel.id, channel });
+        m_obs_data_packet_channel.Notify(subchannel.id, *channel);
+        return true;
+    }
+
+    return false;
+}
+
+void BasicRadio::RemoveChannel(const subchannel_id_t id) {
+    // NOTE: Runners are only processed while the lock isn't held so this is safe
+    m_msc_runners.erase(id);
+    m_audio_channels.erase(id);
+    m_data_packet_channels.erase(id);
+}
+
+bool BasicRadio::ValidateSpeculativeChannels(const DAB_Database& live_database) {
+    if (m_speculative_subchannels.empty()) return false;
+    m_nb_speculative_frames++;
+
+    const bool is_timeout = m_nb_speculative_frames > SPECULATIVE_CHANNEL_TIMEOUT_FRAMES;
+    // The cache may belong to a different ensemble that was previously on this frequency
+    const auto& live_ensemble = live_database.ensemble;
+    const bool is_other_ensemble = live_ensemble.is_complete && !(live_ensemble.id == m_cached_database->ensemble.id);
+
+    bool is_removed = false;
+    auto it = m_speculative_subchannels.begin();
+    while (it != m_speculative_subchannels.end()) {
+        const subchannel_id_t id = *it;
+        const auto* live_subchannel = find_subchannel(live_database, id);
+        const auto* live_component = find_service_component(live_database, id);
+        const bool is_live_complete = 
+            (live_subchannel != nullptr) && live_subchannel->is_complete &&
+            (live_component != nullptr) && live_component->is_complete;
+
+        bool is_valid = false;
+        if (is_other_ensemble) {
+            LOG_MESSAGE("Removing speculative subchannel {} since ensemble changed", id);
+        } else if (is_live_complete) {
+            const auto* cached_subchannel = find_subchannel(*m_cached_database, id);
+            const auto* cached_component = find_service_component(*m_cached_database, id);
+            is_valid = is_same_channel(*cached_subchannel, *cached_component, *live_subchannel, *live_component);
+            if (is_valid) {
+                LOG_MESSAGE("Confirmed speculative subchannel {}", id);
+            } else {
+                LOG_MESSAGE("Removing speculative subchannel {} since it was reconfigured", id);
+            }
+        } else if (is_timeout) {
+            LOG_MESSAGE("Removing speculative subchannel {} since it was never confirmed", id);
+        } else {
+            ++it;
             continue;
         }
+
+        if (!is_valid) {
+            RemoveChannel(id);
+            is_removed = true;
+        }
+        it = m_speculative_subchannels.erase(it);
+    }
+
+    if (m_speculative_subchannels.empty()) {
+        m_cached_database = nullptr;
     }
-}
\ No newline at end of file
+    return is_removed;
+}
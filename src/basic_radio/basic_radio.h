@@ -4,10 +4,15 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
+#include "dab/algorithms/dab_viterbi_decoder.h"
 #include "dab/constants/dab_parameters.h"
 #include "dab/database/dab_database_types.h"
+#include "utility/latency_histogram.h"
+#include "utility/metrics.h"
 #include "utility/observable.h"
 #include "utility/span.h"
+#include "utility/thread_placement.h"
 #include "viterbi_config.h"
 
 struct DAB_Database;
@@ -15,16 +20,35 @@ struct DAB_Misc_Info;
 struct DatabaseUpdaterGlobalStatistics;
 class BasicThreadPool;
 class BasicFICRunner;
+struct BasicFICRunner_Config;
 class Basic_MSC_Runner;
 class Basic_Audio_Channel;
 class Basic_Data_Packet_Channel;
+struct Subchannel;
+struct ServiceComponent;
+
+// Latency of each stage of the radio measured from when the frame was read by the demodulator
+struct Basic_Radio_Latency {
+    Latency_Histogram input;        // frame was passed to the radio
+    Latency_Histogram process;      // FIC and all subchannels in the frame were decoded
+};
+
+// Width of the Viterbi path metrics used by the FIC decoder and the subchannel decoders
+struct BasicRadio_Viterbi_Config {
+    DAB_Viterbi_Decoder::Metric fic = DAB_Viterbi_Decoder::Metric::U16;
+    // 8bit path metrics lose more at higher code rates so they are only used for strongly protected subchannels
+    // Subchannels with this protection level or stronger (1 is the strongest) use 8bit path metrics
+    // 0 decodes every subchannel with 16bit path metrics
+    int msc_u8_protection_level = 0;
+};
 
 // Our basic radio
 class BasicRadio
 {
 private:
     const DAB_Parameters m_params;
-    std::unique_ptr<BasicThreadPool> m_thread_pool;
+    const BasicRadio_Viterbi_Config m_viterbi_config;
+    std::shared_ptr<BasicThreadPool> m_thread_pool;
     std::unique_ptr<BasicFICRunner> m_fic_runner;
     std::unordered_map<subchannel_id_t, std::shared_ptr<Basic_MSC_Runner>> m_msc_runners;
     std::mutex m_mutex_data;
@@ -35,10 +59,30 @@ private:
     std::unordered_map<subchannel_id_t, std::shared_ptr<Basic_Data_Packet_Channel>> m_data_packet_channels;
     Observable<subchannel_id_t, Basic_Audio_Channel&> m_obs_audio_channel;
     Observable<subchannel_id_t, Basic_Data_Packet_Channel&> m_obs_data_packet_channel;
+    // Symbols containing the FIC and the capacity units of subchannels that are being decoded
+    std::vector<int> m_wanted_symbols;
+    Observable<tcb::span<const int>> m_obs_wanted_symbols;
+    // Channels created from a cached database before the live FIC has confirmed them
+    std::unique_ptr<DAB_Database> m_cached_database;
+    std::vector<subchannel_id_t> m_speculative_subchannels;
+    size_t m_nb_speculative_frames = 0;
+    // latency tracing
+    Metric_Counter m_nb_frames_processed;
+    Basic_Radio_Latency m_latency;
 public:
-    explicit BasicRadio(const DAB_Parameters& params, const size_t nb_threads=0);
+    explicit BasicRadio(
+        const DAB_Parameters& params, const size_t nb_threads=0, const Thread_Placement& placement=Thread_Placement(),
+        const BasicRadio_Viterbi_Config& viterbi_config=BasicRadio_Viterbi_Config()
+    );
+    // Radios can share a pool as long as only one of them processes a frame at a time
+    BasicRadio(
+        const DAB_Parameters& params, std::shared_ptr<BasicThreadPool> thread_pool,
+        const BasicRadio_Viterbi_Config& viterbi_config=BasicRadio_Viterbi_Config()
+    );
     ~BasicRadio();
+    // Frames without a trace are timed from when they are passed to the radio
     void Process(tcb::span<const viterbi_bit_t> buf);
+    void Process(tcb::span<const viterbi_bit_t> buf, const Frame_Trace& trace);
     Basic_Audio_Channel* Get_Audio_Channel(const subchannel_id_t id);
     Basic_Data_Packet_Channel* Get_Data_Packet_Channel(const subchannel_id_t id);
     auto& GetMutex() { return m_mutex_data; }
@@ -47,7 +91,27 @@ public:
     auto& GetDatabaseStatistics() { return *(m_dab_database_stats.get()); }
     auto& On_Audio_Channel() { return m_obs_audio_channel; }
     auto& On_Data_Packet_Channel() { return m_obs_data_packet_channel; }
+    // Called with the indices of the symbols in a frame that hold wanted data whenever they change
+    // This can be passed to OFDM_Demod::SetWantedSymbols() so other symbols aren't demodulated
+    auto& On_Wanted_Symbols() { return m_obs_wanted_symbols; }
+    tcb::span<const int> GetWantedSymbols() const { return m_wanted_symbols; }
     size_t GetTotalThreads() const;
+    const auto& GetViterbiConfig() const { return m_viterbi_config; }
+    // Change this before processing any frames since it is read by the FIC decoder thread
+    BasicFICRunner_Config& GetFICRunnerConfig();
+    // Thread placement of the worker pool that decodes the FIC and subchannels
+    const Thread_Placement_Report& GetPlacementReport() const;
+    // Per service latencies are in Basic_MSC_Runner::GetLatency()
+    auto& GetLatency() { return m_latency; }
+    // Adds the metrics of the radio and every subchannel decoder which can be called from any thread
+    // Labels are added to every metric to identify this radio, e.g. the ensemble or tuner
+    void CollectMetrics(Metrics_Writer& writer, const Metric_Labels& labels);
+    // Spin up channels from the last known database so audio starts before the FIC is decoded
+    void LoadDatabaseCache(const DAB_Database& db);
 private:
     void UpdateAfterProcessing();
+    void UpdateWantedSymbols();
+    bool CreateChannel(const Subchannel& subchannel, const ServiceComponent& service_component);
+    void RemoveChannel(const subchannel_id_t id);
+    bool ValidateSpeculativeChannels(const DAB_Database& live_database);
 };
\ No newline at end of file
@@ -29,7 +29,7 @@ Basic_Slideshow_Manager::Basic_Slideshow_Manager(size_t max_slideshows) {
     m_max_size = max_slideshows;
 }
 
-std::shared_ptr<Basic_Slideshow> Basic_Slideshow_Manager::Process_MOT_Entity(MOT_Entity& entity) {
+std::shared_ptr<Basic_Slideshow> Basic_Slideshow_Manager::Process_MOT_Entity(const MOT_Entity& entity) {
     // DOC: ETSI TS 101 499
     // Clause 6.2.3 MOT ContentTypes and ContentSubTypes 
     // For specific types used for slideshows
@@ -59,9 +59,12 @@ std::shared_ptr<Basic_Slideshow> Basic_Slideshow_Manager::Process_MOT_Entity(MOT
         MOT_Slideshow_Processor::ProcessHeaderExtension(slideshow_header, p.type, p.data);
     }
 
-    const size_t total_bytes = entity.body_buf.size();
-    slideshow->image_data.resize(total_bytes);
-    std::copy_n(entity.body_buf.begin(), total_bytes, slideshow->image_data.begin());
+    if (entity.body_data != nullptr) {
+        slideshow->image_buffer = entity.body_data;
+    } else {
+        slideshow->image_buffer = std::make_shared<const std::vector<uint8_t>>(entity.body_buf.begin(), entity.body_buf.end());
+    }
+    slideshow->image_data = *slideshow->image_buffer;
 
     // Core MOT header parameters
     auto& content_name = entity.header.content_name;
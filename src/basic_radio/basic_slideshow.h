@@ -10,6 +10,7 @@
 
 #include "dab/mot/MOT_entities.h"
 #include "utility/observable.h"
+#include "utility/span.h"
 
 enum class Basic_Image_Type {
     NONE, JPEG, PNG
@@ -27,7 +28,9 @@ struct Basic_Slideshow {
     std::string click_through_url = "";
     std::string alt_location_url = "";
     bool is_emergency_alert = false;
-    std::vector<uint8_t> image_data;
+    // Shares the completed MOT body instead of copying it
+    tcb::span<const uint8_t> image_data;
+    std::shared_ptr<const std::vector<uint8_t>> image_buffer;
 };
 
 class Basic_Slideshow_Manager 
@@ -40,7 +43,7 @@ private:
 public:
     explicit Basic_Slideshow_Manager(size_t max_slideshows=25);
     // returns nullptr if MOT entity wasn't a slideshow
-    std::shared_ptr<Basic_Slideshow> Process_MOT_Entity(MOT_Entity& entity);
+    std::shared_ptr<Basic_Slideshow> Process_MOT_Entity(const MOT_Entity& entity);
     auto& GetSlideshowsMutex(void) { return m_mutex_slideshows; }
     auto& GetSlideshows(void) { return m_slideshows; }
     auto& OnNewSlideshow(void) { return m_obs_on_new_slideshow; }
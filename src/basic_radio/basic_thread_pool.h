@@ -7,6 +7,8 @@
 #include <queue>
 #include <vector>
 #include <stddef.h>
+#include <string>
+#include "utility/thread_placement.h"
 
 // simple thread pool to decode FIC and MSC channels across all cores
 class BasicThreadPool 
@@ -16,6 +18,8 @@ private:
     volatile bool m_is_running;
     size_t m_nb_threads;
     std::vector<std::thread> m_task_threads;
+    const Thread_Placement m_placement;
+    Thread_Placement_Report m_placement_report;
     // tasks
     using Task = std::function<void()>;
     int m_total_tasks;
@@ -26,21 +30,26 @@ private:
     bool m_is_wait_all;
     std::condition_variable m_cv_wait_done;
 public:
-    explicit BasicThreadPool(size_t nb_threads=0) {
+    explicit BasicThreadPool(size_t nb_threads=0, const Thread_Placement& placement=Thread_Placement())
+    : m_placement(placement)
+    {
         m_total_tasks = 0;
         m_is_running = true;
         m_is_wait_all = false;
-        m_nb_threads = nb_threads ? nb_threads : std::thread::hardware_concurrency();
+        const size_t nb_available_threads = m_placement.IsEnabled() ? m_placement.cpus.size() : std::thread::hardware_concurrency();
+        m_nb_threads = nb_threads ? nb_threads : nb_available_threads;
 
         m_task_threads.reserve(m_nb_threads);
         for (size_t i = 0; i < m_nb_threads; i++) {
-            m_task_threads.emplace_back(&BasicThreadPool::RunnerThread, this);
+            m_task_threads.emplace_back(&BasicThreadPool::RunnerThread, this, i);
         }
     }
     ~BasicThreadPool() {
         StopAll();
     }
     size_t GetTotalThreads() const { return m_nb_threads; }
+    const auto& GetThreadPlacement() const { return m_placement; }
+    const auto& GetPlacementReport() const { return m_placement_report; }
     void StopAll() {
         if (!m_is_running) {
             return;
@@ -70,7 +79,11 @@ public:
     }
 private:
     // thread waits for new tasks and runs them
-    void RunnerThread() {
+    void RunnerThread(const size_t thread_index) {
+        const bool is_pinned = ApplyThreadPlacement(m_placement, thread_index);
+        m_placement_report.AddThread(GetCurrentThreadPlacement(
+            "BasicThreadPool::Runner[" + std::to_string(thread_index) + "]", is_pinned
+        ));
         while (m_is_running) {
             auto lock = std::unique_lock(m_mutex_total_tasks);
             m_cv_wait_task.wait(lock, [this] {
@@ -0,0 +1,115 @@
+#include "./basic_archive_stream.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <fmt/format.h>
+#include "basic_radio/basic_audio_params.h"
+#include "utility/span.h"
+#include "./basic_file_writer.h"
+
+using SystemClock = std::chrono::system_clock;
+
+// Canonical PCM WAV header written by BasicFileWriter::OpenWav
+constexpr uint64_t WAV_HEADER_BYTES = 44;
+constexpr char INDEX_MAGIC[8] = { 'D','A','B','I','D','X','0','1' };
+
+static void WriteLittleEndian(uint8_t* buf, const uint64_t value) {
+    for (size_t i = 0; i < sizeof(value); i++) {
+        buf[i] = uint8_t((value >> (i*8)) & 0xFF);
+    }
+}
+
+static std::string FormatTime(const SystemClock::time_point time) {
+    auto t = SystemClock::to_time_t(time);
+    auto tm = *std::localtime(&t);
+    return fmt::format("{:04}-{:02}-{:02}T{:02}-{:02}-{:02}",
+        tm.tm_year+1900, tm.tm_mon+1, tm.tm_mday,
+        tm.tm_hour, tm.tm_min, tm.tm_sec);
+}
+
+BasicArchiveStream::BasicArchiveStream(
+    const fs::path& dir, std::string name, std::string extension,
+    std::shared_ptr<BasicFileWriter> writer, const BasicArchive_Config cfg)
+: m_dir(dir), m_name(name), m_extension(extension), m_cfg(cfg), m_writer(writer)
+{}
+
+BasicArchiveStream::~BasicArchiveStream() {
+    CloseSegment();
+}
+
+void BasicArchiveStream::SetWavParams(BasicAudioParams params) {
+    if (m_wav_params.has_value() && (m_wav_params.value() == params)) {
+        return;
+    }
+    m_wav_params = std::optional(params);
+    Split();
+}
+
+void BasicArchiveStream::Write(tcb::span<const uint8_t> frame) {
+    const auto now = SystemClock::now();
+    if ((m_file == nullptr) || (now >= m_segment_end)) {
+        CloseSegment();
+        OpenSegment(now);
+    }
+
+    // Dropped frames are not counted or indexed so the index stays consistent with what reached the disk
+    const uint64_t byte_offset = m_nb_segment_bytes;
+    if (!m_writer->Write(m_file, frame)) {
+        return;
+    }
+    m_nb_segment_bytes += frame.size();
+
+    if (m_cfg.is_write_index && (now >= m_next_index_time)) {
+        m_next_index_time = now + m_cfg.index_period;
+        const auto unix_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+        uint8_t entry[BasicArchiveIndexEntry::SIZE];
+        WriteLittleEndian(&entry[0], uint64_t(unix_time_ms));
+        WriteLittleEndian(&entry[8], byte_offset);
+        m_writer->Write(m_index_file, { entry, sizeof(entry) });
+    }
+}
+
+void BasicArchiveStream::Split() {
+    CloseSegment();
+}
+
+void BasicArchiveStream::OpenSegment(const SystemClock::time_point now) {
+    const auto segment_duration = std::chrono::duration_cast<SystemClock::duration>(m_cfg.segment_duration);
+    const auto since_epoch = now.time_since_epoch();
+    if (segment_duration.count() > 0) {
+        const auto segment_start = since_epoch - (since_epoch % segment_duration);
+        m_segment_end = SystemClock::time_point(segment_start + segment_duration);
+    } else {
+        m_segment_end = SystemClock::time_point::max();
+    }
+
+    const auto filepath = m_dir / fmt::format("{}_{}.{}", FormatTime(now), m_name, m_extension);
+    if (m_wav_params.has_value()) {
+        m_file = m_writer->OpenWav(filepath, m_wav_params.value());
+        m_nb_segment_bytes = WAV_HEADER_BYTES;
+    } else {
+        m_file = m_writer->Open(filepath);
+        m_nb_segment_bytes = 0;
+    }
+
+    if (m_cfg.is_write_index) {
+        auto index_filepath = filepath;
+        index_filepath += ".idx";
+        m_index_file = m_writer->Open(index_filepath);
+        m_writer->Write(m_index_file, { reinterpret_cast<const uint8_t*>(INDEX_MAGIC), sizeof(INDEX_MAGIC) });
+        m_next_index_time = now;
+    }
+}
+
+void BasicArchiveStream::CloseSegment() {
+    m_writer->Close(m_file);
+    m_writer->Close(m_index_file);
+    m_file = nullptr;
+    m_index_file = nullptr;
+    m_nb_segment_bytes = 0;
+}
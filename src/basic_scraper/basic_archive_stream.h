@@ -0,0 +1,69 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include "basic_radio/basic_audio_params.h"
+#include "utility/span.h"
+#include "./basic_file_writer.h"
+
+namespace fs = std::filesystem;
+
+struct BasicArchive_Config {
+    // Segments are aligned to multiples of this duration since the unix epoch
+    std::chrono::seconds segment_duration = std::chrono::hours(1);
+    // Minimum spacing between entries in the index sidecar
+    std::chrono::milliseconds index_period = std::chrono::milliseconds(1000);
+    bool is_write_index = true;
+};
+
+// Index sidecar file format ({segment}.idx)
+// Header: 8 byte magic "DABIDX01"
+// Entry:  int64_t unix_time_ms, uint64_t byte_offset (little endian)
+// Each entry points to the start of a frame in the segment that was received at that time
+struct BasicArchiveIndexEntry {
+    static constexpr size_t SIZE = 16;
+    int64_t unix_time_ms;
+    uint64_t byte_offset;
+};
+
+// Continuous recording that is split into time based segments
+// {dir}/{date}_{name}.{extension}
+// {dir}/{date}_{name}.{extension}.idx
+class BasicArchiveStream
+{
+private:
+    const fs::path m_dir;
+    const std::string m_name;
+    const std::string m_extension;
+    const BasicArchive_Config m_cfg;
+    std::shared_ptr<BasicFileWriter> m_writer;
+    std::optional<BasicAudioParams> m_wav_params = std::nullopt;
+    // current segment
+    BasicFileWriter::FileHandle m_file;
+    BasicFileWriter::FileHandle m_index_file;
+    std::chrono::system_clock::time_point m_segment_end;
+    std::chrono::system_clock::time_point m_next_index_time;
+    uint64_t m_nb_segment_bytes = 0;
+public:
+    BasicArchiveStream(
+        const fs::path& dir, std::string name, std::string extension,
+        std::shared_ptr<BasicFileWriter> writer, const BasicArchive_Config cfg);
+    ~BasicArchiveStream();
+    BasicArchiveStream(BasicArchiveStream&) = delete;
+    BasicArchiveStream(BasicArchiveStream&&) = delete;
+    BasicArchiveStream& operator=(BasicArchiveStream&) = delete;
+    BasicArchiveStream& operator=(BasicArchiveStream&&) = delete;
+    // Segments are written as a WAV file if params are provided, changing them starts a new segment
+    void SetWavParams(BasicAudioParams params);
+    // Each write must be an entire frame so segments and index entries always land on a frame boundary
+    void Write(tcb::span<const uint8_t> frame);
+    // Start a new segment on the next write
+    void Split();
+private:
+    void OpenSegment(const std::chrono::system_clock::time_point now);
+    void CloseSegment();
+};
@@ -0,0 +1,337 @@
+#include "./basic_file_writer.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include "basic_radio/basic_audio_params.h"
+#include "utility/span.h"
+
+#include "./basic_scraper_logging.h"
+#define LOG_MESSAGE(...) BASIC_SCRAPER_LOG_MESSAGE(fmt::format(__VA_ARGS__))
+#define LOG_ERROR(...) BASIC_SCRAPER_LOG_ERROR(fmt::format(__VA_ARGS__))
+
+using Clock = std::chrono::steady_clock;
+
+struct BasicFileWriter::File {
+    const fs::path filepath;
+    const std::optional<BasicAudioParams> wav_params;
+    FILE* fp = nullptr;
+    size_t nb_data_bytes = 0;
+    bool is_header_dirty = false;
+    std::vector<uint8_t> buffer;
+    Clock::time_point last_flush;
+    File(const fs::path& _filepath, std::optional<BasicAudioParams> _wav_params)
+    : filepath(_filepath), wav_params(_wav_params) {}
+};
+
+struct BasicFileWriter::Command {
+    enum class Type { OPEN, WRITE, CLOSE, WRITE_FILE };
+    Type type;
+    FileHandle file;
+    tcb::span<const uint8_t> data;
+    std::vector<uint8_t> owned_data;
+    std::shared_ptr<const void> owner;
+};
+
+// Source: http://soundfile.sapp.org/doc/WaveFormat/
+struct WavHeader {
+    char     ChunkID[4];
+    int32_t  ChunkSize;
+    char     Format[4];
+    // Subchunk 1 = format information
+    char     Subchunk1ID[4];
+    int32_t  Subchunk1Size;
+    int16_t  AudioFormat;
+    int16_t  NumChannels;
+    int32_t  SampleRate;
+    int32_t  ByteRate;
+    int16_t  BlockAlign;
+    int16_t  BitsPerSample;
+    // Subchunk 2 = data
+    char     Subchunk2ID[4];
+    int32_t  Subchunk2Size;
+};
+
+static void WriteWavHeader(FILE* fp, BasicAudioParams params) {
+    WavHeader header;
+    const int16_t NumChannels = params.is_stereo ? 2 : 1;
+    const int32_t BitsPerSample = params.bytes_per_sample * 8;
+    const int32_t SampleRate = static_cast<int32_t>(params.frequency);
+
+    std::memcpy(header.ChunkID, "RIFF", 4);
+    std::memcpy(header.Format, "WAVE", 4);
+    std::memcpy(header.Subchunk1ID, "fmt ", 4);
+    std::memcpy(header.Subchunk2ID, "data", 4);
+
+    header.Subchunk1Size = 16;  // size of PCM format fields
+    header.AudioFormat = 1;     // Linear quantisation
+    header.NumChannels = NumChannels;
+    header.SampleRate = SampleRate;
+    header.BitsPerSample = BitsPerSample;
+    header.ByteRate = header.SampleRate * header.NumChannels * header.BitsPerSample / 8;
+    header.BlockAlign = header.NumChannels * header.BitsPerSample / 8;
+
+    // We update these values as data is flushed and when we close the file
+    header.Subchunk2Size = 0;
+    header.ChunkSize = 36 + header.Subchunk2Size;
+
+    fwrite(&header, sizeof(WavHeader), 1, fp);
+}
+
+static void UpdateWavHeader(FILE* fp, const int32_t nb_data_bytes) {
+    const int32_t Subchunk2Size = nb_data_bytes;
+    const int32_t ChunkSize = 36 + Subchunk2Size;
+
+    // Source: http://soundfile.sapp.org/doc/WaveFormat/
+    // Refer to offset of each field
+    // ChunkSize
+    fseek(fp, 4, SEEK_SET);
+    fwrite(&ChunkSize, sizeof(int32_t), 1, fp);
+    // Subchunk2Size
+    fseek(fp, 40, SEEK_SET);
+    fwrite(&Subchunk2Size, sizeof(int32_t), 1, fp);
+
+    fseek(fp, 0, SEEK_END);
+}
+
+static FILE* OpenFile(const fs::path& filepath) {
+    std::error_code ec;
+    fs::create_directories(filepath.parent_path(), ec);
+    if (ec) {
+        LOG_ERROR("Failed to create directory {}: {}", filepath.parent_path().string(), ec.message());
+    }
+    const auto filepath_str = filepath.string();
+    FILE* fp = fopen(filepath_str.c_str(), "wb+");
+    if (fp == nullptr) {
+        LOG_ERROR("Failed to open file {}", filepath_str);
+    }
+    return fp;
+}
+
+BasicFileWriter::BasicFileWriter(const BasicFileWriter_Config cfg)
+: m_cfg(cfg)
+{
+    m_thread = std::make_unique<std::thread>([this]() {
+        RunThread();
+    });
+}
+
+BasicFileWriter::~BasicFileWriter() {
+    {
+        auto lock = std::scoped_lock(m_mutex_queue);
+        m_is_stop = true;
+    }
+    m_cv_queue.notify_one();
+    m_thread->join();
+}
+
+BasicFileWriter::FileHandle BasicFileWriter::Open(const fs::path& filepath) {
+    auto file = std::make_shared<File>(filepath, std::nullopt);
+    Command command;
+    command.type = Command::Type::OPEN;
+    command.file = file;
+    Push(std::move(command));
+    return file;
+}
+
+BasicFileWriter::FileHandle BasicFileWriter::OpenWav(const fs::path& filepath, BasicAudioParams params) {
+    auto file = std::make_shared<File>(filepath, std::optional(params));
+    Command command;
+    command.type = Command::Type::OPEN;
+    command.file = file;
+    Push(std::move(command));
+    return file;
+}
+
+void BasicFileWriter::Close(const FileHandle& file) {
+    if (file == nullptr) return;
+    Command command;
+    command.type = Command::Type::CLOSE;
+    command.file = file;
+    Push(std::move(command));
+}
+
+bool BasicFileWriter::Write(const FileHandle& file, tcb::span<const uint8_t> data) {
+    if (file == nullptr) return false;
+    Command command;
+    command.type = Command::Type::WRITE;
+    command.file = file;
+    command.owned_data.assign(data.begin(), data.end());
+    command.data = command.owned_data;
+    return Push(std::move(command));
+}
+
+bool BasicFileWriter::Write(const FileHandle& file, tcb::span<const uint8_t> data, std::shared_ptr<const void> owner) {
+    if (file == nullptr) return false;
+    Command command;
+    command.type = Command::Type::WRITE;
+    command.file = file;
+    command.data = data;
+    command.owner = std::move(owner);
+    return Push(std::move(command));
+}
+
+bool BasicFileWriter::WriteFile(const fs::path& filepath, tcb::span<const uint8_t> data, std::shared_ptr<const void> owner) {
+    Command command;
+    command.type = Command::Type::WRITE_FILE;
+    command.file = std::make_shared<File>(filepath, std::nullopt);
+    if (owner == nullptr) {
+        command.owned_data.assign(data.begin(), data.end());
+        command.data = command.owned_data;
+    } else {
+        command.data = data;
+        command.owner = std::move(owner);
+    }
+    return Push(std::move(command));
+}
+
+bool BasicFileWriter::Push(Command&& command) {
+    // NOTE: Opening and closing files are never dropped so that the file handles are always released
+    const size_t nb_bytes = command.data.size();
+    if (nb_bytes > 0) {
+        // Reserve the bytes in one step since several decoder threads can push at once
+        size_t nb_queued = m_nb_queued_bytes.load();
+        do {
+            if ((nb_queued + nb_bytes) > m_cfg.max_queued_bytes) {
+                m_nb_dropped_writes++;
+                m_nb_dropped_bytes += nb_bytes;
+                return false;
+            }
+        } while (!m_nb_queued_bytes.compare_exchange_weak(nb_queued, nb_queued + nb_bytes));
+    }
+
+    bool is_wake = false;
+    {
+        auto lock = std::scoped_lock(m_mutex_queue);
+        is_wake = m_queue.empty();
+        m_queue.push_back(std::move(command));
+    }
+    if (is_wake) {
+        m_cv_queue.notify_one();
+    }
+    return true;
+}
+
+void BasicFileWriter::RunThread() {
+    std::vector<Command> commands;
+    while (true) {
+        bool is_stop = false;
+        {
+            auto lock = std::unique_lock(m_mutex_queue);
+            m_cv_queue.wait_for(lock, m_cfg.flush_period, [this]() {
+                return m_is_stop || !m_queue.empty();
+            });
+            std::swap(commands, m_queue);
+            is_stop = m_is_stop;
+        }
+
+        for (auto& command: commands) {
+            RunCommand(command);
+        }
+        // Release data owners now that everything has been written
+        commands.clear();
+
+        // Periodically flush so files on disk are reasonably up to date
+        const auto now = Clock::now();
+        for (auto& file: m_open_files) {
+            if ((now - file->last_flush) < m_cfg.flush_period) continue;
+            FlushFile(*file, true);
+        }
+
+        if (is_stop) break;
+    }
+
+    for (auto& file: m_open_files) {
+        CloseFile(*file);
+    }
+    m_open_files.clear();
+}
+
+void BasicFileWriter::RunCommand(Command& command) {
+    auto& file = *(command.file.get());
+    switch (command.type) {
+    case Command::Type::OPEN:
+        {
+            file.fp = OpenFile(file.filepath);
+            if (file.fp == nullptr) break;
+            if (file.wav_params.has_value()) {
+                WriteWavHeader(file.fp, file.wav_params.value());
+            }
+            file.last_flush = Clock::now();
+            m_open_files.push_back(command.file);
+            LOG_MESSAGE("Opened file {}", file.filepath.string());
+        }
+        break;
+    case Command::Type::WRITE:
+        {
+            m_nb_queued_bytes -= command.data.size();
+            if (file.fp == nullptr) break;
+            file.buffer.insert(file.buffer.end(), command.data.begin(), command.data.end());
+            if (file.buffer.size() >= m_cfg.flush_block_bytes) {
+                FlushFile(file, false);
+            }
+        }
+        break;
+    case Command::Type::CLOSE:
+        {
+            CloseFile(file);
+            auto it = std::find(m_open_files.begin(), m_open_files.end(), command.file);
+            if (it != m_open_files.end()) {
+                m_open_files.erase(it);
+            }
+        }
+        break;
+    case Command::Type::WRITE_FILE:
+        {
+            m_nb_queued_bytes -= command.data.size();
+            FILE* fp = OpenFile(file.filepath);
+            if (fp == nullptr) break;
+            const size_t N = command.data.size();
+            const size_t nb_written = fwrite(command.data.data(), sizeof(uint8_t), N, fp);
+            if (nb_written != N) {
+                LOG_ERROR("Failed to write bytes {}/{} to {}", nb_written, N, file.filepath.string());
+            }
+            fclose(fp);
+            LOG_MESSAGE("Wrote file {}", file.filepath.string());
+        }
+        break;
+    }
+}
+
+void BasicFileWriter::FlushFile(File& file, const bool is_update_header) {
+    if (file.fp == nullptr) return;
+    if (!file.buffer.empty()) {
+        const size_t N = file.buffer.size();
+        const size_t nb_written = fwrite(file.buffer.data(), sizeof(uint8_t), N, file.fp);
+        if (nb_written != N) {
+            LOG_ERROR("Failed to write bytes {}/{} to {}", nb_written, N, file.filepath.string());
+        }
+        file.nb_data_bytes += nb_written;
+        file.buffer.clear();
+        file.is_header_dirty = true;
+    }
+    if (!is_update_header) return;
+    file.last_flush = Clock::now();
+    if (file.wav_params.has_value() && file.is_header_dirty) {
+        UpdateWavHeader(file.fp, int32_t(file.nb_data_bytes));
+        file.is_header_dirty = false;
+    }
+}
+
+void BasicFileWriter::CloseFile(File& file) {
+    if (file.fp == nullptr) return;
+    FlushFile(file, true);
+    fclose(file.fp);
+    file.fp = nullptr;
+}
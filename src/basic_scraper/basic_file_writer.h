@@ -0,0 +1,74 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "basic_radio/basic_audio_params.h"
+#include "utility/span.h"
+
+namespace fs = std::filesystem;
+
+struct BasicFileWriter_Config {
+    size_t max_queued_bytes = 64*1024*1024;
+    size_t flush_block_bytes = 256*1024;
+    std::chrono::milliseconds flush_period = std::chrono::milliseconds(1000);
+};
+
+// Performs all file system operations for the scrapers on a dedicated thread
+// Writes are queued and coalesced into large blocks so the decoder threads never block on disk
+// If the disk cannot keep up the queue is bounded and new writes are dropped
+class BasicFileWriter
+{
+public:
+    struct File;
+    using FileHandle = std::shared_ptr<File>;
+private:
+    struct Command;
+    const BasicFileWriter_Config m_cfg;
+    std::mutex m_mutex_queue;
+    std::condition_variable m_cv_queue;
+    std::vector<Command> m_queue;
+    bool m_is_stop = false;
+    // statistics
+    std::atomic<size_t> m_nb_queued_bytes = 0;
+    std::atomic<uint64_t> m_nb_dropped_writes = 0;
+    std::atomic<uint64_t> m_nb_dropped_bytes = 0;
+    // only accessed by the writer thread
+    std::vector<FileHandle> m_open_files;
+    std::unique_ptr<std::thread> m_thread;
+public:
+    explicit BasicFileWriter(const BasicFileWriter_Config cfg = {});
+    ~BasicFileWriter();
+    BasicFileWriter(BasicFileWriter&) = delete;
+    BasicFileWriter(BasicFileWriter&&) = delete;
+    BasicFileWriter& operator=(BasicFileWriter&) = delete;
+    BasicFileWriter& operator=(BasicFileWriter&&) = delete;
+    // Parent directories are created on the writer thread
+    FileHandle Open(const fs::path& filepath);
+    // Header is rewritten periodically and when the file is closed
+    FileHandle OpenWav(const fs::path& filepath, BasicAudioParams params);
+    void Close(const FileHandle& file);
+    // Returns false if the write was dropped due to backpressure
+    bool Write(const FileHandle& file, tcb::span<const uint8_t> data);
+    // Avoids copying the data by holding a reference to its owner until it is written
+    bool Write(const FileHandle& file, tcb::span<const uint8_t> data, std::shared_ptr<const void> owner);
+    // Create, write and close an entire file in one go
+    bool WriteFile(const fs::path& filepath, tcb::span<const uint8_t> data, std::shared_ptr<const void> owner=nullptr);
+    size_t GetQueuedBytes() const { return m_nb_queued_bytes; }
+    size_t GetMaxQueuedBytes() const { return m_cfg.max_queued_bytes; }
+    bool GetIsBackpressure() const { return m_nb_queued_bytes >= m_cfg.max_queued_bytes/2; }
+    uint64_t GetTotalDroppedWrites() const { return m_nb_dropped_writes; }
+    uint64_t GetTotalDroppedBytes() const { return m_nb_dropped_bytes; }
+private:
+    bool Push(Command&& command);
+    void RunThread();
+    void RunCommand(Command& command);
+    void FlushFile(File& file, const bool is_update_header);
+    void CloseFile(File& file);
+};
@@ -1,12 +1,12 @@
 #include "./basic_scraper.h"
 #include <stdint.h>
-#include <stdio.h>
-#include <cstring>
+#include <algorithm>
 #include <ctime>
 #include <filesystem>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 #include <fmt/format.h>
 #include "basic_radio/basic_audio_channel.h"
 #include "basic_radio/basic_audio_params.h"
@@ -20,6 +20,7 @@
 #include "dab/database/dab_database_entities.h"
 #include "dab/database/dab_database_types.h"
 #include "utility/span.h"
+#include "./basic_file_writer.h"
 
 namespace fs = std::filesystem;
 
@@ -51,8 +52,10 @@ static ServiceComponent* find_service_component(DAB_Database& db, subchannel_id_
 void BasicScraper::attach_to_radio(std::shared_ptr<BasicScraper> scraper, BasicRadio& radio) {
     if (scraper == nullptr) return;
     auto root_directory = scraper->m_root_directory;
+    auto writer = scraper->m_writer;
+    auto cfg = scraper->m_cfg;
     radio.On_Audio_Channel().Attach(
-        [scraper, root_directory, &radio](subchannel_id_t id, Basic_Audio_Channel& channel) {
+        [scraper, root_directory, writer, cfg, &radio](subchannel_id_t id, Basic_Audio_Channel& channel) {
             // determine root folder
             auto& db = radio.GetDatabase();
             auto* component = find_service_component(db, id);
@@ -64,13 +67,13 @@ void BasicScraper::attach_to_radio(std::shared_ptr<BasicScraper> scraper, BasicR
             auto base_path = fs::path(root_folder) / fs::path(child_folder);
             auto abs_path = fs::absolute(base_path);
 
-            auto dab_plus_scraper = std::make_shared<Basic_Audio_Channel_Scraper>(abs_path);
+            auto dab_plus_scraper = std::make_shared<Basic_Audio_Channel_Scraper>(abs_path, writer, cfg);
             scraper->m_scrapers.push_back(dab_plus_scraper);
             Basic_Audio_Channel_Scraper::attach_to_channel(dab_plus_scraper, channel);
         }
     );
     radio.On_Data_Packet_Channel().Attach(
-        [scraper, root_directory, &radio](subchannel_id_t id, Basic_Data_Packet_Channel& channel) {
+        [scraper, root_directory, writer, &radio](subchannel_id_t id, Basic_Data_Packet_Channel& channel) {
             // determine root folder
             auto& db = radio.GetDatabase();
             auto* component = find_service_component(db, id);
@@ -82,44 +85,50 @@ void BasicScraper::attach_to_radio(std::shared_ptr<BasicScraper> scraper, BasicR
             auto base_path = fs::path(root_folder) / fs::path(child_folder);
             auto abs_path = fs::absolute(base_path);
 
-            auto mot_scraper = std::make_shared<BasicMOTScraper>(abs_path / "MOT");
-            channel.OnMOTEntity().Attach([mot_scraper](MOT_Entity mot_entity) {
+            auto mot_scraper = std::make_shared<BasicMOTScraper>(abs_path / "MOT", writer);
+            channel.OnMOTEntity().Attach([mot_scraper](const MOT_Entity& mot_entity) {
                 mot_scraper->OnMOTEntity(mot_entity);
             });
 
-            auto slideshow_scraper = std::make_shared<BasicSlideshowScraper>(abs_path / "slideshow");
+            auto slideshow_scraper = std::make_shared<BasicSlideshowScraper>(abs_path / "slideshow", writer);
             channel.GetSlideshowManager().OnNewSlideshow().Attach(
                 [slideshow_scraper](std::shared_ptr<Basic_Slideshow> slideshow) {
-                    slideshow_scraper->OnSlideshow(*slideshow);
+                    slideshow_scraper->OnSlideshow(slideshow);
                 }
             );
         }
     );
 }
 
-Basic_Audio_Channel_Scraper::Basic_Audio_Channel_Scraper(const fs::path& dir) 
+Basic_Audio_Channel_Scraper::Basic_Audio_Channel_Scraper(const fs::path& dir, std::shared_ptr<BasicFileWriter> writer, const BasicScraper_Config cfg) 
 : m_dir(dir), 
-  m_audio_scraper(dir / "audio"), 
-  m_slideshow_scraper(dir / "slideshow"),
-  m_mot_scraper(dir / "MOT")
+  m_cfg(cfg),
+  m_writer(writer),
+  m_audio_scraper(dir / "audio", writer, cfg.archive), 
+  m_slideshow_scraper(dir / "slideshow", writer),
+  m_mot_scraper(dir / "MOT", writer),
+  m_audio_aac_archive(dir / "aac", "audio", "aac", writer, cfg.archive),
+  m_audio_mp2_archive(dir / "mp2", "audio", "mp2", writer, cfg.archive)
 {
     LOG_MESSAGE("[DAB+] Opened directory {}", m_dir.string());
 }
 
 void Basic_Audio_Channel_Scraper::attach_to_channel(std::shared_ptr<Basic_Audio_Channel_Scraper> scraper, Basic_Audio_Channel& channel) {
     if (scraper == nullptr) return;
-    channel.OnAudioData().Attach(
-        [scraper](BasicAudioParams params, tcb::span<const uint8_t> data) {
-            scraper->m_audio_scraper.OnAudioData(params, data);
-        }
-    );
+    if (scraper->m_cfg.is_record_pcm) {
+        channel.OnAudioData().Attach(
+            [scraper](BasicAudioParams params, tcb::span<const uint8_t> data) {
+                scraper->m_audio_scraper.OnAudioData(params, data);
+            }
+        );
+    }
     channel.GetSlideshowManager().OnNewSlideshow().Attach(
         [scraper](std::shared_ptr<Basic_Slideshow> slideshow) {
-            scraper->m_slideshow_scraper.OnSlideshow(*slideshow);
+            scraper->m_slideshow_scraper.OnSlideshow(slideshow);
         }
     );
     channel.OnMOTEntity().Attach(
-        [scraper](MOT_Entity mot) {
+        [scraper](const MOT_Entity& mot) {
             scraper->m_mot_scraper.OnMOTEntity(mot);
         }
     );
@@ -128,193 +137,50 @@ void Basic_Audio_Channel_Scraper::attach_to_channel(std::shared_ptr<Basic_Audio_
     if (ascty == AudioServiceType::DAB) {
         auto& derived = dynamic_cast<Basic_DAB_Channel&>(channel);
         derived.OnMP2Data().Attach([scraper](tcb::span<const uint8_t> data) {
-            auto& writer = scraper->m_audio_mp2_writer;
-            if (writer == nullptr) {
-                auto dir = scraper->m_dir / "mp2";
-                fs::create_directories(dir);
-                auto filepath = dir / fmt::format("{}_audio.mp2", GetCurrentTime());
-                auto filepath_str = filepath.string();
-                FILE* fp = fopen(filepath_str.c_str(), "wb+");
-                if (fp != nullptr) LOG_MESSAGE("[mp2] Opened file {}", filepath_str);
-                writer = std::make_unique<BasicBinaryWriter>(fp);
-            }
-            writer->Write(data);
+            scraper->m_audio_mp2_archive.Write(data);
         });
     } else if (ascty == AudioServiceType::DAB_PLUS) {
         auto& derived = dynamic_cast<Basic_DAB_Plus_Channel&>(channel);
         derived.OnAACData().Attach([scraper](auto superframe_header, auto mpeg4_header, auto buf) {
-            auto& writer = scraper->m_audio_aac_writer;
+            auto& archive = scraper->m_audio_aac_archive;
             auto& old_header = scraper->m_old_aac_header;
-            if ((writer == nullptr) || (old_header != superframe_header)) {
-                auto dir = scraper->m_dir / "aac";
-                fs::create_directories(dir);
-                auto filepath = dir / fmt::format("{}_audio.aac", GetCurrentTime());
-                auto filepath_str = filepath.string();
-                FILE* fp = fopen(filepath_str.c_str(), "wb+");
-                if (fp != nullptr) LOG_MESSAGE("[aac] Opened file {}", filepath_str);
-                writer = std::make_unique<BasicBinaryWriter>(fp);
+            // Start a new segment if the codec parameters change
+            if (!old_header.has_value() || (old_header.value() != superframe_header)) {
+                archive.Split();
                 old_header = superframe_header;
             }
-            writer->Write(mpeg4_header);
-            writer->Write(buf);
+            // ADTS header followed by the access unit
+            auto& frame = scraper->m_aac_frame_buf;
+            frame.resize(mpeg4_header.size() + buf.size());
+            std::copy(mpeg4_header.begin(), mpeg4_header.end(), frame.begin());
+            std::copy(buf.begin(), buf.end(), frame.begin() + mpeg4_header.size());
+            archive.Write(frame);
         });
     }
 
+    // Audio is archived in its encoded form so PCM is only decoded if it is being recorded
     auto& controls = channel.GetControls();
     controls.SetIsDecodeAudio(true);
     controls.SetIsDecodeData(true);
     controls.SetIsPlayAudio(false);
-}
-
-BasicBinaryWriter::~BasicBinaryWriter() {
-    if (m_fp != nullptr) {
-        fclose(m_fp);
-        m_fp = nullptr;
-    }
-}
-
-void BasicBinaryWriter::Write(tcb::span<const uint8_t> data) {
-    if (m_fp != nullptr) {
-        fwrite(data.data(), sizeof(uint8_t), data.size(), m_fp);
-    }
-}
-
-BasicAudioScraper::~BasicAudioScraper() {
-    if (m_fp_wav != nullptr) {
-        CloseWavFile(m_fp_wav, m_total_bytes_written);
-        m_fp_wav = nullptr;
-        m_total_bytes_written = 0;
-    }
+    controls.SetIsDecodePCM(scraper->m_cfg.is_record_pcm);
 }
 
 void BasicAudioScraper::OnAudioData(BasicAudioParams params, tcb::span<const uint8_t> data) {
-    if (!m_old_params.has_value() || (m_old_params.value() != params)) {
-        if (m_fp_wav != nullptr) {
-            CloseWavFile(m_fp_wav, m_total_bytes_written);
-            m_fp_wav = nullptr;
-            m_total_bytes_written = 0;
-        }
-
-        m_fp_wav = CreateWavFile(params);
-        m_total_bytes_written = 0;
-        m_old_params = std::optional(params);
-    }
-
-    if (m_fp_wav == nullptr) {
-        return;
-    }
-
-    const size_t N = data.size(); 
-    const size_t nb_written = fwrite(data.data(), sizeof(uint8_t), N, m_fp_wav);
-    if (nb_written != N) {
-        LOG_ERROR("[audio] Failed to write bytes {}/{}", nb_written, N);
-    }
-    m_total_bytes_written += (int)nb_written;
-    UpdateWavHeader(m_fp_wav, m_total_bytes_written);
-}
-
-FILE* BasicAudioScraper::CreateWavFile(BasicAudioParams params) {
-    fs::create_directories(m_dir);
-    auto filepath = m_dir / fmt::format("{}_audio.wav", GetCurrentTime());
-    auto filepath_str = filepath.string();
-
-    FILE* fp = fopen(filepath_str.c_str(), "wb+");
-    if (fp == nullptr) {
-        LOG_ERROR("[audio] Failed to open file {}", filepath_str);
-        return fp;
-    }
-
-    LOG_MESSAGE("[audio] Opened file {}", filepath_str);
-
-    // Source: http://soundfile.sapp.org/doc/WaveFormat/
-    struct WavHeader {
-        char     ChunkID[4];
-        int32_t  ChunkSize;
-        char     Format[4];
-        // Subchunk 1 = format information
-        char     Subchunk1ID[4];
-        int32_t  Subchunk1Size;
-        int16_t  AudioFormat;
-        int16_t  NumChannels;
-        int32_t  SampleRate;
-        int32_t  ByteRate;
-        int16_t  BlockAlign;
-        int16_t  BitsPerSample;
-        // Subchunk 2 = data 
-        char     Subchunk2ID[4];
-        int32_t  Subchunk2Size;
-    } header;
-
-    const int16_t NumChannels = params.is_stereo ? 2 : 1;
-    const int32_t BitsPerSample = params.bytes_per_sample * 8;
-    const int32_t SampleRate = static_cast<int32_t>(params.frequency);
-
-    std::memcpy(header.ChunkID, "RIFF", 4);
-    std::memcpy(header.Format, "WAVE", 4);
-    std::memcpy(header.Subchunk1ID, "fmt ", 4);
-    std::memcpy(header.Subchunk2ID, "data", 4);
-
-    header.Subchunk1Size = 16;  // size of PCM format fields 
-    header.AudioFormat = 1;     // Linear quantisation
-    header.NumChannels = NumChannels;     
-    header.SampleRate = SampleRate;
-    header.BitsPerSample = BitsPerSample;
-    header.ByteRate = header.SampleRate * header.NumChannels * header.BitsPerSample / 8;
-    header.BlockAlign = header.NumChannels * header.BitsPerSample / 8;
-
-    // We update these values when we close the file
-    header.Subchunk2Size = 0;
-    header.ChunkSize = 36 + header.Subchunk2Size; 
-
-    fwrite(&header, sizeof(WavHeader), 1, fp);
-
-    return fp;
-}
-
-void BasicAudioScraper::UpdateWavHeader(FILE* fp, const int nb_data_bytes) {
-    const int32_t Subchunk2Size = nb_data_bytes;
-    const int32_t ChunkSize = 36 + Subchunk2Size;
-
-    // Source: http://soundfile.sapp.org/doc/WaveFormat/
-    // Refer to offset of each field
-    // ChunkSize
-    fseek(fp, 4, SEEK_SET);
-    fwrite(&ChunkSize, sizeof(int32_t), 1, fp);
-    // Subchunk2Size
-    fseek(fp, 40, SEEK_SET);
-    fwrite(&Subchunk2Size, sizeof(int32_t), 1, fp);
-
-    fseek(fp, 0, SEEK_END);
-}
-
-void BasicAudioScraper::CloseWavFile(FILE* fp, const int nb_data_bytes) {
-    UpdateWavHeader(fp, nb_data_bytes);
-    fclose(fp);
+    m_archive.SetWavParams(params);
+    m_archive.Write(data);
 }
 
-void BasicSlideshowScraper::OnSlideshow(Basic_Slideshow& slideshow) {
-    fs::create_directories(m_dir);
-    const auto id = slideshow.transport_id;
-    auto filepath = m_dir / fmt::format("{}_{}_{}", GetCurrentTime(), id, slideshow.name);
-    auto filepath_str = filepath.string();
-
-    FILE* fp = fopen(filepath_str.c_str(), "wb+");
-    if (fp == nullptr) {
-        LOG_ERROR("[slideshow] Failed to open file {}", filepath_str);
-        return;
-    }
-
-    const auto image_buffer = slideshow.image_data;
-    const size_t nb_written = fwrite(image_buffer.data(), sizeof(uint8_t), image_buffer.size(), fp);
-    if (nb_written != image_buffer.size()) {
-        LOG_ERROR("[slideshow] Failed to write bytes {}/{}", nb_written, image_buffer.size());
+void BasicSlideshowScraper::OnSlideshow(std::shared_ptr<Basic_Slideshow> slideshow) {
+    const auto id = slideshow->transport_id;
+    auto filepath = m_dir / fmt::format("{}_{}_{}", GetCurrentTime(), id, slideshow->name);
+    const auto& image_buffer = slideshow->image_data;
+    if (!m_writer->WriteFile(filepath, image_buffer, slideshow)) {
+        LOG_ERROR("[slideshow] Dropped file {} due to disk backpressure", filepath.string());
     }
-    fclose(fp);
-
-    LOG_MESSAGE("[slideshow] Wrote file {}", filepath_str);
 }
 
-void BasicMOTScraper::OnMOTEntity(MOT_Entity mot) {
+void BasicMOTScraper::OnMOTEntity(const MOT_Entity& mot) {
     auto& content_name_str = mot.header.content_name;
     std::string content_name;
     if (content_name_str != std::nullopt) {
@@ -324,23 +190,8 @@ void BasicMOTScraper::OnMOTEntity(MOT_Entity mot) {
         content_name = fmt::format("content_type_{}_{}.bin", header.content_type, header.content_sub_type);
     }
 
-    fs::create_directories(m_dir);
     auto filepath = m_dir / fmt::format("{}_{}_{}", GetCurrentTime(), mot.transport_id, content_name);
-    auto filepath_str = filepath.string();
-
-    FILE* fp = fopen(filepath_str.c_str(), "wb+");
-    if (fp == nullptr) {
-        LOG_ERROR("[MOT] Failed to open file {}", filepath_str);
-        return;
-    }
-    
-    auto body_buf = mot.body_buf;
-
-    const size_t nb_written = fwrite(body_buf.data(), sizeof(uint8_t), body_buf.size(), fp);
-    if (nb_written != body_buf.size()) {
-        LOG_ERROR("[MOT] Failed to write bytes {}/{}", nb_written, body_buf.size());
+    if (!m_writer->WriteFile(filepath, mot.body_buf, mot.body_data)) {
+        LOG_ERROR("[MOT] Dropped file {} due to disk backpressure", filepath.string());
     }
-    fclose(fp);
-
-    LOG_MESSAGE("[MOT] Wrote file {}", filepath_str);
-}
\ No newline at end of file
+}
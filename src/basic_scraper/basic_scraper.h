@@ -1,6 +1,5 @@
 #pragma once
 #include <stdint.h>
-#include <stdio.h>
 #include <filesystem>
 #include <memory>
 #include <optional>
@@ -10,6 +9,8 @@
 #include "dab/audio/aac_frame_processor.h"
 #include "dab/mot/MOT_entities.h"
 #include "utility/span.h"
+#include "./basic_archive_stream.h"
+#include "./basic_file_writer.h"
 
 namespace fs = std::filesystem;
 
@@ -18,11 +19,25 @@ namespace fs = std::filesystem;
 // └─service_{id}
 //   └─component_{id}
 //     ├─audio
-//     │ └─{date}_audio.wav
+//     │ ├─{date}_audio.wav
+//     │ └─{date}_audio.wav.idx
+//     ├─aac
+//     │ ├─{date}_audio.aac
+//     │ └─{date}_audio.aac.idx
+//     ├─mp2
+//     │ ├─{date}_audio.mp2
+//     │ └─{date}_audio.mp2.idx
 //     ├─slideshow
 //     │ └─{date}_{transport_id}_{label}.{ext}
 //     └─MOT
 //       └─{date}_{transport_id}_{label}.{ext}
+// Audio is archived as ADTS AAC (DAB+) or MP2 (DAB) in time based segments
+// Decoded PCM is optional since it takes up roughly 10x the disk bandwidth
+struct BasicScraper_Config {
+    BasicArchive_Config archive;
+    bool is_record_pcm = false;
+};
+
 class BasicRadio;
 class Basic_Audio_Channel;
 struct Basic_Slideshow;
@@ -30,68 +45,51 @@ struct Basic_Slideshow;
 class BasicAudioScraper 
 {
 private:
-    std::optional<BasicAudioParams> m_old_params = std::nullopt;
-    FILE* m_fp_wav = nullptr;
-    int m_total_bytes_written = 0;
-    const fs::path m_dir;    
+    BasicArchiveStream m_archive;
 public:
-    explicit BasicAudioScraper(const fs::path& dir): m_dir(dir) {}
-    ~BasicAudioScraper();
-    BasicAudioScraper(BasicAudioScraper&) = delete;
-    BasicAudioScraper(BasicAudioScraper&&) = delete;
-    BasicAudioScraper& operator=(BasicAudioScraper&) = delete;
-    BasicAudioScraper& operator=(BasicAudioScraper&&) = delete;
+    explicit BasicAudioScraper(const fs::path& dir, std::shared_ptr<BasicFileWriter> writer, const BasicArchive_Config cfg)
+    : m_archive(dir, "audio", "wav", writer, cfg) {}
     void OnAudioData(BasicAudioParams params, tcb::span<const uint8_t> data);
-private:
-    FILE* CreateWavFile(BasicAudioParams params);
-    void UpdateWavHeader(FILE* fp, const int nb_data_bytes);
-    void CloseWavFile(FILE* fp, const int nb_data_bytes);
 };
 
 class BasicSlideshowScraper
 {
 private:
     const fs::path m_dir;
+    std::shared_ptr<BasicFileWriter> m_writer;
 public:
-    explicit BasicSlideshowScraper(const fs::path& dir): m_dir(dir) {}
-    void OnSlideshow(Basic_Slideshow& slideshow);
+    explicit BasicSlideshowScraper(const fs::path& dir, std::shared_ptr<BasicFileWriter> writer)
+    : m_dir(dir), m_writer(writer) {}
+    void OnSlideshow(std::shared_ptr<Basic_Slideshow> slideshow);
 };
 
 class BasicMOTScraper
 {
 private:
     const fs::path m_dir;
+    std::shared_ptr<BasicFileWriter> m_writer;
 public:
-    explicit BasicMOTScraper(const fs::path& dir): m_dir(dir) {}
-    void OnMOTEntity(MOT_Entity mot);
-};
-
-class BasicBinaryWriter
-{
-private:
-    FILE* m_fp = nullptr;
-public:
-    explicit BasicBinaryWriter(FILE* fp): m_fp(fp) {}
-    ~BasicBinaryWriter();
-    BasicBinaryWriter(BasicBinaryWriter&) = delete;
-    BasicBinaryWriter(BasicBinaryWriter&&) = delete;
-    BasicBinaryWriter& operator=(BasicBinaryWriter&) = delete;
-    BasicBinaryWriter& operator=(BasicBinaryWriter&&) = delete;
-    void Write(tcb::span<const uint8_t> data);
+    explicit BasicMOTScraper(const fs::path& dir, std::shared_ptr<BasicFileWriter> writer)
+    : m_dir(dir), m_writer(writer) {}
+    void OnMOTEntity(const MOT_Entity& mot);
 };
 
 class Basic_Audio_Channel_Scraper
 {
 private:
     const fs::path m_dir;
+    const BasicScraper_Config m_cfg;
+    std::shared_ptr<BasicFileWriter> m_writer;
     BasicAudioScraper m_audio_scraper;
     BasicSlideshowScraper m_slideshow_scraper;
     BasicMOTScraper m_mot_scraper;
-    std::unique_ptr<BasicBinaryWriter> m_audio_aac_writer;
-    std::unique_ptr<BasicBinaryWriter> m_audio_mp2_writer;
-    SuperFrameHeader m_old_aac_header;
+    BasicArchiveStream m_audio_aac_archive;
+    BasicArchiveStream m_audio_mp2_archive;
+    std::optional<SuperFrameHeader> m_old_aac_header = std::nullopt;
+    // ADTS header and access unit are joined so the archive writes or drops them together
+    std::vector<uint8_t> m_aac_frame_buf;
 public:
-    explicit Basic_Audio_Channel_Scraper(const fs::path& dir);
+    explicit Basic_Audio_Channel_Scraper(const fs::path& dir, std::shared_ptr<BasicFileWriter> writer, const BasicScraper_Config cfg);
     static void attach_to_channel(std::shared_ptr<Basic_Audio_Channel_Scraper> scraper, Basic_Audio_Channel& channel);
 };
 
@@ -99,9 +97,13 @@ class BasicScraper
 {
 private:
     std::string m_root_directory;
+    const BasicScraper_Config m_cfg;
+    std::shared_ptr<BasicFileWriter> m_writer;
     std::vector<std::shared_ptr<Basic_Audio_Channel_Scraper>> m_scrapers;
 public:
     template <typename T>
-    explicit BasicScraper(T root_directory): m_root_directory(root_directory) {}
+    explicit BasicScraper(T root_directory, const BasicScraper_Config cfg = {})
+    : m_root_directory(root_directory), m_cfg(cfg), m_writer(std::make_shared<BasicFileWriter>()) {}
     static void attach_to_radio(std::shared_ptr<BasicScraper> scraper, BasicRadio& radio);
+    const BasicFileWriter& GetFileWriter() const { return *m_writer; }
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <limits>
 #include <memory>
+#include <vector>
 #include "detect_architecture.h"
 #include "simd_flags.h" // NOLINT
 #include "utility/span.h"
@@ -23,13 +24,20 @@
 constexpr size_t K = DAB_Viterbi_Decoder::m_constraint_length;
 constexpr size_t R = DAB_Viterbi_Decoder::m_code_rate;
 const uint8_t code_polynomial[R] = { 109, 79, 83, 109 };
-constexpr int16_t soft_decision_low = int16_t(SOFT_DECISION_VITERBI_LOW);
-constexpr int16_t soft_decision_high = int16_t(SOFT_DECISION_VITERBI_HIGH);
-constexpr int16_t soft_decision_unpunctured = int16_t(SOFT_DECISION_VITERBI_PUNCTURED);
+
+// 16bit path metrics
+constexpr int16_t soft_decision_low_u16 = int16_t(SOFT_DECISION_VITERBI_LOW);
+constexpr int16_t soft_decision_high_u16 = int16_t(SOFT_DECISION_VITERBI_HIGH);
+
+// 8bit path metrics
+// NOTE: The soft decisions are requantised so that the branch metrics are small enough to fit in a uint8_t
+//       with enough headroom for the spread of path metrics between renormalisations
+constexpr int8_t soft_decision_low_u8 = -3;
+constexpr int8_t soft_decision_high_u8 = +3;
 
 // Use same configuration for all decoders
-static ViterbiDecoder_Config<uint16_t> create_decoder_config() {
-    const uint16_t max_error = uint16_t(soft_decision_high-soft_decision_low) * uint16_t(DAB_Viterbi_Decoder::m_code_rate);
+static ViterbiDecoder_Config<uint16_t> create_decoder_config_u16() {
+    const uint16_t max_error = uint16_t(soft_decision_high_u16-soft_decision_low_u16) * uint16_t(R);
     const uint16_t error_margin = max_error * uint16_t(5u);
     ViterbiDecoder_Config<uint16_t> config;
     config.soft_decision_max_error = max_error;
@@ -38,13 +46,32 @@ static ViterbiDecoder_Config<uint16_t> create_decoder_config() {
     config.renormalisation_threshold = std::numeric_limits<uint16_t>::max() - error_margin;
     return config; 
 }
-static const auto decoder_config = create_decoder_config();
+
+static ViterbiDecoder_Config<uint8_t> create_decoder_config_u8() {
+    const uint8_t max_error = uint8_t((soft_decision_high_u8-soft_decision_low_u8) * int(R));
+    // Every state can be reached from the best state within K branches
+    // So the spread of path metrics is bounded by K times the largest branch metric
+    const uint8_t error_margin = uint8_t(max_error * uint8_t(K));
+    ViterbiDecoder_Config<uint8_t> config;
+    config.soft_decision_max_error = max_error;
+    config.initial_start_error = std::numeric_limits<uint8_t>::min();
+    config.initial_non_start_error = uint8_t(config.initial_start_error + error_margin);
+    config.renormalisation_threshold = uint8_t(std::numeric_limits<uint8_t>::max() - error_margin);
+    return config; 
+}
+
+static const auto decoder_config_u16 = create_decoder_config_u16();
+static const auto decoder_config_u8 = create_decoder_config_u8();
 
 // Share the branch table for all decoders
 // This saves memory since we don't reallocate the same table for each decoder instance
-static const auto decoder_branch_table = ViterbiBranchTable<K,R,int16_t>(
+static const auto decoder_branch_table_u16 = ViterbiBranchTable<K,R,int16_t>(
     code_polynomial,
-    soft_decision_high, soft_decision_low
+    soft_decision_high_u16, soft_decision_low_u16
+);
+static const auto decoder_branch_table_u8 = ViterbiBranchTable<K,R,int8_t>(
+    code_polynomial,
+    soft_decision_high_u8, soft_decision_low_u8
 );
 
 // Wrap compile time selected decoder for forward declaration
@@ -52,42 +79,185 @@ static const auto decoder_branch_table = ViterbiBranchTable<K,R,int16_t>(
     #if defined(__AVX2__)
         #pragma message("DAB_VITERBI_DECODER using x86 AVX2")
         #include "viterbi/x86/viterbi_decoder_avx_u16.h"
-        using Decoder = ViterbiDecoder_AVX_u16<K,R>;
+        #include "viterbi/x86/viterbi_decoder_avx_u8.h"
+        using Decoder_u16 = ViterbiDecoder_AVX_u16<K,R>;
+        using Decoder_u8 = ViterbiDecoder_AVX_u8<K,R>;
     #elif defined(__SSE4_1__)
         #pragma message("DAB_VITERBI_DECODER using x86 SSE4.1")
         #include "viterbi/x86/viterbi_decoder_sse_u16.h"
-        using Decoder = ViterbiDecoder_SSE_u16<K,R>;
+        #include "viterbi/x86/viterbi_decoder_sse_u8.h"
+        using Decoder_u16 = ViterbiDecoder_SSE_u16<K,R>;
+        using Decoder_u8 = ViterbiDecoder_SSE_u8<K,R>;
     #else
         #pragma message("DAB_VITERBI_DECODER using x86 SCALAR")
         #include "viterbi/viterbi_decoder_scalar.h"
-        using Decoder = ViterbiDecoder_Scalar<K,R,uint16_t,int16_t>;
+        using Decoder_u16 = ViterbiDecoder_Scalar<K,R,uint16_t,int16_t>;
+        using Decoder_u8 = ViterbiDecoder_Scalar<K,R,uint8_t,int8_t>;
     #endif
 #elif defined(__ARCH_AARCH64__)
     #pragma message("DAB_VITERBI_DECODER using ARM AARCH64 NEON")
     #include "viterbi/arm/viterbi_decoder_neon_u16.h"
-    using Decoder = ViterbiDecoder_NEON_u16<K,R>;
+    #include "viterbi/arm/viterbi_decoder_neon_u8.h"
+    using Decoder_u16 = ViterbiDecoder_NEON_u16<K,R>;
+    using Decoder_u8 = ViterbiDecoder_NEON_u8<K,R>;
 #else
     #pragma message("DAB_VITERBI_DECODER using crossplatform SCALAR")
     #include "viterbi/viterbi_decoder_scalar.h"
-    using Decoder = ViterbiDecoder_Scalar<K,R,uint16_t,int16_t>;
+    using Decoder_u16 = ViterbiDecoder_Scalar<K,R,uint16_t,int16_t>;
+    using Decoder_u8 = ViterbiDecoder_Scalar<K,R,uint8_t,int8_t>;
 #endif
 
-using Core = ViterbiDecoder_Core<K,R,uint16_t,int16_t>;
-class DAB_Viterbi_Decoder_Internal: public Core
+struct Metric_U16 {
+    using error_t = uint16_t;
+    using soft_t = int16_t;
+    using decoder_t = Decoder_u16;
+    static const auto& get_branch_table() { return decoder_branch_table_u16; }
+    static const auto& get_config() { return decoder_config_u16; }
+    static soft_t convert(const viterbi_bit_t x) { return soft_t(x); }
+};
+
+struct Metric_U8 {
+    using error_t = uint8_t;
+    using soft_t = int8_t;
+    using decoder_t = Decoder_u8;
+    static const auto& get_branch_table() { return decoder_branch_table_u8; }
+    static const auto& get_config() { return decoder_config_u8; }
+    // Round to nearest level in [-3,+3]
+    static soft_t convert(const viterbi_bit_t x) {
+        constexpr int N = int(SOFT_DECISION_VITERBI_HIGH);
+        constexpr int L = int(soft_decision_high_u8);
+        const int y = int(x)*L;
+        return soft_t((y + ((y >= 0) ? N/2 : -N/2)) / N);
+    }
+};
+
+class DAB_Viterbi_Decoder_Internal 
 {
 public:
-    template <typename ... U>
-    DAB_Viterbi_Decoder_Internal(U&& ... args): Core(std::forward<U>(args)...) {}
+    struct depuncture_res {
+        size_t total_output_symbols;
+        size_t total_punctured_symbols;
+    };
+public:
+    virtual ~DAB_Viterbi_Decoder_Internal() = default;
+    virtual void set_traceback_length(const size_t traceback_length) = 0;
+    virtual size_t get_traceback_length() const = 0;
+    virtual size_t get_current_decoded_bit() const = 0;
+    virtual void reset(const size_t starting_state) = 0;
+    // Returns the accumulated error and the number of punctured symbols consumed
+    virtual uint64_t update(
+        tcb::span<const viterbi_bit_t> punctured_symbols,
+        tcb::span<const uint8_t> puncture_code,
+        const size_t requested_output_symbols,
+        size_t& total_punctured_symbols
+    ) = 0;
+    virtual uint64_t chainback(tcb::span<uint8_t> bytes_out, const size_t end_state) = 0;
 };
 
+template <typename T>
+class DAB_Viterbi_Decoder_Impl: public DAB_Viterbi_Decoder_Internal
+{
+private:
+    using error_t = typename T::error_t;
+    using soft_t = typename T::soft_t;
+    using decoder_t = typename T::decoder_t;
+    ViterbiDecoder_Core<K,R,error_t,soft_t> m_core;
+    std::vector<soft_t> m_depunctured_symbols;
+public:
+    DAB_Viterbi_Decoder_Impl(): m_core(T::get_branch_table(), T::get_config()) {}
+    void set_traceback_length(const size_t traceback_length) override {
+        m_core.set_traceback_length(traceback_length);
+    }
+    size_t get_traceback_length() const override {
+        return m_core.get_traceback_length();
+    }
+    size_t get_current_decoded_bit() const override {
+        return m_core.m_current_decoded_bit;
+    }
+    void reset(const size_t starting_state) override {
+        m_core.reset(starting_state);
+    }
+    uint64_t update(
+        tcb::span<const viterbi_bit_t> punctured_symbols,
+        tcb::span<const uint8_t> puncture_code,
+        const size_t requested_output_symbols,
+        size_t& total_punctured_symbols
+    ) override {
+        const auto res = depuncture_symbols(punctured_symbols, puncture_code, requested_output_symbols);
+        total_punctured_symbols = res.total_punctured_symbols;
+        return decoder_t::template update<uint64_t>(m_core, m_depunctured_symbols.data(), res.total_output_symbols);
+    }
+    uint64_t chainback(tcb::span<uint8_t> bytes_out, const size_t end_state) override {
+        const size_t total_bits = bytes_out.size()*8u;
+        m_core.chainback(bytes_out.data(), total_bits, end_state);
+        return uint64_t(m_core.get_error());
+    }
+private:
+    depuncture_res depuncture_symbols(
+        tcb::span<const viterbi_bit_t> punctured_symbols, 
+        tcb::span<const uint8_t> puncture_code,
+        const size_t requested_output_symbols
+    ) {
+        assert(requested_output_symbols % R == 0);
+
+        const size_t total_punctured_symbols = punctured_symbols.size();
+        const size_t total_puncture_code = puncture_code.size();
+
+        // Resize only if we need more depunctured symbols
+        if (requested_output_symbols > m_depunctured_symbols.size()) {
+            m_depunctured_symbols.resize(requested_output_symbols);
+        }
+
+        depuncture_res res;
+        res.total_output_symbols = 0;
+        res.total_punctured_symbols = 0;
+
+        size_t index_punctured_symbol = 0;
+        size_t index_puncture_code = 0;
+        size_t index_output_symbol = 0;
+
+        while (index_output_symbol < requested_output_symbols) {
+            const size_t total_block_punctured = size_t(puncture_code[index_puncture_code]);
+            const size_t total_block_unpunctured = R - size_t(total_block_punctured);
 
-DAB_Viterbi_Decoder::DAB_Viterbi_Decoder()
-: m_depunctured_symbols(), m_accumulated_error(0)
+            const size_t remaining_punctured = total_punctured_symbols - index_punctured_symbol;
+            assert(remaining_punctured >= total_block_punctured);
+            if (remaining_punctured < total_block_punctured) { 
+                return res;
+            }
+
+            for (size_t i = 0; i < total_block_punctured; i++)  {
+                m_depunctured_symbols[index_output_symbol] = T::convert(punctured_symbols[index_punctured_symbol]);
+                index_punctured_symbol++;
+                index_output_symbol++;
+            }
+
+            for (size_t i = 0; i < total_block_unpunctured; i++)  {
+                m_depunctured_symbols[index_output_symbol] = T::convert(SOFT_DECISION_VITERBI_PUNCTURED);
+                index_output_symbol++;
+            }
+
+            index_puncture_code = (index_puncture_code+1) % total_puncture_code;
+        }
+
+        res.total_output_symbols = index_output_symbol;
+        res.total_punctured_symbols = index_punctured_symbol;
+        return res;
+    }
+};
+
+DAB_Viterbi_Decoder::DAB_Viterbi_Decoder(const Metric metric)
+: m_metric(metric), m_accumulated_error(0)
 {
-    m_decoder = std::make_unique<DAB_Viterbi_Decoder_Internal>(
-        decoder_branch_table,
-        decoder_config
-    );
+    switch (m_metric) {
+    case Metric::U8:
+        m_decoder = std::make_unique<DAB_Viterbi_Decoder_Impl<Metric_U8>>();
+        break;
+    case Metric::U16:
+    default:
+        m_decoder = std::make_unique<DAB_Viterbi_Decoder_Impl<Metric_U16>>();
+        break;
+    }
 }
 
 DAB_Viterbi_Decoder::~DAB_Viterbi_Decoder() {
@@ -103,7 +273,7 @@ size_t DAB_Viterbi_Decoder::get_traceback_length() const {
 }
 
 size_t DAB_Viterbi_Decoder::get_current_decoded_bit() const {
-    return m_decoder->m_current_decoded_bit;
+    return m_decoder->get_current_decoded_bit();
 };
 
 void DAB_Viterbi_Decoder::reset(const size_t starting_state) {
@@ -116,66 +286,12 @@ size_t DAB_Viterbi_Decoder::update(
     tcb::span<const uint8_t> puncture_code,
     const size_t requested_output_symbols
 ) {
-    const auto res = depuncture_symbols(punctured_symbols, puncture_code, requested_output_symbols);
-    m_accumulated_error += Decoder::update<uint64_t>(*m_decoder.get(), m_depunctured_symbols.data(), res.total_output_symbols);
-    return res.total_punctured_symbols;
+    size_t total_punctured_symbols = 0;
+    m_accumulated_error += m_decoder->update(punctured_symbols, puncture_code, requested_output_symbols, total_punctured_symbols);
+    return total_punctured_symbols;
 }
 
 uint64_t DAB_Viterbi_Decoder::chainback(tcb::span<uint8_t> bytes_out, const size_t end_state) {
-    const size_t total_bits = bytes_out.size()*8u;
-    m_decoder->chainback(bytes_out.data(), total_bits, end_state);
-    const uint64_t error = m_accumulated_error + uint64_t(m_decoder->get_error());
+    const uint64_t error = m_accumulated_error + m_decoder->chainback(bytes_out, end_state);
     return error;
 }
-
-DAB_Viterbi_Decoder::depuncture_res DAB_Viterbi_Decoder::depuncture_symbols(
-    tcb::span<const viterbi_bit_t> punctured_symbols, 
-    tcb::span<const uint8_t> puncture_code,
-    const size_t requested_output_symbols
-) {
-    assert(requested_output_symbols % m_code_rate == 0);
-
-    const size_t total_punctured_symbols = punctured_symbols.size();
-    const size_t total_puncture_code = puncture_code.size();
-
-    // Resize only if we need more depunctured symbols
-    if (requested_output_symbols > m_depunctured_symbols.size()) {
-        m_depunctured_symbols.resize(requested_output_symbols);
-    }
-
-    depuncture_res res;
-    res.total_output_symbols = 0;
-    res.total_punctured_symbols = 0;
-
-    size_t index_punctured_symbol = 0;
-    size_t index_puncture_code = 0;
-    size_t index_output_symbol = 0;
-
-    while (index_output_symbol < requested_output_symbols) {
-        const size_t total_block_punctured = size_t(puncture_code[index_puncture_code]);
-        const size_t total_block_unpunctured = m_code_rate - size_t(total_block_punctured);
-
-        const size_t remaining_punctured = total_punctured_symbols - index_punctured_symbol;
-        assert(remaining_punctured >= total_block_punctured);
-        if (remaining_punctured < total_block_punctured) { 
-            return res;
-        }
-
-        for (size_t i = 0; i < total_block_punctured; i++)  {
-            m_depunctured_symbols[index_output_symbol] = int16_t(punctured_symbols[index_punctured_symbol]);
-            index_punctured_symbol++;
-            index_output_symbol++;
-        }
-
-        for (size_t i = 0; i < total_block_unpunctured; i++)  {
-            m_depunctured_symbols[index_output_symbol] = soft_decision_unpunctured;
-            index_output_symbol++;
-        }
-
-        index_puncture_code = (index_puncture_code+1) % total_puncture_code;
-    }
-
-    res.total_output_symbols = index_output_symbol;
-    res.total_punctured_symbols = index_punctured_symbol;
-    return res;
-}
@@ -3,7 +3,6 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <memory>
-#include <vector>
 #include "viterbi_config.h"
 #include "utility/span.h"
 
@@ -14,13 +13,23 @@ class DAB_Viterbi_Decoder
 public:
     static constexpr size_t m_constraint_length = 7;
     static constexpr size_t m_code_rate = 4;
+    // Width of the path metrics used by the decoder core
+    // U16: Soft decisions keep their full range
+    // U8:  All 64 states fit in a single AVX2 register which doubles the number of lanes
+    //      Soft decisions are requantised to 7 levels and path metrics are renormalised more often
+    //      Use this for heavily protected channels such as the FIC where the coarser metric costs little
+    enum class Metric {
+        U16,
+        U8,
+    };
 private:
+    const Metric m_metric;
     std::unique_ptr<DAB_Viterbi_Decoder_Internal> m_decoder;
-    std::vector<int16_t> m_depunctured_symbols;
     uint64_t m_accumulated_error;
 public:
-    DAB_Viterbi_Decoder();
+    explicit DAB_Viterbi_Decoder(const Metric metric=Metric::U16);
     ~DAB_Viterbi_Decoder();
+    Metric get_metric() const { return m_metric; }
     void set_traceback_length(const size_t traceback_length);
     size_t get_traceback_length() const;
     size_t get_current_decoded_bit() const;
@@ -31,15 +40,4 @@ public:
         const size_t requested_output_symbols
     );
     uint64_t chainback(tcb::span<uint8_t> bytes_out, const size_t end_state=0u);
-private:
-    struct depuncture_res {
-        size_t total_output_symbols;
-        size_t total_punctured_symbols;
-    };
-    inline
-    depuncture_res depuncture_symbols(
-        tcb::span<const viterbi_bit_t> punctured_symbols, 
-        tcb::span<const uint8_t> puncture_code,
-        const size_t requested_output_symbols
-    );
-};
\ No newline at end of file
+};
@@ -0,0 +1,126 @@
+#include "./energy_dispersal.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include "detect_architecture.h"
+#include "simd_flags.h" // NOLINT
+#include "utility/span.h"
+#include "./additive_scrambler.h"
+
+using PRBS_Table = std::array<uint8_t, ENERGY_DISPERSAL_MAX_BYTES>;
+
+static PRBS_Table Generate_PRBS_Table() {
+    PRBS_Table table;
+    AdditiveScrambler scrambler;
+    scrambler.SetSyncword(0xFFFF);
+    scrambler.Reset();
+    for (auto& b: table) {
+        b = scrambler.Process();
+    }
+    return table;
+}
+
+tcb::span<const uint8_t> GetEnergyDispersalPRBS() {
+    // NOTE: Static local initialisation is thread safe so decoders on different threads can share this
+    static const PRBS_Table table = Generate_PRBS_Table();
+    return table;
+}
+
+static void xor_bytes_scalar(tcb::span<uint8_t> y, tcb::span<const uint8_t> x) {
+    assert(y.size() <= x.size());
+    const size_t N = y.size();
+    for (size_t i = 0; i < N; i++) {
+        y[i] ^= x[i];
+    }
+}
+
+// x86
+#if defined(__ARCH_X86__)
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+static void xor_bytes_sse2(tcb::span<uint8_t> y, tcb::span<const uint8_t> x) {
+    assert(y.size() <= x.size());
+    const size_t N = y.size();
+
+    // 128bits = 16bytes
+    const size_t K = 16u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    for (size_t i = 0; i < N_vector; i+=K) {
+        __m128i X = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i]));
+        __m128i Y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&y[i]));
+        Y = _mm_xor_si128(Y, X);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&y[i]), Y);
+    }
+
+    xor_bytes_scalar(y.subspan(N_vector), x.subspan(N_vector));
+}
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+static void xor_bytes_avx2(tcb::span<uint8_t> y, tcb::span<const uint8_t> x) {
+    assert(y.size() <= x.size());
+    const size_t N = y.size();
+
+    // 256bits = 32bytes
+    const size_t K = 32u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    for (size_t i = 0; i < N_vector; i+=K) {
+        __m256i X = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&x[i]));
+        __m256i Y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&y[i]));
+        Y = _mm256_xor_si256(Y, X);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&y[i]), Y);
+    }
+
+    xor_bytes_scalar(y.subspan(N_vector), x.subspan(N_vector));
+}
+#endif
+
+#endif
+
+// arm
+#if defined(__ARCH_AARCH64__)
+#include <arm_neon.h>
+static void xor_bytes_neon(tcb::span<uint8_t> y, tcb::span<const uint8_t> x) {
+    assert(y.size() <= x.size());
+    const size_t N = y.size();
+
+    // 128bits = 16bytes
+    const size_t K = 16u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    for (size_t i = 0; i < N_vector; i+=K) {
+        uint8x16_t X = vld1q_u8(&x[i]);
+        uint8x16_t Y = vld1q_u8(&y[i]);
+        Y = veorq_u8(Y, X);
+        vst1q_u8(&y[i], Y);
+    }
+
+    xor_bytes_scalar(y.subspan(N_vector), x.subspan(N_vector));
+}
+#endif
+
+void ApplyEnergyDispersal(tcb::span<uint8_t> buf) {
+    const auto prbs = GetEnergyDispersalPRBS();
+    assert(buf.size() <= prbs.size());
+    #if defined(__ARCH_X86__)
+        #if defined(__AVX2__)
+        xor_bytes_avx2(buf, prbs);
+        #elif defined(__SSE2__)
+        xor_bytes_sse2(buf, prbs);
+        #else
+        xor_bytes_scalar(buf, prbs);
+        #endif
+    #elif defined(__ARCH_AARCH64__)
+        xor_bytes_neon(buf, prbs);
+    #else
+        xor_bytes_scalar(buf, prbs);
+    #endif
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utility/span.h"
+
+// DOC: ETSI EN 300 401
+// Clause 10 - Energy dispersal
+// The FIC and MSC both reset the PRBS to the all 1s syncword at the start of each FIB group and logical frame
+// Since the sequence is identical every time we generate it once and descramble with a vectorised XOR
+// NOTE: The CIF contains 55296 bits for all transmission modes so no FIB group or logical frame can exceed this
+constexpr size_t ENERGY_DISPERSAL_MAX_BYTES = 55296/8;
+
+// Lazily generated PRBS which is shared between all decoders
+tcb::span<const uint8_t> GetEnergyDispersalPRBS();
+// Descramble buffer in place
+void ApplyEnergyDispersal(tcb::span<uint8_t> buf);
@@ -0,0 +1,281 @@
+#include "./packed_soft_bits.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "detect_architecture.h"
+#include "simd_flags.h" // NOLINT
+#include "utility/span.h"
+#include "viterbi_config.h"
+
+// Nearest level is floor((|x|+9)/18) which we compute as floor((|x|+9)*57/1024)
+// NOTE: This is exact for |x| <= 128 and fits in a uint16_t so every instruction set can use it
+constexpr uint16_t QUANTISE_OFFSET = uint16_t(PACKED_SOFT_BIT_STEP/2);
+constexpr uint16_t QUANTISE_MUL = 57;
+constexpr int QUANTISE_SHIFT = 10;
+
+// Two's complement nibble to soft bit
+// NOTE: -8 is never packed but we clamp it in case the buffer is corrupted
+#define L(x) viterbi_bit_t((x)*PACKED_SOFT_BIT_STEP)
+alignas(16) static const viterbi_bit_t UNPACK_TABLE[16] = {
+    L(0), L(+1), L(+2), L(+3), L(+4), L(+5), L(+6), L(+7),
+    L(-7), L(-7), L(-6), L(-5), L(-4), L(-3), L(-2), L(-1),
+};
+#undef L
+
+static inline uint8_t pack_soft_bit(const viterbi_bit_t x) {
+    const uint16_t magnitude = uint16_t((x < 0) ? -int(x) : int(x));
+    const int level = int(((magnitude + QUANTISE_OFFSET) * QUANTISE_MUL) >> QUANTISE_SHIFT);
+    return uint8_t((x < 0) ? -level : level) & 0x0F;
+}
+
+static void pack_soft_bits_scalar(tcb::span<const viterbi_bit_t> bits, tcb::span<uint8_t> packed) {
+    const size_t N = bits.size();
+    const size_t M = N/2;
+    for (size_t i = 0; i < M; i++) {
+        const uint8_t lo = pack_soft_bit(bits[2*i]);
+        const uint8_t hi = pack_soft_bit(bits[2*i+1]);
+        packed[i] = uint8_t(lo | (hi << 4));
+    }
+    if (N % 2 == 1) {
+        packed[M] = pack_soft_bit(bits[N-1]);
+    }
+}
+
+static void unpack_soft_bits_scalar(tcb::span<const uint8_t> packed, tcb::span<viterbi_bit_t> bits) {
+    const size_t N = bits.size();
+    const size_t M = N/2;
+    for (size_t i = 0; i < M; i++) {
+        const uint8_t b = packed[i];
+        bits[2*i]   = UNPACK_TABLE[b & 0x0F];
+        bits[2*i+1] = UNPACK_TABLE[b >> 4];
+    }
+    if (N % 2 == 1) {
+        bits[N-1] = UNPACK_TABLE[packed[M] & 0x0F];
+    }
+}
+
+// x86
+#if defined(__ARCH_X86__)
+
+#if defined(__SSSE3__) && !defined(__AVX2__)
+#include <tmmintrin.h>
+static inline __m128i quantise_soft_bits_sse(const __m128i x) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i offset = _mm_set1_epi16(int16_t(QUANTISE_OFFSET));
+    const __m128i mul = _mm_set1_epi16(int16_t(QUANTISE_MUL));
+    // |x| in 16bit lanes so the multiply doesn't overflow
+    const __m128i magnitude = _mm_abs_epi8(x);
+    __m128i lo = _mm_unpacklo_epi8(magnitude, zero);
+    __m128i hi = _mm_unpackhi_epi8(magnitude, zero);
+    lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_add_epi16(lo, offset), mul), QUANTISE_SHIFT);
+    hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_add_epi16(hi, offset), mul), QUANTISE_SHIFT);
+    const __m128i level = _mm_packus_epi16(lo, hi);
+    return _mm_sign_epi8(level, x);
+}
+
+// Pairs of levels in each 16bit lane are merged into the low byte
+static inline __m128i merge_nibbles_sse(const __m128i level) {
+    const __m128i lo = _mm_and_si128(level, _mm_set1_epi16(0x000F));
+    const __m128i hi = _mm_and_si128(_mm_srli_epi16(level, 4), _mm_set1_epi16(0x00F0));
+    return _mm_or_si128(lo, hi);
+}
+
+static void pack_soft_bits_ssse3(tcb::span<const viterbi_bit_t> bits, tcb::span<uint8_t> packed) {
+    const size_t N = bits.size();
+
+    // 256bits = 32 soft bits = 16 packed bytes
+    const size_t K = 32u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    for (size_t i = 0; i < N_vector; i+=K) {
+        const __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&bits[i]));
+        const __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&bits[i+16]));
+        const __m128i y0 = merge_nibbles_sse(quantise_soft_bits_sse(x0));
+        const __m128i y1 = merge_nibbles_sse(quantise_soft_bits_sse(x1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&packed[i/2]), _mm_packus_epi16(y0, y1));
+    }
+
+    pack_soft_bits_scalar(bits.subspan(N_vector), packed.subspan(N_vector/2));
+}
+
+static void unpack_soft_bits_ssse3(tcb::span<const uint8_t> packed, tcb::span<viterbi_bit_t> bits) {
+    const size_t N = bits.size();
+
+    // 128bits = 16 packed bytes = 32 soft bits
+    const size_t K = 32u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    const __m128i table = _mm_load_si128(reinterpret_cast<const __m128i*>(UNPACK_TABLE));
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&packed[i/2]));
+        const __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(b, mask));
+        const __m128i hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(b, 4), mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&bits[i]),    _mm_unpacklo_epi8(lo, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&bits[i+16]), _mm_unpackhi_epi8(lo, hi));
+    }
+
+    unpack_soft_bits_scalar(packed.subspan(N_vector/2), bits.subspan(N_vector));
+}
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+static inline __m256i quantise_soft_bits_avx2(const __m256i x) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i offset = _mm256_set1_epi16(int16_t(QUANTISE_OFFSET));
+    const __m256i mul = _mm256_set1_epi16(int16_t(QUANTISE_MUL));
+    // unpack and pack both work within 128bit lanes so the order is preserved
+    const __m256i magnitude = _mm256_abs_epi8(x);
+    __m256i lo = _mm256_unpacklo_epi8(magnitude, zero);
+    __m256i hi = _mm256_unpackhi_epi8(magnitude, zero);
+    lo = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_add_epi16(lo, offset), mul), QUANTISE_SHIFT);
+    hi = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_add_epi16(hi, offset), mul), QUANTISE_SHIFT);
+    const __m256i level = _mm256_packus_epi16(lo, hi);
+    return _mm256_sign_epi8(level, x);
+}
+
+static inline __m256i merge_nibbles_avx2(const __m256i level) {
+    const __m256i lo = _mm256_and_si256(level, _mm256_set1_epi16(0x000F));
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(level, 4), _mm256_set1_epi16(0x00F0));
+    return _mm256_or_si256(lo, hi);
+}
+
+static void pack_soft_bits_avx2(tcb::span<const viterbi_bit_t> bits, tcb::span<uint8_t> packed) {
+    const size_t N = bits.size();
+
+    // 512bits = 64 soft bits = 32 packed bytes
+    const size_t K = 64u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    for (size_t i = 0; i < N_vector; i+=K) {
+        const __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&bits[i]));
+        const __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&bits[i+32]));
+        const __m256i y0 = merge_nibbles_avx2(quantise_soft_bits_avx2(x0));
+        const __m256i y1 = merge_nibbles_avx2(quantise_soft_bits_avx2(x1));
+        // packus interleaves 64bit blocks from each lane so we reorder them afterwards
+        const __m256i y = _mm256_permute4x64_epi64(_mm256_packus_epi16(y0, y1), 0b11'01'10'00);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&packed[i/2]), y);
+    }
+
+    pack_soft_bits_scalar(bits.subspan(N_vector), packed.subspan(N_vector/2));
+}
+
+static void unpack_soft_bits_avx2(tcb::span<const uint8_t> packed, tcb::span<viterbi_bit_t> bits) {
+    const size_t N = bits.size();
+
+    // 256bits = 32 packed bytes = 64 soft bits
+    const size_t K = 64u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    const __m256i table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(UNPACK_TABLE)));
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&packed[i/2]));
+        const __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(b, mask));
+        const __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(b, 4), mask));
+        // unpack works within 128bit lanes so we reorder them afterwards
+        const __m256i y0 = _mm256_unpacklo_epi8(lo, hi);
+        const __m256i y1 = _mm256_unpackhi_epi8(lo, hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&bits[i]),    _mm256_permute2x128_si256(y0, y1, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&bits[i+32]), _mm256_permute2x128_si256(y0, y1, 0x31));
+    }
+
+    unpack_soft_bits_scalar(packed.subspan(N_vector/2), bits.subspan(N_vector));
+}
+#endif
+
+#endif
+
+// arm
+#if defined(__ARCH_AARCH64__)
+#include <arm_neon.h>
+static inline uint8x16_t quantise_soft_bits_neon(const int8x16_t x) {
+    const uint8x16_t magnitude = vreinterpretq_u8_s8(vabsq_s8(x));
+    // |x|+9 <= 137 so we can multiply without widening the input
+    const uint8x16_t y = vaddq_u8(magnitude, vdupq_n_u8(uint8_t(QUANTISE_OFFSET)));
+    const uint8x8_t mul = vdup_n_u8(uint8_t(QUANTISE_MUL));
+    const uint8x8_t lo = vshrn_n_u16(vmull_u8(vget_low_u8(y), mul), QUANTISE_SHIFT);
+    const uint8x8_t hi = vshrn_n_u16(vmull_u8(vget_high_u8(y), mul), QUANTISE_SHIFT);
+    const int8x16_t level = vreinterpretq_s8_u8(vcombine_u8(lo, hi));
+    const uint8x16_t is_negative = vcltzq_s8(x);
+    return vreinterpretq_u8_s8(vbslq_s8(is_negative, vnegq_s8(level), level));
+}
+
+static void pack_soft_bits_neon(tcb::span<const viterbi_bit_t> bits, tcb::span<uint8_t> packed) {
+    const size_t N = bits.size();
+
+    // 256bits = 32 soft bits = 16 packed bytes
+    const size_t K = 32u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    for (size_t i = 0; i < N_vector; i+=K) {
+        const int8x16x2_t x = vld2q_s8(&bits[i]);
+        const uint8x16_t even = quantise_soft_bits_neon(x.val[0]);
+        const uint8x16_t odd = quantise_soft_bits_neon(x.val[1]);
+        // shift left and insert keeps the low nibble of the even bit
+        vst1q_u8(&packed[i/2], vsliq_n_u8(vandq_u8(even, vdupq_n_u8(0x0F)), odd, 4));
+    }
+
+    pack_soft_bits_scalar(bits.subspan(N_vector), packed.subspan(N_vector/2));
+}
+
+static void unpack_soft_bits_neon(tcb::span<const uint8_t> packed, tcb::span<viterbi_bit_t> bits) {
+    const size_t N = bits.size();
+
+    // 128bits = 16 packed bytes = 32 soft bits
+    const size_t K = 32u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    const int8x16_t table = vld1q_s8(UNPACK_TABLE);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        const uint8x16_t b = vld1q_u8(&packed[i/2]);
+        int8x16x2_t y;
+        y.val[0] = vqtbl1q_s8(table, vandq_u8(b, vdupq_n_u8(0x0F)));
+        y.val[1] = vqtbl1q_s8(table, vshrq_n_u8(b, 4));
+        vst2q_s8(&bits[i], y);
+    }
+
+    unpack_soft_bits_scalar(packed.subspan(N_vector/2), bits.subspan(N_vector));
+}
+#endif
+
+void PackSoftBits(tcb::span<const viterbi_bit_t> bits, tcb::span<uint8_t> packed) {
+    assert(packed.size() >= GetPackedSoftBitsSize(bits.size()));
+    #if defined(__ARCH_X86__)
+        #if defined(__AVX2__)
+        pack_soft_bits_avx2(bits, packed);
+        #elif defined(__SSSE3__)
+        pack_soft_bits_ssse3(bits, packed);
+        #else
+        pack_soft_bits_scalar(bits, packed);
+        #endif
+    #elif defined(__ARCH_AARCH64__)
+        pack_soft_bits_neon(bits, packed);
+    #else
+        pack_soft_bits_scalar(bits, packed);
+    #endif
+}
+
+void UnpackSoftBits(tcb::span<const uint8_t> packed, tcb::span<viterbi_bit_t> bits) {
+    assert(packed.size() >= GetPackedSoftBitsSize(bits.size()));
+    #if defined(__ARCH_X86__)
+        #if defined(__AVX2__)
+        unpack_soft_bits_avx2(packed, bits);
+        #elif defined(__SSSE3__)
+        unpack_soft_bits_ssse3(packed, bits);
+        #else
+        unpack_soft_bits_scalar(packed, bits);
+        #endif
+    #elif defined(__ARCH_AARCH64__)
+        unpack_soft_bits_neon(packed, bits);
+    #else
+        unpack_soft_bits_scalar(packed, bits);
+    #endif
+}
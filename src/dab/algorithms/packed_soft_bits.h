@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utility/span.h"
+#include "viterbi_config.h"
+
+// Viterbi soft bits requantised to 4 bits and packed two to a byte
+// This halves the memory used by buffers which hold soft bits for a long time, i.e. the CIF deinterleaver
+// Bit 2k is stored in the low nibble and bit 2k+1 in the high nibble of byte k
+// Each nibble is a signed level from -7 to +7 which unpacks back to a multiple of PACKED_SOFT_BIT_STEP
+// NOTE: Puncturing is unaffected since 0 is packed and unpacked losslessly
+constexpr int PACKED_SOFT_BIT_STEP = 18;
+constexpr int PACKED_SOFT_BIT_MAX_LEVEL = 7;
+
+constexpr size_t GetPackedSoftBitsSize(const size_t nb_bits) { return (nb_bits+1)/2; }
+// packed must fit GetPackedSoftBitsSize(bits.size())
+void PackSoftBits(tcb::span<const viterbi_bit_t> bits, tcb::span<uint8_t> packed);
+// packed must fit GetPackedSoftBitsSize(bits.size())
+void UnpackSoftBits(tcb::span<const uint8_t> packed, tcb::span<viterbi_bit_t> bits);
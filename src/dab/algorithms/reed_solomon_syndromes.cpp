@@ -0,0 +1,260 @@
+#include "./reed_solomon_syndromes.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include "detect_architecture.h"
+#include "simd_flags.h" // NOLINT
+#include "utility/span.h"
+
+Reed_Solomon_Syndromes::Reed_Solomon_Syndromes(
+    const int galois_field_polynomial, const int fcr, const int primer, const int nb_roots)
+: m_nb_roots(nb_roots)
+{
+    // Generate Galois field lookup tables
+    constexpr int NN = 255;
+    uint8_t alpha_to[NN+1] = {0};
+    uint8_t index_of[NN+1] = {0};
+    int sr = 1;
+    for (int i = 0; i < NN; i++) {
+        index_of[sr] = uint8_t(i);
+        alpha_to[i] = uint8_t(sr);
+        sr <<= 1;
+        if (sr & (1 << 8)) sr ^= galois_field_polynomial;
+        sr &= NN;
+    }
+    assert(sr == 1 && "Field generator polynomial is not primitive");
+
+    const auto gf_mul = [&](const uint8_t x, const int log_c) -> uint8_t {
+        if (x == 0) return 0;
+        return alpha_to[(int(index_of[x]) + log_c) % NN];
+    };
+
+    // Horner's method evaluates s_i = s_i*α^((fcr+i)*prim) + data[j] for each root
+    m_mul_table_lo.resize(size_t(nb_roots)*16u);
+    m_mul_table_hi.resize(size_t(nb_roots)*16u);
+    for (int i = 0; i < nb_roots; i++) {
+        const int log_c = ((fcr+i)*primer) % NN;
+        for (int j = 0; j < 16; j++) {
+            m_mul_table_lo[i*16+j] = gf_mul(uint8_t(j), log_c);
+            m_mul_table_hi[i*16+j] = gf_mul(uint8_t(j << 4), log_c);
+        }
+    }
+}
+
+// Narrowest lane width of vectorised implementation
+#if defined(__ARCH_X86__)
+    #if defined(__SSSE3__)
+    constexpr size_t SIMD_MIN_LANES = 16;
+    #else
+    constexpr size_t SIMD_MIN_LANES = 0;
+    #endif
+#elif defined(__ARCH_AARCH64__)
+    constexpr size_t SIMD_MIN_LANES = 16;
+#else
+    constexpr size_t SIMD_MIN_LANES = 0;
+#endif
+
+struct SyndromeArgs {
+    const uint8_t* buf;
+    size_t stride;
+    size_t nb_symbols;
+    const uint8_t* mul_table_lo;
+    const uint8_t* mul_table_hi;
+    int nb_roots;
+};
+
+static void calculate_syndromes_scalar(const SyndromeArgs& args, const size_t start, tcb::span<uint8_t> is_error) {
+    const size_t N = is_error.size();
+    for (size_t i = start; i < N; i++) {
+        uint8_t error = 0;
+        for (int k = 0; k < args.nb_roots; k++) {
+            const uint8_t* lo = &args.mul_table_lo[k*16];
+            const uint8_t* hi = &args.mul_table_hi[k*16];
+            uint8_t s = 0;
+            for (size_t j = 0; j < args.nb_symbols; j++) {
+                s = lo[s & 0x0F] ^ hi[s >> 4] ^ args.buf[i + j*args.stride];
+            }
+            error |= s;
+        }
+        is_error[i] = (error != 0) ? 1 : 0;
+    }
+}
+
+// x86
+#if defined(__ARCH_X86__)
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+static size_t calculate_syndromes_ssse3(const SyndromeArgs& args, const size_t start, tcb::span<uint8_t> is_error) {
+    const size_t N = is_error.size();
+
+    // 128bits = 16 codewords
+    const size_t K = 16u;
+    const size_t M = (N-start)/K;
+    const size_t N_vector = start + M*K;
+
+    const __m128i nibble_mask = _mm_set1_epi8(0x0F);
+    for (size_t i = start; i < N_vector; i+=K) {
+        __m128i error = _mm_setzero_si128();
+        for (int k = 0; k < args.nb_roots; k++) {
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&args.mul_table_lo[k*16]));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&args.mul_table_hi[k*16]));
+            __m128i s = _mm_setzero_si128();
+            for (size_t j = 0; j < args.nb_symbols; j++) {
+                const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&args.buf[i + j*args.stride]));
+                const __m128i s_lo = _mm_and_si128(s, nibble_mask);
+                const __m128i s_hi = _mm_and_si128(_mm_srli_epi16(s, 4), nibble_mask);
+                s = _mm_xor_si128(_mm_shuffle_epi8(lo, s_lo), _mm_shuffle_epi8(hi, s_hi));
+                s = _mm_xor_si128(s, x);
+            }
+            error = _mm_or_si128(error, s);
+        }
+        const __m128i is_valid = _mm_cmpeq_epi8(error, _mm_setzero_si128());
+        const uint32_t valid_mask = uint32_t(_mm_movemask_epi8(is_valid));
+        for (size_t j = 0; j < K; j++) {
+            is_error[i+j] = ((valid_mask >> j) & 0b1) ? 0 : 1;
+        }
+    }
+    return N_vector;
+}
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+static size_t calculate_syndromes_avx2(const SyndromeArgs& args, const size_t start, tcb::span<uint8_t> is_error) {
+    const size_t N = is_error.size();
+
+    // 256bits = 32 codewords
+    const size_t K = 32u;
+    const size_t M = (N-start)/K;
+    const size_t N_vector = start + M*K;
+
+    const __m256i nibble_mask = _mm256_set1_epi8(0x0F);
+    for (size_t i = start; i < N_vector; i+=K) {
+        __m256i error = _mm256_setzero_si256();
+        for (int k = 0; k < args.nb_roots; k++) {
+            // NOTE: Byte shuffles operate within each 128bit lane so we copy the table into both lanes
+            const __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&args.mul_table_lo[k*16])));
+            const __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&args.mul_table_hi[k*16])));
+            __m256i s = _mm256_setzero_si256();
+            for (size_t j = 0; j < args.nb_symbols; j++) {
+                const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&args.buf[i + j*args.stride]));
+                const __m256i s_lo = _mm256_and_si256(s, nibble_mask);
+                const __m256i s_hi = _mm256_and_si256(_mm256_srli_epi16(s, 4), nibble_mask);
+                s = _mm256_xor_si256(_mm256_shuffle_epi8(lo, s_lo), _mm256_shuffle_epi8(hi, s_hi));
+                s = _mm256_xor_si256(s, x);
+            }
+            error = _mm256_or_si256(error, s);
+        }
+        const __m256i is_valid = _mm256_cmpeq_epi8(error, _mm256_setzero_si256());
+        const uint32_t valid_mask = uint32_t(_mm256_movemask_epi8(is_valid));
+        for (size_t j = 0; j < K; j++) {
+            is_error[i+j] = ((valid_mask >> j) & 0b1) ? 0 : 1;
+        }
+    }
+    return N_vector;
+}
+#endif
+
+#endif
+
+// arm
+#if defined(__ARCH_AARCH64__)
+#include <arm_neon.h>
+static size_t calculate_syndromes_neon(const SyndromeArgs& args, const size_t start, tcb::span<uint8_t> is_error) {
+    const size_t N = is_error.size();
+
+    // 128bits = 16 codewords
+    const size_t K = 16u;
+    const size_t M = (N-start)/K;
+    const size_t N_vector = start + M*K;
+
+    const uint8x16_t nibble_mask = vdupq_n_u8(0x0F);
+    for (size_t i = start; i < N_vector; i+=K) {
+        uint8x16_t error = vdupq_n_u8(0);
+        for (int k = 0; k < args.nb_roots; k++) {
+            const uint8x16_t lo = vld1q_u8(&args.mul_table_lo[k*16]);
+            const uint8x16_t hi = vld1q_u8(&args.mul_table_hi[k*16]);
+            uint8x16_t s = vdupq_n_u8(0);
+            for (size_t j = 0; j < args.nb_symbols; j++) {
+                const uint8x16_t x = vld1q_u8(&args.buf[i + j*args.stride]);
+                const uint8x16_t s_lo = vandq_u8(s, nibble_mask);
+                const uint8x16_t s_hi = vshrq_n_u8(s, 4);
+                s = veorq_u8(vqtbl1q_u8(lo, s_lo), vqtbl1q_u8(hi, s_hi));
+                s = veorq_u8(s, x);
+            }
+            error = vorrq_u8(error, s);
+        }
+        alignas(16) uint8_t errors[K];
+        vst1q_u8(errors, error);
+        for (size_t j = 0; j < K; j++) {
+            is_error[i+j] = (errors[j] != 0) ? 1 : 0;
+        }
+    }
+    return N_vector;
+}
+#endif
+
+// Process as many codewords as possible using the widest lanes first
+static size_t calculate_syndromes_simd(const SyndromeArgs& args, size_t start, tcb::span<uint8_t> is_error) {
+    #if defined(__ARCH_X86__)
+        #if defined(__AVX2__)
+        start = calculate_syndromes_avx2(args, start, is_error);
+        #endif
+        #if defined(__SSSE3__)
+        start = calculate_syndromes_ssse3(args, start, is_error);
+        #endif
+    #elif defined(__ARCH_AARCH64__)
+        start = calculate_syndromes_neon(args, start, is_error);
+    #endif
+    return start;
+}
+
+size_t Reed_Solomon_Syndromes::Calculate(
+    tcb::span<const uint8_t> buf, const size_t stride, const size_t nb_symbols, 
+    tcb::span<uint8_t> is_error)
+{
+    const size_t N = is_error.size();
+    if ((N == 0) || (nb_symbols == 0)) return 0;
+    assert(stride >= N);
+    assert(buf.size() >= (nb_symbols-1)*stride + N);
+
+    SyndromeArgs args;
+    args.buf = buf.data();
+    args.stride = stride;
+    args.nb_symbols = nb_symbols;
+    args.mul_table_lo = m_mul_table_lo.data();
+    args.mul_table_hi = m_mul_table_hi.data();
+    args.nb_roots = m_nb_roots;
+
+    const size_t N_vector = calculate_syndromes_simd(args, 0, is_error);
+    if (N_vector < N) {
+        if (SIMD_MIN_LANES == 0) {
+            calculate_syndromes_scalar(args, N_vector, is_error);
+        } else if (N >= SIMD_MIN_LANES) {
+            // Overlap the last block with codewords that were already checked
+            calculate_syndromes_simd(args, N-SIMD_MIN_LANES, is_error);
+        } else {
+            // Pad out codewords so they fill the entire lane
+            m_padded_buf.resize(nb_symbols*SIMD_MIN_LANES);
+            std::fill(m_padded_buf.begin(), m_padded_buf.end(), uint8_t(0));
+            for (size_t j = 0; j < nb_symbols; j++) {
+                for (size_t i = 0; i < N; i++) {
+                    m_padded_buf[j*SIMD_MIN_LANES + i] = buf[j*stride + i];
+                }
+            }
+            uint8_t padded_is_error[SIMD_MIN_LANES+1] = {0};
+            args.buf = m_padded_buf.data();
+            args.stride = SIMD_MIN_LANES;
+            calculate_syndromes_simd(args, 0, { padded_is_error, SIMD_MIN_LANES });
+            std::copy_n(padded_is_error, N, is_error.begin());
+        }
+    }
+
+    size_t nb_errors = 0;
+    for (size_t i = 0; i < N; i++) {
+        nb_errors += size_t(is_error[i]);
+    }
+    return nb_errors;
+}
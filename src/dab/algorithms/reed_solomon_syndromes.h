@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+
+// Evaluates the syndromes of many GF(2^8) Reed Solomon codewords at once
+// If all the syndromes of a codeword are zero then it is valid and error location can be skipped
+// This is the common case for a clean signal so we only need to run the full decoder on the rest
+// NOTE: Multiplication by each constant root is done with split nibble lookup tables
+//       y = c*x = c*(x & 0x0F) ^ c*(x & 0xF0), which maps onto 16 entry byte shuffles
+class Reed_Solomon_Syndromes
+{
+private:
+    const int m_nb_roots;
+    // 16 entries for each root
+    std::vector<uint8_t> m_mul_table_lo;
+    std::vector<uint8_t> m_mul_table_hi;
+    // Used when there are too few codewords to fill a vector
+    std::vector<uint8_t> m_padded_buf;
+public:
+    // Parameters are the same as Reed_Solomon_Decoder for 8bit symbols
+    Reed_Solomon_Syndromes(const int galois_field_polynomial, const int fcr, const int primer, const int nb_roots);
+    // Codewords are interleaved so that symbol j of codeword i is located at buf[i + j*stride]
+    // Shortened codewords can omit the leading zero padding symbols since they don't affect the syndromes
+    // Sets is_error[i] to 1 if codeword i has a non-zero syndrome, otherwise 0
+    // Returns the number of codewords with a non-zero syndrome
+    size_t Calculate(
+        tcb::span<const uint8_t> buf, const size_t stride, const size_t nb_symbols, 
+        tcb::span<uint8_t> is_error);
+};
@@ -302,7 +302,20 @@ AAC_Audio_Decoder::AAC_Audio_Decoder(const struct Params _params)
     m_mpeg4_header.resize(32);
     GenerateBitfileConfig();
     GenerateMPEG4Header();
+    // NOTE: libfaad is only opened on the first decoded frame
+    //       This way we can produce MPEG-4 headers without paying for the decoder
+    m_decoder_handle = nullptr;
+    m_decoder_frame_info = nullptr;
+}
+
+AAC_Audio_Decoder::~AAC_Audio_Decoder() {
+    if (m_decoder_handle != nullptr) {
+        NeAACDecClose(m_decoder_handle);
+    }
+    delete m_decoder_frame_info;
+}
 
+void AAC_Audio_Decoder::OpenDecoder() {
     m_decoder_handle = NeAACDecOpen();
     m_decoder_frame_info = new NeAACDecFrameInfo();
     auto decoder_config = NeAACDecGetCurrentConfiguration(m_decoder_handle);
@@ -320,12 +333,10 @@ AAC_Audio_Decoder::AAC_Audio_Decoder(const struct Params _params)
     // TODO: manage the errors that libfaad spits out
 }
 
-AAC_Audio_Decoder::~AAC_Audio_Decoder() {
-    NeAACDecClose(m_decoder_handle);
-    delete m_decoder_frame_info;
-}
-
 AAC_Audio_Decoder::Result AAC_Audio_Decoder::DecodeFrame(tcb::span<uint8_t> data) {
+    if (m_decoder_handle == nullptr) {
+        OpenDecoder();
+    }
     const uint8_t* audio_data_buf = reinterpret_cast<const uint8_t*>(NeAACDecDecode(m_decoder_handle, m_decoder_frame_info, data.data(), int(data.size())));
     LOG_MESSAGE("aac_decoder_error={}", m_decoder_frame_info->error);
 
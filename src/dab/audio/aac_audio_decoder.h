@@ -45,10 +45,13 @@ public:
     AAC_Audio_Decoder(AAC_Audio_Decoder&&) = delete;
     AAC_Audio_Decoder& operator=(AAC_Audio_Decoder&) = delete;
     AAC_Audio_Decoder& operator=(AAC_Audio_Decoder&&) = delete;
+    // libfaad is opened lazily on the first call
     Result DecodeFrame(tcb::span<uint8_t> data);
     Params GetParams() { return m_params; }
     tcb::span<const uint8_t> GetMPEG4Header(uint16_t frame_length_bytes);
+    bool GetIsDecoderOpen() const { return m_decoder_handle != nullptr; }
 private:
+    void OpenDecoder();
     void GenerateBitfileConfig();
     void GenerateMPEG4Header();
 };
\ No newline at end of file
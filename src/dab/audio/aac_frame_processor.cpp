@@ -1,11 +1,13 @@
 #include "./aac_frame_processor.h"
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
 #include <memory>
 #include <fmt/format.h>
 #include "utility/span.h"
 #include "../algorithms/crc.h"
 #include "../algorithms/reed_solomon_decoder.h"
+#include "../algorithms/reed_solomon_syndromes.h"
 #include "../dab_logging.h"
 #define TAG "aac-frame-processor"
 static auto _logger = DAB_LOG_REGISTER(TAG);
@@ -109,7 +111,7 @@ AAC_Frame_Processor::AAC_Frame_Processor() {
     // Therefore we need to use the RS(255,245) decoder
     // As according to the spec we should insert 135 padding symbols (bytes)
     m_rs_decoder = std::make_unique<Reed_Solomon_Decoder>(8, GALOIS_FIELD_POLY, 0, 1, CODE_TOTAL_ROOTS, NB_RS_PADDING_BYTES);
-    m_rs_encoded_buf.resize(NB_RS_MESSAGE_BYTES, 0);
+    m_rs_syndromes = std::make_unique<Reed_Solomon_Syndromes>(GALOIS_FIELD_POLY, 0, 1, CODE_TOTAL_ROOTS);
     // Reed solomon code can correct up to floor(t/2) symbols that were wrong
     // where t = the number of parity symbols
     m_rs_error_positions.resize(NB_RS_PARITY_BYTES, 0);
@@ -135,16 +137,7 @@ void AAC_Frame_Processor::Process(tcb::span<const uint8_t> buf) {
         return;
     }
 
-    // If the buffer size changed reset our accumulated DAB logical frames
-    if (m_prev_nb_dab_frame_bytes != N) {
-        if (m_prev_nb_dab_frame_bytes != 0) {
-            LOG_ERROR("Unexpected resize of DAB logical frame %d!=%d", m_prev_nb_dab_frame_bytes, N);
-        }
-        m_prev_nb_dab_frame_bytes = N;
-        m_super_frame_buf.resize(m_TOTAL_DAB_FRAMES*N);
-        m_curr_dab_frame = 0;
-        m_state = State::WAIT_FRAME_START;
-    }
+    ResizeFrames(N);
 
     // if our superframes fail validation too many times
     // then we resort to waiting for the firecode to be valid
@@ -176,6 +169,30 @@ void AAC_Frame_Processor::Process(tcb::span<const uint8_t> buf) {
     }
 }
 
+tcb::span<uint8_t> AAC_Frame_Processor::GetNextFrameBuffer(const size_t nb_dab_frame_bytes) {
+    const int N = int(nb_dab_frame_bytes);
+    if (N < MIN_DAB_LOGICAL_FRAME_SIZE) {
+        return {};
+    }
+    ResizeFrames(N);
+    return tcb::span(m_super_frame_buf).subspan(m_curr_dab_frame*N, N);
+}
+
+void AAC_Frame_Processor::ResizeFrames(const int nb_dab_frame_bytes) {
+    // If the buffer size changed reset our accumulated DAB logical frames
+    const int N = nb_dab_frame_bytes;
+    if (m_prev_nb_dab_frame_bytes == N) {
+        return;
+    }
+    if (m_prev_nb_dab_frame_bytes != 0) {
+        LOG_ERROR("Unexpected resize of DAB logical frame {}!={}", m_prev_nb_dab_frame_bytes, N);
+    }
+    m_prev_nb_dab_frame_bytes = N;
+    m_super_frame_buf.resize(m_TOTAL_DAB_FRAMES*N);
+    m_curr_dab_frame = 0;
+    m_state = State::WAIT_FRAME_START;
+}
+
 bool AAC_Frame_Processor::CalculateFirecode(tcb::span<const uint8_t> buf) {
     auto crc_data = buf.subspan(NB_FIRECODE_CRC16_BYTES, NB_FIRECODE_DATA_BYTES);
     const uint16_t crc_rx = (buf[0] << 8) | buf[1];
@@ -193,9 +210,11 @@ bool AAC_Frame_Processor::CalculateFirecode(tcb::span<const uint8_t> buf) {
 void AAC_Frame_Processor::AccumulateFrame(tcb::span<const uint8_t> buf) {
     const size_t N = buf.size();
     auto dst_buf = tcb::span(m_super_frame_buf).subspan(m_curr_dab_frame*N, N);
-    for (size_t i = 0; i < N; i++) {
-        dst_buf[i] = buf[i];
+    // Frame was decoded in place from GetNextFrameBuffer()
+    if (buf.data() == dst_buf.data()) {
+        return;
     }
+    std::copy_n(buf.begin(), N, dst_buf.begin());
 }
 
 void AAC_Frame_Processor::ProcessSuperFrame(const int nb_dab_frame_bytes) {
@@ -328,14 +347,41 @@ bool AAC_Frame_Processor::ReedSolomonDecode(const int nb_dab_frame_bytes) {
     // We need to interleave the data so we can perform Reed Solomon decoding
     // Then we deinterleave the corrected RS data into the super frame buffer
 
-    // reed solomon decoder
+    // The superframe is already interleaved so we can check the syndromes of all codewords at once
+    // Only the codewords with a non-zero syndrome need to go through error location
+    m_rs_is_error.resize(size_t(N));
+    const size_t nb_rs_errors = m_rs_syndromes->Calculate(
+        m_super_frame_buf, size_t(N), size_t(NB_RS_MESSAGE_BYTES), m_rs_is_error);
+    if (nb_rs_errors == 0) {
+        return true;
+    }
+
+    m_rs_error_columns.clear();
     for (int i = 0; i < N; i++) {
-        // Interleave for decoding
-        for (int j = 0; j < NB_RS_MESSAGE_BYTES; j++) {
-            m_rs_encoded_buf[j] = m_super_frame_buf[i + j*N];
+        if (m_rs_is_error[i]) {
+            m_rs_error_columns.push_back(i);
         }
+    }
+
+    // Interleave the corrupted codewords for decoding
+    // Walk the superframe row by row so each row is read sequentially once 
+    // instead of striding through the entire superframe for every codeword
+    const int K = int(m_rs_error_columns.size());
+    m_rs_encoded_buf.resize(size_t(K*NB_RS_MESSAGE_BYTES));
+    for (int j = 0; j < NB_RS_MESSAGE_BYTES; j++) {
+        const uint8_t* row = &m_super_frame_buf[j*N];
+        uint8_t* dst = &m_rs_encoded_buf[j];
+        for (int k = 0; k < K; k++) {
+            dst[k*NB_RS_MESSAGE_BYTES] = row[m_rs_error_columns[k]];
+        }
+    }
+
+    // reed solomon decoder
+    for (int c = 0; c < K; c++) {
+        const int i = m_rs_error_columns[c];
+        uint8_t* rs_encoded_buf = &m_rs_encoded_buf[c*NB_RS_MESSAGE_BYTES];
         const int error_count = m_rs_decoder->Decode(
-            m_rs_encoded_buf.data(), m_rs_error_positions.data(), 0);
+            rs_encoded_buf, m_rs_error_positions.data(), 0);
 
         LOG_MESSAGE("[reed-solomon] index={}/{} error_count={}", i, N, error_count);
         // rs decoder returns -1 to indicate too many errors
@@ -354,7 +400,7 @@ bool AAC_Frame_Processor::ReedSolomonDecode(const int nb_dab_frame_bytes) {
                 continue;
             }
             // Deinterleave for error correction
-            m_super_frame_buf[i + k*N] = m_rs_encoded_buf[k];
+            m_super_frame_buf[i + k*N] = rs_encoded_buf[k];
         }
     }
 
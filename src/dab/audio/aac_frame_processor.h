@@ -6,6 +6,7 @@
 #include "utility/span.h"
 
 class Reed_Solomon_Decoder;
+class Reed_Solomon_Syndromes;
 
 enum class MPEG_Surround {
     NOT_USED, SURROUND_51, SURROUND_71, SURROUND_OTHER, RFA
@@ -39,7 +40,10 @@ private:
     enum class State { WAIT_FRAME_START, COLLECT_FRAMES };
 private:
     std::unique_ptr<Reed_Solomon_Decoder> m_rs_decoder;
+    std::unique_ptr<Reed_Solomon_Syndromes> m_rs_syndromes;
     std::vector<uint8_t> m_rs_encoded_buf;
+    std::vector<uint8_t> m_rs_is_error;
+    std::vector<int> m_rs_error_columns;
     std::vector<int> m_rs_error_positions;
     std::vector<uint8_t> m_super_frame_buf;
     // superframe acquisition state
@@ -66,12 +70,16 @@ public:
     ~AAC_Frame_Processor();
     // A audio super frame consists of 5 DAB logical frames
     void Process(tcb::span<const uint8_t> buf);
+    // Slot in the superframe buffer that the next DAB logical frame will occupy
+    // The MSC decoder can write into this directly and pass it back to Process() to avoid a copy
+    tcb::span<uint8_t> GetNextFrameBuffer(const size_t nb_dab_frame_bytes);
     auto& OnFirecodeError(void) { return m_obs_firecode_error; }
     auto& OnRSError(void) { return m_obs_rs_error; }
     auto& OnSuperFrameHeader(void) { return m_obs_superframe_header; }
     auto& OnAccessUnitCRCError(void) { return m_obs_au_crc_error; }
     auto& OnAccessUnit(void) { return m_obs_access_unit; }
 private:
+    void ResizeFrames(const int nb_dab_frame_bytes);
     bool CalculateFirecode(tcb::span<const uint8_t> buf);
     void AccumulateFrame(tcb::span<const uint8_t> buf);
     void ProcessSuperFrame(const int nb_dab_frame_bytes);
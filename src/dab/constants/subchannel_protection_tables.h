@@ -167,4 +167,14 @@ static uint32_t CalculateEEPBitrate(const Subchannel& subchannel) {
 
 static UEP_Descriptor GetUEPDescriptor(const Subchannel& subchannel) {
     return UEP_PROTECTION_TABLE[subchannel.uep_prot_index];
+}
+
+// DOC: ETSI EN 300 401
+// Clause 6.2.1 - Basic sub-channel organization
+// Protection level goes from 1 (strongest) to 5 for UEP and from 1 to 4 for EEP
+static int GetSubchannelProtectionLevel(const Subchannel& subchannel) {
+    if (subchannel.is_uep) {
+        return int(GetUEPDescriptor(subchannel).protection_level);
+    }
+    return int(subchannel.eep_prot_level)+1;
 }
\ No newline at end of file
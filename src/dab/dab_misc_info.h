@@ -26,4 +26,5 @@ struct DAB_Datetime {
 struct DAB_Misc_Info {
     DAB_Datetime datetime;
     DAB_CIF_Counter cif_counter;
+    uint8_t change_flags = 0; // fig 0/0 non-zero when a multiplex reconfiguration is pending
 };
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "./dab_database_serialiser.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "utility/span.h"
+#include "./dab_database.h"
+#include "./dab_database_entities.h"
+#include "./dab_database_types.h"
+
+// Bump the version whenever the layout of an entity changes
+static constexpr uint8_t MAGIC[8] = { 'D', 'A', 'B', 'D', 'B', '0', '0', '1' };
+
+class Database_Writer
+{
+private:
+    std::vector<uint8_t>& m_buf;
+public:
+    explicit Database_Writer(std::vector<uint8_t>& buf): m_buf(buf) {}
+    template <typename T>
+    void Write(const T value) {
+        if constexpr(std::is_enum_v<T>) {
+            Write(static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr(std::is_same_v<T, bool>) {
+            m_buf.push_back(value ? 1 : 0);
+        } else {
+            using U = std::make_unsigned_t<T>;
+            const U v = static_cast<U>(value);
+            for (size_t i = 0; i < sizeof(U); i++) {
+                m_buf.push_back(uint8_t((v >> (i*8)) & 0xFF));
+            }
+        }
+    }
+    void WriteString(const std::string& str) {
+        // Labels are at most 16 characters so a single length byte is enough
+        const size_t N = (str.size() > 0xFF) ? 0xFF : str.size();
+        Write(uint8_t(N));
+        m_buf.insert(m_buf.end(), str.begin(), str.begin() + ptrdiff_t(N));
+    }
+    template <typename T>
+    void WriteVector(const std::vector<T>& vec) {
+        Write(uint16_t(vec.size()));
+        for (const auto& v: vec) Write(v);
+    }
+};
+
+class Database_Reader
+{
+private:
+    tcb::span<const uint8_t> m_buf;
+    size_t m_index = 0;
+    bool m_is_error = false;
+public:
+    explicit Database_Reader(tcb::span<const uint8_t> buf): m_buf(buf) {}
+    bool IsError() const { return m_is_error; }
+    bool IsEnd() const { return m_index == m_buf.size(); }
+    template <typename T>
+    void Read(T& value) {
+        if constexpr(std::is_enum_v<T>) {
+            std::underlying_type_t<T> v = 0;
+            Read(v);
+            value = static_cast<T>(v);
+        } else if constexpr(std::is_same_v<T, bool>) {
+            uint8_t v = 0;
+            Read(v);
+            value = (v != 0);
+        } else {
+            using U = std::make_unsigned_t<T>;
+            U v = 0;
+            if (!Consume(sizeof(U))) return;
+            for (size_t i = 0; i < sizeof(U); i++) {
+                v |= U(U(m_buf[m_index-sizeof(U)+i]) << (i*8));
+            }
+            value = static_cast<T>(v);
+        }
+    }
+    void ReadString(std::string& str) {
+        uint8_t N = 0;
+        Read(N);
+        if (!Consume(N)) return;
+        auto data = m_buf.subspan(m_index-N, N);
+        str.assign(data.begin(), data.end());
+    }
+    template <typename T>
+    void ReadVector(std::vector<T>& vec) {
+        uint16_t N = 0;
+        Read(N);
+        vec.clear();
+        for (uint16_t i = 0; (i < N) && !m_is_error; i++) {
+            T v{};
+            Read(v);
+            vec.push_back(v);
+        }
+    }
+    bool Consume(const size_t N) {
+        if (m_is_error || ((m_buf.size() - m_index) < N)) {
+            m_is_error = true;
+            return false;
+        }
+        m_index += N;
+        return true;
+    }
+};
+
+static void WriteServiceId(Database_Writer& w, const ServiceId& id) {
+    w.Write(id.value);
+    w.Write(id.type);
+}
+
+static ServiceId ReadServiceId(Database_Reader& r) {
+    ServiceId id;
+    r.Read(id.value);
+    r.Read(id.type);
+    return id;
+}
+
+std::vector<uint8_t> SerialiseDatabase(const DAB_Database& db) {
+    std::vector<uint8_t> buf;
+    buf.insert(buf.end(), std::begin(MAGIC), std::end(MAGIC));
+    Database_Writer w(buf);
+
+    const auto& ensemble = db.ensemble;
+    w.Write(ensemble.id.value);
+    w.Write(ensemble.extended_country_code);
+    w.WriteString(ensemble.label);
+    w.WriteString(ensemble.short_label);
+    w.Write(ensemble.nb_services);
+    w.Write(ensemble.reconfiguration_count);
+    w.Write(ensemble.local_time_offset);
+    w.Write(ensemble.international_table_id);
+    w.Write(ensemble.is_complete);
+
+    w.Write(uint16_t(db.services.size()));
+    for (const auto& service: db.services) {
+        WriteServiceId(w, service.id);
+        w.WriteString(service.label);
+        w.WriteString(service.short_label);
+        w.Write(service.programme_type);
+        w.Write(service.is_complete);
+    }
+
+    w.Write(uint16_t(db.service_components.size()));
+    for (const auto& component: db.service_components) {
+        WriteServiceId(w, component.service_id);
+        w.Write(component.component_id);
+        w.Write(component.global_id);
+        w.Write(component.subchannel_id);
+        w.Write(component.packet_address);
+        w.WriteString(component.label);
+        w.WriteString(component.short_label);
+        w.Write(component.language);
+        w.WriteVector(component.application_types);
+        w.Write(component.transport_mode);
+        w.Write(component.audio_service_type);
+        w.Write(component.data_service_type);
+        w.Write(component.is_complete);
+    }
+
+    w.Write(uint16_t(db.subchannels.size()));
+    for (const auto& subchannel: db.subchannels) {
+        w.Write(subchannel.id);
+        w.Write(subchannel.start_address);
+        w.Write(subchannel.length);
+        w.Write(subchannel.is_uep);
+        w.Write(subchannel.uep_prot_index);
+        w.Write(subchannel.eep_prot_level);
+        w.Write(subchannel.eep_type);
+        w.Write(subchannel.fec_scheme);
+        w.Write(subchannel.is_complete);
+    }
+
+    w.Write(uint16_t(db.link_services.size()));
+    for (const auto& link: db.link_services) {
+        w.Write(link.id);
+        w.Write(link.is_active_link);
+        w.Write(link.is_hard_link);
+        w.Write(link.is_international);
+        WriteServiceId(w, link.service_id);
+        w.Write(link.is_complete);
+    }
+
+    w.Write(uint16_t(db.fm_services.size()));
+    for (const auto& fm: db.fm_services) {
+        w.Write(fm.RDS_PI_code);
+        w.Write(fm.linkage_set_number);
+        w.Write(fm.is_time_compensated);
+        w.WriteVector(fm.frequencies);
+        w.Write(fm.is_complete);
+    }
+
+    w.Write(uint16_t(db.drm_services.size()));
+    for (const auto& drm: db.drm_services) {
+        w.Write(drm.drm_code);
+        w.Write(drm.linkage_set_number);
+        w.Write(drm.is_time_compensated);
+        w.WriteVector(drm.frequencies);
+        w.Write(drm.is_complete);
+    }
+
+    w.Write(uint16_t(db.amss_services.size()));
+    for (const auto& amss: db.amss_services) {
+        w.Write(amss.amss_code);
+        w.Write(amss.is_time_compensated);
+        w.WriteVector(amss.frequencies);
+        w.Write(amss.is_complete);
+    }
+
+    w.Write(uint16_t(db.other_ensembles.size()));
+    for (const auto& other: db.other_ensembles) {
+        w.Write(other.id.value);
+        w.Write(other.is_continuous_output);
+        w.Write(other.is_geographically_adjacent);
+        w.Write(other.is_transmission_mode_I);
+        w.Write(other.frequency);
+        w.Write(other.is_complete);
+    }
+
+    return buf;
+}
+
+bool DeserialiseDatabase(tcb::span<const uint8_t> buf, DAB_Database& db) {
+    const size_t N_magic = sizeof(MAGIC);
+    if (buf.size() < N_magic) return false;
+    for (size_t i = 0; i < N_magic; i++) {
+        if (buf[i] != MAGIC[i]) return false;
+    }
+
+    // Parse into a temporary so a corrupt cache never leaves a partial database behind
+    DAB_Database res;
+    Database_Reader r(buf.subspan(N_magic));
+    uint16_t N = 0;
+
+    auto& ensemble = res.ensemble;
+    r.Read(ensemble.id.value);
+    r.Read(ensemble.extended_country_code);
+    r.ReadString(ensemble.label);
+    r.ReadString(ensemble.short_label);
+    r.Read(ensemble.nb_services);
+    r.Read(ensemble.reconfiguration_count);
+    r.Read(ensemble.local_time_offset);
+    r.Read(ensemble.international_table_id);
+    r.Read(ensemble.is_complete);
+
+    r.Read(N);
+    for (uint16_t i = 0; (i < N) && !r.IsError(); i++) {
+        auto& service = res.services.emplace_back(ReadServiceId(r));
+        r.ReadString(service.label);
+        r.ReadString(service.short_label);
+        r.Read(service.programme_type);
+        r.Read(service.is_complete);
+    }
+
+    r.Read(N);
+    for (uint16_t i = 0; (i < N) && !r.IsError(); i++) {
+        const auto service_id = ReadServiceId(r);
+        service_component_id_t component_id = 0;
+        r.Read(component_id);
+        auto& component = res.service_components.emplace_back(service_id, component_id);
+        r.Read(component.global_id);
+        r.Read(component.subchannel_id);
+        r.Read(component.packet_address);
+        r.ReadString(component.label);
+        r.ReadString(component.short_label);
+        r.Read(component.language);
+        r.ReadVector(component.application_types);
+        r.Read(component.transport_mode);
+        r.Read(component.audio_service_type);
+        r.Read(component.data_service_type);
+        r.Read(component.is_complete);
+    }
+
+    r.Read(N);
+    for (uint16_t i = 0; (i < N) && !r.IsError(); i++) {
+        subchannel_id_t id = 0;
+        r.Read(id);
+        auto& subchannel = res.subchannels.emplace_back(id);
+        r.Read(subchannel.start_address);
+        r.Read(subchannel.length);
+        r.Read(subchannel.is_uep);
+        r.Read(subchannel.uep_prot_index);
+        r.Read(subchannel.eep_prot_level);
+        r.Read(subchannel.eep_type);
+        r.Read(subchannel.fec_scheme);
+        r.Read(subchannel.is_complete);
+    }
+
+    r.Read(N);
+    for (uint16_t i = 0; (i < N) && !r.IsError(); i++) {
+        lsn_t id = 0;
+        r.Read(id);
+        auto& link = res.link_services.emplace_back(id);
+        r.Read(link.is_active_link);
+        r.Read(link.is_hard_link);
+        r.Read(link.is_international);
+        link.service_id = ReadServiceId(r);
+        r.Read(link.is_complete);
+    }
+
+    r.Read(N);
+    for (uint16_t i = 0; (i < N) && !r.IsError(); i++) {
+        fm_id_t id = 0;
+        r.Read(id);
+        auto& fm = res.fm_services.emplace_back(id);
+        r.Read(fm.linkage_set_number);
+        r.Read(fm.is_time_compensated);
+        r.ReadVector(fm.frequencies);
+        r.Read(fm.is_complete);
+    }
+
+    r.Read(N);
+    for (uint16_t i = 0; (i < N) && !r.IsError(); i++) {
+        drm_id_t id = 0;
+        r.Read(id);
+        auto& drm = res.drm_services.emplace_back(id);
+        r.Read(drm.linkage_set_number);
+        r.Read(drm.is_time_compensated);
+        r.ReadVector(drm.frequencies);
+        r.Read(drm.is_complete);
+    }
+
+    r.Read(N);
+    for (uint16_t i = 0; (i < N) && !r.IsError(); i++) {
+        amss_id_t id = 0;
+        r.Read(id);
+        auto& amss = res.amss_services.emplace_back(id);
+        r.Read(amss.is_time_compensated);
+        r.ReadVector(amss.frequencies);
+        r.Read(amss.is_complete);
+    }
+
+    r.Read(N);
+    for (uint16_t i = 0; (i < N) && !r.IsError(); i++) {
+        EnsembleId id;
+        r.Read(id.value);
+        auto& other = res.other_ensembles.emplace_back(id);
+        r.Read(other.is_continuous_output);
+        r.Read(other.is_geographically_adjacent);
+        r.Read(other.is_transmission_mode_I);
+        r.Read(other.frequency);
+        r.Read(other.is_complete);
+    }
+
+    if (r.IsError() || !r.IsEnd()) return false;
+    db = std::move(res);
+    return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+
+struct DAB_Database;
+
+// Compact binary form of a database so a previously decoded ensemble can be restored without the FIC
+// Fixed width fields are little endian so the cache is portable between hosts
+std::vector<uint8_t> SerialiseDatabase(const DAB_Database& db);
+// Returns false if the buffer is truncated, corrupt or was written by an incompatible version
+bool DeserialiseDatabase(tcb::span<const uint8_t> buf, DAB_Database& db);
@@ -6,9 +6,9 @@
 #include <fmt/format.h>
 #include "utility/span.h"
 #include "viterbi_config.h"
-#include "../algorithms/additive_scrambler.h"
 #include "../algorithms/crc.h"
 #include "../algorithms/dab_viterbi_decoder.h"
+#include "../algorithms/energy_dispersal.h"
 #include "../constants/puncture_codes.h"
 #include "../dab_logging.h"
 #define TAG "fic-decoder"
@@ -32,7 +32,7 @@ static auto Generate_CRC_Calc() {
 
 static auto CRC16_CALC = Generate_CRC_Calc();
 
-FIC_Decoder::FIC_Decoder(const size_t nb_encoded_bits, const size_t nb_fibs_per_group)
+FIC_Decoder::FIC_Decoder(const size_t nb_encoded_bits, const size_t nb_fibs_per_group, const DAB_Viterbi_Decoder::Metric viterbi_metric)
 // NOTE: 1/3 coding rate after puncturing and 1/4 code
 // For all transmission modes these parameters are constant
 : m_nb_fibs_per_group(nb_fibs_per_group),
@@ -40,11 +40,10 @@ FIC_Decoder::FIC_Decoder(const size_t nb_encoded_bits, const size_t nb_fibs_per_
   m_nb_decoded_bytes(nb_encoded_bits/(8*3)),
   m_nb_decoded_bits(nb_encoded_bits/3)
 {
-    m_vitdec = std::make_unique<DAB_Viterbi_Decoder>();
+    m_vitdec = std::make_unique<DAB_Viterbi_Decoder>(viterbi_metric);
     m_vitdec->set_traceback_length(m_nb_decoded_bits);
     m_decoded_bytes.resize(m_nb_decoded_bytes);
-    m_scrambler = std::make_unique<AdditiveScrambler>();
-    m_scrambler->SetSyncword(0xFFFF);
+    assert(m_nb_decoded_bytes <= ENERGY_DISPERSAL_MAX_BYTES);
 }
 
 FIC_Decoder::~FIC_Decoder() = default;
@@ -86,13 +85,11 @@ void FIC_Decoder::DecodeFIBGroup(tcb::span<const viterbi_bit_t> encoded_bits, co
 
     const uint64_t error = m_vitdec->chainback(m_decoded_bytes);
     LOG_MESSAGE("error:    {}", error);
+    m_statistics.nb_fib_groups.Increment();
+    m_statistics.total_viterbi_error.Increment(error);
 
     // descrambler
-    m_scrambler->Reset();
-    for (size_t i = 0; i < m_nb_decoded_bytes; i++) {
-        uint8_t b = m_scrambler->Process();
-        m_decoded_bytes[i] ^= b;
-    }
+    ApplyEnergyDispersal(m_decoded_bytes);
 
     // crc16 check
     const size_t nb_fib_bytes = m_nb_decoded_bytes/m_nb_fibs_per_group;
@@ -110,8 +107,11 @@ void FIC_Decoder::DecodeFIBGroup(tcb::span<const viterbi_bit_t> encoded_bits, co
         const bool is_valid = crc16_rx == crc16_pred;
         LOG_MESSAGE("[crc16] fib={}/{} is_match={} pred={:04X} got={:04X}", 
             i, m_nb_fibs_per_group, is_valid, crc16_pred, crc16_rx);
-        if (is_valid) {
-            obs_on_fib.Notify(data_buf);
+        m_statistics.nb_fibs.Increment();
+        if (!is_valid) {
+            m_statistics.nb_fib_crc_errors.Increment();
+            continue;
         }
+        obs_on_fib.Notify(data_buf);
     }
 }
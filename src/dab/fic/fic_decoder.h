@@ -4,19 +4,25 @@
 #include <stddef.h>
 #include <memory>
 #include <vector>
+#include "../algorithms/dab_viterbi_decoder.h"
+#include "utility/metrics.h"
 #include "utility/observable.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
 
-class DAB_Viterbi_Decoder;
-class AdditiveScrambler;
+struct FIC_Decoder_Statistics {
+    Metric_Counter nb_fib_groups;
+    Metric_Counter nb_fibs;
+    Metric_Counter nb_fib_crc_errors;
+    // Sum of the error returned by the Viterbi decoder's chainback for each FIB group
+    Metric_Counter total_viterbi_error;
+};
 
 // Decodes the convolutionally encoded, scrambled and CRC16 group of FIGs
 class FIC_Decoder 
 {
 private:
     std::unique_ptr<DAB_Viterbi_Decoder> m_vitdec;
-    std::unique_ptr<AdditiveScrambler> m_scrambler;
     std::vector<uint8_t> m_decoded_bytes;
 
     const size_t m_nb_fibs_per_group;
@@ -26,10 +32,13 @@ private:
 
     // fib buffer
     Observable<tcb::span<const uint8_t>> obs_on_fib;
+    FIC_Decoder_Statistics m_statistics;
 public:
     // number of bits in FIB (fast information block) group per CIF (common interleaved frame)
-    FIC_Decoder(const size_t nb_encoded_bits, const size_t nb_fibs_per_group);
+    // The FIC is heavily protected so it can use the narrower U8 metric with little loss
+    FIC_Decoder(const size_t nb_encoded_bits, const size_t nb_fibs_per_group, const DAB_Viterbi_Decoder::Metric viterbi_metric=DAB_Viterbi_Decoder::Metric::U16);
     ~FIC_Decoder();
     void DecodeFIBGroup(tcb::span<const viterbi_bit_t> encoded_bits, const size_t cif_index);
     auto& OnFIB(void) { return obs_on_fib; }
+    const auto& GetStatistics(void) const { return m_statistics; }
 };
\ No newline at end of file
@@ -1,7 +1,10 @@
 #include "./MOT_assembler.h"
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
+#include <memory>
 #include <optional>
+#include <vector>
 #include <fmt/format.h>
 #include "utility/span.h"
 #include "../dab_logging.h"
@@ -10,100 +13,176 @@ static auto _logger = DAB_LOG_REGISTER(TAG);
 #define LOG_MESSAGE(...) DAB_LOG_MESSAGE(TAG, fmt::format(__VA_ARGS__))
 #define LOG_ERROR(...) DAB_LOG_ERROR(TAG, fmt::format(__VA_ARGS__))
 
+constexpr size_t BITMAP_WORD_BITS = 64;
+
 MOT_Assembler::MOT_Assembler() {
     Reset();
 }
 
 void MOT_Assembler::Reset(void) {
-    // We end up reusing this data
-    for (auto& segment: m_segments) {
-        segment.length = 0;
-        segment.unordered_index = 0;
-    }
+    // NOTE: Listeners may still hold the old buffer so we start a new one
+    m_buffer = std::make_shared<std::vector<uint8_t>>();
+    m_received_segments.clear();
+    m_nb_received_segments = 0;
     m_total_segments = std::nullopt;
-    m_unordered_buffer.clear();
-    m_ordered_buffer.clear();
-    m_segments.clear();
+    m_segment_size = std::nullopt;
+    m_last_segment_size = 0;
+    m_pending_last_segment.clear();
+    m_is_last_segment_pending = false;
+    m_expected_size = std::nullopt;
 }
 
 void MOT_Assembler::SetTotalSegments(const size_t N) {
+    // A different number of segments means the entity was replaced
+    if (m_total_segments.has_value() && (m_total_segments.value() != N)) {
+        LOG_MESSAGE("Total segments changed from {} to {}", m_total_segments.value(), N);
+        Reset();
+    }
     m_total_segments = std::optional(N);
-    m_segments.resize(N);
-}
+    m_received_segments.resize((N + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS, 0);
 
-bool MOT_Assembler::AddSegment(const size_t index, tcb::span<const uint8_t> buf) {
-    if (index >= m_segments.size()) {
-        m_segments.resize(index+1);
+    // Discard any segments that were beyond the end
+    size_t nb_received = 0;
+    for (size_t i = 0; i < m_received_segments.size(); i++) {
+        auto& word = m_received_segments[i];
+        const size_t nb_bits = std::min(BITMAP_WORD_BITS, N - i*BITMAP_WORD_BITS);
+        if (nb_bits < BITMAP_WORD_BITS) {
+            word &= (uint64_t(1) << nb_bits) - 1;
+        }
+        for (uint64_t v = word; v != 0; v &= v-1) {
+            nb_received++;
+        }
     }
+    m_nb_received_segments = nb_received;
+    ReserveExpectedSize();
+}
 
+void MOT_Assembler::SetExpectedSize(const size_t nb_bytes) {
+    m_expected_size = std::optional(nb_bytes);
+    ReserveExpectedSize();
+}
+
+bool MOT_Assembler::AddSegment(const size_t index, tcb::span<const uint8_t> buf) {
     if (m_total_segments.has_value() && (index >= m_total_segments.value())) {
         LOG_ERROR("Segment index overflow specified total segments ({}>={})", index, m_total_segments.value());
         return false;
     }
 
-    auto& segment = m_segments[index];
+    const bool is_last_segment = m_total_segments.has_value() && (index == (m_total_segments.value()-1));
 
     // Segment already present
-    if (segment.length != 0) {
-        if (segment.length != buf.size()) {
-            LOG_ERROR("Segment {} has conflicting size {}!={}", index, segment.length, buf.size());
-            return false;
+    if (IsSegmentReceived(index)) {
+        const size_t expected_size = is_last_segment ? m_last_segment_size : m_segment_size.value_or(0);
+        if (expected_size != buf.size()) {
+            LOG_ERROR("Segment {} has conflicting size {}!={}", index, expected_size, buf.size());
         }
         // TODO: do we check if each segment has matching contents?
         return false;
     }
 
-    // Add segment
     LOG_MESSAGE("Adding segment {} with length={}", index, buf.size());
-    const size_t old_size = m_unordered_buffer.size();
-    const size_t new_size = old_size + buf.size();
-    segment.length = buf.size();
-    segment.unordered_index = old_size;
-    m_unordered_buffer.resize(new_size);
-
-    auto dst_buf = tcb::span(m_unordered_buffer).subspan(old_size, buf.size());
-    for (size_t i = 0; i < buf.size(); i++) {
-        dst_buf[i] = buf[i];
+    if (is_last_segment) {
+        m_last_segment_size = buf.size();
+        if (index == 0) {
+            WriteSegment(0, buf);
+        } else if (m_segment_size.has_value()) {
+            WriteSegment(index*m_segment_size.value(), buf);
+        } else {
+            m_pending_last_segment.assign(buf.begin(), buf.end());
+            m_is_last_segment_pending = true;
+        }
+    } else {
+        if (!m_segment_size.has_value()) {
+            m_segment_size = std::optional(buf.size());
+            ReserveExpectedSize();
+        } else if (m_segment_size.value() != buf.size()) {
+            LOG_ERROR("Segment {} has conflicting size {}!={}", index, m_segment_size.value(), buf.size());
+            return false;
+        }
+        WriteSegment(index*m_segment_size.value(), buf);
+
+        if (m_is_last_segment_pending) {
+            const size_t last_index = m_total_segments.value()-1;
+            WriteSegment(last_index*m_segment_size.value(), m_pending_last_segment);
+            m_pending_last_segment.clear();
+            m_is_last_segment_pending = false;
+        }
     }
-    const auto is_complete = CheckComplete();
+
+    SetSegmentReceived(index);
+    const bool is_complete = CheckComplete();
     if (is_complete) {
-        ReconstructOrderedBuffer();
+        // Trim anything from segments that were discarded after the total was known
+        const size_t N = m_total_segments.value();
+        const size_t total_size = (N-1)*m_segment_size.value_or(0) + m_last_segment_size;
+        if (m_buffer->size() != total_size) {
+            GetWritableBuffer().resize(total_size);
+        }
+        LOG_MESSAGE("Completed buffer with {} segments with length={}", N, total_size);
     }
     return is_complete;
 }
 
-bool MOT_Assembler::CheckComplete(void) {
+bool MOT_Assembler::CheckComplete(void) const {
     // undefined segment length
     if (!m_total_segments.has_value()) {
         return false;
     }
- 
-    size_t total_size = 0;
-    for (size_t i = 0; i < m_total_segments.value(); i++) {
-        const auto& segment = m_segments[i];
-        if (segment.length == 0) return false;
-        total_size += segment.length;
-    }
-    if (total_size != m_unordered_buffer.size()) {
+    if (m_is_last_segment_pending) {
         return false;
     }
-    return true;
+    return m_nb_received_segments == m_total_segments.value();
 }
 
-void MOT_Assembler::ReconstructOrderedBuffer(void) {
-    if (!m_total_segments.has_value()) return;
+bool MOT_Assembler::IsSegmentReceived(const size_t index) const {
+    const size_t word = index / BITMAP_WORD_BITS;
+    if (word >= m_received_segments.size()) return false;
+    const uint64_t mask = uint64_t(1) << (index % BITMAP_WORD_BITS);
+    return (m_received_segments[word] & mask) != 0;
+}
 
-    LOG_MESSAGE("Reconstructing buffer with {} segments with length={}", m_total_segments.value(), m_unordered_buffer.size());
-    m_ordered_buffer.resize(m_unordered_buffer.size());
-    auto dst_buf = tcb::span(m_ordered_buffer);
+void MOT_Assembler::SetSegmentReceived(const size_t index) {
+    const size_t word = index / BITMAP_WORD_BITS;
+    if (word >= m_received_segments.size()) {
+        m_received_segments.resize(word+1, 0);
+    }
+    const uint64_t mask = uint64_t(1) << (index % BITMAP_WORD_BITS);
+    m_received_segments[word] |= mask;
+    m_nb_received_segments++;
+}
 
-    size_t curr_write_index = 0;
-    for (size_t i = 0; i < m_total_segments.value(); i++) {
-        auto& segment = m_segments[i];
-        auto src_buf = tcb::span(m_unordered_buffer).subspan(segment.unordered_index, segment.length);
-        for (size_t j = 0; j < segment.length; j++) {
-            dst_buf[curr_write_index+j] = src_buf[j];
-        }
-        curr_write_index += segment.length;
+void MOT_Assembler::WriteSegment(const size_t offset, tcb::span<const uint8_t> buf) {
+    auto& buffer = GetWritableBuffer();
+    const size_t end = offset + buf.size();
+    if (buffer.size() < end) {
+        buffer.resize(end);
     }
-}
\ No newline at end of file
+    std::copy_n(buf.begin(), buf.size(), buffer.begin() + ptrdiff_t(offset));
+}
+
+void MOT_Assembler::ReserveExpectedSize() {
+    // NOTE: The body size is a 28bit field so a corrupted header could ask for up to 256MB
+    //       We only reserve it if all but the last segment are full and the last segment is not empty
+    if (!m_expected_size.has_value() || !m_total_segments.has_value() || !m_segment_size.has_value()) {
+        return;
+    }
+    const size_t nb_bytes = m_expected_size.value();
+    const size_t N = m_total_segments.value();
+    const size_t min_size = (N-1)*m_segment_size.value() + 1;
+    const size_t max_size = N*m_segment_size.value();
+    m_expected_size = std::nullopt;
+    if ((nb_bytes < min_size) || (nb_bytes > max_size)) {
+        LOG_ERROR("Expected size {} doesn't fit {} segments of {} bytes", nb_bytes, N, m_segment_size.value());
+        return;
+    }
+    if (m_buffer.use_count() > 1) return;
+    m_buffer->reserve(nb_bytes);
+}
+
+std::vector<uint8_t>& MOT_Assembler::GetWritableBuffer() {
+    // Copy on write if a listener is still holding onto a completed buffer
+    if (m_buffer.use_count() > 1) {
+        m_buffer = std::make_shared<std::vector<uint8_t>>(*m_buffer);
+    }
+    return *m_buffer;
+}
@@ -2,34 +2,47 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <memory>
 #include <vector>
 #include <optional>
 #include "utility/span.h"
 
 // Assembles MOT entity from segments
-class MOT_Assembler 
+// DOC: ETSI EN 301 234
+// Clause 5.1: Segmentation of MOT entities
+// All segments except the last have the same size so each segment is written directly to its final offset
+class MOT_Assembler
 {
 private:
-    struct Segment {
-        size_t unordered_index;
-        size_t length;
-        Segment() {
-            unordered_index = 0;
-            length = 0;
-        }
-    };
-private:
-    std::vector<uint8_t> m_unordered_buffer;
-    std::vector<uint8_t> m_ordered_buffer;
-    std::vector<Segment> m_segments;
+    // The completed buffer is shared with listeners so it is never modified in place after being handed out
+    std::shared_ptr<std::vector<uint8_t>> m_buffer;
+    // One bit per received segment
+    std::vector<uint64_t> m_received_segments;
+    size_t m_nb_received_segments = 0;
     std::optional<size_t> m_total_segments = std::nullopt;
+    std::optional<size_t> m_segment_size = std::nullopt;
+    size_t m_last_segment_size = 0;
+    // The last segment can arrive before we know the offset to write it to
+    std::vector<uint8_t> m_pending_last_segment;
+    bool m_is_last_segment_pending = false;
+    // Size given by the MOT header which is only trusted once the segments agree with it
+    std::optional<size_t> m_expected_size = std::nullopt;
 public:
     MOT_Assembler();
     void Reset(void);
     void SetTotalSegments(const size_t N);
+    // Reserve space if the size of the entity is known ahead of time
+    // NOTE: Space is only reserved once the total segments and segment size confirm the size
+    void SetExpectedSize(const size_t nb_bytes);
     bool AddSegment(const size_t index, tcb::span<const uint8_t> buf);
-    tcb::span<uint8_t> GetData() { return m_ordered_buffer; }
-    bool CheckComplete();
+    tcb::span<const uint8_t> GetData() const { return *m_buffer; }
+    // Holds a reference to the data so it can outlive the assembler
+    std::shared_ptr<const std::vector<uint8_t>> GetBuffer() const { return m_buffer; }
+    bool CheckComplete() const;
 private:
-    void ReconstructOrderedBuffer();
-};
\ No newline at end of file
+    bool IsSegmentReceived(const size_t index) const;
+    void SetSegmentReceived(const size_t index);
+    void WriteSegment(const size_t offset, tcb::span<const uint8_t> buf);
+    void ReserveExpectedSize();
+    std::vector<uint8_t>& GetWritableBuffer();
+};
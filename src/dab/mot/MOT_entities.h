@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include <memory>
 #include <vector>
 #include <string>
 #include <optional>
@@ -38,4 +39,6 @@ struct MOT_Entity {
     mot_transport_id_t transport_id;
     MOT_Header_Entity header;
     tcb::span<const uint8_t> body_buf;
+    // Owns body_buf so listeners can keep it without copying
+    std::shared_ptr<const std::vector<uint8_t>> body_data;
 };
\ No newline at end of file
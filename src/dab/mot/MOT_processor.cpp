@@ -76,6 +76,12 @@ void MOT_Processor::Process_MSC_Data_Group(const MOT_MSC_Data_Group_Header heade
     }
 
     auto& assembler = GetAssembler(*assembler_table, header.data_group_type);
+    if (header.data_group_type == MOT_Data_Type::UNSCRAMBLED_BODY) {
+        auto* body_header = m_body_headers.find(header.transport_id);
+        if (body_header != nullptr) {
+            assembler.SetExpectedSize(size_t(body_header->body_size));
+        }
+    }
     if (header.is_last_segment) {
         assembler.SetTotalSegments(header.segment_number+1);
     }
@@ -137,6 +143,7 @@ bool MOT_Processor::CheckBodyComplete(const mot_transport_id_t transport_id) {
     MOT_Entity entity;
     entity.transport_id = transport_id;
     entity.body_buf = body_buf;
+    entity.body_data = body_assembler.GetBuffer();
     entity.header = *header;
 
     LOG_MESSAGE("Completed a MOT header entity with header={} body={} tid={}", entity.header.header_size, entity.header.body_size, entity.transport_id);
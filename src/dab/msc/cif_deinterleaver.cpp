@@ -1,6 +1,11 @@
 #include "./cif_deinterleaver.h"
+#include <stddef.h>
+#include <stdint.h>
 #include "utility/span.h"
 #include "viterbi_config.h"
+#if DAB_CORE_USE_PACKED_SOFT_BITS
+#include "../algorithms/packed_soft_bits.h"
+#endif
 
 // DOC: ETSI EN 300 401
 // Clause 12 - Time interleaving
@@ -10,6 +15,8 @@ const int CIF_INDICES_OFFSETS[TOTAL_CIF_DEINTERLEAVE] = {
     0,8,4,12, 2,10,6,14, 1,9,5,13, 3,11,7,15
 };
 
+#if !DAB_CORE_USE_PACKED_SOFT_BITS
+
 CIF_Deinterleaver::CIF_Deinterleaver(const int nb_bytes)
 : m_nb_bytes(nb_bytes) 
 {
@@ -68,4 +75,68 @@ bool CIF_Deinterleaver::Deinterleave(tcb::span<viterbi_bit_t> out_bits_buf) {
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+#else
+
+CIF_Deinterleaver::CIF_Deinterleaver(const int nb_bytes)
+: m_nb_bytes(nb_bytes) 
+{
+    const size_t nb_packed = GetPackedSoftBitsSize(size_t(m_nb_bytes*8));
+    m_packed_buffer.resize(nb_packed*TOTAL_CIF_DEINTERLEAVE);
+    m_packed_out.resize(nb_packed);
+}
+
+void CIF_Deinterleaver::Consume(tcb::span<const viterbi_bit_t> bits_buf) {
+    const int nb_bits = m_nb_bytes*8;
+    const size_t nb_packed = GetPackedSoftBitsSize(size_t(nb_bits));
+
+    // Pack directly into circular buffer
+    auto curr_packed_buf = tcb::span(m_packed_buffer).subspan(nb_packed*size_t(m_curr_frame), nb_packed);
+    PackSoftBits(bits_buf.first(size_t(nb_bits)), curr_packed_buf);
+
+    // Advance frame
+    m_curr_frame = (m_curr_frame+1) % TOTAL_CIF_DEINTERLEAVE;
+    if (m_total_frames_stored < TOTAL_CIF_DEINTERLEAVE) {
+        m_total_frames_stored++;
+    } 
+}
+
+bool CIF_Deinterleaver::Deinterleave(tcb::span<viterbi_bit_t> out_bits_buf) {
+    const int nb_bits = m_nb_bytes*8;
+    const size_t nb_packed = GetPackedSoftBitsSize(size_t(nb_bits));
+
+    // insufficient frames to deinterleave
+    if (m_total_frames_stored < TOTAL_CIF_DEINTERLEAVE) {
+        return false;
+    }
+
+    // Index=0 points to the newest frame
+    const uint8_t* BUFFER_LOOKUP[TOTAL_CIF_DEINTERLEAVE]; 
+    for (int i = 0; i < TOTAL_CIF_DEINTERLEAVE; i++) {
+        const int frame_index = ((m_curr_frame-1) -i + TOTAL_CIF_DEINTERLEAVE) % TOTAL_CIF_DEINTERLEAVE;
+        BUFFER_LOOKUP[i] = &m_packed_buffer[size_t(frame_index)*nb_packed];
+    }
+
+    // Each byte holds an even and odd bit which come from different frames
+    // Since the interleaving period of 16 bits is 8 bytes we can select the frames for each byte ahead of time
+    constexpr int TOTAL_BYTES_PERIOD = TOTAL_CIF_DEINTERLEAVE/2;
+    const uint8_t* LOW_LOOKUP[TOTAL_BYTES_PERIOD];
+    const uint8_t* HIGH_LOOKUP[TOTAL_BYTES_PERIOD];
+    for (int i = 0; i < TOTAL_BYTES_PERIOD; i++) {
+        LOW_LOOKUP[i]  = BUFFER_LOOKUP[(TOTAL_CIF_DEINTERLEAVE-1) - CIF_INDICES_OFFSETS[2*i]];
+        HIGH_LOOKUP[i] = BUFFER_LOOKUP[(TOTAL_CIF_DEINTERLEAVE-1) - CIF_INDICES_OFFSETS[2*i+1]];
+    }
+
+    // Deinterleave while packed and only unpack the reconstructed frame
+    for (size_t i = 0; i < nb_packed; i+=TOTAL_BYTES_PERIOD) {
+        for (size_t j = 0; j < TOTAL_BYTES_PERIOD; j++) {
+            m_packed_out[i+j] = uint8_t((LOW_LOOKUP[j][i+j] & 0x0F) | (HIGH_LOOKUP[j][i+j] & 0xF0));
+        }
+    }
+    UnpackSoftBits(m_packed_out, out_bits_buf.first(size_t(nb_bits)));
+
+    return true;
+}
+
+#endif
@@ -1,15 +1,23 @@
 #pragma once
 
+#include <stdint.h>
 #include <vector>
 #include "utility/span.h"
 #include "viterbi_config.h"
 
 // Used to deinterleave DAB logical frames coming over a subchannel
 // Refer to ETSI EN 300 401 Clause 12 for a detailed explanation
+// NOTE: If DAB_CORE_USE_PACKED_SOFT_BITS is defined the stored frames are packed to 4bit soft bits
+//       This halves the memory used by the 16 stored frames at the cost of a coarser soft decision
 class CIF_Deinterleaver 
 {
 private:
+#if DAB_CORE_USE_PACKED_SOFT_BITS
+    std::vector<uint8_t> m_packed_buffer;
+    std::vector<uint8_t> m_packed_out;
+#else
     std::vector<viterbi_bit_t> m_bits_buffer;
+#endif
     const int m_nb_bytes;
     int m_curr_frame = 0;
     int m_total_frames_stored = 0;
@@ -19,4 +27,4 @@ public:
     void Consume(tcb::span<const viterbi_bit_t> bits_buf); 
     // Output the deinterleaved bits into a bits array
     bool Deinterleave(tcb::span<viterbi_bit_t> out_bits_buf);
-};
\ No newline at end of file
+};
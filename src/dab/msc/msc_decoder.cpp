@@ -7,8 +7,8 @@
 #include "utility/span.h"
 #include "viterbi_config.h"
 #include "./cif_deinterleaver.h"
-#include "../algorithms/additive_scrambler.h"
 #include "../algorithms/dab_viterbi_decoder.h"
+#include "../algorithms/energy_dispersal.h"
 #include "../constants/puncture_codes.h"
 #include "../constants/subchannel_protection_tables.h"
 #include "../dab_logging.h"
@@ -22,28 +22,56 @@ static auto _logger = DAB_LOG_REGISTER(TAG);
 constexpr int TOTAL_CAPACITY_UNIT_BITS = 64;
 constexpr int TOTAL_CAPACITY_UNIT_BYTES = TOTAL_CAPACITY_UNIT_BITS/8;
 
-MSC_Decoder::MSC_Decoder(const Subchannel subchannel) 
+// Each 128bit block of depunctured symbols decodes to 32 bits with the 1/4 mother code
+// The tail bits from the final PI_X block are discarded
+static int CalculateDecodedBytes(const Subchannel& subchannel) {
+    int total_blocks = 0;
+    if (!subchannel.is_uep) {
+        const auto descriptor = GetEEPDescriptor(subchannel);
+        const int n = subchannel.length / descriptor.capacity_unit_multiple;
+        for (int i = 0; i < EEP_Descriptor::TOTAL_PUNCTURE_CODES; i++) {
+            total_blocks += descriptor.Lx[i].GetLx(n);
+        }
+    } else {
+        const auto descriptor = GetUEPDescriptor(subchannel);
+        for (int i = 0; i < UEP_Descriptor::TOTAL_PUNCTURE_CODES; i++) {
+            total_blocks += int(descriptor.Lx[i]);
+        }
+    }
+    const int nb_decoded_bits = total_blocks*128/int(DAB_Viterbi_Decoder::m_code_rate);
+    return nb_decoded_bits/8;
+}
+
+MSC_Decoder::MSC_Decoder(const Subchannel subchannel, const DAB_Viterbi_Decoder::Metric viterbi_metric) 
 : m_subchannel(subchannel), 
   m_nb_encoded_bits(m_subchannel.length*TOTAL_CAPACITY_UNIT_BITS),
-  m_nb_encoded_bytes(m_subchannel.length*TOTAL_CAPACITY_UNIT_BYTES)
+  m_nb_encoded_bytes(m_subchannel.length*TOTAL_CAPACITY_UNIT_BYTES),
+  m_nb_decoded_bytes(CalculateDecodedBytes(m_subchannel))
 {
     m_encoded_bits_buf.resize(m_nb_encoded_bits);
     m_decoded_bytes_buf.resize(m_nb_encoded_bytes);
 
     m_deinterleaver = std::make_unique<CIF_Deinterleaver>(m_nb_encoded_bytes);
 
-    m_vitdec = std::make_unique<DAB_Viterbi_Decoder>();
+    m_vitdec = std::make_unique<DAB_Viterbi_Decoder>(viterbi_metric);
     // NOTE: The number of encoded symbols is always greater than the number of input bits
     // TODO: Can we set this to a more conservative number to save memory?
     m_vitdec->set_traceback_length(m_nb_encoded_bits);
-
-    m_scrambler = std::make_unique<AdditiveScrambler>();
-    m_scrambler->SetSyncword(0xFFFF);
 }
 
 MSC_Decoder::~MSC_Decoder() = default;
 
 tcb::span<uint8_t> MSC_Decoder::DecodeCIF(tcb::span<const viterbi_bit_t> buf) {
+    return DecodeCIF(buf, m_decoded_bytes_buf);
+}
+
+tcb::span<uint8_t> MSC_Decoder::DecodeCIF(tcb::span<const viterbi_bit_t> buf, tcb::span<uint8_t> out_bytes) {
+    if (int(out_bytes.size()) < m_nb_decoded_bytes) {
+        LOG_ERROR("Output buffer with {} bytes cannot fit decoded frame with {} bytes", 
+            out_bytes.size(), m_nb_decoded_bytes);
+        return {};
+    }
+
     const int N = (int)buf.size();
     const int start_bit = m_subchannel.start_address*TOTAL_CAPACITY_UNIT_BITS;
     const int end_bit = start_bit + m_nb_encoded_bits;
@@ -66,15 +94,15 @@ tcb::span<uint8_t> MSC_Decoder::DecodeCIF(tcb::span<const viterbi_bit_t> buf) {
     int nb_decoded_bytes = 0;
     if (!m_subchannel.is_uep) {
         LOG_MESSAGE("Decoding EEP");
-        nb_decoded_bytes = DecodeEEP();
+        nb_decoded_bytes = DecodeEEP(out_bytes);
     } else {
         LOG_MESSAGE("Decoding UEP");
-        nb_decoded_bytes = DecodeUEP();
+        nb_decoded_bytes = DecodeUEP(out_bytes);
     }
-    return { m_decoded_bytes_buf.data(), size_t(nb_decoded_bytes) };
+    return out_bytes.first(size_t(nb_decoded_bytes));
 }
 
-int MSC_Decoder::DecodeEEP() {
+int MSC_Decoder::DecodeEEP(tcb::span<uint8_t> out_bytes) {
     const auto descriptor = GetEEPDescriptor(m_subchannel);
 
     const int n = m_subchannel.length / descriptor.capacity_unit_multiple;
@@ -101,21 +129,21 @@ int MSC_Decoder::DecodeEEP() {
     const int nb_tail_bits = 24/int(DAB_Viterbi_Decoder::m_code_rate);
     const int nb_decoded_bits = curr_decoded_bit-nb_tail_bits;
     const int nb_decoded_bytes = nb_decoded_bits/8;
-    const uint64_t error = m_vitdec->chainback({m_decoded_bytes_buf.data(), (size_t)nb_decoded_bytes});
+    assert(nb_decoded_bytes == m_nb_decoded_bytes);
+    auto decoded_bytes = out_bytes.first(size_t(nb_decoded_bytes));
+    const uint64_t error = m_vitdec->chainback(decoded_bytes);
     LOG_MESSAGE("vitdec_error: {}", error);
+    m_statistics.nb_decoded_frames.Increment();
+    m_statistics.total_viterbi_error.Increment(error);
 
     // descrambler
-    m_scrambler->Reset();
-    for (int i = 0; i < nb_decoded_bytes; i++) {
-        uint8_t b = m_scrambler->Process();
-        m_decoded_bytes_buf[i] ^= b;
-    }
+    ApplyEnergyDispersal(decoded_bytes);
 
     return nb_decoded_bytes;
 }
 
 // TODO: We don't have any samples to test if UEP decoding works
-int MSC_Decoder::DecodeUEP() {
+int MSC_Decoder::DecodeUEP(tcb::span<uint8_t> out_bytes) {
     const auto descriptor = GetUEPDescriptor(m_subchannel);
 
     // DOC: ETSI EN 300 401
@@ -140,15 +168,15 @@ int MSC_Decoder::DecodeUEP() {
     const int nb_decoded_bits = curr_decoded_bit-nb_tail_bits;
     assert(nb_decoded_bits % 8 == 0);
     const int nb_decoded_bytes = nb_decoded_bits/8;
-    const uint64_t error = m_vitdec->chainback({m_decoded_bytes_buf.data(), (size_t)nb_decoded_bytes});
+    assert(nb_decoded_bytes == m_nb_decoded_bytes);
+    auto decoded_bytes = out_bytes.first(size_t(nb_decoded_bytes));
+    const uint64_t error = m_vitdec->chainback(decoded_bytes);
     LOG_MESSAGE("vitdec_error: {}", error);
+    m_statistics.nb_decoded_frames.Increment();
+    m_statistics.total_viterbi_error.Increment(error);
 
     // descrambler
-    m_scrambler->Reset();
-    for (int i = 0; i < nb_decoded_bytes; i++) {
-        uint8_t b = m_scrambler->Process();
-        m_decoded_bytes_buf[i] ^= b;
-    }
+    ApplyEnergyDispersal(decoded_bytes);
 
     return nb_decoded_bytes;
 }
\ No newline at end of file
@@ -3,13 +3,19 @@
 #include <stdint.h>
 #include <vector>
 #include <memory>
+#include "../algorithms/dab_viterbi_decoder.h"
 #include "../database/dab_database_entities.h"
+#include "utility/metrics.h"
 #include "utility/span.h"
 #include "viterbi_config.h"
 
 class CIF_Deinterleaver;
-class DAB_Viterbi_Decoder;
-class AdditiveScrambler;
+
+struct MSC_Decoder_Statistics {
+    Metric_Counter nb_decoded_frames;
+    // Sum of the error returned by the Viterbi decoder's chainback for each frame
+    Metric_Counter total_viterbi_error;
+};
 
 // Is associated with a subchannel residing inside the CIF (common interleaved frame)
 // Performs deinterleaving and decoding on that subchannel
@@ -20,19 +26,25 @@ private:
     // Internal buffers
     const int m_nb_encoded_bits;
     const int m_nb_encoded_bytes;
+    const int m_nb_decoded_bytes;
     std::vector<viterbi_bit_t> m_encoded_bits_buf;
     std::vector<uint8_t> m_decoded_bytes_buf;
     // Decoders and deinterleavers
     std::unique_ptr<CIF_Deinterleaver> m_deinterleaver;
     std::unique_ptr<DAB_Viterbi_Decoder> m_vitdec;
-    std::unique_ptr<AdditiveScrambler> m_scrambler;
+    MSC_Decoder_Statistics m_statistics;
 public:
-    explicit MSC_Decoder(const Subchannel subchannel);
+    explicit MSC_Decoder(const Subchannel subchannel, const DAB_Viterbi_Decoder::Metric viterbi_metric=DAB_Viterbi_Decoder::Metric::U16);
     ~MSC_Decoder();
     // Returns the number of bytes decoded
     // NOTE: the number of bytes decoded can be 0 if the deinterleaver is still collecting frames
     tcb::span<uint8_t> DecodeCIF(tcb::span<const viterbi_bit_t> buf);
+    // Decode directly into a caller owned buffer which must fit GetNbDecodedBytes()
+    tcb::span<uint8_t> DecodeCIF(tcb::span<const viterbi_bit_t> buf, tcb::span<uint8_t> out_bytes);
+    // Size of each decoded logical frame
+    int GetNbDecodedBytes() const { return m_nb_decoded_bytes; }
+    const auto& GetStatistics() const { return m_statistics; }
 private:
-    int DecodeEEP();
-    int DecodeUEP();
+    int DecodeEEP(tcb::span<uint8_t> out_bytes);
+    int DecodeUEP(tcb::span<uint8_t> out_bytes);
 };
\ No newline at end of file
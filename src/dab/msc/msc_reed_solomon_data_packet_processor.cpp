@@ -7,6 +7,7 @@
 #include <fmt/format.h>
 #include "utility/span.h"
 #include "../algorithms/reed_solomon_decoder.h"
+#include "../algorithms/reed_solomon_syndromes.h"
 #include "../dab_logging.h"
 #define TAG "msc-reed-solomon-data-packet-processor"
 static auto _logger = DAB_LOG_REGISTER(TAG);
@@ -40,7 +41,10 @@ static_assert(RS_DATA_TABLE_SIZE == (FEC_PACKET_DATA_FIELD_SIZE*TOTAL_FEC_PACKET
 MSC_Reed_Solomon_Data_Packet_Processor::MSC_Reed_Solomon_Data_Packet_Processor() {
     m_rs_encoded_buf.resize(RS_MESSAGE_BYTES);
     m_rs_error_positions.resize(RS_PARITY_BYTES);
-    m_rs_data_table.resize(RS_DATA_TABLE_SIZE);
+    // Application data table followed by the RS data table
+    // Symbol x of row y is located at [x*RS_TOTAL_ROWS + y]
+    m_rs_codewords_buf.resize(APPLICATION_DATA_TABLE_SIZE + RS_DATA_TABLE_SIZE);
+    m_rs_is_error.resize(RS_TOTAL_ROWS);
     m_ring_buf.resize(TOTAL_RING_BUFFER_SIZE);
     // ETSI EN 300 401
     // Clause: 5.3.5.1 FEC frame
@@ -50,6 +54,7 @@ MSC_Reed_Solomon_Data_Packet_Processor::MSC_Reed_Solomon_Data_Packet_Processor()
     constexpr int CODE_TOTAL_ROOTS = 16; // same as number of rs parity bits
     // We pad the RS(204,188) code to RS(255,239) by adding zero symbols to the left of the message
     m_rs_decoder = std::make_unique<Reed_Solomon_Decoder>(8, GALOIS_FIELD_POLY, 0, 1, CODE_TOTAL_ROOTS, int(RS_PADDING_BYTES));
+    m_rs_syndromes = std::make_unique<Reed_Solomon_Syndromes>(GALOIS_FIELD_POLY, 0, 1, CODE_TOTAL_ROOTS);
 }
 
 MSC_Reed_Solomon_Data_Packet_Processor::~MSC_Reed_Solomon_Data_Packet_Processor() = default;
@@ -186,7 +191,15 @@ void MSC_Reed_Solomon_Data_Packet_Processor::ResetRingBuffer() {
 void MSC_Reed_Solomon_Data_Packet_Processor::PerformReedSolomonCorrection() {
     assert(m_ring_size == TOTAL_RING_BUFFER_SIZE);
 
+    // Unwrap application data table from ring buffer
+    auto app_data_table = tcb::span(m_rs_codewords_buf).first(APPLICATION_DATA_TABLE_SIZE);
+    for (size_t i = 0; i < APPLICATION_DATA_TABLE_SIZE; i++) {
+        const size_t i_ring = (m_ring_read_head + i) % m_ring_buf.size();
+        app_data_table[i] = m_ring_buf[i_ring];
+    }
+
     // Figure 17: Complete FEC packet set
+    auto rs_data_table = tcb::span(m_rs_codewords_buf).subspan(APPLICATION_DATA_TABLE_SIZE, RS_DATA_TABLE_SIZE);
     for (size_t i = 0; i < TOTAL_FEC_PACKETS; i++) {
         // Remove header from FEC packets
         const size_t i_ring = m_ring_read_head + APPLICATION_DATA_TABLE_SIZE + i*FEC_PACKET_LENGTH + FEC_PACKET_HEADER_SIZE;
@@ -201,24 +214,21 @@ void MSC_Reed_Solomon_Data_Packet_Processor::PerformReedSolomonCorrection() {
         }
         for (size_t j = 0; j < data_field_size; j++) {
             const size_t j_ring = (i_ring+j) % m_ring_buf.size();
-            m_rs_data_table[i_table+j] = m_ring_buf[j_ring];
+            rs_data_table[i_table+j] = m_ring_buf[j_ring];
         }
     }
 
     // Figure 15: Structure of FEC frame
+    // Each row is a codeword whose symbols are spread column-wise so we can check all rows at once
+    // Only the rows with a non-zero syndrome need to go through error location
+    m_rs_syndromes->Calculate(m_rs_codewords_buf, RS_TOTAL_ROWS, RS_MESSAGE_BYTES, m_rs_is_error);
     for (size_t y = 0; y < RS_TOTAL_ROWS; y++) {
-        // Read application data table (transform from ring row-wise to table column-wise)
-        for (size_t i = 0; i < RS_DATA_BYTES; i++) {
-            const size_t x = i;
-            const size_t i_offset = i*RS_TOTAL_ROWS + y;
-            const size_t i_ring = (m_ring_read_head + i_offset) % m_ring_buf.size();
-            m_rs_encoded_buf[x] = m_ring_buf[i_ring];
+        if (!m_rs_is_error[y]) {
+            continue;
         }
-        // Read rs data table (transform from ring row-wise to table column-wise)
-        for (size_t i = 0; i < RS_PARITY_BYTES; i++) {
-            const size_t x = RS_DATA_BYTES + i;
-            const size_t i_offset = i*RS_TOTAL_ROWS + y;
-            m_rs_encoded_buf[x] = m_rs_data_table[i_offset];
+        // Read table column-wise
+        for (size_t x = 0; x < RS_MESSAGE_BYTES; x++) {
+            m_rs_encoded_buf[x] = m_rs_codewords_buf[x*RS_TOTAL_ROWS + y];
         }
 
         const int error_count = m_rs_decoder->Decode(m_rs_encoded_buf.data(), m_rs_error_positions.data(), 0);
@@ -10,6 +10,7 @@
 #include "utility/span.h"
 
 class Reed_Solomon_Decoder;
+class Reed_Solomon_Syndromes;
 
 class MSC_Reed_Solomon_Data_Packet_Processor
 {
@@ -19,7 +20,8 @@ public:
 private:
     std::vector<uint8_t> m_rs_encoded_buf;
     std::vector<int> m_rs_error_positions;
-    std::vector<uint8_t> m_rs_data_table;
+    std::vector<uint8_t> m_rs_codewords_buf;
+    std::vector<uint8_t> m_rs_is_error;
     std::vector<uint8_t> m_pop_buf;
     std::vector<uint8_t> m_ring_buf;
     size_t m_ring_read_head = 0;
@@ -30,6 +32,7 @@ private:
     std::optional<uint8_t> m_last_counter = std::nullopt;
     Callback m_callback = nullptr;
     std::unique_ptr<Reed_Solomon_Decoder> m_rs_decoder;
+    std::unique_ptr<Reed_Solomon_Syndromes> m_rs_syndromes;
 public:
     MSC_Reed_Solomon_Data_Packet_Processor();
     ~MSC_Reed_Solomon_Data_Packet_Processor();
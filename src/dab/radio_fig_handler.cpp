@@ -27,6 +27,7 @@ void Radio_FIG_Handler::OnEnsemble_1_ID(
     if (m_misc_info) {
         m_misc_info->cif_counter.upper_count = cif_upper;
         m_misc_info->cif_counter.lower_count = cif_lower;
+        m_misc_info->change_flags = change_flags;
     }
 }
 
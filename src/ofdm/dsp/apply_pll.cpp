@@ -9,7 +9,7 @@
 #include "./apply_pll.h"
 #include "./chebyshev_sine.h"
 
-static void apply_pll_scalar(
+void apply_pll_scalar(
     tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y, 
     const float freq_norm, const float dt_norm)
 {
@@ -118,6 +118,48 @@ static void apply_pll_avx(
 
 #endif
 
+// arm
+#if defined(__ARCH_AARCH64__)
+#include <arm_neon.h>
+#include "./arm/c32_mul.h"
+
+static void apply_pll_neon(
+    tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y, 
+    const float freq_norm, const float dt_norm) 
+{
+    assert(x.size() == y.size());
+    const size_t N = x.size();
+
+    // 128bits = 16bytes = 2*8bytes
+    const size_t K = 2u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    const float dt_step = freq_norm;
+    alignas(16) float dt_step_pack_arr[K*2u];
+    for (size_t i = 0; i < K; i++) {
+        const float dt = float(i)*dt_step;
+        dt_step_pack_arr[2*i+0] = dt+0.25f; // f(x) = cos(2*PI*x) = sin[2*PI*(x+0.25)]
+        dt_step_pack_arr[2*i+1] = dt;
+    }
+    const float32x4_t dt_step_pack = vld1q_f32(dt_step_pack_arr);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        float32x4_t dt = vdupq_n_f32(dt_norm + float(i)*dt_step);
+        dt = vaddq_f32(dt, dt_step_pack);
+        // translate to [-0.5,+0.5] within chebyshev accurate range
+        dt = vsubq_f32(dt, vrndnq_f32(dt));
+        float32x4_t pll = chebyshev_sine_neon(dt);
+        float32x4_t X = vld1q_f32(reinterpret_cast<const float*>(&x[i]));
+        float32x4_t Y = c32_mul_neon(X, pll);
+        vst1q_f32(reinterpret_cast<float*>(&y[i]), Y);
+    }
+ 
+    const float dt_scalar = dt_norm + float(N_vector)*dt_step;
+    apply_pll_scalar(x.subspan(N_vector), y.subspan(N_vector), freq_norm, dt_scalar);
+}
+
+#endif
+
 void apply_pll_auto(
     tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y, 
     const float freq_norm, const float dt_norm
@@ -130,6 +172,8 @@ void apply_pll_auto(
         #else
         apply_pll_scalar(x, y, freq_norm, dt_norm);
         #endif
+    #elif defined(__ARCH_AARCH64__)
+        apply_pll_neon(x, y, freq_norm, dt_norm);
     #else
         apply_pll_scalar(x, y, freq_norm, dt_norm);
     #endif
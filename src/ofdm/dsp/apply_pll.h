@@ -8,3 +8,8 @@ void apply_pll_auto(
     tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y,
     const float freq_norm, const float dt_norm=0.0f
 );
+// Portable reference that the vectorised variants are checked against
+void apply_pll_scalar(
+    tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y,
+    const float freq_norm, const float dt_norm=0.0f
+);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <arm_neon.h>
+#include "simd_flags.h" // NOLINT
+
+// Conjugate multiply packed complex float 
+// Y = X0*~X1
+
+#if defined(__SIMD_NEON__)
+static inline float32x4_t c32_conj_mul_neon(float32x4_t x0, float32x4_t x1) {
+    // Vectorise complex conjugate multiplication
+    // [a b] * ~[c d] = [ac+bd bc-ad]
+    const float32x4_t CONJ_MASK = { 1.0f, -1.0f, 1.0f, -1.0f };
+
+    // [a a]
+    float32x4_t a1 = vtrn1q_f32(x0, x0);
+    // [b b]
+    float32x4_t a2 = vtrn2q_f32(x0, x0);
+    // [d c]
+    float32x4_t a0 = vrev64q_f32(x1);
+    // [ac -ad]
+    float32x4_t b1 = vmulq_f32(a1, vmulq_f32(x1, CONJ_MASK));
+    // [ac+bd bc-ad]
+    float32x4_t y = vfmaq_f32(b1, a2, a0);
+    return y;
+}
+#endif
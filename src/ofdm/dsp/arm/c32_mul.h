@@ -0,0 +1,26 @@
+#pragma once
+
+#include <arm_neon.h>
+#include "simd_flags.h" // NOLINT
+
+// Multiply packed complex float 
+
+#if defined(__SIMD_NEON__)
+static inline float32x4_t c32_mul_neon(float32x4_t x0, float32x4_t x1) {
+    // Vectorise complex multiplication
+    // [a b] * [c d] = [ac-bd ad+bc]
+    const float32x4_t SIGN_MASK = { -1.0f, 1.0f, -1.0f, 1.0f };
+
+    // [a a]
+    float32x4_t a1 = vtrn1q_f32(x0, x0);
+    // [b b]
+    float32x4_t a2 = vtrn2q_f32(x0, x0);
+    // [-d c]
+    float32x4_t a0 = vmulq_f32(vrev64q_f32(x1), SIGN_MASK);
+    // [ac ad]
+    float32x4_t b1 = vmulq_f32(a1, x1);
+    // [ac-bd ad+bc]
+    float32x4_t y = vfmaq_f32(b1, a2, a0);
+    return y;
+}
+#endif
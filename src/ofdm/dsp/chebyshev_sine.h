@@ -106,3 +106,32 @@ static inline __m256 _mm256_chebyshev_sine(__m256 x) {
 #endif
 
 #endif
+
+// arm
+#if defined(__ARCH_AARCH64__)
+#include <arm_neon.h>
+
+static inline float32x4_t chebyshev_sine_neon(float32x4_t x) {
+    const float32x4_t A0 = vdupq_n_f32(CHEBYSHEV_POLYNOMIAL_COEFFICIENTS[0]);
+    const float32x4_t A1 = vdupq_n_f32(CHEBYSHEV_POLYNOMIAL_COEFFICIENTS[1]);
+    const float32x4_t A2 = vdupq_n_f32(CHEBYSHEV_POLYNOMIAL_COEFFICIENTS[2]);
+    const float32x4_t A3 = vdupq_n_f32(CHEBYSHEV_POLYNOMIAL_COEFFICIENTS[3]);
+    const float32x4_t A4 = vdupq_n_f32(CHEBYSHEV_POLYNOMIAL_COEFFICIENTS[4]);
+    const float32x4_t A5 = vdupq_n_f32(CHEBYSHEV_POLYNOMIAL_COEFFICIENTS[5]);
+    // Calculate g(x) = a5*x^10 + a4*x^8 + a3*x^6 + a2*x^4 + a1*x^2 + a0
+    // NOTE: vfmaq_f32(c,a,b) = c + a*b
+    const float32x4_t z = vmulq_f32(x,x);     // z = x^2
+    const float32x4_t b5 = A5;                // a5*z^0
+    const float32x4_t b4 = vfmaq_f32(A4,b5,z); // a5*z^1 + a4*z^0
+    const float32x4_t b3 = vfmaq_f32(A3,b4,z); // a5*z^2 + a4*z^1 + a3*z^0
+    const float32x4_t b2 = vfmaq_f32(A2,b3,z); // a5*z^3 + a4*z^2 + a3*z^1 + a2*z^0
+    const float32x4_t b1 = vfmaq_f32(A1,b2,z); // a5*z^4 + a4*z^3 + a3*z^2 + a2*z^1 + a1*z^0
+    const float32x4_t b0 = vfmaq_f32(A0,b1,z); // a5*z^5 + a4*z^4 + a3*z^3 + a2*z^2 + a1*z^1 + a0*z^0
+    // Calculate f(x) = g(x) * (x-0.5) * (x+0.5) * x
+    //           f(x) = g(x) * (x^2 - 0.25) * x
+    //           f(x) = g(x) * (z-0.25) * x
+    const float32x4_t c0 = vsubq_f32(z,vdupq_n_f32(0.25f));
+    return vmulq_f32(vmulq_f32(b0,c0),x);
+}
+
+#endif
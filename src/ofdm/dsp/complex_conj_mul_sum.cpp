@@ -101,6 +101,45 @@ std::complex<float> complex_conj_mul_sum_avx(
 
 #endif
 
+#if defined(__ARCH_AARCH64__)
+#include <arm_neon.h>
+#include "./arm/c32_conj_mul.h"
+
+std::complex<float> complex_conj_mul_sum_neon(
+    tcb::span<const std::complex<float>> x0,
+    tcb::span<const std::complex<float>> x1)
+{
+    assert(x0.size() == x1.size());
+    const size_t N = x0.size();
+
+    // 128bits = 16bytes = 2*8bytes
+    const size_t K = 2u;
+    const size_t M = N/K;
+    const size_t N_vector = M*K;
+
+    float32x4_t Y_vec = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < N_vector; i+=K) {
+        float32x4_t X0 = vld1q_f32(reinterpret_cast<const float*>(&x0[i]));
+        float32x4_t X1 = vld1q_f32(reinterpret_cast<const float*>(&x1[i]));
+        float32x4_t Y = c32_conj_mul_neon(X0, X1);
+        Y_vec = vaddq_f32(Y, Y_vec);
+    }
+
+    // [c1 c2]
+    // [c1+c2]
+    const float32x2_t v0 = vadd_f32(vget_low_f32(Y_vec), vget_high_f32(Y_vec));
+    // Extract real and imaginary components
+    auto y = std::complex<float>{
+        vget_lane_f32(v0, 0),
+        vget_lane_f32(v0, 1),
+    };
+
+    y += complex_conj_mul_sum_scalar(x0.subspan(N_vector), x1.subspan(N_vector));
+    return y;
+}
+
+#endif
+
 std::complex<float> complex_conj_mul_sum_auto(
     tcb::span<const std::complex<float>> x0,
     tcb::span<const std::complex<float>> x1)
@@ -113,6 +152,8 @@ std::complex<float> complex_conj_mul_sum_auto(
         #else
         return complex_conj_mul_sum_scalar(x0, x1);
         #endif
+    #elif defined(__ARCH_AARCH64__)
+        return complex_conj_mul_sum_neon(x0, x1);
     #else
         return complex_conj_mul_sum_scalar(x0, x1);
     #endif
@@ -7,3 +7,8 @@ std::complex<float> complex_conj_mul_sum_auto(
     tcb::span<const std::complex<float>> x0,
     tcb::span<const std::complex<float>> x1
 );
+// Scalar implementation that the vectorised variants must match
+std::complex<float> complex_conj_mul_sum_scalar(
+    tcb::span<const std::complex<float>> x0,
+    tcb::span<const std::complex<float>> x1
+);
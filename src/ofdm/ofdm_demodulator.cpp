@@ -7,17 +7,21 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
 #include <thread>
 #include <fftw3.h>
 #include "detect_architecture.h"
 #include "simd_flags.h" // NOLINT
 #include "utility/joint_allocate.h"
+#include "utility/latency_histogram.h"
 #include "utility/span.h"
+#include "utility/thread_placement.h"
 #include "viterbi_config.h"
 #include "./dsp/apply_pll.h"
 #include "./dsp/complex_conj_mul_sum.h"
 #include "./ofdm_demodulator_threads.h"
 #include "./ofdm_params.h"
+#include "./ofdm_symbol_demapper.h"
 
 #define PROFILE_ENABLE 1
 #include "./profiler.h"
@@ -48,29 +52,6 @@ constexpr float TWO_PI = float(M_PI) * 2.0f; // NOLINT
 // DOC: docs/DAB_implementation_in_SDR_detailed.pdf
 // NOTE: Unless specified otherwise all clauses referenced belong to the above documentation
 
-// Receive the real/imaginary component of our data carrier
-// Determine the bit value associated with it
-// Return the bit value as a soft decision bit 
-// - Hard decision bit: 0 or 1
-// - Soft decision bit: Between -A and A
-// We do this since our Viterbi decoder works with soft decision bits
-static inline 
-viterbi_bit_t convert_to_viterbi_bit(const float x) {
-    // Clause 3.4.2 - QPSK symbol mapper
-    // phi = (1-2*b0) + (1-2*b1)*1j
-    // x0 = 1-2*b0, x1 = 1-2*b1
-    // b = (1-x)/2
-
-    // NOTE: Phil Karn's viterbi decoder is configured so that b => b' : (0,1) => (-A,+A)
-    // Where b is the logical bit value, and b' is the value used for soft decision decoding
-    // b' = (2*b-1) * A 
-    // b' = (1-x-1)*A
-    // b' = -A*x
-    constexpr float scale = (float)(SOFT_DECISION_VITERBI_HIGH);
-    const float v = -x*scale;
-    return (viterbi_bit_t)(v);
-}
-
 template <typename ... T>
 static void ApplyPLL(T... args) {
     PROFILE_BEGIN_FUNC();
@@ -81,8 +62,10 @@ OFDM_Demod::OFDM_Demod(
     const OFDM_Params& params,
     const tcb::span<const std::complex<float>> prs_fft_ref, 
     const tcb::span<const int> carrier_mapper,
-    int nb_desired_threads)
+    int nb_desired_threads,
+    const Thread_Placement& placement)
 :   m_params(params), 
+    m_placement(placement),
     m_active_buffer(params, m_active_buffer_data, ALIGN_AMOUNT),
     m_inactive_buffer(params, m_inactive_buffer_data, ALIGN_AMOUNT),
     m_null_power_dip_buffer(m_null_power_dip_buffer_data),
@@ -109,6 +92,9 @@ OFDM_Demod::OFDM_Demod(
         m_pipeline_dqpsk_vec_buffer,      BufferParameters{ (m_params.nb_frame_symbols-1)*m_params.nb_fft, ALIGN_AMOUNT },
         m_pipeline_out_bits,              BufferParameters{ (m_params.nb_frame_symbols-1)*m_params.nb_data_carriers*2 }
     );
+    // NOTE: The joint block is first touched from inside our cpu set so its pages are local to the threads using it
+    m_is_joint_data_block_locked = false;
+    RunWithThreadPlacement(m_placement, [this]() { InitialiseJointDataBlock(); });
 
     m_fft_plan = fftwf_plan_dft_1d((int)m_params.nb_fft, nullptr, nullptr, FFTW_FORWARD, FFTW_ESTIMATE);
     m_ifft_plan = fftwf_plan_dft_1d((int)m_params.nb_fft, nullptr, nullptr, FFTW_BACKWARD, FFTW_ESTIMATE);
@@ -117,13 +103,23 @@ OFDM_Demod::OFDM_Demod(
     m_state = State::FINDING_NULL_POWER_DIP;
     m_total_frames_desync = 0;
     m_total_frames_read = 0;
+    m_total_samples_read = 0;
+    m_pending_frame_end_sample = 0;
+    m_frame_end_sample = 0;
     m_is_found_coarse_freq_offset = false;
     m_freq_coarse_offset = 0;
     m_freq_fine_offset = 0;
     m_fine_time_offset = 0;
+    m_is_tracking = false;
+    m_nb_frames_synced = 0;
+    m_nb_frames_since_coarse_sync = 0;
     m_is_null_start_found = false;
     m_is_null_end_found = false;
     m_signal_l1_average = 0;
+    m_is_wanted_symbols_changed = false;
+    m_pending_wanted_symbols.resize(m_params.nb_frame_symbols-1, 1);
+    m_is_symbol_wanted.resize(m_params.nb_frame_symbols-1, 1);
+    m_is_symbol_fft_required.resize(m_params.nb_frame_symbols+1, 1);
 
     // Clause 3.12.1 - Fine time synchronisation
     // Correlation in time domain is the conjugate product in frequency domain
@@ -141,13 +137,30 @@ OFDM_Demod::OFDM_Demod(
 
     // Clause 3.16.1 - Frequency deinterleaving
     std::copy_n(carrier_mapper.begin(), m_params.nb_data_carriers, m_carrier_mapper.begin());
+    m_symbol_demapper = GetOFDMSymbolDemapper(m_params, m_carrier_mapper);
 
     CreateThreads(nb_desired_threads);
 }
 
+void OFDM_Demod::InitialiseJointDataBlock() {
+    const auto block = tcb::span<uint8_t>(m_joint_data_block);
+    Thread_Placement_Report::Memory memory;
+    memory.name = "OFDM_Demod::JointDataBlock";
+    memory.nb_bytes = block.size();
+    // Huge pages are only used if advised before the pages are faulted in
+    if (m_placement.is_huge_pages) memory.is_huge_pages = AdviseHugePages(block);
+    std::fill(block.begin(), block.end(), uint8_t(0));
+    if (m_placement.is_lock_memory) memory.is_locked = LockMemory(block);
+    memory.numa_node = GetMemoryNUMANode(block.data());
+    m_is_joint_data_block_locked = memory.is_locked;
+    m_placement_report.AddMemory(std::move(memory));
+}
+
 void OFDM_Demod::CreateThreads(int nb_desired_threads) {
     const int nb_syms = (int)m_params.nb_frame_symbols+1;
-    const int total_system_threads = (int)std::thread::hardware_concurrency();
+    // NOTE: Restricting our threads to a cpu set means only those cpus are available to us
+    const int total_system_threads = m_placement.IsEnabled() ? 
+        (int)m_placement.cpus.size() : (int)std::thread::hardware_concurrency();
 
     int nb_threads = 0; 
     // Manually set number of threads
@@ -186,6 +199,8 @@ void OFDM_Demod::CreateThreads(int nb_desired_threads) {
     m_coordinator_thread = std::make_unique<std::thread>(
         [this]() {
             PROFILE_TAG_THREAD("OFDM_Demod::CoordinatorThread");
+            const bool is_pinned = ApplyThreadPlacement(m_placement, 0);
+            m_placement_report.AddThread(GetCurrentThreadPlacement("OFDM_Demod::Coordinator", is_pinned));
             while (CoordinatorThread());
         }
     );
@@ -202,9 +217,13 @@ void OFDM_Demod::CreateThreads(int nb_desired_threads) {
         }
 
         m_pipeline_threads.emplace_back(std::make_unique<std::thread>(
-            [this, &pipeline, dependent_pipeline]() {
+            [this, &pipeline, dependent_pipeline, i]() {
                 PROFILE_TAG_THREAD("OFDM_Demod::PipelineThread");
                 PROFILE_TAG_DATA_THREAD(std::optional(InstrumentorThread::Descriptor{pipeline.GetSymbolStart(), pipeline.GetSymbolEnd()}));
+                const bool is_pinned = ApplyThreadPlacement(m_placement, i+1);
+                m_placement_report.AddThread(GetCurrentThreadPlacement(
+                    "OFDM_Demod::Pipeline[" + std::to_string(i) + "]", is_pinned
+                ));
                 while (PipelineThread(pipeline, dependent_pipeline));
             }
         ));
@@ -223,6 +242,10 @@ OFDM_Demod::~OFDM_Demod() {
         pipeline_thread->join();
     }
 
+    if (m_is_joint_data_block_locked) {
+        UnlockMemory(m_joint_data_block);
+    }
+
     // fft/ifft buffers
     fftwf_destroy_plan(m_fft_plan);
     fftwf_destroy_plan(m_ifft_plan);
@@ -245,6 +268,7 @@ void OFDM_Demod::Process(tcb::span<const std::complex<float>> buf) {
     while (curr_index < N) {
         auto* block = &buf[curr_index];
         const size_t N_remain = N-curr_index;
+        const size_t prev_index = curr_index;
 
         switch (m_state) {
 
@@ -271,9 +295,17 @@ void OFDM_Demod::Process(tcb::span<const std::complex<float>> buf) {
             curr_index += ReadSymbols({block, N_remain});
             break;
         }
+        m_total_samples_read += uint64_t(curr_index-prev_index);
     }
 }
 
+void OFDM_Demod::Flush() {
+    PROFILE_BEGIN_FUNC();
+    m_coordinator->WaitEnd();
+    // Nothing is in flight so the next frame doesn't need to wait
+    m_coordinator->SignalEnd();
+}
+
 void OFDM_Demod::Reset() {
     PROFILE_BEGIN_FUNC();
     m_state = State::FINDING_NULL_POWER_DIP;
@@ -286,6 +318,51 @@ void OFDM_Demod::Reset() {
     m_freq_coarse_offset = 0;
     m_freq_fine_offset = 0;
     m_fine_time_offset = 0;
+
+    // Loss of lock so we fall back to full acquisition
+    m_is_tracking = false;
+    m_nb_frames_synced = 0;
+    m_nb_frames_since_coarse_sync = 0;
+}
+
+void OFDM_Demod::SetWantedSymbols(tcb::span<const int> symbols) {
+    auto lock = std::scoped_lock(m_mutex_wanted_symbols);
+    std::fill(m_pending_wanted_symbols.begin(), m_pending_wanted_symbols.end(), uint8_t(0));
+    const int N = int(m_pending_wanted_symbols.size());
+    for (const int i: symbols) {
+        if ((i < 0) || (i >= N)) continue;
+        m_pending_wanted_symbols[i] = 1;
+    }
+    m_is_wanted_symbols_changed = true;
+}
+
+void OFDM_Demod::SetAllSymbolsWanted() {
+    auto lock = std::scoped_lock(m_mutex_wanted_symbols);
+    std::fill(m_pending_wanted_symbols.begin(), m_pending_wanted_symbols.end(), uint8_t(1));
+    m_is_wanted_symbols_changed = true;
+}
+
+// NOTE: Called between frames when no pipeline threads are running
+void OFDM_Demod::UpdateWantedSymbols() {
+    auto lock = std::scoped_lock(m_mutex_wanted_symbols);
+    if (!m_is_wanted_symbols_changed) return;
+    m_is_wanted_symbols_changed = false;
+    std::copy(m_pending_wanted_symbols.begin(), m_pending_wanted_symbols.end(), m_is_symbol_wanted.begin());
+
+    // Clause 3.15 - Differential demodulator
+    // DQPSK output symbol i needs the FFT of symbols i and i+1 where symbol 0 is the PRS
+    bool is_all_wanted = true;
+    std::fill(m_is_symbol_fft_required.begin(), m_is_symbol_fft_required.end(), uint8_t(0));
+    for (size_t i = 0; i < m_is_symbol_wanted.size(); i++) {
+        if (!m_is_symbol_wanted[i]) {
+            is_all_wanted = false;
+            continue;
+        }
+        m_is_symbol_fft_required[i+0] = 1;
+        m_is_symbol_fft_required[i+1] = 1;
+    }
+    // The null symbol is only used for display so we skip it if anything was excluded
+    m_is_symbol_fft_required[m_params.nb_frame_symbols] = is_all_wanted ? 1 : 0;
 }
 
 size_t OFDM_Demod::FindNullPowerDip(tcb::span<const std::complex<float>> buf) {
@@ -366,6 +443,25 @@ size_t OFDM_Demod::RunCoarseFreqSync(tcb::span<const std::complex<float>> buf) {
         return 0;
     }
 
+    if (m_is_tracking && !m_cfg.sync.is_tracking_mode) {
+        m_is_tracking = false;
+    }
+
+    // Once locked the coarse frequency offset rarely changes
+    // Only rerun the correlation periodically or if the fine frequency offset drifts towards the edge of an fft bin
+    if (m_is_tracking) {
+        m_nb_frames_since_coarse_sync++;
+        const float fft_bin_spacing = 1.0f/float(m_params.nb_fft);
+        const float drift_threshold = m_cfg.sync.tracking_fine_freq_drift_threshold * fft_bin_spacing;
+        const bool is_drifting = std::abs(m_freq_fine_offset) > drift_threshold;
+        const bool is_scheduled = m_nb_frames_since_coarse_sync >= m_cfg.sync.tracking_coarse_freq_period;
+        if (!is_drifting && !is_scheduled) {
+            m_state = State::RUNNING_FINE_TIME_SYNC;
+            return 0;
+        }
+        m_nb_frames_since_coarse_sync = 0;
+    }
+
     auto corr_time_buf = tcb::span(m_correlation_time_buffer);
     auto prs_sym = corr_time_buf.subspan(m_params.nb_null_period, m_params.nb_symbol_period);
 
@@ -491,6 +587,39 @@ size_t OFDM_Demod::RunFineTimeSync(tcb::span<const std::complex<float>> buf) {
 
     // Get IFFT to get our correlation result
     CalculateIFFT(m_correlation_fft_buffer, m_correlation_ifft_buffer);
+
+    const int impulse_max_index = m_is_tracking ? FindImpulsePeakTracking() : FindImpulsePeakAcquisition();
+    // If the main lobe is insufficiently powerful we do not have a valid impulse response
+    // This probably means we had a severe desync and should restart
+    if (impulse_max_index < 0) {
+        Reset();
+        return 0;
+    }
+
+    // The PRS correlation lobe occurs just after the cyclic prefix
+    // We actually want the index at the start of the cyclic prefix, so we adjust offset for that
+    const int offset = impulse_max_index - (int)m_params.nb_cyclic_prefix;
+    const int prs_start_index = (int)m_params.nb_null_period + offset;
+    const int prs_length = (int)m_params.nb_symbol_period - offset;
+    auto prs_buf = corr_time_buf.subspan(prs_start_index, prs_length);
+    
+    m_inactive_buffer.Reset();
+    m_inactive_buffer.ConsumeBuffer(prs_buf);
+
+    m_correlation_time_buffer.SetLength(0);
+    m_fine_time_offset = offset;
+    m_state = State::READING_SYMBOLS;
+
+    m_nb_frames_synced++;
+    if (!m_is_tracking && m_cfg.sync.is_tracking_mode && (m_nb_frames_synced >= m_cfg.sync.nb_frames_to_track)) {
+        m_is_tracking = true;
+        m_nb_frames_since_coarse_sync = 0;
+    }
+    return 0;
+}
+
+int OFDM_Demod::FindImpulsePeakAcquisition() {
+    PROFILE_BEGIN_FUNC();
     for (size_t i = 0; i < m_params.nb_fft; i++) {
         const auto& v = m_correlation_ifft_buffer[i];
         const float A = 20.0f*std::log10(std::abs(v));
@@ -524,27 +653,47 @@ size_t OFDM_Demod::RunFineTimeSync(tcb::span<const std::complex<float>> buf) {
     }
     impulse_avg /= (float)m_params.nb_fft;
 
-    // If the main lobe is insufficiently powerful we do not have a valid impulse response
-    // This probably means we had a severe desync and should restart
     if ((impulse_max_value - impulse_avg) < m_cfg.sync.impulse_peak_threshold_db) {
-        Reset();
-        return 0;
+        return -1;
     }
+    return impulse_max_index;
+}
 
-    // The PRS correlation lobe occurs just after the cyclic prefix
-    // We actually want the index at the start of the cyclic prefix, so we adjust offset for that
-    const int offset = impulse_max_index - (int)m_params.nb_cyclic_prefix;
-    const int prs_start_index = (int)m_params.nb_null_period + offset;
-    const int prs_length = (int)m_params.nb_symbol_period - offset;
-    auto prs_buf = corr_time_buf.subspan(prs_start_index, prs_length);
-    
-    m_inactive_buffer.Reset();
-    m_inactive_buffer.ConsumeBuffer(prs_buf);
+int OFDM_Demod::FindImpulsePeakTracking() {
+    PROFILE_BEGIN_FUNC();
+    // When locked the impulse peak only drifts slightly due to sampling clock offset
+    // Therefore we avoid the log10 per bin and only search near the expected location
+    CalculatePower(m_correlation_ifft_buffer, m_correlation_impulse_response);
+    const int N = int(m_params.nb_fft);
+    float impulse_avg = 0.0f;
+    for (int i = 0; i < N; i++) {
+        impulse_avg += m_correlation_impulse_response[i];
+    }
+    impulse_avg /= float(N);
+
+    const int expected_peak_x = (int)m_params.nb_cyclic_prefix;
+    const int window = std::max(1, int(m_cfg.sync.tracking_impulse_window_norm * float(m_params.nb_cyclic_prefix)));
+    const int window_start = std::max(0, expected_peak_x-window);
+    const int window_end = std::min(N-1, expected_peak_x+window);
+    float impulse_max_value = m_correlation_impulse_response[window_start];
+    int impulse_max_index = window_start;
+    for (int i = window_start; i <= window_end; i++) {
+        const float peak_value = m_correlation_impulse_response[i];
+        if (peak_value > impulse_max_value) {
+            impulse_max_value = peak_value;
+            impulse_max_index = i;
+        }
+    }
 
-    m_correlation_time_buffer.SetLength(0);
-    m_fine_time_offset = offset;
-    m_state = State::READING_SYMBOLS;
-    return 0;
+    // Acquisition compares the peak against the mean of the dB response
+    // For a noise floor that is Rayleigh distributed this sits 2.51dB below the dB of the mean power
+    constexpr float RAYLEIGH_LOG_MEAN_OFFSET_DB = 2.51f;
+    const float threshold_db = m_cfg.sync.impulse_peak_threshold_db - RAYLEIGH_LOG_MEAN_OFFSET_DB;
+    const float threshold = std::pow(10.0f, threshold_db/10.0f);
+    if (impulse_max_value < impulse_avg*threshold) {
+        return -1;
+    }
+    return impulse_max_index;
 }
 
 size_t OFDM_Demod::ReadSymbols(tcb::span<const std::complex<float>> buf) {
@@ -561,9 +710,17 @@ size_t OFDM_Demod::ReadSymbols(tcb::span<const std::complex<float>> buf) {
         m_correlation_time_buffer[i] = null_sym[i];
     }
 
+    // Time spent waiting for the previous frame to finish counts towards this frame's latency
+    const int64_t frame_timestamp = GetLatencyTimestamp();
     PROFILE_BEGIN(coordinator_wait);
     m_coordinator->WaitEnd();
     PROFILE_END(coordinator_wait);
+    UpdateWantedSymbols();
+    m_pending_frame_end_sample = m_total_samples_read + uint64_t(nb_read);
+    const uint64_t nb_frame_samples = uint64_t(m_params.nb_null_period + m_params.nb_frame_symbols*m_params.nb_symbol_period);
+    m_pending_frame_trace.sample_index = 
+        (m_pending_frame_end_sample > nb_frame_samples) ? (m_pending_frame_end_sample - nb_frame_samples) : 0;
+    m_pending_frame_trace.timestamp_ns = frame_timestamp;
     // double buffer
     std::swap(m_inactive_buffer_data, m_active_buffer_data);
     m_inactive_buffer.Reset();
@@ -588,6 +745,9 @@ bool OFDM_Demod::CoordinatorThread() {
     if (m_coordinator->IsStopped()) {
         return false;
     }
+    // NOTE: The reader thread can overwrite this once we signal the end of the frame
+    const uint64_t frame_end_sample = m_pending_frame_end_sample;
+    Frame_Trace frame_trace = m_pending_frame_trace;
 
     PROFILE_BEGIN(pipeline_workers);
     {
@@ -606,11 +766,13 @@ bool OFDM_Demod::CoordinatorThread() {
         // Clause 3.13.1 - Fraction frequency offset estimation
         PROFILE_BEGIN(calculate_phase_error);
         float average_cyclic_error = 0;
+        size_t nb_phase_error_symbols = 0;
         for (const auto& pipeline: m_pipelines) {
             const float cyclic_error = pipeline->GetAveragePhaseError();
             average_cyclic_error += cyclic_error;
+            nb_phase_error_symbols += pipeline->GetTotalPhaseErrorSymbols();
         }
-        average_cyclic_error /= float(m_params.nb_frame_symbols);
+        average_cyclic_error /= float(std::max(nb_phase_error_symbols, size_t(1)));
         // Calculate adjustments to fine frequency offset 
         const float fine_freq_error = CalculateFineFrequencyError(average_cyclic_error);
         const float beta = m_cfg.sync.fine_freq_update_beta;
@@ -630,6 +792,10 @@ bool OFDM_Demod::CoordinatorThread() {
     }
     PROFILE_END(pipeline_workers);
     m_total_frames_read++;
+    m_frame_end_sample = frame_end_sample;
+    frame_trace.frame_index = uint64_t(m_total_frames_read);
+    m_frame_trace = frame_trace;
+    m_frame_latency.RecordSince(m_frame_trace);
 
     PROFILE_BEGIN(obs_on_ofdm_frame);
     m_obs_on_ofdm_frame.Notify(m_pipeline_out_bits);
@@ -671,6 +837,7 @@ bool OFDM_Demod::PipelineThread(OFDM_Demod_Pipeline& thread_data, OFDM_Demod_Pip
     //       can be changed in the reader thread due to coarse frequency correction
     const float frequency_offset = m_freq_coarse_offset + m_freq_fine_offset;
     for (int i = symbol_start; i < symbol_end; i++) {
+        if (!m_is_symbol_fft_required[i]) continue;
         auto sym_buf = m_active_buffer.GetDataSymbol(i);
         const int sample_offset = i*(int)m_params.nb_symbol_period;
         const float dt_start = float(sample_offset) * frequency_offset;
@@ -683,12 +850,16 @@ bool OFDM_Demod::PipelineThread(OFDM_Demod_Pipeline& thread_data, OFDM_Demod_Pip
     // Get phase error using cyclic prefix (ignore null symbol)
     PROFILE_BEGIN(calculate_phase_error);
     float total_phase_error = 0.0f;
+    size_t nb_phase_error_symbols = 0;
     for (int i = symbol_start; i < symbol_end_no_null; i++) {
+        if (!m_is_symbol_fft_required[i]) continue;
         auto sym_buf = m_active_buffer.GetDataSymbol(i);
         const float cyclic_error = CalculateCyclicPhaseError(sym_buf);
         total_phase_error += cyclic_error;
+        nb_phase_error_symbols++;
     }
     thread_data.SetAveragePhaseError(total_phase_error);
+    thread_data.SetTotalPhaseErrorSymbols(nb_phase_error_symbols);
     PROFILE_END(calculate_phase_error);
 
     // Signal to the coordinator thread our phase error
@@ -700,6 +871,7 @@ bool OFDM_Demod::PipelineThread(OFDM_Demod_Pipeline& thread_data, OFDM_Demod_Pip
     // Calculate fft (include null symbol)
     const auto calculate_fft = [this](int start, int end) {
         for (int i = start; i < end; i++) {
+            if (!m_is_symbol_fft_required[i]) continue;
             auto sym_buf = m_active_buffer.GetDataSymbol(i);
             // Clause 3.14.1 - Cyclic prefix removal
             auto data_buf = sym_buf.subspan(m_params.nb_cyclic_prefix, m_params.nb_fft);
@@ -729,12 +901,15 @@ bool OFDM_Demod::PipelineThread(OFDM_Demod_Pipeline& thread_data, OFDM_Demod_Pip
         const size_t nb_viterbi_bits = m_params.nb_data_carriers*2;
         for (int i = start; i < end; i++) {
             PROFILE_BEGIN(calculate_dqpsk_symbol);
+            auto viterbi_bit_buf = m_pipeline_out_bits.subspan(i*nb_viterbi_bits, nb_viterbi_bits);
+            if (!m_is_symbol_wanted[i]) {
+                std::fill(viterbi_bit_buf.begin(), viterbi_bit_buf.end(), viterbi_bit_t(0));
+                continue;
+            }
             auto fft_buf_0 = m_pipeline_fft_buffer.subspan((i+0)*m_params.nb_fft, m_params.nb_fft);
             auto fft_buf_1 = m_pipeline_fft_buffer.subspan((i+1)*m_params.nb_fft, m_params.nb_fft);
             auto dqpsk_vec_buf = m_pipeline_dqpsk_vec_buffer.subspan(i*m_params.nb_data_carriers, m_params.nb_data_carriers);
-            auto viterbi_bit_buf = m_pipeline_out_bits.subspan(i*nb_viterbi_bits, nb_viterbi_bits);
-            CalculateDQPSK(fft_buf_1, fft_buf_0, dqpsk_vec_buf);
-            CalculateViterbiBits(dqpsk_vec_buf, viterbi_bit_buf);
+            CalculateViterbiBits(fft_buf_1, fft_buf_0, dqpsk_vec_buf, viterbi_bit_buf);
         }
     };
 
@@ -839,53 +1014,15 @@ void OFDM_Demod::UpdateFineFrequencyOffset(const float delta) {
     m_freq_fine_offset = std::fmod(m_freq_fine_offset, fft_bin_wrap);
 }
 
-void OFDM_Demod::CalculateDQPSK(
-    tcb::span<const std::complex<float>> in0, 
-    tcb::span<const std::complex<float>> in1, 
-    tcb::span<std::complex<float>> out_vec)
+void OFDM_Demod::CalculateViterbiBits(
+    tcb::span<const std::complex<float>> in0, tcb::span<const std::complex<float>> in1, 
+    tcb::span<std::complex<float>> vec_out, tcb::span<viterbi_bit_t> bit_out)
 {
     PROFILE_BEGIN_FUNC();
-    const int M = (int)m_params.nb_data_carriers/2;
-    const int N_fft = (int)m_params.nb_fft;
-
     // Clause 3.14.3 - Zero padding removal
-    // We store the subcarriers that carry information
-    for (int i = -M, subcarrier_index = 0; i <= M; i++) {
-        // The DC bin carries no information
-        if (i == 0) {
-            continue;
-        }
-        const int fft_index = (N_fft+i) % N_fft;
-
-        // arg(z1*~z0) = arg(z1)+arg(~z0) = arg(z1)-arg(z0)
-        const auto phase_delta_vec = in1[fft_index] * std::conj(in0[fft_index]);
-        out_vec[subcarrier_index] = phase_delta_vec;
-        subcarrier_index++;
-    }
-}
-
-void OFDM_Demod::CalculateViterbiBits(tcb::span<const std::complex<float>> vec_buf, tcb::span<viterbi_bit_t> bit_buf) {
-    PROFILE_BEGIN_FUNC();
-    const size_t N = m_params.nb_data_carriers;
-
+    // Clause 3.15 - Differential demodulator
     // Clause 3.16 - Data demapper
-    for (size_t i = 0; i < N; i++) {
-        // Clause 3.16.1 - Freuency deinterleaving
-        const size_t j = m_carrier_mapper[i];
-        const auto& vec = vec_buf[j];
-
-        // const float A = std::abs(vec);
-        // NOTE: Use the L1 norm since it doesn't truncate like L2 norm
-        //       I.e. When real=imag, then we expect b0=A, b1=A
-        //            But with L2 norm, we get b0=0.707*A, b1=0.707*A
-        //                with L1 norm, we get b0=A, b1=A as expected
-        const float A = std::max(std::abs(vec.real()), std::abs(vec.imag()));
-        const auto norm_vec = vec / A;
-
-        // Clause 3.16.2 - QPSK symbol demapper
-        bit_buf[i]   = convert_to_viterbi_bit(+norm_vec.real());
-        bit_buf[i+N] = convert_to_viterbi_bit(-norm_vec.imag());
-    }
+    m_symbol_demapper(in0, in1, m_carrier_mapper, vec_out, bit_out, m_params);
 }
 
 void OFDM_Demod::CalculateFFT(tcb::span<const std::complex<float>> fft_in, tcb::span<std::complex<float>> fft_out) {
@@ -919,6 +1056,15 @@ void OFDM_Demod::CalculateMagnitude(tcb::span<const std::complex<float>> fft_buf
     }
 }
 
+void OFDM_Demod::CalculatePower(tcb::span<const std::complex<float>> buf, tcb::span<float> power_buf) {
+    PROFILE_BEGIN_FUNC();
+    const size_t N = buf.size();
+    for (size_t i = 0; i < N; i++) {
+        const auto& v = buf[i];
+        power_buf[i] = v.real()*v.real() + v.imag()*v.imag();
+    }
+}
+
 float OFDM_Demod::CalculateL1Average(tcb::span<const std::complex<float>> block) {
     PROFILE_BEGIN_FUNC();
     const size_t N = block.size();
@@ -8,12 +8,15 @@
 #include <thread>
 #include <vector>
 #include "utility/aligned_allocator.hpp"
+#include "utility/latency_histogram.h"
 #include "utility/observable.h"
 #include "utility/span.h"
+#include "utility/thread_placement.h"
 #include "viterbi_config.h"
 #include "./circular_buffer.h"
 #include "./ofdm_frame_buffer.h"
 #include "./ofdm_params.h"
+#include "./ofdm_symbol_demapper.h"
 #include "./reconstruction_buffer.h"
 
 struct fftwf_plan_s;
@@ -41,6 +44,12 @@ struct OFDM_Demod_Config {
         // fine time sync
         float impulse_peak_threshold_db = 20.0f;
         float impulse_peak_distance_probability = 0.15f;
+        // tracking once locked
+        bool is_tracking_mode = true;
+        int nb_frames_to_track = 5;                      // consecutive synced frames before tracking
+        int tracking_coarse_freq_period = 20;            // frames between coarse freq sync when tracking
+        float tracking_fine_freq_drift_threshold = 0.4f; // normalised to fft bin spacing
+        float tracking_impulse_window_norm = 0.5f;       // normalised to cyclic prefix length
     } sync;
 };
 
@@ -61,16 +70,34 @@ private:
     // statistics
     int m_total_frames_read;
     int m_total_frames_desync;
+    uint64_t m_total_samples_read;
+    // sample index after the last symbol of a frame which is passed from the reader to the coordinator thread
+    uint64_t m_pending_frame_end_sample;
+    uint64_t m_frame_end_sample;
+    Frame_Trace m_pending_frame_trace;
+    Frame_Trace m_frame_trace;
+    // time from the last sample of a frame being read to its soft bits being ready
+    Latency_Histogram m_frame_latency;
     // time and frequency correction
     std::mutex m_mutex_freq_fine_offset;
     bool m_is_found_coarse_freq_offset;
     float m_freq_coarse_offset;
     float m_freq_fine_offset;
     int m_fine_time_offset;
+    // tracking after lock
+    bool m_is_tracking;
+    int m_nb_frames_synced;
+    int m_nb_frames_since_coarse_sync;
     // null power dip search
     bool m_is_null_start_found;
     bool m_is_null_end_found;
     float m_signal_l1_average;
+    // symbol selection so we only demodulate symbols that contain wanted data
+    std::mutex m_mutex_wanted_symbols;
+    bool m_is_wanted_symbols_changed;
+    std::vector<uint8_t> m_pending_wanted_symbols;
+    std::vector<uint8_t> m_is_symbol_wanted;        // DQPSK output symbols
+    std::vector<uint8_t> m_is_symbol_fft_required;  // PRS, data and null symbols
     // fft
     fftwf_plan_s* m_fft_plan;
     fftwf_plan_s* m_ifft_plan;
@@ -79,6 +106,10 @@ private:
     std::vector<std::unique_ptr<OFDM_Demod_Pipeline>> m_pipelines;
     std::unique_ptr<std::thread> m_coordinator_thread;
     std::vector<std::unique_ptr<std::thread>> m_pipeline_threads;
+    // cpus our threads run on and where our buffers are placed
+    const Thread_Placement m_placement;
+    Thread_Placement_Report m_placement_report;
+    bool m_is_joint_data_block_locked;
     // callback for when ofdm is completed
     Observable<tcb::span<const viterbi_bit_t>> m_obs_on_ofdm_frame;
     // Joint memory allocation block
@@ -105,12 +136,15 @@ private:
     tcb::span<viterbi_bit_t>          m_pipeline_out_bits;
     // 4. carrier frequency deinterleaving
     tcb::span<int> m_carrier_mapper;
+    // 5. specialised for the transmission mode if possible
+    OFDM_Symbol_Demapper m_symbol_demapper;
 public:
     OFDM_Demod(
         const OFDM_Params& params, 
         const tcb::span<const std::complex<float>> prs_fft_ref, 
         const tcb::span<const int> carrier_mapper,
-        int nb_desired_threads=0);
+        int nb_desired_threads=0,
+        const Thread_Placement& placement=Thread_Placement());
     ~OFDM_Demod();
     // threads use lambdas which take in the this pointer
     // therefore we disable move/copy semantics to preservce its memory location
@@ -120,6 +154,13 @@ public:
     OFDM_Demod& operator=(OFDM_Demod&&) = delete;
     void Process(tcb::span<const std::complex<float>> block);
     void Reset();
+    // Blocks until the frame being demodulated is finished so it is delivered before the demodulator is destroyed
+    void Flush();
+    // Only demodulate the symbols that are wanted and output soft bits of zero (erasures) for the rest
+    // Indices are for the DQPSK output symbols, i.e. 0 is the first symbol after the PRS
+    // NOTE: This is applied at the start of the next frame so it is safe to call from another thread
+    void SetWantedSymbols(tcb::span<const int> symbols);
+    void SetAllSymbolsWanted();
 public:
     OFDM_Params GetOFDMParams() const { return m_params; }
     State GetState() const { return m_state; }
@@ -130,22 +171,38 @@ public:
     float GetCoarseFrequencyOffset() const { return m_freq_coarse_offset; }
     float GetNetFrequencyOffset() const { return m_freq_fine_offset + m_freq_coarse_offset; }
     int GetFineTimeOffset() const { return m_fine_time_offset; }
+    bool GetIsTracking() const { return m_is_tracking; }
     int GetTotalFramesRead() const { return m_total_frames_read; }
     int GetTotalFramesDesync() const { return m_total_frames_desync; }
+    uint64_t GetTotalSamplesRead() const { return m_total_samples_read; }
+    // Index of the input sample after the end of the frame passed to On_OFDM_Frame
+    uint64_t GetFrameEndSample() const { return m_frame_end_sample; }
+    // Identifies the frame passed to On_OFDM_Frame so downstream stages can measure their latency
+    const auto& GetFrameTrace() const { return m_frame_trace; }
+    auto& GetFrameLatency() { return m_frame_latency; }
+    const auto& GetFrameLatency() const { return m_frame_latency; }
+    tcb::span<const uint8_t> GetIsSymbolWanted() const { return m_is_symbol_wanted; }
     tcb::span<const std::complex<float>> GetFrameFFT() const { return m_pipeline_fft_buffer; }
     tcb::span<const std::complex<float>> GetFrameDataVec() const { return m_pipeline_dqpsk_vec_buffer; }
     tcb::span<const viterbi_bit_t> GetFrameDataBits() const { return m_pipeline_out_bits; }
+    // NOTE: Impulse response is in dB during acquisition and linear power when tracking
     tcb::span<const float> GetImpulseResponse() const { return m_correlation_impulse_response; }
     tcb::span<const float> GetCoarseFrequencyResponse() const { return m_correlation_frequency_response; }
     tcb::span<const std::complex<float>> GetCorrelationTimeBuffer() const { return m_correlation_time_buffer; }
+    const auto& GetThreadPlacement() const { return m_placement; }
+    const auto& GetPlacementReport() const { return m_placement_report; }
     auto& On_OFDM_Frame() { return m_obs_on_ofdm_frame; }
 private:
     size_t FindNullPowerDip(tcb::span<const std::complex<float>> buf);
     size_t ReadNullPRS(tcb::span<const std::complex<float>> buf);
     size_t RunCoarseFreqSync(tcb::span<const std::complex<float>> buf);
     size_t RunFineTimeSync(tcb::span<const std::complex<float>> buf);
+    int FindImpulsePeakAcquisition();
+    int FindImpulsePeakTracking();
     size_t ReadSymbols(tcb::span<const std::complex<float>> buf);
+    void UpdateWantedSymbols();
 private:
+    void InitialiseJointDataBlock();
     void CreateThreads(int nb_desired_threads);
     bool CoordinatorThread();
     bool PipelineThread(OFDM_Demod_Pipeline& thread_data, OFDM_Demod_Pipeline* dependent_thread_data);
@@ -153,14 +210,14 @@ private:
     float CalculateTimeOffset(const size_t i, const float freq_offset);
     float CalculateCyclicPhaseError(tcb::span<const std::complex<float>> sym);
     float CalculateFineFrequencyError(const float cyclic_phase_error);
-    void CalculateDQPSK(
+    void CalculateViterbiBits(
         tcb::span<const std::complex<float>> in0, tcb::span<const std::complex<float>> in1, 
-        tcb::span<std::complex<float>> out_vec);
-    void CalculateViterbiBits(tcb::span<const std::complex<float>> vec_buf, tcb::span<viterbi_bit_t> bit_buf);
+        tcb::span<std::complex<float>> vec_out, tcb::span<viterbi_bit_t> bit_out);
     void CalculateFFT(tcb::span<const std::complex<float>> fft_in, tcb::span<std::complex<float>> fft_out);
     void CalculateIFFT(tcb::span<const std::complex<float>> fft_in, tcb::span<std::complex<float>> fft_out);
     void CalculateRelativePhase(tcb::span<const std::complex<float>> fft_in, tcb::span<std::complex<float>> arg_out);
     void CalculateMagnitude(tcb::span<const std::complex<float>> fft_buf, tcb::span<float> mag_buf);
+    void CalculatePower(tcb::span<const std::complex<float>> buf, tcb::span<float> power_buf);
     float CalculateL1Average(tcb::span<const std::complex<float>> block);
     void UpdateSignalAverage(tcb::span<const std::complex<float>> block);
     void UpdateFineFrequencyOffset(const float delta);
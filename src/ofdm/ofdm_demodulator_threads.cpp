@@ -15,6 +15,7 @@ OFDM_Demod_Pipeline::OFDM_Demod_Pipeline(const size_t start, const size_t end)
     m_is_end = false;
     m_is_terminated = false;
     m_average_phase_error = 0.0f;
+    m_nb_phase_error_symbols = 0;
 }
 
 OFDM_Demod_Pipeline::~OFDM_Demod_Pipeline() {
@@ -13,6 +13,7 @@ private:
     const size_t m_symbol_start;
     const size_t m_symbol_end;
     float m_average_phase_error;
+    size_t m_nb_phase_error_symbols;
 
     bool m_is_start;
     std::mutex m_mutex_start;
@@ -43,6 +44,9 @@ public:
     size_t GetSymbolEnd() const { return m_symbol_end; }
     float GetAveragePhaseError() const { return m_average_phase_error; }
     void SetAveragePhaseError(const float error) { m_average_phase_error = error; }
+    // Symbols that aren't demodulated don't contribute to the phase error
+    size_t GetTotalPhaseErrorSymbols() const { return m_nb_phase_error_symbols; }
+    void SetTotalPhaseErrorSymbols(const size_t N) { m_nb_phase_error_symbols = N; }
     void Stop();
     bool IsStopped() const { return m_is_terminated; }
     // Called from coordinator thread
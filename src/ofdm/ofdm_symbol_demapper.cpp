@@ -0,0 +1,160 @@
+#include "./ofdm_symbol_demapper.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include "utility/span.h"
+#include "viterbi_config.h"
+#include "./ofdm_params.h"
+
+// DOC: docs/DAB_implementation_in_SDR_detailed.pdf
+// NOTE: Unless specified otherwise all clauses referenced belong to the above documentation
+
+// Receive the real/imaginary component of our data carrier
+// Determine the bit value associated with it
+// Return the bit value as a soft decision bit 
+// - Hard decision bit: 0 or 1
+// - Soft decision bit: Between -A and A
+// We do this since our Viterbi decoder works with soft decision bits
+static inline 
+viterbi_bit_t convert_to_viterbi_bit(const float x) {
+    // Clause 3.4.2 - QPSK symbol mapper
+    // phi = (1-2*b0) + (1-2*b1)*1j
+    // x0 = 1-2*b0, x1 = 1-2*b1
+    // b = (1-x)/2
+
+    // NOTE: Phil Karn's viterbi decoder is configured so that b => b' : (0,1) => (-A,+A)
+    // Where b is the logical bit value, and b' is the value used for soft decision decoding
+    // b' = (2*b-1) * A 
+    // b' = (1-x-1)*A
+    // b' = -A*x
+    constexpr float scale = (float)(SOFT_DECISION_VITERBI_HIGH);
+    const float v = -x*scale;
+    return (viterbi_bit_t)(v);
+}
+
+// Clause 3.15 - Differential demodulator
+// arg(z1*~z0) = arg(z1)+arg(~z0) = arg(z1)-arg(z0)
+// NOTE: We expand the product so the compiler doesn't emit the slow path for infinite/nan std::complex multiplies
+static inline
+void calculate_dqpsk(
+    const std::complex<float>* x0, const std::complex<float>* x1, std::complex<float>* y, 
+    const size_t N
+) {
+    for (size_t i = 0; i < N; i++) {
+        const float re = x1[i].real()*x0[i].real() + x1[i].imag()*x0[i].imag();
+        const float im = x1[i].imag()*x0[i].real() - x1[i].real()*x0[i].imag();
+        y[i] = { re, im };
+    }
+}
+
+template <typename T>
+static inline
+void demap_symbol(
+    const std::complex<float>* in0, const std::complex<float>* in1, const T* carrier_mapper,
+    std::complex<float>* vec_out, viterbi_bit_t* bits_out,
+    const size_t nb_fft, const size_t nb_data_carriers
+) {
+    const size_t M = nb_data_carriers/2;
+
+    // Clause 3.14.3 - Zero padding removal
+    // We store the subcarriers that carry information
+    // -F <= f < 0 are at the end of the fft and 0 < f <= F come after the DC bin which carries no information
+    calculate_dqpsk(&in0[nb_fft-M], &in1[nb_fft-M], &vec_out[0], M);
+    calculate_dqpsk(&in0[1],        &in1[1],        &vec_out[M], M);
+
+    // Clause 3.16 - Data demapper
+    for (size_t i = 0; i < nb_data_carriers; i++) {
+        // Clause 3.16.1 - Freuency deinterleaving
+        const size_t j = size_t(carrier_mapper[i]);
+        const auto& vec = vec_out[j];
+
+        // NOTE: Use the L1 norm since it doesn't truncate like L2 norm
+        //       I.e. When real=imag, then we expect b0=A, b1=A
+        //            But with L2 norm, we get b0=0.707*A, b1=0.707*A
+        //                with L1 norm, we get b0=A, b1=A as expected
+        const float A = std::max(std::abs(vec.real()), std::abs(vec.imag()));
+
+        // Clause 3.16.2 - QPSK symbol demapper
+        bits_out[i]                  = convert_to_viterbi_bit(+vec.real()/A);
+        bits_out[i+nb_data_carriers] = convert_to_viterbi_bit(-vec.imag()/A);
+    }
+}
+
+static void demap_symbol_generic(
+    tcb::span<const std::complex<float>> in0,
+    tcb::span<const std::complex<float>> in1,
+    tcb::span<const int> carrier_mapper,
+    tcb::span<std::complex<float>> vec_out,
+    tcb::span<viterbi_bit_t> bits_out,
+    const OFDM_Params& params
+) {
+    demap_symbol(
+        in0.data(), in1.data(), carrier_mapper.data(), vec_out.data(), bits_out.data(),
+        params.nb_fft, params.nb_data_carriers
+    );
+}
+
+// DOC: ETSI EN 300 401
+// Clause 14.6.1 - Frequency interleaving
+// Same construction as get_DAB_mapper_ref() but evaluated at compile time
+template <size_t NB_FFT, size_t NB_DATA_CARRIERS>
+static constexpr std::array<uint16_t, NB_DATA_CARRIERS> generate_carrier_mapper() {
+    constexpr size_t N = NB_FFT;
+    constexpr size_t K = N/4;
+    constexpr size_t DC_index = N/2;
+    constexpr size_t start_index = DC_index - NB_DATA_CARRIERS/2;
+    constexpr size_t end_index = DC_index + NB_DATA_CARRIERS/2;
+
+    std::array<uint16_t, NB_DATA_CARRIERS> carrier_map{};
+    size_t carrier_map_index = 0;
+    size_t v = 0;
+    for (size_t i = 0; i < N; i++) {
+        if (i > 0) v = (13*v + K-1) % N;
+        if ((v < start_index) || (v > end_index) || (v == DC_index)) {
+            continue;
+        }
+        carrier_map[carrier_map_index++] = uint16_t((v < DC_index) ? (v-start_index) : (v-start_index-1));
+    }
+    return carrier_map;
+}
+
+template <size_t NB_FFT, size_t NB_DATA_CARRIERS>
+static constexpr auto CARRIER_MAPPER = generate_carrier_mapper<NB_FFT, NB_DATA_CARRIERS>();
+
+template <size_t NB_FFT, size_t NB_DATA_CARRIERS>
+static void demap_symbol_static(
+    tcb::span<const std::complex<float>> in0,
+    tcb::span<const std::complex<float>> in1,
+    tcb::span<const int> /*carrier_mapper*/,
+    tcb::span<std::complex<float>> vec_out,
+    tcb::span<viterbi_bit_t> bits_out,
+    const OFDM_Params& /*params*/
+) {
+    demap_symbol(
+        in0.data(), in1.data(), CARRIER_MAPPER<NB_FFT, NB_DATA_CARRIERS>.data(), vec_out.data(), bits_out.data(),
+        NB_FFT, NB_DATA_CARRIERS
+    );
+}
+
+template <size_t NB_FFT, size_t NB_DATA_CARRIERS>
+static bool is_static_demapper_valid(const OFDM_Params& params, tcb::span<const int> carrier_mapper) {
+    if (params.nb_fft != NB_FFT) return false;
+    if (params.nb_data_carriers != NB_DATA_CARRIERS) return false;
+    if (carrier_mapper.size() < NB_DATA_CARRIERS) return false;
+    const auto& ref = CARRIER_MAPPER<NB_FFT, NB_DATA_CARRIERS>;
+    return std::equal(ref.begin(), ref.end(), carrier_mapper.begin(), [](uint16_t a, int b) { return int(a) == b; });
+}
+
+OFDM_Symbol_Demapper GetOFDMSymbolDemapper(const OFDM_Params& params, tcb::span<const int> carrier_mapper) {
+    // DOC: doc/DAB_parameters.pdf
+    // Clause A1.1 - System parameters
+    // Transmission modes I, II, III and IV
+    if (is_static_demapper_valid<2048,1536>(params, carrier_mapper)) return &demap_symbol_static<2048,1536>;
+    if (is_static_demapper_valid<512,384>(params, carrier_mapper))   return &demap_symbol_static<512,384>;
+    if (is_static_demapper_valid<256,192>(params, carrier_mapper))   return &demap_symbol_static<256,192>;
+    if (is_static_demapper_valid<1024,768>(params, carrier_mapper))  return &demap_symbol_static<1024,768>;
+    return &demap_symbol_generic;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+#include <complex>
+#include "utility/span.h"
+#include "viterbi_config.h"
+#include "./ofdm_params.h"
+
+// Converts the FFT of two consecutive OFDM symbols into soft decision bits using the phase of in1*conj(in0)
+// in0[nb_fft], in1[nb_fft], vec_out[nb_data_carriers], bits_out[2*nb_data_carriers]
+using OFDM_Symbol_Demapper = void (*)(
+    tcb::span<const std::complex<float>> in0,
+    tcb::span<const std::complex<float>> in1,
+    tcb::span<const int> carrier_mapper,
+    tcb::span<std::complex<float>> vec_out,
+    tcb::span<viterbi_bit_t> bits_out,
+    const OFDM_Params& params
+);
+
+// Returns a demapper that is specialised at compile time if the parameters and carrier mapper match a DAB transmission mode
+// This gives the compiler known trip counts and a constexpr frequency deinterleaving table
+// Otherwise returns a generic demapper which uses the runtime parameters
+OFDM_Symbol_Demapper GetOFDMSymbolDemapper(const OFDM_Params& params, tcb::span<const int> carrier_mapper);
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <new>
 #include <type_traits>
+#include <utility>
 
 // C++17 aligned allocator
 // Sources: https://en.cppreference.com/w/cpp/named_req/Allocator
@@ -34,6 +35,16 @@ public:
         assert(reinterpret_cast<uintptr_t>(ptr) % m_alignment == 0);
         operator delete(ptr, std::align_val_t(m_alignment));
     }
+    // Elements are default initialised so allocating doesn't touch the memory
+    // This lets the owner pick which thread first touches the pages and therefore which NUMA node they live on
+    template <typename U>
+    void construct(U* ptr) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new(static_cast<void*>(ptr)) U;
+    }
+    template <typename U, typename ... Args>
+    void construct(U* ptr, Args&& ... args) {
+        ::new(static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+    }
     bool operator==(const AlignedAllocator& other) const noexcept {
         return m_alignment == other.m_alignment;
     }
@@ -46,6 +46,7 @@ static std::vector<uint8_t, AlignedAllocator<uint8_t>> AllocateJoint(size_t curr
 }
 
 // Recursive template for creating a jointly allocated block 
+// NOTE: The block is left uninitialised so the caller decides which thread first touches it
 template <typename T, typename ... Ts>
 static std::vector<uint8_t, AlignedAllocator<uint8_t>> AllocateJoint(tcb::span<T>& buf, BufferParameters params, Ts&& ... args) {
     return AllocateJoint(0, 1, buf, params, args...);
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+
+// Monotonic clock shared by every stage so latencies can be compared across threads
+inline int64_t GetLatencyTimestamp() {
+    return int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count());
+}
+
+// Identifies the OFDM frame that decoded data originated from
+struct Frame_Trace {
+    uint64_t frame_index = 0;       // total frames read by the demodulator
+    uint64_t sample_index = 0;      // input sample at the start of the null symbol
+    int64_t timestamp_ns = 0;       // time when the last sample of the frame was read
+    bool IsValid() const { return timestamp_ns != 0; }
+    int64_t GetElapsed(const int64_t now_ns) const { return now_ns - timestamp_ns; }
+};
+
+// Lock free histogram of latencies with power of 2 buckets in microseconds
+// - Bucket 0 holds [0,2)us and bucket i holds [2^i,2^(i+1))us
+// - Recording is wait free so it can be called from decoder threads while a reader takes snapshots
+// - Counts are relaxed so a snapshot taken while recording can be off by the samples in flight
+class Latency_Histogram
+{
+public:
+    static constexpr size_t TOTAL_BUCKETS = 32;
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t total_us = 0;
+        uint64_t max_us = 0;
+        uint64_t last_us = 0;
+        std::array<uint64_t, TOTAL_BUCKETS> buckets {0};
+        float GetMean() const { return (count > 0) ? float(total_us)/float(count) : 0.0f; }
+        // Linearly interpolates within the bucket that holds the percentile
+        float GetPercentile(const float percentile) const {
+            if (count == 0) return 0.0f;
+            const float target = percentile*float(count);
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < TOTAL_BUCKETS; i++) {
+                const uint64_t nb_bucket = buckets[i];
+                if (nb_bucket == 0) continue;
+                if (float(cumulative + nb_bucket) >= target) {
+                    const float lower = (i == 0) ? 0.0f : float(GetBucketLowerBound(i));
+                    const float upper = float(GetBucketLowerBound(i+1));
+                    const float fraction = (target - float(cumulative)) / float(nb_bucket);
+                    const float value = lower + (upper-lower)*fraction;
+                    return (value < float(max_us)) ? value : float(max_us);
+                }
+                cumulative += nb_bucket;
+            }
+            return float(max_us);
+        }
+    };
+private:
+    std::array<std::atomic<uint64_t>, TOTAL_BUCKETS> m_buckets;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_total_us;
+    std::atomic<uint64_t> m_max_us;
+    std::atomic<uint64_t> m_last_us;
+public:
+    Latency_Histogram() { Reset(); }
+    Latency_Histogram(const Latency_Histogram&) = delete;
+    Latency_Histogram& operator=(const Latency_Histogram&) = delete;
+
+    static constexpr uint64_t GetBucketLowerBound(const size_t index) {
+        return (index == 0) ? 0 : (uint64_t(1) << index);
+    }
+
+    static size_t GetBucketIndex(const uint64_t value_us) {
+        size_t index = 0;
+        uint64_t x = value_us >> 1;
+        while ((x != 0) && (index < TOTAL_BUCKETS-1)) {
+            x >>= 1;
+            index++;
+        }
+        return index;
+    }
+
+    void Record(const int64_t latency_ns) {
+        // Clocks can only go backwards if the timestamp came from another host
+        const uint64_t value_us = (latency_ns > 0) ? uint64_t(latency_ns/1000) : 0;
+        m_buckets[GetBucketIndex(value_us)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_total_us.fetch_add(value_us, std::memory_order_relaxed);
+        m_last_us.store(value_us, std::memory_order_relaxed);
+        uint64_t max_us = m_max_us.load(std::memory_order_relaxed);
+        while ((value_us > max_us) && !m_max_us.compare_exchange_weak(max_us, value_us, std::memory_order_relaxed)) {}
+    }
+
+    void RecordSince(const Frame_Trace& trace) {
+        if (!trace.IsValid()) return;
+        Record(trace.GetElapsed(GetLatencyTimestamp()));
+    }
+
+    Snapshot GetSnapshot() const {
+        Snapshot snapshot;
+        for (size_t i = 0; i < TOTAL_BUCKETS; i++) {
+            snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        }
+        snapshot.count = m_count.load(std::memory_order_relaxed);
+        snapshot.total_us = m_total_us.load(std::memory_order_relaxed);
+        snapshot.max_us = m_max_us.load(std::memory_order_relaxed);
+        snapshot.last_us = m_last_us.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void Reset() {
+        for (auto& bucket: m_buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_total_us.store(0, std::memory_order_relaxed);
+        m_max_us.store(0, std::memory_order_relaxed);
+        m_last_us.store(0, std::memory_order_relaxed);
+    }
+};
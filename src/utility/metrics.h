@@ -0,0 +1,212 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "./latency_histogram.h"
+#include "./observable.h"
+
+// Monotonically increasing count that is updated by a single decoder thread and read by any thread
+class Metric_Counter
+{
+private:
+    std::atomic<uint64_t> m_value {0};
+public:
+    void Increment(const uint64_t delta=1) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+    uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+};
+
+enum class Metric_Type { COUNTER, GAUGE, HISTOGRAM };
+using Metric_Labels = std::vector<std::pair<std::string, std::string>>;
+
+struct Metric_Sample {
+    std::string name;
+    std::string help;
+    Metric_Type type;
+    Metric_Labels labels;
+    double value = 0.0;
+    Latency_Histogram::Snapshot histogram;
+};
+
+// Passed to collectors which read the current value of the metrics they own
+class Metrics_Writer
+{
+private:
+    std::vector<Metric_Sample> m_samples;
+public:
+    void AddCounter(std::string_view name, std::string_view help, const Metric_Labels& labels, const uint64_t value) {
+        Add(name, help, Metric_Type::COUNTER, labels).value = double(value);
+    }
+    void AddGauge(std::string_view name, std::string_view help, const Metric_Labels& labels, const double value) {
+        Add(name, help, Metric_Type::GAUGE, labels).value = value;
+    }
+    void AddHistogram(std::string_view name, std::string_view help, const Metric_Labels& labels, const Latency_Histogram& histogram) {
+        Add(name, help, Metric_Type::HISTOGRAM, labels).histogram = histogram.GetSnapshot();
+    }
+    std::vector<Metric_Sample>& GetSamples() { return m_samples; }
+private:
+    Metric_Sample& Add(std::string_view name, std::string_view help, const Metric_Type type, const Metric_Labels& labels) {
+        auto& sample = m_samples.emplace_back();
+        sample.name = std::string(name);
+        sample.help = std::string(help);
+        sample.type = type;
+        sample.labels = labels;
+        return sample;
+    }
+};
+
+// Single place to read the health of every decode stage
+// - Components keep their own lock free counters and histograms so updating them costs an atomic add
+// - Owners of components attach a collector which copies those values out when a snapshot is taken
+// - Collectors must be detached before the components they read are destroyed
+class Metrics_Registry
+{
+public:
+    using Collector = std::function<void(Metrics_Writer&)>;
+private:
+    struct Entry {
+        ObserverToken token;
+        Collector collector;
+    };
+    std::vector<Entry> m_collectors;
+    ObserverToken m_next_token = INVALID_OBSERVER_TOKEN;
+    std::mutex m_mutex;
+public:
+    ObserverToken Attach(Collector collector) {
+        auto lock = std::scoped_lock(m_mutex);
+        m_next_token++;
+        if (m_next_token == INVALID_OBSERVER_TOKEN) m_next_token++;
+        m_collectors.push_back({ m_next_token, std::move(collector) });
+        return m_next_token;
+    }
+    // Blocks until any snapshot using the collector has finished
+    bool Detach(const ObserverToken token) {
+        auto lock = std::scoped_lock(m_mutex);
+        for (auto it = m_collectors.begin(); it != m_collectors.end(); ++it) {
+            if (it->token != token) continue;
+            m_collectors.erase(it);
+            return true;
+        }
+        return false;
+    }
+    std::vector<Metric_Sample> GetSnapshot() {
+        auto lock = std::scoped_lock(m_mutex);
+        Metrics_Writer writer;
+        for (auto& entry: m_collectors) {
+            entry.collector(writer);
+        }
+        return std::move(writer.GetSamples());
+    }
+};
+
+// DOC: Prometheus text based exposition format version 0.0.4
+// Samples of the same metric are grouped under one HELP and TYPE line in the order they were first collected
+// Histograms are converted from microseconds to seconds with cumulative power of 2 buckets
+inline void AppendPrometheusLabels(std::string& out, const Metric_Labels& labels, const char* le=nullptr) {
+    if (labels.empty() && (le == nullptr)) return;
+    out += '{';
+    bool is_first = true;
+    auto append_label = [&out, &is_first](std::string_view key, std::string_view value) {
+        if (!is_first) out += ',';
+        is_first = false;
+        out += key;
+        out += "=\"";
+        for (const char c: value) {
+            switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"':  out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default:   out += c; break;
+            }
+        }
+        out += '"';
+    };
+    for (const auto& [key, value]: labels) {
+        append_label(key, value);
+    }
+    if (le != nullptr) append_label("le", le);
+    out += '}';
+}
+
+inline void AppendPrometheusValue(std::string& out, const double value) {
+    // Counters are printed exactly while fractional values don't need more than single precision
+    char buf[32];
+    const bool is_integer = (value < 9.0e15) && (value > -9.0e15) && (value == double(int64_t(value)));
+    snprintf(buf, sizeof(buf), is_integer ? "%.0f" : "%.9g", value);
+    out += buf;
+    out += '\n';
+}
+
+inline std::string FormatPrometheusText(const std::vector<Metric_Sample>& samples) {
+    std::vector<std::string_view> names;
+    std::unordered_map<std::string_view, std::vector<const Metric_Sample*>> families;
+    for (const auto& sample: samples) {
+        auto& family = families[sample.name];
+        if (family.empty()) names.push_back(sample.name);
+        family.push_back(&sample);
+    }
+
+    std::string out;
+    char buf[32];
+    for (const auto name: names) {
+        const auto& family = families[name];
+        const auto& first = *(family.front());
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += first.help;
+        out += "\n# TYPE ";
+        out += name;
+        switch (first.type) {
+        case Metric_Type::COUNTER:   out += " counter\n"; break;
+        case Metric_Type::GAUGE:     out += " gauge\n"; break;
+        case Metric_Type::HISTOGRAM: out += " histogram\n"; break;
+        }
+        for (const auto* sample: family) {
+            if (sample->type != Metric_Type::HISTOGRAM) {
+                out += name;
+                AppendPrometheusLabels(out, sample->labels);
+                out += ' ';
+                AppendPrometheusValue(out, sample->value);
+                continue;
+            }
+            const auto& histogram = sample->histogram;
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < Latency_Histogram::TOTAL_BUCKETS-1; i++) {
+                cumulative += histogram.buckets[i];
+                snprintf(buf, sizeof(buf), "%.6g", double(Latency_Histogram::GetBucketLowerBound(i+1))*1e-6);
+                out += name;
+                out += "_bucket";
+                AppendPrometheusLabels(out, sample->labels, buf);
+                out += ' ';
+                AppendPrometheusValue(out, double(cumulative));
+            }
+            // NOTE: The total is taken from the buckets since the count can be read while a sample is recorded
+            cumulative += histogram.buckets[Latency_Histogram::TOTAL_BUCKETS-1];
+            out += name;
+            out += "_bucket";
+            AppendPrometheusLabels(out, sample->labels, "+Inf");
+            out += ' ';
+            AppendPrometheusValue(out, double(cumulative));
+            out += name;
+            out += "_sum";
+            AppendPrometheusLabels(out, sample->labels);
+            out += ' ';
+            AppendPrometheusValue(out, double(histogram.total_us)*1e-6);
+            out += name;
+            out += "_count";
+            AppendPrometheusLabels(out, sample->labels);
+            out += ' ';
+            AppendPrometheusValue(out, double(cumulative));
+        }
+    }
+    return out;
+}
@@ -1,22 +1,155 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
 #include <functional>
+#include <utility>
 #include <vector>
 
+// Returned by Observable::Attach so the observer can be removed later
+using ObserverToken = uint32_t;
+constexpr ObserverToken INVALID_OBSERVER_TOKEN = 0;
+
+// Arguments are forwarded to every observer by const reference so heavy types are never copied
+// Most observables only have a few observers so they are stored inline to avoid chasing pointers
 template <typename ... T>
-class Observable 
+class Observable
 {
 private:
-    using Observer = std::function<void(T...)>;
-    std::vector<Observer> m_observers;
+    using Observer = std::function<void(const T&...)>;
+    struct Entry {
+        ObserverToken token = INVALID_OBSERVER_TOKEN;
+        Observer observer;
+    };
+    static constexpr size_t INLINE_CAPACITY = 4;
+    Entry m_inline_observers[INLINE_CAPACITY];
+    size_t m_nb_inline_observers = 0;
+    std::vector<Entry> m_overflow_observers;
+    // Observers attached while notifying are held here so the observers being called are never moved
+    std::vector<Entry> m_pending_observers;
+    ObserverToken m_next_token = INVALID_OBSERVER_TOKEN;
+    // Observers can attach or detach themselves (or others) while being notified
+    bool m_is_notifying = false;
+    bool m_is_pending_removal = false;
 public:
-    void Attach(const Observer& observer) {
-        m_observers.push_back(observer);
+    ObserverToken Attach(Observer observer) {
+        m_next_token++;
+        if (m_next_token == INVALID_OBSERVER_TOKEN) m_next_token++;
+        Entry entry;
+        entry.token = m_next_token;
+        entry.observer = std::move(observer);
+        if (m_is_notifying) {
+            m_pending_observers.push_back(std::move(entry));
+        } else if (m_nb_inline_observers < INLINE_CAPACITY) {
+            m_inline_observers[m_nb_inline_observers] = std::move(entry);
+            m_nb_inline_observers++;
+        } else {
+            m_overflow_observers.push_back(std::move(entry));
+        }
+        return m_next_token;
+    }
+
+    // Returns false if the token was not attached
+    bool Detach(const ObserverToken token) {
+        if (token == INVALID_OBSERVER_TOKEN) return false;
+        Entry* entry = Find(token);
+        if (entry == nullptr) return false;
+        entry->token = INVALID_OBSERVER_TOKEN;
+        // Removal is deferred so we don't shift observers that are being iterated
+        if (m_is_notifying) {
+            m_is_pending_removal = true;
+        } else {
+            RemoveDetached();
+        }
+        return true;
+    }
+
+    size_t GetTotalObservers() const {
+        return m_nb_inline_observers + m_overflow_observers.size() + m_pending_observers.size();
+    }
+
+    void Notify(const T& ... args) {
+        // NOTE: Observers attached during notification are called once the outermost notify has finished
+        const size_t nb_inline = m_nb_inline_observers;
+        const size_t nb_overflow = m_overflow_observers.size();
+        const bool is_nested = m_is_notifying;
+        m_is_notifying = true;
+        for (size_t i = 0; i < nb_inline; i++) {
+            auto& entry = m_inline_observers[i];
+            if (entry.token == INVALID_OBSERVER_TOKEN) continue;
+            entry.observer(args...);
+        }
+        for (size_t i = 0; i < nb_overflow; i++) {
+            auto& entry = m_overflow_observers[i];
+            if (entry.token == INVALID_OBSERVER_TOKEN) continue;
+            entry.observer(args...);
+        }
+        if (is_nested) return;
+        m_is_notifying = false;
+        if (m_is_pending_removal) {
+            RemoveDetached();
+        }
+        if (!m_pending_observers.empty()) {
+            AttachPending();
+        }
+    }
+private:
+    Entry* Find(const ObserverToken token) {
+        for (size_t i = 0; i < m_nb_inline_observers; i++) {
+            if (m_inline_observers[i].token == token) return &m_inline_observers[i];
+        }
+        for (auto& entry: m_overflow_observers) {
+            if (entry.token == token) return &entry;
+        }
+        for (auto& entry: m_pending_observers) {
+            if (entry.token == token) return &entry;
+        }
+        return nullptr;
     }
-    // Copies arguments to list of callbacks
-    void Notify(T ... args) {
-        for (const auto& o: m_observers) {
-            o(args...);
+
+    void AttachPending() {
+        for (auto& entry: m_pending_observers) {
+            if (entry.token == INVALID_OBSERVER_TOKEN) continue;
+            if (m_nb_inline_observers < INLINE_CAPACITY) {
+                m_inline_observers[m_nb_inline_observers] = std::move(entry);
+                m_nb_inline_observers++;
+            } else {
+                m_overflow_observers.push_back(std::move(entry));
+            }
+        }
+        m_pending_observers.clear();
+    }
+
+    void RemoveDetached() {
+        m_is_pending_removal = false;
+        size_t nb_inline = 0;
+        for (size_t i = 0; i < m_nb_inline_observers; i++) {
+            auto& entry = m_inline_observers[i];
+            if (entry.token == INVALID_OBSERVER_TOKEN) continue;
+            if (nb_inline != i) {
+                m_inline_observers[nb_inline] = std::move(entry);
+            }
+            nb_inline++;
+        }
+        // Pull overflow observers back inline to keep attachment order
+        auto overflow_it = m_overflow_observers.begin();
+        for (; overflow_it != m_overflow_observers.end(); ++overflow_it) {
+            if (overflow_it->token == INVALID_OBSERVER_TOKEN) continue;
+            if (nb_inline == INLINE_CAPACITY) break;
+            m_inline_observers[nb_inline] = std::move(*overflow_it);
+            overflow_it->token = INVALID_OBSERVER_TOKEN;
+            nb_inline++;
+        }
+        for (size_t i = nb_inline; i < m_nb_inline_observers; i++) {
+            m_inline_observers[i] = Entry{};
         }
+        m_nb_inline_observers = nb_inline;
+        m_overflow_observers.erase(
+            std::remove_if(m_overflow_observers.begin(), m_overflow_observers.end(), [](const Entry& entry) {
+                return entry.token == INVALID_OBSERVER_TOKEN;
+            }),
+            m_overflow_observers.end()
+        );
     }
-};
\ No newline at end of file
+};
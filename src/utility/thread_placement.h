@@ -0,0 +1,220 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "./span.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+// Where the threads and buffers of a demodulator or radio should live
+// - Threads are restricted to a set of cpus so they don't migrate across sockets
+// - Buffers are first touched by a thread in that set so the OS places their pages on the same NUMA node
+// - Unsupported platforms ignore the placement and the report shows that nothing was pinned
+struct Thread_Placement {
+    std::vector<int> cpus;              // empty lets the OS schedule threads anywhere
+    bool is_pin_each_thread = false;    // thread i only runs on cpus[i % N] instead of floating within the set
+    bool is_huge_pages = false;         // advise the OS to back large buffers with transparent huge pages
+    bool is_lock_memory = false;        // lock large buffers into memory so they are never paged out
+    bool IsEnabled() const { return !cpus.empty(); }
+};
+
+// Placement that each thread and buffer actually ended up with
+// NOTE: Threads add themselves when they start so the report can be read while it is being filled
+class Thread_Placement_Report
+{
+public:
+    struct Thread {
+        std::string name;
+        bool is_pinned = false;
+        int cpu = -1;                   // cpu the thread was running on after it was pinned
+        int numa_node = -1;
+    };
+    struct Memory {
+        std::string name;
+        size_t nb_bytes = 0;
+        bool is_huge_pages = false;
+        bool is_locked = false;
+        int numa_node = -1;             // node of the first page
+    };
+private:
+    mutable std::mutex m_mutex;
+    std::vector<Thread> m_threads;
+    std::vector<Memory> m_memory;
+public:
+    void AddThread(Thread thread) {
+        auto lock = std::scoped_lock(m_mutex);
+        m_threads.push_back(std::move(thread));
+    }
+    void AddMemory(Memory memory) {
+        auto lock = std::scoped_lock(m_mutex);
+        m_memory.push_back(std::move(memory));
+    }
+    std::vector<Thread> GetThreads() const {
+        auto lock = std::scoped_lock(m_mutex);
+        return m_threads;
+    }
+    std::vector<Memory> GetMemory() const {
+        auto lock = std::scoped_lock(m_mutex);
+        return m_memory;
+    }
+};
+
+inline int GetCurrentCPU() {
+#if defined(__linux__)
+    return sched_getcpu();
+#elif _WIN32
+    return int(GetCurrentProcessorNumber());
+#else
+    return -1;
+#endif
+}
+
+inline int GetCurrentNUMANode() {
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return -1;
+    return int(node);
+#elif _WIN32
+    PROCESSOR_NUMBER processor;
+    GetCurrentProcessorNumberEx(&processor);
+    USHORT node = 0;
+    if (!GetNumaProcessorNodeEx(&processor, &node)) return -1;
+    return int(node);
+#else
+    return -1;
+#endif
+}
+
+// Returns -1 if the page hasn't been touched yet or the OS can't tell us
+inline int GetMemoryNUMANode(const void* ptr) {
+#if defined(__linux__) && defined(SYS_move_pages)
+    // NOTE: move_pages without target nodes only queries where the pages are
+    void* pages[1] = { const_cast<void*>(ptr) };
+    int status[1] = { -1 };
+    if (syscall(SYS_move_pages, 0, 1, pages, nullptr, status, 0) != 0) return -1;
+    return (status[0] >= 0) ? status[0] : -1;
+#else
+    (void)ptr;
+    return -1;
+#endif
+}
+
+// Restricts the calling thread to the cpus in the placement
+inline bool ApplyThreadPlacement(const Thread_Placement& placement, const size_t thread_index) {
+    if (!placement.IsEnabled()) return false;
+    const size_t N = placement.cpus.size();
+    const size_t start = placement.is_pin_each_thread ? (thread_index % N) : 0;
+    const size_t end = placement.is_pin_each_thread ? (start+1) : N;
+#if defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (size_t i = start; i < end; i++) {
+        const int cpu = placement.cpus[i];
+        if ((cpu < 0) || (cpu >= CPU_SETSIZE)) continue;
+        CPU_SET(cpu, &cpu_set);
+    }
+    if (CPU_COUNT(&cpu_set) == 0) return false;
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) return false;
+    // NOTE: The new mask only applies once the thread is rescheduled
+    sched_yield();
+    return true;
+#elif _WIN32
+    DWORD_PTR mask = 0;
+    for (size_t i = start; i < end; i++) {
+        const int cpu = placement.cpus[i];
+        if ((cpu < 0) || (cpu >= int(sizeof(DWORD_PTR)*8))) continue;
+        mask |= (DWORD_PTR(1) << cpu);
+    }
+    if (mask == 0) return false;
+    if (SetThreadAffinityMask(GetCurrentThread(), mask) == 0) return false;
+    SwitchToThread();
+    return true;
+#else
+    (void)start;
+    (void)end;
+    return false;
+#endif
+}
+
+inline Thread_Placement_Report::Thread GetCurrentThreadPlacement(std::string name, const bool is_pinned) {
+    Thread_Placement_Report::Thread thread;
+    thread.name = std::move(name);
+    thread.is_pinned = is_pinned;
+    thread.cpu = GetCurrentCPU();
+    thread.numa_node = GetCurrentNUMANode();
+    return thread;
+}
+
+// Transparent huge pages only apply to whole pages so the unaligned head and tail of the buffer are skipped
+// NOTE: This must be called before the buffer is first touched for the advice to apply when pages are faulted in
+inline bool AdviseHugePages(tcb::span<uint8_t> buf) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    constexpr uintptr_t HUGE_PAGE_SIZE = 2u*1024u*1024u;
+    const uintptr_t start = reinterpret_cast<uintptr_t>(buf.data());
+    const uintptr_t end = start + buf.size();
+    const uintptr_t aligned_start = (start + HUGE_PAGE_SIZE-1) & ~(HUGE_PAGE_SIZE-1);
+    const uintptr_t aligned_end = end & ~(HUGE_PAGE_SIZE-1);
+    if (aligned_end <= aligned_start) return false;
+    return madvise(reinterpret_cast<void*>(aligned_start), size_t(aligned_end-aligned_start), MADV_HUGEPAGE) == 0;
+#else
+    (void)buf;
+    return false;
+#endif
+}
+
+// NOTE: This can fail if the process exceeds its locked memory limit
+inline bool LockMemory(tcb::span<uint8_t> buf) {
+    if (buf.empty()) return false;
+#if defined(__linux__)
+    return mlock(buf.data(), buf.size()) == 0;
+#elif _WIN32
+    return VirtualLock(buf.data(), buf.size()) != 0;
+#else
+    return false;
+#endif
+}
+
+inline void UnlockMemory(tcb::span<uint8_t> buf) {
+    if (buf.empty()) return;
+#if defined(__linux__)
+    munlock(buf.data(), buf.size());
+#elif _WIN32
+    VirtualUnlock(buf.data(), buf.size());
+#endif
+}
+
+// Runs the function on a temporary thread inside the placement so any memory it touches is local to those cpus
+template <typename F>
+void RunWithThreadPlacement(const Thread_Placement& placement, F&& func) {
+    if (!placement.IsEnabled()) {
+        func();
+        return;
+    }
+    Thread_Placement whole_set = placement;
+    whole_set.is_pin_each_thread = false;
+    auto thread = std::thread([&whole_set, &func]() {
+        ApplyThreadPlacement(whole_set, 0);
+        func();
+    });
+    thread.join();
+}